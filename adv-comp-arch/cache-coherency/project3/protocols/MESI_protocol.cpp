@@ -1,274 +1,81 @@
 #include "MESI_protocol.h"
-#include "../sim/mreq.h"
-#include "../sim/sim.h"
-#include "../sim/hash_table.h"
-
-extern Simulator *Sim;
 
 /*************************
- * Constructor/Destructor.
+ * Transition table.
  *************************/
-MESI_protocol::MESI_protocol (Hash_table *my_table, Hash_entry *my_entry)
-    : Protocol (my_table, my_entry)
-{
-	 this->state = MESI_CACHE_I;
-}
-
-MESI_protocol::~MESI_protocol ()
-{    
-}
-
-void MESI_protocol::dump (void)
-{
-    const char *block_states[] = {"X","I","S","E","M","IX","IM"};
-    fprintf (stderr, "MESI_protocol - state: %s\n", block_states[state]);
-}
 
-void MESI_protocol::process_cache_request (Mreq *request)
-{
-	switch (state) {
-	case MESI_CACHE_I:  do_cache_I (request); break;
-	case MESI_CACHE_IX: do_cache_IX (request); break;
-	case MESI_CACHE_IM: do_cache_IM (request); break;
-	case MESI_CACHE_SM: do_cache_SM (request); break;
-	case MESI_CACHE_M:  do_cache_M (request); break;
-	case MESI_CACHE_E:  do_cache_E (request); break;
-	case MESI_CACHE_S:  do_cache_S (request); break;
-    default:
-        fatal_error ("Invalid Cache State for MESI Protocol\n");
+/** A load miss waits in IX and lands in E when nobody raised the shared
+ *  line, S otherwise.  E upgrades to M silently.  An upgrade from S waits in
+ *  SM; if another cache's GET wins the bus first the upgrade becomes a full
+ *  miss in IM.
+ */
+const Protocol_table MESI_table = {
+    "MESI_protocol",
+    {"X","I","S","E","M","IX","SM","IM"},
+    /* X, I, S, E, M, IX, SM, IM */
+    {EVICT_BUSY, EVICT_CLEAN, EVICT_PUTS, EVICT_PUTS, EVICT_PUTM,
+     EVICT_BUSY, EVICT_BUSY, EVICT_BUSY},
+    /* X, I, S, E, M, IX, SM, IM */
+    {PERM_NONE, PERM_NONE, PERM_READ, PERM_WRITE, PERM_WRITE, PERM_NONE,
+     PERM_READ, PERM_NONE},
+    {
+        /* X */
+        TR_ERR_ROW,
+        /* I */
+        {TR (ACT_GETS | ACT_MISS, MESI_CACHE_IX),       /* LOAD */
+         TR (ACT_GETM | ACT_MISS, MESI_CACHE_IM),       /* STORE */
+         TR_NOP,                                        /* GETS */
+         TR_NOP,                                        /* GETM */
+         TR_NOP,                                        /* DATA */
+         TR_NOP,                                        /* own GETS */
+         TR_NOP},                                       /* own GETM */
+        /* S */
+        {TR (ACT_DATA_PROC, 0),
+         TR (ACT_GETM | ACT_MISS, MESI_CACHE_SM),
+         TR (ACT_SHARED, 0),
+         TR (0, MESI_CACHE_I),
+         TR_NOP,
+         TR (ACT_SHARED, 0),
+         TR (0, MESI_CACHE_I)},
+        /* E */
+        {TR (ACT_DATA_PROC, 0),
+         TR (ACT_DATA_PROC | ACT_UPGRADE, MESI_CACHE_M),
+         TR (ACT_SHARED | ACT_DATA_BUS, MESI_CACHE_S),
+         TR (ACT_DATA_BUS, MESI_CACHE_I),
+         TR_ERR,
+         TR (ACT_SHARED | ACT_DATA_BUS, MESI_CACHE_S),
+         TR (ACT_DATA_BUS, MESI_CACHE_I)},
+        /* M */
+        {TR (ACT_DATA_PROC, 0),
+         TR (ACT_DATA_PROC, 0),
+         TR (ACT_SHARED | ACT_DATA_BUS, MESI_CACHE_S),
+         TR (ACT_DATA_BUS, MESI_CACHE_I),
+         TR_NOP,
+         TR (ACT_SHARED | ACT_DATA_BUS, MESI_CACHE_S),
+         TR (ACT_DATA_BUS, MESI_CACHE_I)},
+        /* IX */
+        {TR_ERR,
+         TR_ERR,
+         TR_NOP,
+         TR_NOP,
+         TR_IF_SHARED (ACT_DATA_PROC, MESI_CACHE_E, MESI_CACHE_S),
+         TR_NOP,
+         TR_NOP},
+        /* SM */
+        {TR_ERR,
+         TR_ERR,
+         TR (ACT_SHARED, MESI_CACHE_IM),
+         TR (ACT_SHARED, MESI_CACHE_IM),
+         TR (ACT_DATA_PROC, MESI_CACHE_M),
+         TR_NOP,
+         TR_NOP},
+        /* IM */
+        {TR_ERR,
+         TR_ERR,
+         TR_NOP,
+         TR_NOP,
+         TR (ACT_DATA_PROC, MESI_CACHE_M),
+         TR_NOP,
+         TR_NOP},
     }
-}
-
-void MESI_protocol::process_snoop_request (Mreq *request)
-{
-	switch (state) {
-
-	case MESI_CACHE_I:  do_snoop_I (request); break;
-	case MESI_CACHE_IM: do_snoop_IM (request); break;
-	case MESI_CACHE_SM: do_snoop_SM (request); break;
-	case MESI_CACHE_IX: do_snoop_IX (request); break;
-	case MESI_CACHE_M:  do_snoop_M (request); break;
-	case MESI_CACHE_E:  do_snoop_E (request); break;
-	case MESI_CACHE_S:  do_snoop_S (request); break;
-    default:
-    	fatal_error ("Invalid Cache State for MESI Protocol\n");
-    }
-}
-
-inline void MESI_protocol::do_cache_I (Mreq *request)
-{
-	switch (request->msg) {
-	// If we get a request from the processor we need to get the data
-	case STORE:
-		send_GETM(request->addr);
-		state = MESI_CACHE_IM;
-		Sim->cache_misses++;
-		break;
-	case LOAD:
-		/* Line up the GETM in the Bus' queue */
-		send_GETS(request->addr);
-		state = MESI_CACHE_IX;
-		/* This is a cache miss */
-		Sim->cache_misses++;
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MESI_protocol::do_cache_S (Mreq *request)
-{
-	switch (request->msg) {
-	case LOAD: /*Nothing else to be done*/
-		send_DATA_to_proc(request->addr);
-		break;
-	case STORE:
-		state = MESI_CACHE_SM;
-		Sim->cache_misses++;
-		send_GETM(request->addr);
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MESI_protocol::do_cache_E (Mreq *request)
-{
-	switch (request->msg) {
-	case LOAD: /*Nothing else to be done*/
-		send_DATA_to_proc(request->addr);
-		break;
-	case STORE:
-		/*Data need not be supplied because we are
-		 * the only ones with this cache line*/
-		state = MESI_CACHE_M;
-		Sim->silent_upgrades++;
-		send_DATA_to_proc(request->addr);
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MESI_protocol::do_cache_IX (Mreq *request)
-{
-	request->print_msg (my_table->moduleID, "ERROR");
-	fatal_error ("Client: I state shouldn't see this message\n");
-}
-inline void MESI_protocol::do_cache_IM (Mreq *request)
-{
-	request->print_msg (my_table->moduleID, "ERROR");
-	fatal_error ("Client: I state shouldn't see this message\n");
-}
-inline void MESI_protocol::do_cache_SM (Mreq *request)
-{
-	request->print_msg (my_table->moduleID, "ERROR");
-	fatal_error ("Client: I state shouldn't see this message\n");
-}
-inline void MESI_protocol::do_cache_M (Mreq *request)
-{
-	switch (request->msg) {
-	case LOAD: /*Nothing else to be done*/
-	case STORE:
-		send_DATA_to_proc(request->addr);
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-inline void MESI_protocol::do_snoop_I (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-	case GETM:
-	case DATA:
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MESI_protocol::do_snoop_IX (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-	case GETM: break;
-	/*During this time if there already was an exclusive owner,
-	we would know by checking the shared line*/
-	case DATA:
-		send_DATA_to_proc(request->addr);
-		if (get_shared_line())
-			state = MESI_CACHE_S;
-		else /*Alternatively, this means that data has come from the memory*/
-			state = MESI_CACHE_E;
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MESI_protocol::do_snoop_IM (Mreq *request)
-{
-	switch (request->msg) {
-		case GETS:
-		case GETM:
-			break;
-		case DATA:
-			send_DATA_to_proc(request->addr);
-			state = MESI_CACHE_M;
-			break;
-		default:
-	        request->print_msg (my_table->moduleID, "ERROR");
-	        fatal_error ("Client: I state shouldn't see this message\n");
-		}
-}
-
-inline void MESI_protocol::do_snoop_SM (Mreq *request)
-{
-	switch (request->msg) {
-		case GETS:
-		case GETM:
-			if (request->src_mid != my_table->moduleID)
-			{
-				set_shared_line();
-				state = MESI_CACHE_IM;
-			}
-			break;
-		case DATA:
-			send_DATA_to_proc(request->addr);
-			state = MESI_CACHE_M;
-			break;
-		default:
-	        request->print_msg (my_table->moduleID, "ERROR");
-	        fatal_error ("Client: I state shouldn't see this message\n");
-		}
-}
-
-inline void MESI_protocol::do_snoop_S (Mreq *request)
-{
-	switch (request->msg) {
-		case GETS:
-			set_shared_line();
-			break;
-		case GETM:
-			state = MESI_CACHE_I;
-			break;
-		case DATA:
-			break;
-		default:
-			request->print_msg (my_table->moduleID, "ERROR");
-			fatal_error ("Client: I state shouldn't see this message\n");
-		}
-}
-
-inline void MESI_protocol::do_snoop_E (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-		set_shared_line();
-		send_DATA_on_bus(request->addr,request->src_mid);
-		state = MESI_CACHE_S;
-		break;
-	case GETM:
-		send_DATA_on_bus(request->addr,request->src_mid);
-		state = MESI_CACHE_I;
-		break;
-	/*During this time if there already was an exclusive owner,
-	we would know by checking the shared line*/
-	case DATA:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MESI_protocol::do_snoop_M (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-		set_shared_line();
-		send_DATA_on_bus(request->addr,request->src_mid);
-		state = MESI_CACHE_S;
-		break;
-	case GETM:
-		//set_shared_line();
-		send_DATA_on_bus(request->addr,request->src_mid);
-		state = MESI_CACHE_I;
-		break;
-	case DATA:
-		break;
-	default:
-		request->print_msg (my_table->moduleID, "ERROR");
-		fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
+};
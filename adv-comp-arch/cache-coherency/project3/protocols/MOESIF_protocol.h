@@ -23,40 +23,6 @@ typedef enum {
 
 } MOESIF_cache_state_t;
 
-class MOESIF_protocol : public Protocol {
-public:
-    MOESIF_protocol (Hash_table *my_table, Hash_entry *my_entry);
-    ~MOESIF_protocol ();
-
-    MOESIF_cache_state_t state;
-    
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
-
-    inline void do_cache_I (Mreq *request);
-	inline void do_cache_S (Mreq *request);
-	inline void do_cache_E (Mreq *request);
-	inline void do_cache_O (Mreq *request);
-	inline void do_cache_M (Mreq *request);
-	inline void do_cache_SM (Mreq *request);
-	inline void do_cache_IM (Mreq *request);
-	inline void do_cache_IS (Mreq *request);
-	inline void do_cache_OM (Mreq *request);
-	inline void do_cache_F (Mreq *request);
-	inline void do_cache_FM (Mreq *request);
-
-	inline void do_snoop_I (Mreq *request);
-	inline void do_snoop_S (Mreq *request);
-	inline void do_snoop_E (Mreq *request);
-	inline void do_snoop_O (Mreq *request);
-	inline void do_snoop_M (Mreq *request);
-	inline void do_snoop_IS (Mreq *request);
-	inline void do_snoop_IM (Mreq *request);
-	inline void do_snoop_SM (Mreq *request);
-	inline void do_snoop_OM (Mreq *request);
-	inline void do_snoop_F(Mreq *request);
-	inline void do_snoop_FM(Mreq *request);
-};
+extern const Protocol_table MOESIF_table;
 
 #endif // _MOESIF_CACHE_H
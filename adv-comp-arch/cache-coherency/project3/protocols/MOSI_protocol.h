@@ -19,35 +19,6 @@ typedef enum {
     MOSI_CACHE_M
 } MOSI_cache_state_t;
 
-class MOSI_protocol : public Protocol {
-public:
-    MOSI_protocol (Hash_table *my_table, Hash_entry *my_entry);
-    ~MOSI_protocol ();
-
-    MOSI_cache_state_t state;
-    MOSI_cache_state_t nxt_state;
-    
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
-
-    inline void do_cache_I (Mreq *request);
-    inline void do_cache_S (Mreq * request);
-    inline void do_cache_O (Mreq * request);
-    inline void do_cache_M (Mreq *request);
-    inline void do_cache_IM (Mreq *request);
-    inline void do_cache_IS (Mreq *request);
-    inline void do_cache_SM (Mreq *request);
-    inline void do_cache_OM (Mreq *request);
-
-    inline void do_snoop_I (Mreq *request);
-    inline void do_snoop_S (Mreq *request);
-    inline void do_snoop_O (Mreq *request);
-    inline void do_snoop_M (Mreq *request);
-    inline void do_snoop_IM (Mreq *request);
-    inline void do_snoop_IS (Mreq *request);
-    inline void do_snoop_SM (Mreq *request);
-    inline void do_snoop_OM (Mreq *request);
-};
+extern const Protocol_table MOSI_table;
 
 #endif // _MOSI_CACHE_H
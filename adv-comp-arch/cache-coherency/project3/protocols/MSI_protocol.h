@@ -16,36 +16,6 @@ typedef enum {
     MSI_CACHE_M
 } MSI_cache_state_t;
 
-class MSI_protocol : public Protocol {
-public:
-    MSI_protocol (Hash_table *my_table, Hash_entry *my_entry);
-    ~MSI_protocol ();
-
-    // Cache state for this line
-    MSI_cache_state_t state;
-    MSI_cache_state_t nxt_state;
-
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
-
-    /* Functions that specify the actions to take on requests from the processor
-     * when the cache is in various states
-     */
-    inline void do_cache_I (Mreq *request);
-    inline void do_cache_S (Mreq * request);
-    inline void do_cache_IM (Mreq * request);
-    inline void do_cache_M (Mreq *request);
-    inline void do_cache_IS (Mreq *request);
-
-    /* Functions that specify the actions to take on snooped requests
-     * when the cache is in various states
-     */
-    inline void do_snoop_I (Mreq *request);
-    inline void do_snoop_IM (Mreq * request);
-    inline void do_snoop_S (Mreq * request);
-    inline void do_snoop_M (Mreq *request);
-    inline void do_snoop_IS (Mreq *request);
-};
+extern const Protocol_table MSI_table;
 
 #endif // _MSI_CACHE_H
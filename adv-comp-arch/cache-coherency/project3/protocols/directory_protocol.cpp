@@ -0,0 +1,271 @@
+#include "directory_protocol.h"
+#include "../sim/mreq.h"
+#include "../sim/sim.h"
+#include "../sim/hash_table.h"
+#include "../sim/trace.h"
+
+extern Simulator *Sim;
+
+/*************************
+ * Constructor/Destructor.
+ *************************/
+Directory_protocol::Directory_protocol (Hash_table *my_table, protocol_t variant)
+    : Protocol (my_table, NULL)
+{
+    this->has_E = (variant == MESI_PRO || variant == MOESI_PRO);
+    this->has_O = (variant == MOESI_PRO);
+}
+
+Directory_protocol::~Directory_protocol ()
+{
+}
+
+void Directory_protocol::dump (Hash_entry *entry)
+{
+    const char *block_states[] = {"X","I","S","E","O","M","IS_D","IM_AD","SM_AD","OM_AC"};
+    fprintf (stderr, "Directory_protocol - state: %s\n", block_states[entry->state]);
+}
+
+bool Directory_protocol::process_eviction (Hash_entry *entry)
+{
+    switch (entry->state) {
+    case DIR_CACHE_I:
+        break;
+    case DIR_CACHE_S:
+    case DIR_CACHE_E:
+        send_to_home (PUTS, entry->tag);
+        break;
+    case DIR_CACHE_O:
+    case DIR_CACHE_M:
+        send_to_home (PUTM, entry->tag);
+        break;
+    default:
+        /* A request is still outstanding for this line */
+        return false;
+    }
+    entry->state = DIR_CACHE_I;
+    return true;
+}
+
+int Directory_protocol::permission (Hash_entry *entry)
+{
+    switch (entry->state) {
+    case DIR_CACHE_E:
+    case DIR_CACHE_M:
+        return PERM_WRITE;
+    case DIR_CACHE_S:
+    case DIR_CACHE_O:
+    case DIR_CACHE_SM_AD:
+    case DIR_CACHE_OM_AC:
+        return PERM_READ;
+    default:
+        return PERM_NONE;
+    }
+}
+
+void Directory_protocol::process_cache_request (Hash_entry *entry, Mreq *request)
+{
+    switch (entry->state) {
+    case DIR_CACHE_I:
+        my_table->cache_misses++;
+        if (request->msg == LOAD)
+        {
+            send_to_home (GETS, request->addr);
+            entry->state = DIR_CACHE_IS_D;
+        }
+        else
+        {
+            start_write_miss (entry, request->addr, DIR_CACHE_IM_AD);
+        }
+        break;
+    case DIR_CACHE_S:
+        if (request->msg == LOAD)
+        {
+            send_DATA_to_proc (request->addr);
+        }
+        else
+        {
+            my_table->cache_misses++;
+            start_write_miss (entry, request->addr, DIR_CACHE_SM_AD);
+        }
+        break;
+    case DIR_CACHE_E:
+        if (request->msg == STORE)
+        {
+            entry->state = DIR_CACHE_M;
+            my_table->silent_upgrades++;
+        }
+        send_DATA_to_proc (request->addr);
+        break;
+    case DIR_CACHE_O:
+        if (request->msg == LOAD)
+        {
+            send_DATA_to_proc (request->addr);
+        }
+        else
+        {
+            my_table->cache_misses++;
+            start_write_miss (entry, request->addr, DIR_CACHE_OM_AC);
+        }
+        break;
+    case DIR_CACHE_M:
+        send_DATA_to_proc (request->addr);
+        break;
+    default:
+        request->print_msg (my_table->moduleID, "ERROR");
+        fatal_error ("Directory_protocol: transient state shouldn't see a processor request\n");
+    }
+}
+
+void Directory_protocol::process_snoop_request (Hash_entry *entry, const Mreq *request)
+{
+    switch (request->msg) {
+    case DATA:
+    case DATA_E:
+        switch (entry->state) {
+        case DIR_CACHE_IS_D:
+            entry->state = (request->msg == DATA_E) ? DIR_CACHE_E : DIR_CACHE_S;
+            send_DATA_to_proc (request->addr);
+            send_to_home (UNBLOCK, request->addr);
+            break;
+        case DIR_CACHE_IM_AD:
+        case DIR_CACHE_SM_AD:
+        case DIR_CACHE_OM_AC:
+        {
+            Dir_write_miss &miss = write_misses[request->addr];
+
+            miss.data_received = true;
+            miss.acks_expected = request->INV_ACK_count;
+            check_write_complete (entry, request->addr);
+            break;
+        }
+        default:
+            request->print_msg (my_table->moduleID, "ERROR");
+            fatal_error ("Directory_protocol: unexpected data\n");
+        }
+        break;
+
+    case INV_ACK:
+        write_misses[request->addr].acks_received++;
+        check_write_complete (entry, request->addr);
+        break;
+
+    case INV:
+        switch (entry->state) {
+        case DIR_CACHE_S:
+            entry->state = DIR_CACHE_I;
+            break;
+        case DIR_CACHE_SM_AD:
+            /* Another writer won at the home; our upgrade becomes a full miss */
+            entry->state = DIR_CACHE_IM_AD;
+            break;
+        default:
+            request->print_msg (my_table->moduleID, "ERROR");
+            fatal_error ("Directory_protocol: unexpected invalidation\n");
+        }
+        send_INV_ACK (request->addr, request->fwd_mid);
+        break;
+
+    case FWD_GETS:
+        switch (entry->state) {
+        case DIR_CACHE_E:
+        case DIR_CACHE_M:
+            send_DATA_to_cache (request->addr, request->fwd_mid, 0);
+            if (has_O)
+            {
+                entry->state = DIR_CACHE_O;
+            }
+            else
+            {
+                /* Without an O state memory has to be brought up to date;
+                 * the home cannot tell E from a silently upgraded M, so
+                 * it waits for the copy either way */
+                send_DATA_to_cache (request->addr, request->src_mid, 0);
+                entry->state = DIR_CACHE_S;
+            }
+            break;
+        case DIR_CACHE_O:
+        case DIR_CACHE_OM_AC:
+            send_DATA_to_cache (request->addr, request->fwd_mid, 0);
+            break;
+        default:
+            request->print_msg (my_table->moduleID, "ERROR");
+            fatal_error ("Directory_protocol: unexpected FWD_GETS\n");
+        }
+        break;
+
+    case FWD_GETM:
+        switch (entry->state) {
+        case DIR_CACHE_E:
+        case DIR_CACHE_O:
+        case DIR_CACHE_M:
+            send_DATA_to_cache (request->addr, request->fwd_mid, request->INV_ACK_count);
+            entry->state = DIR_CACHE_I;
+            break;
+        case DIR_CACHE_OM_AC:
+            /* Lost ownership before our upgrade reached the home */
+            send_DATA_to_cache (request->addr, request->fwd_mid, request->INV_ACK_count);
+            entry->state = DIR_CACHE_IM_AD;
+            break;
+        default:
+            request->print_msg (my_table->moduleID, "ERROR");
+            fatal_error ("Directory_protocol: unexpected FWD_GETM\n");
+        }
+        break;
+
+    default:
+        request->print_msg (my_table->moduleID, "ERROR");
+        fatal_error ("Directory_protocol: unexpected message\n");
+    }
+}
+
+void Directory_protocol::start_write_miss (Hash_entry *entry, paddr_t addr,
+                                           Dir_cache_state_t next)
+{
+    Dir_write_miss &miss = write_misses[addr];
+
+    miss.data_received = false;
+    miss.acks_expected = 0;
+    miss.acks_received = 0;
+    send_to_home (GETM, addr);
+    entry->state = next;
+}
+
+void Directory_protocol::check_write_complete (Hash_entry *entry, paddr_t addr)
+{
+    MAP<paddr_t, Dir_write_miss>::iterator it = write_misses.find (addr);
+
+    if (!it->second.data_received || it->second.acks_received < it->second.acks_expected)
+        return;
+
+    write_misses.erase (it);
+    entry->state = DIR_CACHE_M;
+    send_DATA_to_proc (addr);
+    send_to_home (UNBLOCK, addr);
+}
+
+void Directory_protocol::send_to_home (message_t msg, paddr_t addr)
+{
+    Mreq * new_request;
+    new_request = new Mreq(msg, addr, my_table->moduleID, Sim->get_home (addr));
+    this->my_table->write_to_net(new_request);
+}
+
+void Directory_protocol::send_DATA_to_cache (paddr_t addr, ModuleID dest, int acks)
+{
+    Mreq * new_request;
+    new_request = new Mreq(DATA, addr, my_table->moduleID, dest);
+    new_request->INV_ACK_count = acks;
+    trace_data_send (TRACE_DATA_SEND_CACHE, my_table->moduleID);
+    this->my_table->write_to_net(new_request);
+
+    if (dest.module_index == L1_M)
+        my_table->cache_to_cache_transfers++;
+}
+
+void Directory_protocol::send_INV_ACK (paddr_t addr, ModuleID dest)
+{
+    Mreq * new_request;
+    new_request = new Mreq(INV_ACK, addr, my_table->moduleID, dest);
+    this->my_table->write_to_net(new_request);
+}
@@ -0,0 +1,61 @@
+#ifndef _DIRECTORY_CACHE_H
+#define _DIRECTORY_CACHE_H
+
+#include "../sim/types.h"
+#include "../sim/enums.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "protocol.h"
+
+/** Cache states.  E and O are only reached by the MESI/MOESI variants.  */
+typedef enum {
+    DIR_CACHE_I = 1,
+    DIR_CACHE_S,
+    DIR_CACHE_E,
+    DIR_CACHE_O,
+    DIR_CACHE_M,
+    DIR_CACHE_IS_D,
+    DIR_CACHE_IM_AD,
+    DIR_CACHE_SM_AD,
+    DIR_CACHE_OM_AC
+} Dir_cache_state_t;
+
+/** Write miss bookkeeping; acks can beat the data.  */
+class Dir_write_miss {
+public:
+    bool data_received;
+    int acks_expected;
+    int acks_received;
+};
+
+/** L1 side of the directory protocols.  Requests go point to point to the
+ *  line's home; the home forwards to the owner or invalidates sharers, and
+ *  the requester collects the data plus INV_ACK_count acks before it sends
+ *  UNBLOCK back to the home.  Like the snooping protocols there is one per
+ *  cache and the line only carries its state; the ack counts live here
+ *  while a write miss is outstanding.  */
+class Directory_protocol : public Protocol {
+public:
+    Directory_protocol (Hash_table *my_table, protocol_t variant);
+    ~Directory_protocol ();
+
+    bool has_E;
+    bool has_O;
+
+    MAP<paddr_t, Dir_write_miss> write_misses;
+
+    void process_cache_request (Hash_entry *entry, Mreq *request);
+    void process_snoop_request (Hash_entry *entry, const Mreq *request);
+    void dump (Hash_entry *entry);
+    bool process_eviction (Hash_entry *entry);
+    int permission (Hash_entry *entry);
+
+private:
+    void send_to_home (message_t msg, paddr_t addr);
+    void send_DATA_to_cache (paddr_t addr, ModuleID dest, int acks);
+    void send_INV_ACK (paddr_t addr, ModuleID dest);
+    void start_write_miss (Hash_entry *entry, paddr_t addr, Dir_cache_state_t next);
+    void check_write_complete (Hash_entry *entry, paddr_t addr);
+};
+
+#endif // _DIRECTORY_CACHE_H
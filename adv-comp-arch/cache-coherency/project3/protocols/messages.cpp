@@ -24,5 +24,16 @@ const char * Mreq::message_t_str[MREQ_MESSAGE_NUM] = {
 
     "DATA",
 
+    "PUTS",
+    "PUTM",
+
+    "DATA_E",
+    "FWD_GETS",
+    "FWD_GETM",
+    "INV",
+    "INV_ACK",
+    "PUT_ACK",
+    "UNBLOCK",
+
     "MREQ_INVALID"
 };
@@ -24,6 +24,18 @@ typedef enum
 
     DATA,
 
+    PUTS,
+    PUTM,
+
+    /** Directory protocols only.  */
+    DATA_E,
+    FWD_GETS,
+    FWD_GETM,
+    INV,
+    INV_ACK,
+    PUT_ACK,
+    UNBLOCK,
+
     MREQ_INVALID,
 	MREQ_MESSAGE_NUM	// Use this to make a Stat Array of message types
 } message_t;
@@ -2,19 +2,113 @@
 #include "../sim/sharers.h"
 #include "../sim/hash_table.h"
 #include "../sim/sim.h"
+#include "../sim/trace.h"
 
 extern Simulator * Sim;
 
-Protocol::Protocol (Hash_table *my_table, Hash_entry *my_entry)
+Protocol::Protocol (Hash_table *my_table, const Protocol_table *table)
 {
     this->my_table = my_table;
-    this->my_entry = my_entry;
+    this->table = table;
 }
 
 Protocol::~Protocol ()
 {
 }
 
+void Protocol::process_cache_request (Hash_entry *entry, Mreq *request)
+{
+    switch (request->msg) {
+    case LOAD:  transition (entry, EV_LOAD, request); break;
+    case STORE: transition (entry, EV_STORE, request); break;
+    default:
+        request->print_msg (my_table->moduleID, "ERROR");
+        fatal_error ("Client: %s state shouldn't see this message\n",
+                     table->state_names[entry->state]);
+    }
+}
+
+void Protocol::process_snoop_request (Hash_entry *entry, const Mreq *request)
+{
+    bool own = (request->src_mid == my_table->moduleID);
+
+    switch (request->msg) {
+    case GETS:  transition (entry, own ? EV_OWN_GETS : EV_GETS, request); break;
+    case GETM:  transition (entry, own ? EV_OWN_GETM : EV_GETM, request); break;
+    case DATA:  transition (entry, EV_DATA, request); break;
+    default:
+        request->print_msg (my_table->moduleID, "ERROR");
+        fatal_error ("Client: %s state shouldn't see this message\n",
+                     table->state_names[entry->state]);
+    }
+}
+
+/** One table lookup per event.  */
+void Protocol::transition (Hash_entry *entry, int event, const Mreq *request)
+{
+    const Transition *t = &table->t[entry->state][event];
+    unsigned char a = t->actions;
+
+    if (a & ACT_ERROR)
+    {
+        request->print_msg (my_table->moduleID, "ERROR");
+        fatal_error ("Client: %s state shouldn't see this message\n",
+                     table->state_names[entry->state]);
+    }
+
+    if (a & ACT_SHARED)
+        set_shared_line ();
+    if (a & ACT_DATA_BUS)
+        send_DATA_on_bus (request->addr, request->src_mid);
+    if (a & ACT_GETS)
+        send_GETS (request->addr);
+    if (a & ACT_GETM)
+        send_GETM (request->addr);
+    if (a & ACT_MISS)
+        my_table->cache_misses++;
+    if (a & ACT_UPGRADE)
+        my_table->silent_upgrades++;
+
+    if (t->next_shared && get_shared_line ())
+        entry->state = t->next_shared;
+    else if (t->next)
+        entry->state = t->next;
+
+    /** After the state change, so the request completes with the access
+     *  the line now grants.  */
+    if (a & ACT_DATA_PROC)
+        send_DATA_to_proc (request->addr);
+}
+
+int Protocol::permission (Hash_entry *entry)
+{
+    return table->perm[entry->state];
+}
+
+void Protocol::dump (Hash_entry *entry)
+{
+    fprintf (stderr, "%s - state: %s\n", table->name, table->state_names[entry->state]);
+}
+
+bool Protocol::process_eviction (Hash_entry *entry)
+{
+    switch (table->evict[entry->state]) {
+    case EVICT_CLEAN:
+        break;
+    case EVICT_PUTS:
+        send_PUTS (entry->tag);
+        break;
+    case EVICT_PUTM:
+        send_PUTM (entry->tag);
+        break;
+    default:
+        /* A request is still outstanding for this line */
+        return false;
+    }
+    entry->state = PROTOCOL_STATE_I;
+    return true;
+}
+
 void Protocol::send_GETM(paddr_t addr)
 {
 	/* Create a new message to send on the bus */
@@ -43,11 +137,11 @@ void Protocol::send_DATA_on_bus(paddr_t addr, ModuleID dest)
 	// When DATA is sent on the bus it _MUST_ have a destination module
 	new_request = new Mreq(DATA, addr, my_table->moduleID, dest);
 	/* Debug Message -- DO NOT REMOVE or you won't match the validation runs */
-	fprintf(stderr,"**** DATA_SEND Cache: %d -- Clock: %lld\n",my_table->moduleID.nodeID,Global_Clock);
+	trace_data_send (TRACE_DATA_SEND_CACHE, my_table->moduleID);
 	/* This will but the message in the bus' arbitration queue to sent */
 	this->my_table->write_to_bus(new_request);
 
-	Sim->cache_to_cache_transfers++;
+	my_table->cache_to_cache_transfers++;
 }
 
 void Protocol::send_DATA_to_proc(paddr_t addr)
@@ -63,6 +157,22 @@ void Protocol::send_DATA_to_proc(paddr_t addr)
 	this->my_table->write_to_proc(new_request);
 }
 
+void Protocol::send_PUTS(paddr_t addr)
+{
+	/* Clean eviction -- memory already has the data, this just tells it the line is gone */
+	Mreq * new_request;
+	new_request = new Mreq(PUTS,addr);
+	this->my_table->write_to_bus(new_request);
+}
+
+void Protocol::send_PUTM(paddr_t addr)
+{
+	/* Dirty eviction -- the writeback carries the data, so there is no reply phase */
+	Mreq * new_request;
+	new_request = new Mreq(PUTM,addr);
+	this->my_table->write_to_bus(new_request);
+}
+
 void Protocol::set_shared_line ()
 {
 	// Set the bus' shared line
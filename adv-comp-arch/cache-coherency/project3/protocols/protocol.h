@@ -5,36 +5,102 @@
 #include "../sim/mreq.h"
 
 class Hash_table;
+class Hash_entry;
 class Sharers;
 
-/** This is the base class for all Coherence Protocols
- * All of your protocols will inherit from this class
- */
+/** Every protocol numbers its states from 1 with I first; 0 is never a
+ *  valid state and means "no change" in a transition.  */
+#define PROTOCOL_STATE_I        1
+#define PROTOCOL_MAX_STATES     16
+
+/** What a line's state machine reacts to.  GETS/GETM are split on whether
+ *  this cache issued them, which is all the snooping protocols look at.  */
+typedef enum {
+    EV_LOAD = 0,
+    EV_STORE,
+    EV_GETS,
+    EV_GETM,
+    EV_DATA,
+    EV_OWN_GETS,
+    EV_OWN_GETM,
+    EV_NUM
+} protocol_event_t;
+
+/** Transition actions.  They touch different things (bus queue, shared
+ *  line, processor buffer, counters) so they run in a fixed order: bit
+ *  order, except that the processor is answered after the state change.  */
+#define ACT_SHARED          0x01    /** Raise the bus' shared line.  */
+#define ACT_DATA_BUS        0x02    /** Supply DATA to the requester.  */
+#define ACT_GETS            0x04
+#define ACT_GETM            0x08
+#define ACT_DATA_PROC       0x10    /** Complete the processor request.  */
+#define ACT_MISS            0x20
+#define ACT_UPGRADE         0x40    /** Silent E -> M.  */
+#define ACT_ERROR           0x80    /** Not a legal event in this state.  */
+
+/** What leaving the cache costs in each state.  */
+#define EVICT_BUSY          0       /** Request outstanding; cannot evict.  */
+#define EVICT_CLEAN         1
+#define EVICT_PUTS          2
+#define EVICT_PUTM          3
+
+/** Access a state grants the processor, for the invariant checker.
+ *  Transient states count as whatever copy they still hold.  */
+#define PERM_NONE           0
+#define PERM_READ           1
+#define PERM_WRITE          2
+
+class Transition {
+public:
+    unsigned char actions;
+    unsigned char next;
+    /** Taken instead of next when the shared line is up, e.g. IS -> S/E.  */
+    unsigned char next_shared;
+};
+
+/** Table shorthand.  */
+#define TR(a, n)                {(a), (n), 0}
+#define TR_IF_SHARED(a, n, s)   {(a), (n), (s)}
+#define TR_NOP                  {0, 0, 0}
+#define TR_ERR                  {ACT_ERROR, 0, 0}
+#define TR_ERR_ROW              {TR_ERR, TR_ERR, TR_ERR, TR_ERR, TR_ERR, TR_ERR, TR_ERR}
 
+/** A snooping protocol, written as data.  A new variant is a new table.  */
+class Protocol_table {
+public:
+    const char *name;
+    const char *state_names[PROTOCOL_MAX_STATES];
+    unsigned char evict[PROTOCOL_MAX_STATES];
+    unsigned char perm[PROTOCOL_MAX_STATES];
+    Transition t[PROTOCOL_MAX_STATES][EV_NUM];
+};
+
+/** Runs a cache's lines through its protocol table.  There is one per
+ *  cache; the line itself only carries its one-byte state.
+ */
 class Protocol
 {
 public:
 
 	/** This is a pointer to the cache the protocol belongs to */
     Hash_table *my_table;
-    /** This is a pointer to the cache entry the protocol was called on */
-    Hash_entry *my_entry;
+    const Protocol_table *table;
 
-    Protocol (Hash_table *my_table, Hash_entry *my_entry);
-    virtual ~Protocol();
+    Protocol (Hash_table *my_table, const Protocol_table *table);
+    ~Protocol();
 
-    /** This virtual function must be implemented by all children
-     * This function handles requests that come from the processor
+    /** Requests that come from the processor.  */
+    void process_cache_request (Hash_entry *entry, Mreq *request);
+    /** Requests that come from the bus.  */
+    void process_snoop_request (Hash_entry *entry, const Mreq *request);
+    /** Dumps the coherence state (Useful for debugging).  */
+    void dump (Hash_entry *entry);
+    /** Called when the line is picked as a replacement victim.  Returns
+     * false if the line is in a transient state and cannot leave the cache
+     * yet; otherwise it sends whatever PUTS/PUTM the state requires.
      */
-    virtual void process_cache_request (Mreq *request) =0;
-    /** This virtual function must be implemented by all children
-	 * This function handles requests that come from the bus
-	 */
-    virtual void process_snoop_request (Mreq *request) =0;
-    /** This virtual function must be implemented by all children
-	 * This function dumps the coherence state (Useful for debugging)
-	 */
-    virtual void dump (void) =0;  
+    bool process_eviction (Hash_entry *entry);
+    int permission (Hash_entry *entry);
 
     /** These helper functions are provided to you to make it easier to
      * interface with the processor and bus.
@@ -46,9 +112,14 @@ public:
     void send_GETS(paddr_t addr);
     void send_DATA_on_bus(paddr_t addr, ModuleID dest);
     void send_DATA_to_proc(paddr_t addr);
+    void send_PUTS(paddr_t addr);
+    void send_PUTM(paddr_t addr);
     /** These helper functions are for setting and getting the bus' shared line */
     void set_shared_line();
     bool get_shared_line();
+
+private:
+    void transition (Hash_entry *entry, int event, const Mreq *request);
 };
 
 #endif /* PROTOCOL_H_ */
@@ -1,12 +1,22 @@
 #include "bus.h"
 #include "mreq.h"
 
+extern Sim_settings settings;
+
 Bus::Bus()
 {
     current_request = NULL;
     data_reply = NULL;
     request_in_progress = false;
     shared_line = false;
+
+    split = settings.bus_split;
+    if (split)
+    {
+        transactions.resize (settings.bus_tags);
+        for (unsigned int i = 0; i < transactions.size (); i++)
+            transactions[i].valid = false;
+    }
 }
 
 Bus::~Bus()
@@ -15,6 +25,12 @@ Bus::~Bus()
 
 void Bus::tick()
 {
+	if (split)
+	{
+		tick_split ();
+		return;
+	}
+
 	if (current_request)
 		delete current_request;
 
@@ -36,7 +52,9 @@ void Bus::tick()
 		shared_line = false;
 	    current_request = pending_requests.front();
 	    pending_requests.pop_front();
-	    request_in_progress = true;
+	    /** Writebacks carry their data with them; there is no reply phase.  */
+	    request_in_progress = (current_request->msg != PUTS &&
+	                           current_request->msg != PUTM);
 	}
 	else
 	{
@@ -44,9 +62,91 @@ void Bus::tick()
 	}
 }
 
+/** Each cycle carries either one reply or one new request.  Replies win so
+ *  that tags are recycled as fast as possible.  */
+void Bus::tick_split()
+{
+	if (current_request)
+	{
+		/** Latch the snoop result for the address phase that just finished.  */
+		if (current_request->bus_tag >= 0 && current_request->msg != DATA)
+			transactions[current_request->bus_tag].shared = shared_line;
+		delete current_request;
+		current_request = NULL;
+	}
+
+	if (!data_replies.empty())
+	{
+		Bus_transaction *t;
+
+		current_request = data_replies.front();
+		data_replies.pop_front();
+
+		t = &transactions[current_request->bus_tag];
+		shared_line = t->shared;
+		t->valid = false;
+		tag_of.erase (t->addr);
+		return;
+	}
+
+	/** Oldest request whose line is not already in flight.  */
+	LIST<Mreq *>::iterator it;
+	for (it = pending_requests.begin (); it != pending_requests.end (); it++)
+	{
+		Mreq *request = *it;
+
+		if (tag_of.find (request->addr) != tag_of.end ())
+			continue;
+
+		if (request->msg != PUTS && request->msg != PUTM)
+		{
+			request->bus_tag = allocate_tag (request->addr);
+			if (request->bus_tag < 0)
+				return;
+		}
+
+		shared_line = false;
+		current_request = request;
+		pending_requests.erase (it);
+		return;
+	}
+}
+
+int Bus::allocate_tag (paddr_t addr)
+{
+	for (unsigned int i = 0; i < transactions.size (); i++)
+	{
+		if (!transactions[i].valid)
+		{
+			transactions[i].valid = true;
+			transactions[i].addr = addr;
+			transactions[i].supplied = false;
+			transactions[i].shared = false;
+			tag_of[addr] = i;
+			return i;
+		}
+	}
+	return -1;
+}
+
 bool Bus::bus_request(Mreq *request)
 {
-	if (request->msg == DATA)
+	if (request->msg == DATA && split)
+	{
+		MAP<paddr_t, int>::iterator it = tag_of.find (request->addr);
+
+		/** A late reply for a transaction someone else already answered.  */
+		if (it == tag_of.end () || transactions[it->second].supplied)
+		{
+			delete request;
+			return false;
+		}
+
+		transactions[it->second].supplied = true;
+		request->bus_tag = it->second;
+		data_replies.push_back (request);
+	}
+	else if (request->msg == DATA)
 	{
 		assert (data_reply == NULL);
 		data_reply = request;
@@ -59,18 +159,18 @@ bool Bus::bus_request(Mreq *request)
 	return true;
 }
 
-Mreq* Bus::bus_snoop()
+/** Every snooper sees the same in-flight request; it is owned by the bus
+ *  and released on the next tick.  */
+const Mreq* Bus::bus_snoop()
+{
+    return current_request;
+}
+
+bool Bus::is_supplied (paddr_t addr)
 {
-    Mreq *request;
+	if (!split)
+		return data_reply != NULL;
 
-    if (current_request)
-    {
-        request = new Mreq ();
-        *request = *current_request;
-        return request;
-    }
-    else
-    {
-        return NULL;
-    }
+	MAP<paddr_t, int>::iterator it = tag_of.find (addr);
+	return it != tag_of.end () && transactions[it->second].supplied;
 }
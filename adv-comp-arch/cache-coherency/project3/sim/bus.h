@@ -5,6 +5,17 @@
 
 class Mreq;
 
+/** One address-phase request waiting for its data on the split bus.  */
+class Bus_transaction {
+public:
+    bool valid;
+    paddr_t addr;
+    /** A DATA reply has been queued; later ones are dropped.  */
+    bool supplied;
+    /** Shared line as it stood at the end of the address phase.  */
+    bool shared;
+};
+
 class Bus{
 public:
     Bus();
@@ -20,11 +31,26 @@ public:
 
     bool shared_line;
 
+    /** Split-transaction mode.  Requests and replies are separate bus
+     *  transactions matched by tag, so several misses can be in flight at
+     *  once.  At most one transaction per line is in flight.  */
+    bool split;
+    VECTOR<Bus_transaction> transactions;
+    MAP<paddr_t, int> tag_of;
+    LIST <Mreq *>data_replies;
+
     void tick ();
 
     bool is_shared_active () { return shared_line; }
     bool bus_request (Mreq * request);
-    Mreq *bus_snoop();
+    const Mreq *bus_snoop();
+
+    /** True once some cache has answered the in-flight request for addr.  */
+    bool is_supplied (paddr_t addr);
+
+private:
+    void tick_split ();
+    int allocate_tag (paddr_t addr);
 };
 
 #endif
@@ -0,0 +1,284 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "directory.h"
+#include "network.h"
+#include "settings.h"
+#include "sim.h"
+#include "stress.h"
+#include "trace.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+/***************************************************************************
+ * Directory_entry constructor.
+ ***************************************************************************/
+Directory_entry::Directory_entry ()
+{
+    state = DIR_I;
+    busy = false;
+    wait_data = false;
+}
+
+/***************************************************************************
+ * Directory constructor, destructor, and functions.
+ ***************************************************************************/
+Directory::Directory (ModuleID moduleID, int dir_latency, int mem_latency, protocol_t protocol)
+    : Module (moduleID, "DIR_")
+{
+    this->dir_latency = dir_latency;
+    this->mem_latency = mem_latency;
+
+    switch (protocol) {
+    case MSI_PRO:   has_E = false; has_O = false; break;
+    case MESI_PRO:  has_E = true;  has_O = false; break;
+    case MOESI_PRO: has_E = true;  has_O = true;  break;
+    default:
+        fatal_error ("Directory: only MSI, MESI and MOESI have directory versions\n");
+    }
+}
+
+Directory::~Directory ()
+{
+    MAP<paddr_t, Directory_entry *>::iterator it;
+
+    for (it = entries.begin (); it != entries.end (); it++)
+        delete it->second;
+}
+
+Directory_entry *Directory::get_entry (paddr_t addr)
+{
+    MAP<paddr_t, Directory_entry *>::iterator it = entries.find (addr);
+
+    if (it != entries.end ())
+        return it->second;
+
+    return entries[addr] = new Directory_entry ();
+}
+
+void Directory::tick ()
+{
+    Directory_entry *entry;
+    Mreq *request;
+    LIST<Dir_send>::iterator it;
+
+    /** One message from the network per cycle.  */
+    request = Sim->net->receive (moduleID);
+    if (request)
+    {
+        trace_request (TRACE_DIR_REQUEST, moduleID, request);
+        entry = get_entry (request->addr);
+
+        switch (request->msg) {
+        case UNBLOCK:
+            assert (entry->busy);
+            entry->busy = false;
+            release (entry, request->addr);
+            delete request;
+            break;
+        case DATA:
+            /** Owner's copy on an E/M -> S downgrade; memory is now current.  */
+            assert (entry->wait_data);
+            entry->wait_data = false;
+            if (Sim->checker)
+                Sim->checker->memory_write (request);
+            release (entry, request->addr);
+            delete request;
+            break;
+        default:
+            if (entry->busy || entry->wait_data || !entry->waiting.empty ())
+            {
+                entry->waiting.push_back (request);
+            }
+            else
+            {
+                process_request (entry, request);
+                delete request;
+            }
+        }
+    }
+
+    /** Lines that just unblocked drain their queue up to the next blocking
+     *  request.  */
+    if (!ready_lines.empty ())
+    {
+        entry = get_entry (ready_lines.front ());
+        ready_lines.pop_front ();
+
+        while (!entry->busy && !entry->wait_data && !entry->waiting.empty ())
+        {
+            request = entry->waiting.front ();
+            entry->waiting.pop_front ();
+            process_request (entry, request);
+            delete request;
+        }
+    }
+
+    for (it = outbox.begin (); it != outbox.end (); )
+    {
+        if (it->time <= Global_Clock)
+        {
+            Sim->net->send (it->msg);
+            it = outbox.erase (it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+/** The line's transaction is over once the requester has unblocked it and
+ *  any copy owed to memory has arrived.  */
+void Directory::release (Directory_entry *entry, paddr_t addr)
+{
+    if (!entry->busy && !entry->wait_data && !entry->waiting.empty ())
+        ready_lines.push_back (addr);
+}
+
+void Directory::tock ()
+{
+    fatal_error ("Directory tock should never be called!\n");
+}
+
+void Directory::send (message_t msg, paddr_t addr, int dest_node, ModuleID fwd_mid,
+                      int acks, int delay)
+{
+    Dir_send s;
+
+    s.msg = new Mreq (msg, addr, moduleID, (ModuleID){dest_node, L1_M});
+    s.msg->fwd_mid = fwd_mid;
+    s.msg->INV_ACK_count = acks;
+    if ((msg == DATA || msg == DATA_E) && Sim->checker)
+        s.msg->data_version = Sim->checker->memory_version (addr);
+    s.time = Global_Clock + delay;
+    outbox.push_back (s);
+}
+
+/** Invalidate every sharer but the requester and except.  Returns the
+ *  number of INV_ACKs the requester has to collect.  */
+int Directory::invalidate_sharers (Directory_entry *entry, Mreq *request, int except)
+{
+    int acks = 0;
+
+    for (int i = 0; i < settings.num_nodes; i++)
+    {
+        if (!entry->sharers.is_sharer (i) || i == request->src_mid.nodeID || i == except)
+            continue;
+
+        send (INV, request->addr, i, request->src_mid, 0, dir_latency);
+        acks++;
+    }
+    entry->sharers.clear_sharers ();
+    return acks;
+}
+
+void Directory::process_request (Directory_entry *entry, Mreq *request)
+{
+    int req = request->src_mid.nodeID;
+    int owner = entry->sharers.get_owner ();
+    ModuleID none = (ModuleID){-1,INVALID_M};
+    int acks;
+
+    switch (request->msg) {
+    case GETS:
+        entry->busy = true;
+        switch (entry->state) {
+        case DIR_I:
+            if (has_E)
+            {
+                send (DATA_E, request->addr, req, none, 0, dir_latency + mem_latency);
+                entry->state = DIR_EM;
+                entry->sharers.set_owner (req);
+            }
+            else
+            {
+                send (DATA, request->addr, req, none, 0, dir_latency + mem_latency);
+                entry->state = DIR_S;
+                entry->sharers.add_sharer (req);
+            }
+            break;
+        case DIR_S:
+            send (DATA, request->addr, req, none, 0, dir_latency + mem_latency);
+            entry->sharers.add_sharer (req);
+            break;
+        case DIR_EM:
+            send (FWD_GETS, request->addr, owner, request->src_mid, 0, dir_latency);
+            entry->sharers.add_sharer (req);
+            if (has_O)
+            {
+                entry->state = DIR_O;
+            }
+            else
+            {
+                entry->state = DIR_S;
+                entry->sharers.add_sharer (owner);
+                entry->sharers.clear_owner ();
+                entry->wait_data = true;
+            }
+            break;
+        case DIR_O:
+            send (FWD_GETS, request->addr, owner, request->src_mid, 0, dir_latency);
+            entry->sharers.add_sharer (req);
+            break;
+        }
+        break;
+
+    case GETM:
+        entry->busy = true;
+        switch (entry->state) {
+        case DIR_I:
+            send (DATA, request->addr, req, none, 0, dir_latency + mem_latency);
+            break;
+        case DIR_S:
+            acks = invalidate_sharers (entry, request, -1);
+            send (DATA, request->addr, req, none, acks, dir_latency + mem_latency);
+            break;
+        case DIR_EM:
+            assert (owner != req);
+            send (FWD_GETM, request->addr, owner, request->src_mid, 0, dir_latency);
+            break;
+        case DIR_O:
+            acks = invalidate_sharers (entry, request, owner);
+            if (owner == req)
+                send (DATA, request->addr, req, none, acks, dir_latency);
+            else
+                send (FWD_GETM, request->addr, owner, request->src_mid, acks, dir_latency);
+            break;
+        }
+        entry->state = DIR_EM;
+        entry->sharers.clear_sharers ();
+        entry->sharers.set_owner (req);
+        break;
+
+    case PUTS:
+    case PUTM:
+        /** The PUT may have raced with a forwarded request that already
+         *  demoted the evicting core to a sharer, or handed the line to
+         *  someone else altogether; in that case it is only acked.  */
+        if (owner == req)
+        {
+            entry->state = entry->sharers.num_sharers () ? DIR_S : DIR_I;
+            entry->sharers.clear_owner ();
+            if (request->msg == PUTM)
+            {
+                Sim->writebacks++;
+                if (Sim->checker)
+                    Sim->checker->memory_write (request);
+            }
+        }
+        else if (entry->sharers.is_sharer (req))
+        {
+            entry->sharers.remove_sharer (req);
+            if (entry->state == DIR_S && entry->sharers.num_sharers () == 0)
+                entry->state = DIR_I;
+        }
+        send (PUT_ACK, request->addr, req, none, 0, dir_latency);
+        break;
+
+    default:
+        request->print_msg (moduleID, "ERROR");
+        fatal_error ("Directory: unexpected request\n");
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef DIRECTORY_H_
+#define DIRECTORY_H_
+
+#include "enums.h"
+#include "module.h"
+#include "mreq.h"
+#include "sharers.h"
+#include "types.h"
+
+using namespace std;
+
+/** Home node states.  EM is a single owner that may be dirty; O is a dirty
+ *  owner plus clean sharers (MOESI only).  */
+typedef enum {
+    DIR_I = 1,
+    DIR_S,
+    DIR_EM,
+    DIR_O
+} dir_state_t;
+
+class Directory_entry {
+public:
+    Directory_entry ();
+
+    dir_state_t state;
+    Sharers sharers;
+
+    /** Blocking directory: one transaction per line at a time, held until
+     *  the requester sends UNBLOCK.  Later requests queue here.  */
+    bool busy;
+    LIST<Mreq *> waiting;
+
+    /** Without an O state a read of an owned line also waits for the
+     *  owner's copy, or memory could still serve the old data.  */
+    bool wait_data;
+};
+
+/** A message leaving the home after the directory or DRAM latency.  */
+class Dir_send {
+public:
+    timestamp_t time;
+    Mreq *msg;
+};
+
+/**
+ * Home directory slice.  Every node holds one; lines are spread over the
+ * slices by Simulator::get_home().  Speaks MSI, MESI or MOESI depending on
+ * whether exclusive-clean and owned states are enabled.
+ */
+class Directory : public Module {
+public:
+    Directory (ModuleID moduleID, int dir_latency, int mem_latency, protocol_t protocol);
+    ~Directory ();
+
+    int dir_latency;
+    int mem_latency;
+    bool has_E;
+    bool has_O;
+
+    MAP<paddr_t, Directory_entry *> entries;
+    LIST<paddr_t> ready_lines;
+    LIST<Dir_send> outbox;
+
+    void tick ();
+    void tock ();
+
+private:
+    Directory_entry *get_entry (paddr_t addr);
+    void process_request (Directory_entry *entry, Mreq *request);
+    void release (Directory_entry *entry, paddr_t addr);
+    int invalidate_sharers (Directory_entry *entry, Mreq *request, int except);
+    void send (message_t msg, paddr_t addr, int dest_node, ModuleID fwd_mid,
+               int acks, int delay);
+};
+
+#endif /* DIRECTORY_H_ */
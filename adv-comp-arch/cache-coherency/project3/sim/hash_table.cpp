@@ -10,14 +10,19 @@
 #include "../protocols/MOSI_protocol.h"
 #include "../protocols/MOESI_protocol.h"
 #include "../protocols/MOESIF_protocol.h"
+#include "../protocols/directory_protocol.h"
+#include "network.h"
 #include "settings.h"
 #include "sharers.h"
 #include "sim.h"
 #include "types.h"
 #include "processor.h"
+#include "stress.h"
+#include "trace.h"
 
 using namespace std;
 
+extern Sim_settings settings;
 extern Simulator *Sim;
 
 /***************************************************************************
@@ -27,52 +32,62 @@ Hash_entry::Hash_entry (Hash_table *t, paddr_t tag)
 {
     this->my_table = t;
     this->tag = tag;
-
-    switch (my_table->protocol) {
-    case MI_PRO:
-        protocol = new MI_protocol (my_table, this);
-        break;
-    case MSI_PRO:
-    	protocol = new MSI_protocol (my_table, this);
-    	break;
-    case MESI_PRO:
-    	protocol = new MESI_protocol (my_table, this);
-    	break;
-    case MOSI_PRO:
-    	protocol = new MOSI_protocol (my_table, this);
-    	break;
-    case MOESI_PRO:
-    	protocol = new MOESI_protocol (my_table, this);
-    	break;
-    case MOESIF_PRO:
-    	protocol = new MOESIF_protocol (my_table, this);
-    	break;
-    default:
-        fatal_error ("Hash_entry: Unknown coherence protocol!\n");
-    }
+    this->lru_stamp = 0;
+    this->state = PROTOCOL_STATE_I;
 }
 
 Hash_entry::~Hash_entry (void)
 {
 }
 
-void Hash_entry::process_request_snoop (Mreq *request)
+void Hash_entry::process_request_snoop (const Mreq *request)
 {
-    assert (protocol);
     assert (request);
 
-    protocol->process_snoop_request (request);
+    if (Sim->checker)
+        Sim->checker->note (tag);
+
+    if (my_table->dir_protocol)
+        my_table->dir_protocol->process_snoop_request (this, request);
+    else
+        my_table->snoop_protocol->process_snoop_request (this, request);
 }
 
 void Hash_entry::process_request_processor (Mreq *request)
 {
-    protocol->process_cache_request (request);
+    if (Sim->checker)
+        Sim->checker->note (tag);
+
+    if (my_table->dir_protocol)
+        my_table->dir_protocol->process_cache_request (this, request);
+    else
+        my_table->snoop_protocol->process_cache_request (this, request);
+}
+
+bool Hash_entry::process_eviction (void)
+{
+    if (Sim->checker)
+        Sim->checker->note (tag);
+
+    if (my_table->dir_protocol)
+        return my_table->dir_protocol->process_eviction (this);
+    return my_table->snoop_protocol->process_eviction (this);
+}
+
+int Hash_entry::permission (void)
+{
+    if (my_table->dir_protocol)
+        return my_table->dir_protocol->permission (this);
+    return my_table->snoop_protocol->permission (this);
 }
 
 void Hash_entry::dump (void)
 {
     fprintf (stderr, "Addr: 0x%llx ", (unsigned long long)tag);
-    protocol->dump ();
+    if (my_table->dir_protocol)
+        my_table->dir_protocol->dump (this);
+    else
+        my_table->snoop_protocol->dump (this);
 }
 
 /***************************************************************************
@@ -80,7 +95,7 @@ void Hash_entry::dump (void)
  ***************************************************************************/
 Hash_table::Hash_table (ModuleID moduleID, const char *name,
                         int size, int assoc, int blocksize, int mshrs,
-                        int hit_time, protocol_t protocol)
+                        int hit_time, protocol_t protocol, bool infinite)
 	: Module (moduleID, name)
 {
     /** Sanity check.  */
@@ -102,7 +117,27 @@ Hash_table::Hash_table (ModuleID moduleID, const char *name,
     this->mshrs = mshrs;
     this->hit_time = hit_time;
     this->protocol = protocol;
+    this->infinite = infinite;
 
+    snoop_protocol = NULL;
+    dir_protocol = NULL;
+    if (settings.dir_enabled)
+    {
+        dir_protocol = new Directory_protocol (this, protocol);
+    }
+    else
+    {
+        switch (protocol) {
+        case MI_PRO:     snoop_protocol = new Protocol (this, &MI_table); break;
+        case MSI_PRO:    snoop_protocol = new Protocol (this, &MSI_table); break;
+        case MESI_PRO:   snoop_protocol = new Protocol (this, &MESI_table); break;
+        case MOSI_PRO:   snoop_protocol = new Protocol (this, &MOSI_table); break;
+        case MOESI_PRO:  snoop_protocol = new Protocol (this, &MOESI_table); break;
+        case MOESIF_PRO: snoop_protocol = new Protocol (this, &MOESIF_table); break;
+        default:
+            fatal_error ("Hash_table: Unknown coherence protocol!\n");
+        }
+    }
 
     /** Calculate tag and index masks once.  */
     num_index_bits = (int) log2 (sets);
@@ -119,12 +154,41 @@ Hash_table::Hash_table (ModuleID moduleID, const char *name,
     index_mask = index_mask & ~tag_mask;
 
     my_entries.clear ();
+    proc_request = NULL;
+
+    cache_misses = 0;
+    cache_accesses = 0;
+    silent_upgrades = 0;
+    cache_to_cache_transfers = 0;
+    evictions = 0;
+
+    ways = NULL;
+    lru_clock = 0;
+    if (!infinite)
+    {
+        ways = new Hash_entry*[sets * assoc];
+        for (int i = 0; i < sets * assoc; i++)
+            ways[i] = NULL;
+    }
 }
 
 /** Destructor.  */
 Hash_table::~Hash_table (void)
 {
+    MAP<paddr_t, Hash_entry*>::iterator it;
+
+    for (it = my_entries.begin (); it != my_entries.end (); it++)
+        delete it->second;
+
+    if (ways)
+    {
+        for (int i = 0; i < sets * assoc; i++)
+            delete ways[i];
+        delete [] ways;
+    }
 
+    delete snoop_protocol;
+    delete dir_protocol;
 }
 
 /*****************************
@@ -132,37 +196,241 @@ Hash_table::~Hash_table (void)
  *****************************/
 void Hash_table::tick (void)
 {
-    Mreq *request;
-    Hash_entry *entry;
+    retry_blocked ();
+    accept_proc_request ();
+    tick_remote ();
+    replay_mshrs ();
+}
+
+void Hash_table::tick_local (void)
+{
+    retry_blocked ();
+    accept_proc_request ();
+    replay_mshrs ();
+}
+
+void Hash_table::tick_remote (void)
+{
+    const Mreq *request;
+
+    /** Request from bus, or the next message off the network.  */
+    if (Sim->net)
+    {
+        Mreq *msg = Sim->net->receive (moduleID);
+        if (msg)
+        {
+            process_network (msg);
+            delete msg;
+        }
+    }
+    else
+    {
+        request = read_input_port ();
+        if (request)
+            process_snoop (request);
+    }
+}
 
-    /** Request from processor.  */
+/** Requests that found their set full of lines still waiting on the bus.  */
+void Hash_table::retry_blocked (void)
+{
+    if (!blocked_requests.empty ())
+    {
+        LIST<Mreq *> retry;
+
+        retry.swap (blocked_requests);
+        for (LIST<Mreq *>::iterator it = retry.begin (); it != retry.end (); it++)
+            service_request (*it);
+    }
+}
+
+/** Request from processor.  */
+void Hash_table::accept_proc_request (void)
+{
     if (proc_request)
     {
-    	fprintf(stderr,"** PROC REQUEST -- ");
-    	proc_request->print_msg (moduleID, NULL);
-    	Sim->cache_accesses++;
-        entry = get_entry (proc_request->addr);
-        assert (entry);
-        entry->process_request_processor (proc_request);
-        delete proc_request;
+    	trace_request (TRACE_PROC_REQUEST, moduleID, proc_request);
+    	cache_accesses++;
+        start_request (proc_request);
         proc_request = NULL;
     }
+}
+
+/** Secondary misses whose line just finished its previous request.  */
+void Hash_table::replay_mshrs (void)
+{
+    if (!mshr_ready.empty ())
+    {
+        LIST<paddr_t> ready;
+
+        ready.swap (mshr_ready);
+        for (LIST<paddr_t>::iterator it = ready.begin (); it != ready.end (); it++)
+        {
+            LIST<Mreq *> &waiting = mshr_table[*it];
+            Mreq *next = waiting.front ();
+
+            waiting.pop_front ();
+            service_request (next);
+        }
+    }
+}
 
-    /** Request from bus.  */
-    request = read_input_port ();
-    if (request)
+void Hash_table::process_snoop (const Mreq *request)
+{
+    Hash_entry *entry;
+
+    if (request->msg == DATA && request->dest_mid != this->moduleID)
     {
-    	if (request->msg == DATA && request->dest_mid != this->moduleID)
-    	{
-    		return;
-    	}
+        return;
+    }
+
+    trace_request (TRACE_SNOOP_REQUEST, moduleID, request);
 
-    	fprintf(stderr,"*** SNOOP REQUEST -- ");
-        request->print_msg (moduleID, NULL);
-        entry = get_entry (request->addr);
-        assert (entry);
+    if (request->msg == DATA && Sim->checker)
+        Sim->checker->fill (moduleID.nodeID, request);
+
+    /** Writebacks need no action from the other caches.  */
+    if (request->msg == PUTS || request->msg == PUTM)
+    {
+        if (request->src_mid == moduleID)
+            pending_writebacks.erase (request->addr);
+        return;
+    }
+
+    /** A finite cache does not allocate lines for other cores' traffic.  */
+    entry = infinite ? get_entry (request->addr) : find_entry (request->addr);
+    if (entry)
         entry->process_request_snoop (request);
+    else if (!pending_writebacks.empty ())
+        snoop_writeback (request);
+}
+
+void Hash_table::process_network (const Mreq *request)
+{
+    Hash_entry *entry;
+
+    trace_request (TRACE_NETWORK_REQUEST, moduleID, request);
+
+    if ((request->msg == DATA || request->msg == DATA_E) && Sim->checker)
+        Sim->checker->fill (moduleID.nodeID, request);
+
+    if (pending_writebacks.find (request->addr) != pending_writebacks.end ())
+    {
+        network_writeback (request);
+        return;
     }
+
+    /** Every message is for a line this cache asked for or still holds.  */
+    entry = find_entry (request->addr);
+    if (!entry)
+    {
+        request->print_msg (moduleID, "ERROR");
+        fatal_error ("%s - network message for a line that is not resident\n", name);
+    }
+    entry->process_request_snoop (request);
+}
+
+/** The home keeps forwarding to an evicted line until it has seen the PUT,
+ *  so the writeback buffer answers for it until the PUT_ACK comes back.  */
+void Hash_table::network_writeback (const Mreq *request)
+{
+    Mreq *reply;
+
+    switch (request->msg) {
+    case FWD_GETS:
+    case FWD_GETM:
+        reply = new Mreq (DATA, request->addr, moduleID, request->fwd_mid);
+        reply->INV_ACK_count = request->INV_ACK_count;
+        trace_data_send (TRACE_DATA_SEND_CACHE, moduleID);
+        write_to_net (reply);
+        cache_to_cache_transfers++;
+
+        /** Same as a resident owner: without O the home waits for memory's
+         *  copy before the line moves on.  */
+        if (request->msg == FWD_GETS && !dir_protocol->has_O)
+        {
+            reply = new Mreq (DATA, request->addr, moduleID, request->src_mid);
+            trace_data_send (TRACE_DATA_SEND_CACHE, moduleID);
+            write_to_net (reply);
+        }
+        break;
+    case INV:
+        reply = new Mreq (INV_ACK, request->addr, moduleID, request->fwd_mid);
+        write_to_net (reply);
+        break;
+    case PUT_ACK:
+        pending_writebacks.erase (request->addr);
+        break;
+    default:
+        request->print_msg (moduleID, "ERROR");
+        fatal_error ("%s - unexpected message for a line being written back\n", name);
+    }
+}
+
+/** The protocols cannot take a second processor request for a line that is
+ *  in a transient state, so later requests to a busy line queue behind it.  */
+void Hash_table::start_request (Mreq *request)
+{
+    MAP<paddr_t, LIST<Mreq *> >::iterator it = mshr_table.find (request->addr);
+
+    if (it != mshr_table.end ())
+    {
+        it->second.push_back (request);
+        return;
+    }
+
+    mshr_table[request->addr];
+    service_request (request);
+}
+
+void Hash_table::service_request (Mreq *request)
+{
+    Hash_entry *entry;
+
+    /** In directory mode a line cannot be refetched until its PUT is acked.  */
+    if (Sim->net && pending_writebacks.find (request->addr) != pending_writebacks.end ())
+    {
+        blocked_requests.push_back (request);
+        return;
+    }
+
+    entry = get_entry (request->addr);
+    if (!entry)
+    {
+        blocked_requests.push_back (request);
+        return;
+    }
+
+    if (Sim->checker)
+        Sim->checker->request (moduleID.nodeID, request);
+
+    entry->process_request_processor (request);
+    delete request;
+}
+
+/** An evicted dirty line is still the only valid copy until its PUTM is on
+ *  the bus, so the writeback buffer answers for it in the meantime.  */
+void Hash_table::snoop_writeback (const Mreq *request)
+{
+    if (request->src_mid == moduleID ||
+        (request->msg != GETS && request->msg != GETM))
+        return;
+
+    if (pending_writebacks.find (request->addr) == pending_writebacks.end ())
+        return;
+
+    Mreq *data = new Mreq (DATA, request->addr, moduleID, request->src_mid);
+    trace_data_send (TRACE_DATA_SEND_CACHE, moduleID);
+    write_to_bus (data);
+    cache_to_cache_transfers++;
+
+    /** The requester now holds the data, and may consider itself the owner;
+     *  memory took the same DATA off the bus.  The PUTM still in the queue
+     *  would write that data back over whatever the line has become by the
+     *  time it goes by, so it is demoted to a PUTS that carries none.  */
+    MAP<paddr_t, Mreq *>::iterator it = pending_writebacks.find (request->addr);
+    it->second->msg = PUTS;
+    pending_writebacks.erase (it);
 }
 
 /** Request sent from processor.  */
@@ -183,7 +451,18 @@ void Hash_table::tock (void)
 Hash_entry* Hash_table::get_entry (paddr_t addr)
 {
     MAP<paddr_t, Hash_entry*>::iterator it;
-    
+    Hash_entry *entry;
+
+    if (!infinite)
+    {
+        entry = find_entry (addr);
+        if (!entry)
+            entry = allocate_entry (addr);
+        if (entry)
+            entry->lru_stamp = ++lru_clock;
+        return entry;
+    }
+
     it = my_entries.find (addr);
     if (it == my_entries.end ())
     {
@@ -192,14 +471,87 @@ Hash_entry* Hash_table::get_entry (paddr_t addr)
     return my_entries[addr];
 }
 
+/** Lookup without allocation.  Returns NULL if the line is not resident.  */
+Hash_entry* Hash_table::find_entry (paddr_t addr)
+{
+    MAP<paddr_t, Hash_entry*>::iterator it;
+
+    if (infinite)
+    {
+        it = my_entries.find (addr);
+        return it == my_entries.end () ? NULL : it->second;
+    }
+
+    Hash_entry **set = &ways[((addr & index_mask) >> num_offset_bits) * assoc];
+    for (int i = 0; i < assoc; i++)
+        if (set[i] && set[i]->tag == addr)
+            return set[i];
+
+    return NULL;
+}
+
+/** Fill a way for addr, evicting the least recently used line that is not
+ *  waiting on the bus.  The victim's protocol issues its own PUTS/PUTM.
+ *  Returns NULL if every way has a request outstanding.  */
+Hash_entry* Hash_table::allocate_entry (paddr_t addr)
+{
+    Hash_entry **set = &ways[((addr & index_mask) >> num_offset_bits) * assoc];
+    VECTOR<bool> tried (assoc, false);
+    int way = -1;
+
+    for (int i = 0; i < assoc; i++)
+    {
+        if (set[i] == NULL)
+        {
+            way = i;
+            break;
+        }
+    }
+
+    while (way < 0)
+    {
+        int victim = -1;
+
+        for (int i = 0; i < assoc; i++)
+            if (!tried[i] && (victim < 0 || set[i]->lru_stamp < set[victim]->lru_stamp))
+                victim = i;
+
+        if (victim < 0)
+            return NULL;
+
+        tried[victim] = true;
+        if (set[victim]->process_eviction ())
+        {
+            delete set[victim];
+            set[victim] = NULL;
+            evictions++;
+            way = victim;
+        }
+    }
+
+    set[way] = new Hash_entry (this, addr);
+    return set[way];
+}
+
 bool Hash_table::write_to_proc (Mreq *mreq)
 {
 	Processor * pr = (Processor*)Sim->get_PR(moduleID.nodeID);
 	mreq->src_mid = moduleID;
 
-	assert (!pr->inbound_request_buf);
+	pr->inbound_request_buf.push_back (mreq);
+
+	if (Sim->checker)
+		Sim->checker->complete (moduleID.nodeID, mreq->addr);
 
-	pr->inbound_request_buf = mreq;
+	/** This completes the request at the head of the line's MSHR.  */
+	MAP<paddr_t, LIST<Mreq *> >::iterator it = mshr_table.find (mreq->addr);
+	if (it != mshr_table.end ())
+	{
+		if (it->second.empty ())
+			mshr_table.erase (it);
+		else
+			mshr_ready.push_back (mreq->addr);
+	}
 
 	return true;
 }
@@ -207,9 +559,57 @@ bool Hash_table::write_to_proc (Mreq *mreq)
 bool Hash_table::write_to_bus (Mreq *mreq)
 {
 	mreq->src_mid = moduleID;
+	if (mreq->msg == PUTM)
+		pending_writebacks[mreq->addr] = mreq;
+	if ((mreq->msg == DATA || mreq->msg == PUTS || mreq->msg == PUTM) && Sim->checker)
+		Sim->checker->cache_send (moduleID.nodeID, mreq);
+	return send_message (mreq);
+}
+
+bool Hash_table::write_to_net (Mreq *mreq)
+{
+	mreq->src_mid = moduleID;
+	if (mreq->msg == PUTS || mreq->msg == PUTM)
+		pending_writebacks[mreq->addr] = NULL;
+	if ((mreq->msg == DATA || mreq->msg == PUTS || mreq->msg == PUTM) && Sim->checker)
+		Sim->checker->cache_send (moduleID.nodeID, mreq);
+	return send_message (mreq);
+}
+
+/** Hand a message to the bus or network, or hold it while a quantum worker
+ *  is running this cache ahead of the interconnect.  */
+bool Hash_table::send_message (Mreq *mreq)
+{
+	if (Sim->quantum_bound)
+	{
+		deferred_sends.push_back (mreq);
+		return true;
+	}
+
+	if (Sim->net)
+	{
+		Sim->net->send (mreq);
+		return true;
+	}
 	return this->write_output_port(mreq);
 }
 
+/** Post the held messages sent before the given cycle; this is when the
+ *  bus or network would have picked them up in lock-step.  */
+void Hash_table::post_deferred (timestamp_t before)
+{
+	while (!deferred_sends.empty () && deferred_sends.front ()->req_time < before)
+	{
+		Mreq *mreq = deferred_sends.front ();
+
+		deferred_sends.pop_front ();
+		if (Sim->net)
+			Sim->net->send (mreq);
+		else
+			write_output_port (mreq);
+	}
+}
+
 /********
  * Debug.
  ********/
@@ -217,7 +617,7 @@ void Hash_table::dump_hash_entry (paddr_t addr)
 {
     Hash_entry *entry;
 
-    entry = get_entry (addr);
+    entry = find_entry (addr);
     if (entry)
         entry->dump ();
 }
@@ -233,11 +633,26 @@ void Hash_table::dump_hash_table ()
 		it->second->dump();
 	}
 
+	if (ways)
+	{
+		for (int i = 0; i < sets * assoc; i++)
+			if (ways[i])
+				ways[i]->dump();
+	}
+
 }
 
 void Hash_table::print_config (void)
 {
     fprintf (stderr, "%s CONFIGURATION\n", name);
     fprintf (stderr, " blocksize:         %d bytes\n", blocksize);
+    if (infinite)
+        fprintf (stderr, " size:              infinite\n");
+    else
+    {
+        fprintf (stderr, " size:              %d bytes\n", size);
+        fprintf (stderr, " assoc:             %d\n", assoc);
+        fprintf (stderr, " sets:              %d\n", sets);
+    }
 }
 
@@ -20,15 +20,25 @@ public:
     Hash_table *my_table;
     paddr_t tag;
 
-    Protocol *protocol;
+    /** Replacement stamp, bumped on every processor access.  */
+    counter_t lru_stamp;
 
-    void process_request_snoop (Mreq *request);
+    /** Coherence state; the cache's Protocol gives it meaning.  */
+    unsigned char state;
+
+    void process_request_snoop (const Mreq *request);
     void process_request_processor (Mreq *request);
+    bool process_eviction (void);
+
+    /** PERM_NONE, PERM_READ or PERM_WRITE in the current state.  */
+    int permission (void);
 
     /** Debug.  */
     void dump ();
 };
 
+class Directory_protocol;
+
 class Hash_table: public Module {
 public:
     /** Parameters.  */
@@ -39,6 +49,11 @@ public:
     int mshrs;
     int hit_time;
     protocol_t protocol;
+    bool infinite;
+
+    /** One of these runs every line; the other is NULL.  */
+    Protocol *snoop_protocol;
+    Directory_protocol *dir_protocol;
 
     /** Masks for tag, index.  */
     int num_index_bits;
@@ -48,17 +63,56 @@ public:
 
     Mreq *proc_request;
 
-    /** Table divided into sets which house the individual entries, indexed with index bits.  */
+    /** Infinite table: every address ever touched, never evicted.  */
     MAP<paddr_t, Hash_entry*> my_entries;
     Hash_entry* null_entry;
 
+    /** Finite table: sets * assoc ways, indexed with index bits.  NULL is an empty way.  */
+    Hash_entry **ways;
+    counter_t lru_clock;
+
+    /** Dirty lines that have been evicted but whose PUTM has not reached the
+     *  bus, with the queued PUTM; in directory mode, any evicted line whose
+     *  PUT is not yet acked (the PUT itself is already in the network).  */
+    MAP<paddr_t, Mreq *> pending_writebacks;
+
+    /** One MSHR per line with a processor request in progress, holding the
+     *  requests that arrived for the line after it.  */
+    MAP<paddr_t, LIST<Mreq *> > mshr_table;
+    LIST<paddr_t> mshr_ready;
+    LIST<Mreq *> blocked_requests;
+
+    /** Bus/network messages sent while a quantum worker owns this cache,
+     *  posted by the serial phase in send order.  */
+    LIST<Mreq *> deferred_sends;
+
+    /** Statistics, summed over the caches by Simulator::dump_stats ().  Kept
+     *  per cache so that quantum workers never share a counter.  */
+    unsigned long int cache_misses;
+    unsigned long int cache_accesses;
+    unsigned long int silent_upgrades;
+    unsigned long int cache_to_cache_transfers;
+    unsigned long int evictions;
+
     /** Internal helper functions.  */
     Hash_entry* get_entry (paddr_t addr);
+    Hash_entry* find_entry (paddr_t addr);
+    Hash_entry* allocate_entry (paddr_t addr);
+    void snoop_writeback (const Mreq *request);
+    void process_snoop (const Mreq *request);
+    void process_network (const Mreq *request);
+    void network_writeback (const Mreq *request);
+    void start_request (Mreq *request);
+    void service_request (Mreq *request);
+    void retry_blocked (void);
+    void accept_proc_request (void);
+    void replay_mshrs (void);
+    bool send_message (Mreq *mreq);
 
 public:
     Hash_table (ModuleID moduleID, const char *name,
                 int size, int assoc, int blocksize, int mshrs,
-                int hit_time, protocol_t protocol);
+                int hit_time, protocol_t protocol, bool infinite);
                 
     ~Hash_table (void);
 
@@ -66,10 +120,17 @@ public:
 
     bool write_to_proc (Mreq *mreq);
     bool write_to_bus (Mreq *mreq);
+    bool write_to_net (Mreq *mreq);
 
     void tick (void);
     void tock (void);
 
+    /** tick () split for the quantum engine: the processor side runs on a
+     *  worker, the bus/network side in the serial phase.  */
+    void tick_local (void);
+    void tick_remote (void);
+    void post_deferred (timestamp_t before);
+
     /** Debug.  */
     void print_config (void);
     void dump_hash_entry (paddr_t addr);
@@ -1,12 +1,17 @@
 
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <unistd.h>
 
 #include "sim.h"
 #include "settings.h"
+#include "stress.h"
+#include "trace.h"
+#include "trace_reader.h"
 
 Sim_settings settings;
 
@@ -19,7 +24,23 @@ void usage (void)
 {
     fprintf (stderr, "Usage:\n");
     fprintf (stderr, "\t-p <protocol> (choices MI, MSI, MESI)\n");
-    fprintf (stderr, "\t-t <trace directory>\n\n");
+    fprintf (stderr, "\t-t <trace directory>\n");
+    fprintf (stderr, "\t-s <L1 size in bytes> (default: infinite)\n");
+    fprintf (stderr, "\t-a <L1 associativity>\n");
+    fprintf (stderr, "\t-b (split-transaction bus)\n");
+    fprintf (stderr, "\t-m <MSHRs per core> (split bus only)\n");
+    fprintf (stderr, "\t-n <memory banks> (split bus only)\n");
+    fprintf (stderr, "\t-d (directory over a mesh; MSI, MESI, MOESI)\n");
+    fprintf (stderr, "\t-q <quantum in cycles> (parallel engine; default: lock-step)\n");
+    fprintf (stderr, "\t-j <worker threads> (default: one per host core)\n");
+    fprintf (stderr, "\t-v <trace level> (0 none, 1 processor, 2 L1, 3 coherence; default: 3)\n");
+    fprintf (stderr, "\t-o <file> (write the event trace in binary instead of text)\n");
+    fprintf (stderr, "\t-D <file> (decode a binary event trace to text and exit)\n");
+    fprintf (stderr, "\t-C (convert the p<N>.trace files to binary p<N>.btrace and exit)\n");
+    fprintf (stderr, "\t-r (read traces on the processor, without the prefetch thread)\n");
+    fprintf (stderr, "\t-g <pattern>[,<cores>[,<accesses>]] (write a stress trace into the -t directory and exit;\n"
+                     "\t   false_sharing, migratory, producer_consumer or random)\n");
+    fprintf (stderr, "\t-c (check coherence invariants every cycle; lock-step only)\n\n");
 }
 
 int main (int argc, char *argv[])
@@ -27,6 +48,20 @@ int main (int argc, char *argv[])
     int num_nodes = 0;
     char *trace_dir = NULL;
     char *protocol = NULL;
+    int l1_size = 0;
+    int l1_assoc = 0;
+    bool bus_split = false;
+    int mshrs = 0;
+    int mem_banks = 0;
+    bool dir_enabled = false;
+    int quantum = 0;
+    int threads = 0;
+    int trace_level = -1;
+    char *trace_file = NULL;
+    bool convert = false;
+    bool trace_prefetch = true;
+    char *stress_spec = NULL;
+    bool check_coherence = false;
     FILE *config_file = NULL;
     char config_path[1000];
     bool debug = false;
@@ -34,7 +69,7 @@ int main (int argc, char *argv[])
     /** Parse command line arguments.  */
     int c;
 
-    while ((c = getopt(argc, argv, "hP:p:t:")) != -1)
+    while ((c = getopt(argc, argv, "hP:p:t:s:a:bm:n:dq:j:v:o:D:Crg:c")) != -1)
     {
         switch(c)
         {
@@ -51,6 +86,67 @@ int main (int argc, char *argv[])
             trace_dir = strdup (optarg);
             break;
 
+        case 's':
+            l1_size = atoi (optarg);
+            break;
+
+        case 'a':
+            l1_assoc = atoi (optarg);
+            break;
+
+        case 'b':
+            bus_split = true;
+            break;
+
+        case 'm':
+            mshrs = atoi (optarg);
+            break;
+
+        case 'n':
+            mem_banks = atoi (optarg);
+            break;
+
+        case 'd':
+            dir_enabled = true;
+            break;
+
+        case 'q':
+            quantum = atoi (optarg);
+            break;
+
+        case 'j':
+            threads = atoi (optarg);
+            break;
+
+        case 'v':
+            trace_level = atoi (optarg);
+            break;
+
+        case 'o':
+            trace_file = strdup (optarg);
+            break;
+
+        case 'D':
+            trace_decode (optarg);
+            exit (0);
+            break;
+
+        case 'C':
+            convert = true;
+            break;
+
+        case 'r':
+            trace_prefetch = false;
+            break;
+
+        case 'g':
+            stress_spec = strdup (optarg);
+            break;
+
+        case 'c':
+            check_coherence = true;
+            break;
+
         default:
             fprintf (stderr, "Invalid command line arguments - %c", c);
             usage ();
@@ -58,6 +154,15 @@ int main (int argc, char *argv[])
         }
     }
 
+    /** The trace directory does not need to exist yet.  */
+    if (stress_spec)
+    {
+        if (trace_dir == NULL)
+            fatal_error ("Error: trace file directory not defined!\n");
+        stress_generate (stress_spec, trace_dir);
+        exit (0);
+    }
+
     sprintf(config_path,"%s/config",trace_dir);
     config_file = fopen (config_path,"r");
     if (fscanf(config_file,"%d\n",&num_nodes) != 1)
@@ -68,6 +173,16 @@ int main (int argc, char *argv[])
     if (num_nodes == 0)
         fatal_error ("Error: number of processors is zero.\n");
 
+    if (convert)
+    {
+        for (int node = 0; node < num_nodes; node++)
+        {
+            sprintf (config_path, "%s/p%d.trace", trace_dir, node);
+            trace_convert (config_path);
+        }
+        exit (0);
+    }
+
     if (protocol == NULL)
         fatal_error ("Error: invalid protocol specified.\n");
 
@@ -81,6 +196,47 @@ int main (int argc, char *argv[])
     settings.num_nodes = num_nodes;
     settings.trace_dir = trace_dir;
 
+    /** The validation runs assume an unbounded L1; only model capacity when asked.  */
+    settings.l1_infinite = (l1_size == 0 && l1_assoc == 0);
+    if (l1_size)
+        settings.l1_cache_size = l1_size;
+    if (l1_assoc)
+        settings.l1_cache_assoc = l1_assoc;
+
+    settings.bus_split = bus_split;
+    if (mshrs)
+        settings.mshrs_per_processor = settings.l1_mshrs = mshrs;
+    if (mem_banks)
+        settings.mem_banks = mem_banks;
+
+    /** Smallest near-square mesh that holds every core.  */
+    settings.dir_enabled = dir_enabled;
+    if (dir_enabled)
+    {
+        settings.network_x_dimension = (int)ceil (sqrt ((double)num_nodes));
+        settings.network_y_dimension = (num_nodes + settings.network_x_dimension - 1)
+                                       / settings.network_x_dimension;
+    }
+
+    if (trace_level >= 0)
+        settings.trace_level = trace_level;
+    settings.trace_file = trace_file;
+    settings.trace_prefetch = trace_prefetch;
+
+    /** The checker looks at every L1 at the end of each cycle.  */
+    if (check_coherence && quantum)
+        fatal_error ("Error: invariant checking needs the lock-step engine.\n");
+    settings.check_coherence = check_coherence;
+
+    /** No point in more workers than cores to simulate.  */
+    settings.sim_quantum = quantum;
+    if (quantum)
+    {
+        if (threads <= 0)
+            threads = (int) sysconf (_SC_NPROCESSORS_ONLN);
+        settings.sim_threads = max (1, min (threads, num_nodes));
+    }
+
     if (!strcmp(protocol,"MI"))
     {
     	settings.protocol = MI_PRO;
@@ -114,5 +270,7 @@ int main (int argc, char *argv[])
 
     /** Build simulator.  */
     Sim = new Simulator ();
+    trace_open ();
     Sim->run ();
+    trace_close ();
 }
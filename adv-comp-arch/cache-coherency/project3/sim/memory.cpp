@@ -1,15 +1,17 @@
 #include "memory.h"
 #include "sim.h"
+#include "stress.h"
+#include "trace.h"
 
+extern Sim_settings settings;
 extern Simulator * Sim;
 
-Memory_controller::Memory_controller(ModuleID moduleID, int hit_time)
+Memory_controller::Memory_controller(ModuleID moduleID, int hit_time, int num_banks)
 	: Module (moduleID, "MC_")
 {
 	this->hit_time = hit_time;
-	request_in_progress = false;
-	data_time = 0;
-	data_target = (ModuleID){-1,INVALID_M};
+	this->num_banks = num_banks;
+	bank_free.assign (num_banks, 0);
 }
 
 Memory_controller::~Memory_controller()
@@ -18,34 +20,82 @@ Memory_controller::~Memory_controller()
 
 void Memory_controller::tick()
 {
-    Mreq *request;
+    const Mreq *request;
+    LIST<Mem_access>::iterator it;
 
     if ((request = read_input_port ()) != NULL)
     {
-		if (request->msg != DATA)
+		if (request->msg == PUTS || request->msg == PUTM)
 		{
-			assert (!request_in_progress);
-			request_in_progress = true;
-			data_addr = request->addr;
-			data_target = request->src_mid;
-			data_time = Global_Clock + hit_time;
+			/** Writebacks are absorbed; nothing goes back on the bus.  */
+			if (request->msg == PUTM)
+			{
+				Sim->writebacks++;
+				if (Sim->checker)
+					Sim->checker->memory_write (request);
+			}
 		}
-		else
+		else if (request->msg == DATA)
 		{
-			request_in_progress = false;
+			cancel_access (request->addr);
+
+			/** Memory snarfs whatever a cache flushes onto the bus.  */
+			if (request->src_mid.module_index == L1_M && Sim->checker)
+				Sim->checker->memory_write (request);
+		}
+		else if (!Sim->bus->is_supplied (request->addr))
+		{
+			/** Caches snoop first; only go to DRAM if none of them answered.  */
+			start_access (request);
 		}
     }
 
-    if (request_in_progress && Global_Clock >= data_time)
+    for (it = accesses.begin (); it != accesses.end (); )
     {
-    	Mreq * new_request;
-    	new_request = new Mreq(DATA,data_addr,moduleID,data_target);
-    	request_in_progress = false;
-    	fprintf(stderr,"**** DATA SEND MC -- Clock: %lld\n",Global_Clock);
-    	this->write_output_port(new_request);
+    	if (Global_Clock >= it->data_time)
+    	{
+    		Mreq * new_request;
+    		new_request = new Mreq(DATA,it->addr,moduleID,it->target);
+    		new_request->data_version = it->version;
+    		trace_data_send (TRACE_DATA_SEND_MC, moduleID);
+    		this->write_output_port(new_request);
+    		it = accesses.erase (it);
+    	}
+    	else
+    	{
+    		it++;
+    	}
     }
 }
 
+void Memory_controller::start_access (const Mreq *request)
+{
+	Mem_access access;
+	int bank = (request->addr >> settings.cache_line_size_log2) % num_banks;
+	timestamp_t start = max (Global_Clock, bank_free[bank]);
+
+	access.addr = request->addr;
+	access.target = request->src_mid;
+	access.data_time = start + hit_time;
+	access.version = Sim->checker ? Sim->checker->memory_version (request->addr) : 0;
+	bank_free[bank] = access.data_time;
+	accesses.push_back (access);
+}
+
+void Memory_controller::cancel_access (paddr_t addr)
+{
+	LIST<Mem_access>::iterator it;
+
+	for (it = accesses.begin (); it != accesses.end (); it++)
+	{
+		if (it->addr == addr)
+		{
+			accesses.erase (it);
+			return;
+		}
+	}
+}
+
 void Memory_controller::tock()
 {
     fatal_error ("Memory controller tock should never be called!\n");
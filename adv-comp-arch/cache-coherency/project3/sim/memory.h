@@ -12,18 +12,32 @@
 
 using namespace std;
 
+/** A read the controller still owes the bus.  */
+class Mem_access {
+public:
+    paddr_t addr;
+    ModuleID target;
+    timestamp_t data_time;
+    /** Invariant checker: what the read found in memory.  */
+    counter_t version;
+};
+
 class Memory_controller : public Module
 {
 public:
-	Memory_controller(ModuleID moduleID, int hit_time);
+	Memory_controller(ModuleID moduleID, int hit_time, int num_banks);
 	~Memory_controller();
 
     int hit_time;
+    int num_banks;
 
-    bool request_in_progress;
-    timestamp_t data_time;
-    paddr_t data_addr;
-    ModuleID data_target;
+    /** Lines are interleaved across banks; each bank serves one access at
+     *  a time and is busy for hit_time cycles.  */
+    VECTOR<timestamp_t> bank_free;
+    LIST<Mem_access> accesses;
+
+    void start_access (const Mreq *request);
+    void cancel_access (paddr_t addr);
 
 	void tick();
 	void tock();
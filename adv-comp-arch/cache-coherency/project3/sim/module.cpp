@@ -8,13 +8,13 @@
 
 extern Simulator *Sim;
 
-bool ModuleID::operator== (const ModuleID &mid)
+bool ModuleID::operator== (const ModuleID &mid) const
 {
     return (this->nodeID == mid.nodeID &&
             this->module_index == mid.module_index);
 }
 
-bool ModuleID::operator!= (const ModuleID &mid)
+bool ModuleID::operator!= (const ModuleID &mid) const
 {
     return !(this->nodeID == mid.nodeID &&
              this->module_index == mid.module_index);
@@ -42,7 +42,9 @@ Module::~Module (void)
         free (name);
 }
 
-Mreq *Module::read_input_port (void)
+/** Snooped requests are a read-only view of the bus' in-flight request and
+ *  are only valid until the next Bus::tick().  Do not modify or delete them. */
+const Mreq *Module::read_input_port (void)
 {
     return Sim->bus->bus_snoop ();
 }
@@ -52,16 +54,16 @@ bool Module::write_output_port (Mreq *mreq)
     return Sim->bus->bus_request (mreq);
 }
 
-void print_id (const char *str, ModuleID mid)
+void print_id (const char *str, ModuleID mid, FILE *out)
 {
     switch (mid.module_index) {
-    case NI_M: fprintf (stderr, "%4s:%3d/NI  ", str, mid.nodeID); break;
-    case PR_M: fprintf (stderr, "%4s:%3d/PR  ", str, mid.nodeID); break;
-    case L1_M: fprintf (stderr, "%4s:%3d/L1  ", str, mid.nodeID); break;
-    case L2_M: fprintf (stderr, "%4s:%3d/L2  ", str, mid.nodeID); break;
-    case L3_M: fprintf (stderr, "%4s:%3d/L3  ", str, mid.nodeID); break;
-    case MC_M: fprintf (stderr, "%4s:%3d/MC  ", str, mid.nodeID); break;
-    case INVALID_M:  fprintf (stderr, "%4s:  None ", str); break;
+    case NI_M: fprintf (out, "%4s:%3d/NI  ", str, mid.nodeID); break;
+    case PR_M: fprintf (out, "%4s:%3d/PR  ", str, mid.nodeID); break;
+    case L1_M: fprintf (out, "%4s:%3d/L1  ", str, mid.nodeID); break;
+    case L2_M: fprintf (out, "%4s:%3d/L2  ", str, mid.nodeID); break;
+    case L3_M: fprintf (out, "%4s:%3d/L3  ", str, mid.nodeID); break;
+    case MC_M: fprintf (out, "%4s:%3d/MC  ", str, mid.nodeID); break;
+    case INVALID_M:  fprintf (out, "%4s:  None ", str); break;
     }
 }
 
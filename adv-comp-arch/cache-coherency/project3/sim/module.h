@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <iostream>
 #include <map>
+#include <stdio.h>
 
 #include "settings.h"
 #include "types.h"
@@ -31,8 +32,8 @@ public:
     int nodeID;
     module_t module_index;
 
-    bool operator== (const ModuleID &mid);
-    bool operator!= (const ModuleID &mid);
+    bool operator== (const ModuleID &mid) const;
+    bool operator!= (const ModuleID &mid) const;
 
     Module* get_module();
 };
@@ -47,13 +48,13 @@ public:
 	Module (ModuleID moduleID, const char *name);
 	virtual ~Module();
 
- 	Mreq *read_input_port (void);
+    const Mreq *read_input_port (void);
     bool write_output_port (Mreq *mreq);
 
     virtual void tick (void) =0;
     virtual void tock (void) =0;
 };
 
-void print_id (const char *str, ModuleID mid);
+void print_id (const char *str, ModuleID mid, FILE *out = stderr);
 
 #endif // MODULE_H_
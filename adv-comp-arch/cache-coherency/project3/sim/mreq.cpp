@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "mreq.h"
 #include "settings.h"
@@ -10,6 +11,60 @@ extern Simulator *Sim;
 
 using namespace std;
 
+/** Number of requests carved out of the heap each time the pool runs dry.  */
+#define MREQ_POOL_CHUNK 256
+
+/** Freelist slot.  A free slot holds the link, a live one holds the Mreq.  */
+union Mreq_slot {
+    Mreq_slot *next;
+    char storage[sizeof (Mreq)];
+    long double align;
+};
+
+/** One pool per thread so quantum workers allocate without locking.  A
+ *  request freed on another thread simply joins that thread's pool.  */
+static __thread Mreq_slot *mreq_free_list = NULL;
+
+/*****************************
+ * Pooled allocation.
+ *****************************/
+void *Mreq::operator new (size_t size)
+{
+    Mreq_slot *slot;
+
+    assert (size == sizeof (Mreq));
+
+    /** Chunks are never handed back; the pool only grows to the peak number
+     *  of requests in flight.  */
+    if (mreq_free_list == NULL)
+    {
+        Mreq_slot *chunk = (Mreq_slot *) malloc (MREQ_POOL_CHUNK * sizeof (Mreq_slot));
+        if (chunk == NULL)
+            fatal_error ("Mreq: Unable to grow request pool\n");
+
+        for (int i = 0; i < MREQ_POOL_CHUNK; i++)
+        {
+            chunk[i].next = mreq_free_list;
+            mreq_free_list = &chunk[i];
+        }
+    }
+
+    slot = mreq_free_list;
+    mreq_free_list = slot->next;
+    return slot;
+}
+
+void Mreq::operator delete (void *ptr)
+{
+    Mreq_slot *slot = (Mreq_slot *) ptr;
+
+    if (slot == NULL)
+        return;
+
+    slot->next = mreq_free_list;
+    mreq_free_list = slot;
+}
+
 /***************
  * Constructor.
  ***************/
@@ -24,13 +79,15 @@ Mreq::Mreq (message_t msg, paddr_t addr, ModuleID src_mid, ModuleID dest_mid)
     this->req_time = Global_Clock;
     this->stalled = false;
     this->preq =NULL;
+    this->bus_tag = -1;
+    this->data_version = 0;
 }
 
 Mreq::~Mreq(void)
 {
 }
 
-void Mreq::print_msg (ModuleID mid, const char *add_msg)
+void Mreq::print_msg (ModuleID mid, const char *add_msg) const
 {
     //TODO: convert fprintfs to c++-ishy output
     print_id ("node", mid);
@@ -40,7 +97,7 @@ void Mreq::print_msg (ModuleID mid, const char *add_msg)
     fprintf (stderr, " %8s\n", Mreq::message_t_str[msg]);
 }
 
-void Mreq::dump ()
+void Mreq::dump () const
 {
     //TODO: convert fprintfs to c++-ishy output
     fprintf (stderr, "Request Dump ");
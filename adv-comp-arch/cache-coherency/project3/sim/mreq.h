@@ -32,12 +32,21 @@ public:
     int INV_ACK_count;
     timestamp_t req_time;
     bool stalled;
+    /** Split-bus transaction tag, -1 until the request wins the bus.  */
+    int bus_tag;
+    /** Invariant checker: the store count of the data a DATA or PUTM
+     *  carries, 0 if unknown.  */
+    counter_t data_version;
 
     static const char * message_t_str[MREQ_MESSAGE_NUM];
 
+    /** Requests are recycled through a freelist instead of the heap.  */
+    static void *operator new (size_t size);
+    static void operator delete (void *ptr);
+
     /** Debug.  */
-    void print_msg (ModuleID mid, const char *add_msg);
-    void dump (void);
+    void print_msg (ModuleID mid, const char *add_msg) const;
+    void dump (void) const;
 };
 
 #endif /*MREQ_H_*/
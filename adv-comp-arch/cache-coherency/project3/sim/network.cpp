@@ -0,0 +1,293 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "mreq.h"
+#include "network.h"
+#include "settings.h"
+#include "sim.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+/***************************************************************************
+ * Router constructor, destructor, and functions.
+ ***************************************************************************/
+Router::Router (int id, int x, int y, int num_vcs)
+{
+    this->id = id;
+    this->x = x;
+    this->y = y;
+    this->num_vcs = num_vcs;
+
+    in_vcs.resize (NUM_PORTS * num_vcs);
+    for (int i = 0; i < NUM_PORTS; i++)
+    {
+        link_free[i] = 0;
+        rr[i] = 0;
+        link_busy[i] = 0;
+    }
+}
+
+Router::~Router ()
+{
+    for (unsigned int i = 0; i < in_vcs.size (); i++)
+        for (unsigned int j = 0; j < in_vcs[i].size (); j++)
+        {
+            delete in_vcs[i][j]->msg;
+            delete in_vcs[i][j];
+        }
+}
+
+/** Dimension-order routing: X first, then Y.  Deadlock free on a mesh.  */
+port_t Router::route (int dest_x, int dest_y)
+{
+    if (dest_x > x)
+        return PORT_EAST;
+    if (dest_x < x)
+        return PORT_WEST;
+    if (dest_y > y)
+        return PORT_SOUTH;
+    if (dest_y < y)
+        return PORT_NORTH;
+    return PORT_LOCAL;
+}
+
+/***************************************************************************
+ * Network constructor, destructor, and functions.
+ ***************************************************************************/
+Network::Network (int x_dim, int y_dim)
+{
+    if (settings.network_topology != MESH)
+        fatal_error ("Network: only the mesh topology is modelled\n");
+
+    if (x_dim * y_dim < settings.num_nodes)
+        fatal_error ("Network: %dx%d mesh cannot hold %d nodes\n",
+                     x_dim, y_dim, settings.num_nodes);
+
+    this->x_dim = x_dim;
+    this->y_dim = y_dim;
+    this->vcs_per_vnet = max (1, settings.num_virtual_channels / (int)NUM_VNETS);
+    this->vc_depth = max (1, settings.buffer_entries_per_vc);
+
+    for (int i = 0; i < x_dim * y_dim; i++)
+        routers.push_back (new Router (i, i % x_dim, i / x_dim, NUM_VNETS * vcs_per_vnet));
+
+    inject_queues.resize (x_dim * y_dim * NUM_VNETS);
+
+    packets_injected = 0;
+    packets_delivered = 0;
+    flits_delivered = 0;
+    total_latency = 0;
+    total_hops = 0;
+}
+
+Network::~Network ()
+{
+    for (unsigned int i = 0; i < routers.size (); i++)
+        delete routers[i];
+}
+
+int Network::vnet_of (Mreq *msg)
+{
+    switch (msg->msg) {
+    case GETS:
+    case GETM:
+    case PUTS:
+    case PUTM:
+        return VNET_REQUEST;
+    case FWD_GETS:
+    case FWD_GETM:
+    case INV:
+    case PUT_ACK:
+        return VNET_FORWARD;
+    default:
+        return VNET_RESPONSE;
+    }
+}
+
+/** One header flit, plus the cache line for messages that carry data.  */
+int Network::flits_of (Mreq *msg)
+{
+    switch (msg->msg) {
+    case DATA:
+    case DATA_E:
+    case PUTM:
+        return 1 + ((settings.cache_line_size << 3) + LINK_FLIT_WIDTH - 1) / LINK_FLIT_WIDTH;
+    default:
+        return 1;
+    }
+}
+
+void Network::send (Mreq *msg)
+{
+    Net_packet *p = new Net_packet;
+
+    assert (msg->src_mid.nodeID >= 0 && msg->dest_mid.nodeID >= 0);
+
+    p->msg = msg;
+    p->vnet = vnet_of (msg);
+    p->flits = flits_of (msg);
+    p->dest = msg->dest_mid.nodeID;
+    p->ready_time = Global_Clock;
+    p->inject_time = Global_Clock;
+    p->hops = 0;
+
+    inject_queues[msg->src_mid.nodeID * NUM_VNETS + p->vnet].push_back (p);
+    packets_injected++;
+}
+
+/** Oldest delivered message for mid, or NULL.  The caller owns it.  */
+Mreq *Network::receive (ModuleID mid)
+{
+    MAP<int, LIST<Net_packet *> >::iterator it = eject_queues.find (eject_key (mid));
+    Net_packet *p;
+    Mreq *msg;
+
+    if (it == eject_queues.end () || it->second.empty ())
+        return NULL;
+
+    p = it->second.front ();
+    if (p->ready_time > Global_Clock)
+        return NULL;
+
+    it->second.pop_front ();
+    msg = p->msg;
+    delete p;
+    return msg;
+}
+
+Router *Network::neighbor (Router *r, int port)
+{
+    switch (port) {
+    case PORT_NORTH: return routers[r->id - x_dim];
+    case PORT_SOUTH: return routers[r->id + x_dim];
+    case PORT_EAST:  return routers[r->id + 1];
+    case PORT_WEST:  return routers[r->id - 1];
+    default:         return r;
+    }
+}
+
+/** Least occupied VC of the packet's vnet with room for it, or -1.  */
+int Network::free_vc (Router *r, int in_port, int vnet)
+{
+    int best = -1;
+
+    for (int vc = vnet * vcs_per_vnet; vc < (vnet + 1) * vcs_per_vnet; vc++)
+    {
+        int depth = r->in_vcs[in_port * r->num_vcs + vc].size ();
+        if (depth < vc_depth &&
+            (best < 0 || depth < (int)r->in_vcs[in_port * r->num_vcs + best].size ()))
+            best = vc;
+    }
+    return best;
+}
+
+/** Switch allocation for one output: grant the first ready input VC, round
+ *  robin, whose head packet routes here and fits downstream.  */
+void Network::traverse (Router *r, int out_port)
+{
+    static const int opposite[NUM_PORTS] = {PORT_SOUTH, PORT_WEST, PORT_NORTH, PORT_EAST, PORT_LOCAL};
+    int total = NUM_PORTS * r->num_vcs;
+
+    if (r->link_free[out_port] > Global_Clock)
+        return;
+
+    for (int i = 0; i < total; i++)
+    {
+        int k = (r->rr[out_port] + i) % total;
+        DEQUE<Net_packet *> &q = r->in_vcs[k];
+        Net_packet *p;
+
+        if (q.empty ())
+            continue;
+
+        p = q.front ();
+        if (p->ready_time > Global_Clock ||
+            r->route (p->dest % x_dim, p->dest / x_dim) != out_port)
+            continue;
+
+        if (out_port == PORT_LOCAL)
+        {
+            /** Ejection; the message is usable once its tail flit is in.  */
+            q.pop_front ();
+            p->ready_time = Global_Clock + p->flits;
+            eject_queues[eject_key (p->msg->dest_mid)].push_back (p);
+
+            packets_delivered++;
+            flits_delivered += p->flits;
+            total_latency += p->ready_time - p->inject_time;
+            total_hops += p->hops;
+        }
+        else
+        {
+            Router *next = neighbor (r, out_port);
+            int in_port = opposite[out_port];
+            int vc = free_vc (next, in_port, p->vnet);
+
+            if (vc < 0)
+                continue;
+
+            q.pop_front ();
+            p->ready_time = Global_Clock + ROUTER_DELAY + LINK_DELAY;
+            p->hops++;
+            next->in_vcs[in_port * next->num_vcs + vc].push_back (p);
+            r->link_busy[out_port] += p->flits;
+        }
+
+        r->link_free[out_port] = Global_Clock + p->flits;
+        r->rr[out_port] = k + 1;
+        return;
+    }
+}
+
+void Network::tick ()
+{
+    for (unsigned int i = 0; i < routers.size (); i++)
+        for (int port = 0; port < NUM_PORTS; port++)
+            traverse (routers[i], port);
+
+    /** Injection, one packet per vnet per node per cycle.  */
+    for (unsigned int node = 0; node < routers.size (); node++)
+    {
+        for (int vnet = 0; vnet < NUM_VNETS; vnet++)
+        {
+            DEQUE<Net_packet *> &q = inject_queues[node * NUM_VNETS + vnet];
+            Router *r = routers[node];
+            Net_packet *p;
+            int vc;
+
+            if (q.empty ())
+                continue;
+
+            vc = free_vc (r, PORT_LOCAL, vnet);
+            if (vc < 0)
+                continue;
+
+            p = q.front ();
+            q.pop_front ();
+            p->ready_time = Global_Clock + ROUTER_DELAY;
+            r->in_vcs[PORT_LOCAL * r->num_vcs + vc].push_back (p);
+        }
+    }
+}
+
+void Network::dump_stats ()
+{
+    counter_t busy = 0;
+    int links = 2 * ((x_dim - 1) * y_dim + (y_dim - 1) * x_dim);
+
+    for (unsigned int i = 0; i < routers.size (); i++)
+        for (int port = 0; port < PORT_LOCAL; port++)
+            busy += routers[i]->link_busy[port];
+
+    fprintf(stderr,"Network:          %dx%d mesh, %d VCs/vnet\n",x_dim,y_dim,vcs_per_vnet);
+    fprintf(stderr,"Packets:          %8lld packets\n",(long long)packets_delivered);
+    fprintf(stderr,"Flits:            %8lld flits\n",(long long)flits_delivered);
+    if (packets_delivered)
+    {
+        fprintf(stderr,"Avg Latency:      %8.2f cycles\n",(double)total_latency / packets_delivered);
+        fprintf(stderr,"Avg Hops:         %8.2f hops\n",(double)total_hops / packets_delivered);
+    }
+    if (links && Global_Clock)
+        fprintf(stderr,"Link Utilization: %8.4f\n",(double)busy / ((double)links * Global_Clock));
+}
@@ -0,0 +1,113 @@
+#ifndef NETWORK_H_
+#define NETWORK_H_
+
+#include "module.h"
+#include "types.h"
+
+using namespace std;
+
+/** Router ports.  */
+typedef enum {
+    PORT_NORTH = 0,
+    PORT_EAST,
+    PORT_SOUTH,
+    PORT_WEST,
+    PORT_LOCAL,
+    NUM_PORTS
+} port_t;
+
+/** Virtual networks.  Each message class gets its own set of VCs so that a
+ *  backed-up request class can never block the replies that would drain it.  */
+typedef enum {
+    VNET_REQUEST = 0,
+    VNET_FORWARD,
+    VNET_RESPONSE,
+    NUM_VNETS
+} vnet_t;
+
+/** Router pipeline depth and link traversal, in cycles.  */
+#define ROUTER_DELAY    1
+#define LINK_DELAY      1
+
+class Net_packet {
+public:
+    Mreq *msg;
+    int vnet;
+    int flits;
+    int dest;
+    /** Earliest cycle the head flit can leave its current buffer.  */
+    timestamp_t ready_time;
+    timestamp_t inject_time;
+    int hops;
+};
+
+class Router {
+public:
+    Router (int id, int x, int y, int num_vcs);
+    ~Router ();
+
+    int id;
+    int x;
+    int y;
+
+    /** Input buffers, [port * num_vcs + vc].  */
+    int num_vcs;
+    VECTOR<DEQUE<Net_packet *> > in_vcs;
+
+    /** Output link is serializing a packet until this cycle.  */
+    timestamp_t link_free[NUM_PORTS];
+    /** Round-robin pointer per output over the input VCs.  */
+    int rr[NUM_PORTS];
+
+    /** Flit-cycles each output link was busy, for utilization.  */
+    counter_t link_busy[NUM_PORTS];
+
+    port_t route (int dest_x, int dest_y);
+};
+
+/**
+ * Cycle-level 2-D mesh with dimension-order (XY) routing, per-vnet virtual
+ * channels and credit-style buffer reservation.  Packets are virtual
+ * cut-through: a packet holds a link for one cycle per flit.
+ */
+class Network {
+public:
+    Network (int x_dim, int y_dim);
+    ~Network ();
+
+    int x_dim;
+    int y_dim;
+    int vcs_per_vnet;
+    int vc_depth;
+
+    VECTOR<Router *> routers;
+
+    /** Per-node injection queues, one per vnet; never full.  */
+    VECTOR<DEQUE<Net_packet *> > inject_queues;
+
+    /** Delivered messages per destination module.  */
+    MAP<int, LIST<Net_packet *> > eject_queues;
+
+    /** Stats.  */
+    counter_t packets_injected;
+    counter_t packets_delivered;
+    counter_t flits_delivered;
+    counter_t total_latency;
+    counter_t total_hops;
+
+    void send (Mreq *msg);
+    Mreq *receive (ModuleID mid);
+
+    void tick ();
+    void dump_stats ();
+
+private:
+    static int vnet_of (Mreq *msg);
+    int flits_of (Mreq *msg);
+    int eject_key (ModuleID mid) { return mid.nodeID * INVALID_M + mid.module_index; }
+    Router *neighbor (Router *r, int port);
+    int free_vc (Router *r, int in_port, int vnet);
+    void traverse (Router *r, int out_port);
+};
+
+#endif /* NETWORK_H_ */
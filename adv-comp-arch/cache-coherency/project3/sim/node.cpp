@@ -2,6 +2,7 @@
 #include "processor.h"
 #include "hash_table.h"
 #include "memory.h"
+#include "directory.h"
 #include "sim.h"
 
 extern Sim_settings settings;
@@ -33,14 +34,21 @@ void Node::build_processor (char *trace_file)
                                         settings.cache_line_size,
                                         settings.l1_mshrs,
                                         settings.l1_hit_time,
-                                        settings.protocol);
+                                        settings.protocol,
+                                        settings.l1_infinite);
 
     mod[PR_M] = new Processor ((ModuleID){nodeID, PR_M}, cache, trace_file);
+
+    /** Each core node also holds a home slice in directory mode.  */
+    if (settings.dir_enabled)
+        mod[MC_M] = new Directory ((ModuleID){nodeID, MC_M}, DIR_LATENCY, 100,
+                                   settings.protocol);
 }
 
 void Node::build_memory_controller (void)
 {
-	mod[MC_M] = new Memory_controller ((ModuleID){nodeID, MC_M}, 100);
+	mod[MC_M] = new Memory_controller ((ModuleID){nodeID, MC_M}, 100,
+                                         settings.bus_split ? settings.mem_banks : 1);
 }
 
 void Node::tick_cache (void)
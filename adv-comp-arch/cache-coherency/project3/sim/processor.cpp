@@ -5,31 +5,36 @@
 #include "processor.h"
 #include "settings.h"
 #include "sim.h"
+#include "trace.h"
+#include "trace_reader.h"
 
 using namespace std;
 
+extern Sim_settings settings;
 extern Simulator * Sim;
 
 Processor::Processor (ModuleID moduleID, Hash_table *cache, char *trace_file)
     : Module (moduleID, "Processor_")
 {
     this->moduleID = moduleID;
-    this->infile = fopen (trace_file, "r");
+    this->reader = new Trace_reader (trace_file);
     this->my_cache = cache;
     this->end_of_trace = false;
-    this->inbound_request = NULL;
-    this->inbound_request_buf = NULL;
+    this->outstanding_requests = 0;
+    this->max_outstanding = 1;
+    if (settings.bus_split || settings.dir_enabled)
+        this->max_outstanding = min (settings.mshrs_per_processor, settings.l1_mshrs);
 }
 
 Processor::~Processor ()
 {
-    fclose (this->infile);
+    delete this->reader;
 }
 
 /** Done once at end of trace and no outstanding requests.  */
 bool Processor::done ()
 {
-    return (end_of_trace && !outstanding_request);
+    return (end_of_trace && !outstanding_requests);
 }
 
 void Processor::tick ()
@@ -37,23 +42,25 @@ void Processor::tick ()
     char c;
     paddr_t addr;
 
-    if (inbound_request)
+    while (!inbound_requests.empty ())
     {
-    	fprintf(stderr,"* COMPLETE -- PR: %d -- Clock: %lld\n",moduleID.nodeID, Global_Clock);
+    	Mreq *inbound_request = inbound_requests.front ();
+    	inbound_requests.pop_front ();
+    	trace_complete (moduleID);
     	assert (inbound_request->msg == DATA);
-    	outstanding_request = false;
+    	assert (outstanding_requests > 0);
+    	outstanding_requests--;
         delete inbound_request;
     }
-    inbound_request = NULL;
 
-    if (end_of_trace || outstanding_request)
+    if (end_of_trace || outstanding_requests >= max_outstanding)
         return;
 
-    if (fscanf (infile, "%c 0x%llx\n", &c, (unsigned long long int*)&addr) == 2)
+    if (reader->next (&c, &addr))
     {
         Mreq *request;
 
-        fprintf (stderr,"* FETCH -- PR: %d -- Clock: %lld -- %c 0x%llx\n", moduleID.nodeID, Global_Clock, c, (unsigned long long int)addr);
+        trace_fetch (moduleID, c, addr);
 
         switch (c) {
         case 'r': request = new Mreq (LOAD, addr, moduleID); break;
@@ -62,8 +69,8 @@ void Processor::tick ()
             fatal_error ("Processor %d: unknown operation - %c", moduleID.nodeID, c);
         }
         
-        my_cache->proc_request =  request;
-        outstanding_request = true;
+        my_cache->processor_request (request);
+        outstanding_requests++;
     }
     else
     {
@@ -73,10 +80,6 @@ void Processor::tick ()
 
 void Processor::tock ()
 {
-	if (inbound_request_buf)
-	{
-		inbound_request = inbound_request_buf;
-		inbound_request_buf = NULL;
-	}
+	inbound_requests.splice (inbound_requests.end (), inbound_request_buf);
 }
 
@@ -12,20 +12,25 @@
 using namespace std;
 
 class Hash_table;
+class Trace_reader;
 
 class Processor : public Module {
 public:
 	Processor(ModuleID moduleID, Hash_table *cache, char *trace_file);
 	~Processor();
 
-    FILE *infile;
+    Trace_reader *reader;
     Hash_table *my_cache;
 
     bool end_of_trace;
-    bool outstanding_request;
 
-    Mreq * inbound_request;
-    Mreq * inbound_request_buf;
+    /** Requests issued to the L1 and not yet answered.  Without a split bus
+     *  the core blocks on every access, i.e. max_outstanding is 1.  */
+    int outstanding_requests;
+    int max_outstanding;
+
+    LIST<Mreq *> inbound_requests;
+    LIST<Mreq *> inbound_request_buf;
 
     bool done ();
 
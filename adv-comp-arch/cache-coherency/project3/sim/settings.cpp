@@ -7,6 +7,7 @@
 #include "sim.h"
 #include "settings.h"
 #include "enums.h"
+#include "trace.h"
 
 extern Sim_settings settings;
 extern FILE * yyin;
@@ -99,6 +100,7 @@ setts identifiers [] = {
 	{"l3_infinite",		   	    &(settings.l3_infinite)           },
 
     /** Directory.  */
+    {"dir_enabled",             &(settings.dir_enabled)           },
 	{"dir_tiers",			    &(settings.dir_tiers)             },
 	{"dir_coherence_policy",	&(settings.dir_coherence_policy)  },
     {"dir_mode",                &(settings.dir_mode)              },
@@ -129,6 +131,15 @@ setts identifiers [] = {
 	{"data_graph",				&(settings.data_graph)			  },
 
 
+    /** Bus and memory.  */
+    {"bus_split",               &(settings.bus_split)             },
+    {"bus_tags",                &(settings.bus_tags)              },
+    {"mem_banks",               &(settings.mem_banks)             },
+
+    /** Quantum engine.  */
+    {"sim_quantum",             &(settings.sim_quantum)           },
+    {"sim_threads",             &(settings.sim_threads)           },
+
 	/** Express Link and VC Stuff */
     {"network_topology",        &(settings.network_topology)      },
 	{"express_link_len",		&(settings.express_link_len)	  },
@@ -138,6 +149,9 @@ setts identifiers [] = {
 	{"num_virtual_channels",	&(settings.num_virtual_channels)  },
 	{"buffer_entries_per_vc",	&(settings.buffer_entries_per_vc) },
 	{"debug_addr",	            &(settings.debug_addr)            },
+    {"trace_level",             &(settings.trace_level)           },
+    {"trace_prefetch",          &(settings.trace_prefetch)        },
+    {"check_coherence",         &(settings.check_coherence)       },
     {"test_addr",               &(settings.test_addr)            },
 
 	/** report generation, tell simulator to output to cerr, cout, or null for no output **/
@@ -245,6 +259,7 @@ void Sim_settings::print_settings (void)
 	fprintf (stderr, " l3_lookup_time:        %16d\n", l3_lookup_time);
 	fprintf (stderr, " l2_infinite:           %16s\n", l2_infinite == true ? "true" : "false");
 
+    fprintf (stderr, " dir_enabled:           %16s\n", dir_enabled == true ? "true" : "false");
 	fprintf (stderr, " dir_tiers:             %16d\n", dir_tiers);
     fprintf (stderr, " dir_mode:              %16d\n", dir_mode);
     fprintf (stderr, " dir_addr_per_node_log2:%16d\n", dir_addr_per_node_log2);
@@ -283,12 +298,22 @@ void Sim_settings::print_settings (void)
 		int hdd_hit_time;
 	*/
 
+    fprintf (stderr, " bus_split:             %16s\n", bus_split == true ? "true" : "false");
+    fprintf (stderr, " bus_tags:              %16d\n", bus_tags);
+    fprintf (stderr, " mem_banks:             %16d\n", mem_banks);
+    fprintf (stderr, " sim_quantum:           %16d\n", sim_quantum);
+    fprintf (stderr, " sim_threads:           %16d\n", sim_threads);
+
     fprintf (stderr, " network_topology:      %16d\n", network_topology);
 	fprintf (stderr, " express_link_len:	  %16d\n", express_link_len);
 	fprintf (stderr, " express_link_active:   %16d\n", express_link_active);
 	fprintf (stderr, " num_virtual_channels:  %16d\n", num_virtual_channels);
 	fprintf (stderr, " buffer_entries_per_vc: %16d\n", buffer_entries_per_vc);
 	fprintf (stderr, " debug_addr:            0x%14llx\n", (unsigned long long int) debug_addr);
+    fprintf (stderr, " trace_level:           %16d\n", trace_level);
+    fprintf (stderr, " trace_file:            %16s\n", trace_file ? trace_file : "stderr");
+    fprintf (stderr, " trace_prefetch:        %16s\n", trace_prefetch == true ? "true" : "false");
+    fprintf (stderr, " check_coherence:       %16s\n", check_coherence == true ? "true" : "false");
     fprintf (stderr, " test_addr:             0x%14llx\n", (unsigned long long int) test_addr);
 
 	fprintf (stderr, " sampling_interval:     %lld\n", sampling_interval);
@@ -375,6 +400,7 @@ void Sim_settings::set_defaults (void)
     l3_lookup_time			= 3;
     l3_infinite             = false;
 
+    dir_enabled             = false;
     dir_tiers               = 1;
     dir_coherence_policy    = new int[1];
     dir_coherence_policy[0] = MESI;
@@ -400,6 +426,13 @@ void Sim_settings::set_defaults (void)
     ro_tracker_gran         = cache_line_size;
     ro_tracker_entries      = (1 << 14);
 
+    bus_split               = false;
+    bus_tags                = 32;
+    mem_banks               = 8;
+
+    sim_quantum             = 0;
+    sim_threads             = 1;
+
     network_topology        = MESH;
 	express_link_len		= 4;
 	express_link_active		= false;
@@ -416,5 +449,9 @@ void Sim_settings::set_defaults (void)
     report_output           = OUTPUT_FMT_CSV;
 
     trace_dir               = NULL;
+    trace_level             = TRACE_COHERENCE;
+    trace_file              = NULL;
+    trace_prefetch          = true;
+    check_coherence         = false;
 }
 
@@ -102,6 +102,7 @@ public:
     bool                 l3_infinite;
 
     // Directory
+    bool                 dir_enabled;
     int                  dir_tiers;
     int*                 dir_coherence_policy;
     dir_mode_t           dir_mode;
@@ -130,6 +131,15 @@ public:
     unsigned int         ro_tracker_entries;
 	bool				 data_graph;
 
+    // Bus and memory
+    bool                 bus_split;
+    int                  bus_tags;
+    int                  mem_banks;
+
+    // Quantum engine; a zero quantum runs every module in lock-step
+    int                  sim_quantum;
+    int                  sim_threads;
+
 	// Network
     network_topology_t   network_topology;
     int					 express_link_len;
@@ -147,6 +157,17 @@ public:
 
     char                 *trace_dir;
 
+    /** Event trace: level up to TRACE_MAX_LEVEL, and a binary output file
+     *  (NULL prints the events as text on stderr).  */
+    int                  trace_level;
+    char                 *trace_file;
+
+    /** Decode the input traces on a background thread.  */
+    bool                 trace_prefetch;
+
+    /** Check SWMR and data-value invariants as the run goes.  */
+    bool                 check_coherence;
+
     protocol_t protocol;
     bool debug;
 
@@ -1,18 +1,31 @@
 #include <math.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <strings.h>
+#include <sys/time.h>
 
 #include "hash_table.h"
 #include "processor.h"
 #include "memory.h"
+#include "directory.h"
+#include "network.h"
+#include "trace_reader.h"
 #include "module.h"
 #include "mreq.h"
 #include "settings.h"
 #include "sim.h"
+#include "stress.h"
 #include "types.h"
 
 extern Sim_settings settings;
+extern Simulator *Sim;
+
+__thread timestamp_t thread_clock = 0;
+
+/** Workers and the main thread meet here at both ends of the parallel
+ *  phase of every quantum.  */
+static pthread_barrier_t quantum_barrier;
 
 /** Fatal Error.  */
 void fatal_error (const char *fmt, ...)
@@ -35,11 +48,24 @@ Simulator::Simulator ()
     
     /** Set global_clock to cycle zero.  */
     global_clock = 0;
+    Global_Clock = 0;
+
+    quantum_bound = false;
+    quantum_stop = false;
+    finish_time = NULL;
+
+    checker = NULL;
+    if (settings.check_coherence)
+        checker = new Coherence_checker ();
 
     /** Allocate bus.  */
     bus = new Bus ();
     assert (bus && "Sim error: Unable to alloc bus.");
 
+    net = NULL;
+    if (settings.dir_enabled)
+        net = new Network (settings.network_x_dimension, settings.network_y_dimension);
+
     Nd = new Node*[settings.num_nodes+1];
 
     /** Allocate processors.  */
@@ -52,42 +78,75 @@ Simulator::Simulator ()
         Nd[node]->build_processor (trace_file);
     }
 
-    /** Allocate memory controllers.  */
+    /** Decode every core's trace ahead of it on a background thread.  */
+    if (settings.trace_prefetch)
+    {
+        Trace_reader **readers = new Trace_reader*[settings.num_nodes];
+
+        for (int node = 0; node < settings.num_nodes; node++)
+            readers[node] = get_PR (node)->reader;
+        trace_prefetch_start (readers, settings.num_nodes);
+    }
+
+    /** Allocate memory controllers.  With a directory memory sits behind
+     *  the home slices, so the extra node stays empty.  */
     Nd[settings.num_nodes] = new Node (settings.num_nodes);
-    Nd[settings.num_nodes]->build_memory_controller ();
+    if (!net)
+        Nd[settings.num_nodes]->build_memory_controller ();
 
     cache_misses = 0;
     silent_upgrades = 0;
     cache_to_cache_transfers = 0;
     cache_accesses = 0;
+    evictions = 0;
+    writebacks = 0;
 }
 
 Simulator::~Simulator ()
 {
+    trace_prefetch_stop ();
+
     for (int i = 0; i < settings.num_nodes; i++)
         delete Nd[i];
 
     delete [] Nd;    
+    delete net;
+    delete [] finish_time;
+    delete checker;
 }
 
 void Simulator::dump_stats ()
 {
+    cache_misses = 0;
+    cache_accesses = 0;
+    silent_upgrades = 0;
+    cache_to_cache_transfers = 0;
+    evictions = 0;
     for (int i=0; i < settings.num_nodes; i++)
     {
     	get_L1(i)->dump_hash_table();
+    	cache_misses += get_L1(i)->cache_misses;
+    	cache_accesses += get_L1(i)->cache_accesses;
+    	silent_upgrades += get_L1(i)->silent_upgrades;
+    	cache_to_cache_transfers += get_L1(i)->cache_to_cache_transfers;
+    	evictions += get_L1(i)->evictions;
     }
     fprintf(stderr,"\nRun Time:         %8lld cycles\n",global_clock);
     fprintf(stderr,"Cache Misses:     %8ld misses\n",cache_misses);
     fprintf(stderr,"Cache Accesses:   %8ld accesses\n",cache_accesses);
     fprintf(stderr,"Silent Upgrades:  %8ld upgrades\n",silent_upgrades);
     fprintf(stderr,"$-to-$ Transfers: %8ld transfers\n",cache_to_cache_transfers);
+    if (!settings.l1_infinite)
+    {
+        fprintf(stderr,"Evictions:        %8ld evictions\n",evictions);
+        fprintf(stderr,"Writebacks:       %8ld writebacks\n",writebacks);
+    }
+    if (net)
+        net->dump_stats ();
 }
 
 void Simulator::run ()
 {
-    int sched;
-    bool done;
-
     /** This must match what's in enums.h.  */
     const char *cp_str[9] = {"CACHE_PRO","MI_PRO","MSI_PRO","MESI_PRO",
 							 "MOESI_PRO","MOSI_PRO","MOESIF_PRO","NULL_PRO","MEM_PRO"};
@@ -96,12 +155,41 @@ void Simulator::run ()
     fprintf (stderr, " Cores: %d", settings.num_nodes);
     fprintf (stderr, " Protocol: %s\n", cp_str[settings.protocol]);
 
+    struct timeval start, end;
+
+    gettimeofday (&start, NULL);
+    if (settings.sim_quantum)
+        run_quantum ();
+    else
+        run_lockstep ();
+    gettimeofday (&end, NULL);
+
+    /** The readers are drained; Sim itself is never deleted.  */
+    trace_prefetch_stop ();
+
+    fprintf(stderr,"\n\nSimulation Finished\n");
+    dump_stats();
+
+    if (checker)
+        checker->report (cp_str[settings.protocol],
+                         (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6);
+}
+
+/** Every module ticks every cycle, in node order.  Validation runs use this.  */
+void Simulator::run_lockstep ()
+{
+    int sched;
+    bool done;
+
     /** Main run loop.  */
     sched = 0;
     done = false;
     while (!done)
     {
-        bus->tick ();
+        if (net)
+            net->tick ();
+        else
+            bus->tick ();
 
         for (int i = 0; i <= settings.num_nodes; i++)
             Nd[i]->tick_cache ();
@@ -115,7 +203,11 @@ void Simulator::run ()
         for (int i = 0; i <= settings.num_nodes; i++)
 			Nd[i]->tock_pr ();
 
+        if (checker)
+            checker->check ();
+
         global_clock++;
+        Global_Clock = global_clock;
 
         done = true;
         for (int i = 0; i < settings.num_nodes; i++)
@@ -125,9 +217,123 @@ void Simulator::run ()
                 break;        
             }
     }
+}
 
-    fprintf(stderr,"\n\nSimulation Finished\n");
-    dump_stats();
+static void *quantum_worker (void *arg)
+{
+    int worker = (int)(long) arg;
+
+    while (true)
+    {
+        pthread_barrier_wait (&quantum_barrier);
+        if (Sim->quantum_stop)
+            break;
+        Sim->run_bound (worker);
+        pthread_barrier_wait (&quantum_barrier);
+    }
+    return NULL;
+}
+
+/** Parallel phase of one quantum: this worker's nodes each run their L1 and
+ *  processor to the end of the quantum without looking at the interconnect.
+ *  Private hits complete here; misses leave their request with the cache.  */
+void Simulator::run_bound (int worker)
+{
+    timestamp_t end = global_clock + settings.sim_quantum;
+
+    for (int i = worker; i < settings.num_nodes; i += settings.sim_threads)
+    {
+        Hash_table *l1 = get_L1 (i);
+        Processor *pr = get_PR (i);
+
+        for (Global_Clock = global_clock; Global_Clock < end; Global_Clock++)
+        {
+            l1->tick_local ();
+            pr->tick ();
+            pr->tock ();
+
+            if (!finish_time[i] && pr->done ())
+                finish_time[i] = Global_Clock + 1;
+        }
+    }
+}
+
+/**
+ * Quantum engine.  Each quantum runs the nodes in parallel for
+ * settings.sim_quantum cycles, then replays the bus or network, the snoop
+ * side of the caches and the memory side serially over the same cycles.
+ * A miss is therefore seen by its core no earlier than the next quantum;
+ * with a quantum of one cycle the result is within an intra-cycle ordering
+ * of run_lockstep ().
+ */
+void Simulator::run_quantum ()
+{
+    int threads = settings.sim_threads;
+    pthread_t *workers = new pthread_t[threads];
+    bool done = false;
+
+    finish_time = new timestamp_t[settings.num_nodes];
+    for (int i = 0; i < settings.num_nodes; i++)
+        finish_time[i] = 0;
+
+    pthread_barrier_init (&quantum_barrier, NULL, threads);
+    for (int w = 1; w < threads; w++)
+        if (pthread_create (&workers[w], NULL, quantum_worker, (void *)(long) w))
+            fatal_error ("Simulator: unable to start quantum worker %d\n", w);
+
+    while (!done)
+    {
+        timestamp_t end = global_clock + settings.sim_quantum;
+
+        quantum_bound = true;
+        pthread_barrier_wait (&quantum_barrier);
+        run_bound (0);
+        pthread_barrier_wait (&quantum_barrier);
+        quantum_bound = false;
+
+        for (Global_Clock = global_clock; Global_Clock < end; Global_Clock++)
+        {
+            for (int i = 0; i < settings.num_nodes; i++)
+                get_L1 (i)->post_deferred (Global_Clock);
+
+            if (net)
+                net->tick ();
+            else
+                bus->tick ();
+
+            for (int i = 0; i < settings.num_nodes; i++)
+                get_L1 (i)->tick_remote ();
+
+            for (int i = 0; i <= settings.num_nodes; i++)
+                Nd[i]->tick_mc ();
+
+            /** Data for the processors is visible from the next cycle on.  */
+            for (int i = 0; i < settings.num_nodes; i++)
+                get_PR (i)->tock ();
+        }
+        global_clock = end;
+
+        done = true;
+        for (int i = 0; i < settings.num_nodes; i++)
+            if (!get_PR(i)->done ())
+            {
+                done = false;
+                break;
+            }
+    }
+
+    quantum_stop = true;
+    pthread_barrier_wait (&quantum_barrier);
+    for (int w = 1; w < threads; w++)
+        pthread_join (workers[w], NULL);
+    pthread_barrier_destroy (&quantum_barrier);
+    delete [] workers;
+
+    /** Report the cycle the last core finished rather than the quantum end.  */
+    global_clock = 0;
+    for (int i = 0; i < settings.num_nodes; i++)
+        global_clock = max (global_clock, finish_time[i]);
+    Global_Clock = global_clock;
 }
 
 Processor* Simulator::get_PR (int node)
@@ -143,6 +349,15 @@ Memory_controller* Simulator::get_MC (int node)
     return (Memory_controller *)(Nd[node]->mod[MC_M]);
 }
 
+/** Lines are interleaved over the slices at cache line granularity.  */
+ModuleID Simulator::get_home (paddr_t addr)
+{
+    int node = ((addr ^ settings.dir_home_swizzle) >> settings.cache_line_size_log2)
+               % settings.num_nodes;
+
+    return (ModuleID){node, MC_M};
+}
+
 /** Debug.  */
 void Simulator::dump_processors (void)
 {
@@ -7,13 +7,19 @@
 #include "settings.h"
 #include "types.h"
 
-#define Global_Clock Sim->global_clock
+/** Cycle being simulated by the calling thread.  Equal to
+ *  Simulator::global_clock except on a quantum worker, which runs its nodes
+ *  up to the end of the current quantum.  */
+extern __thread timestamp_t thread_clock;
+#define Global_Clock thread_clock
 
 class Node;
 class Processor;
 class Hash_table;
 class L1_cache;
 class Memory_controller;
+class Network;
+class Coherence_checker;
 
 void fatal_error (const char *fmt, ...) __attribute__ ((noreturn));
 
@@ -27,8 +33,25 @@ public:
     Node **Nd;
     Bus *bus;
 
+    /** Point-to-point interconnect; only built in directory mode, where it
+     *  replaces the bus.  */
+    Network *net;
+
+    /** Quantum engine.  While quantum_bound is set the workers own the
+     *  processors and L1s, and the caches hold their bus/network traffic
+     *  until the serial phase replays the interconnect for the quantum.  */
+    bool quantum_bound;
+    bool quantum_stop;
+    timestamp_t *finish_time;
+
+    /** Invariant checker; NULL unless check_coherence is set.  */
+    Coherence_checker *checker;
+
     /** Run/Fini for simulator.  */
     void run (void);
+    void run_lockstep (void);
+    void run_quantum (void);
+    void run_bound (int worker);
     void dump_stats (void);
 
     /** Accessor functions */
@@ -36,6 +59,9 @@ public:
     Hash_table *get_L1 (int node);
     Memory_controller *get_MC (int node);
 
+    /** Directory slice that is home for addr.  */
+    ModuleID get_home (paddr_t addr);
+
     /** Debug.  */
     void dump_processors (void);
 	void dump_outstanding_requests (int nodeID);
@@ -45,6 +71,8 @@ public:
     unsigned long int cache_accesses;
     unsigned long int silent_upgrades;
     unsigned long int cache_to_cache_transfers;
+    unsigned long int evictions;
+    unsigned long int writebacks;
 };
 
 #endif
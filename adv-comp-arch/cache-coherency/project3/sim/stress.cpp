@@ -0,0 +1,296 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash_table.h"
+#include "settings.h"
+#include "sim.h"
+#include "stress.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+/** Generated traces use the default 64-byte line and start here.  */
+#define STRESS_LINE         64
+#define STRESS_BASE         0x10000000ULL
+
+/***************************************************************************
+ * Synthetic trace generation.
+ ***************************************************************************/
+static paddr_t stress_addr (int line, int word)
+{
+    return STRESS_BASE + (paddr_t) line * STRESS_LINE + (paddr_t)(word % (STRESS_LINE / 4)) * 4;
+}
+
+/** Access i of core c.  Every core runs its own trace, so the patterns
+ *  only shape which lines collide, not the exact interleaving.  */
+static char stress_access (const char *pattern, int c, int cores, int i,
+                           unsigned int *seed, paddr_t *addr)
+{
+    if (!strcmp (pattern, "false_sharing"))
+    {
+        /** Each core has its own word in the same four lines.  */
+        *addr = stress_addr (i % 4, c);
+        return (i & 1) ? 'w' : 'r';
+    }
+
+    if (!strcmp (pattern, "migratory"))
+    {
+        /** Read-modify-write, each core a step behind the previous one.  */
+        *addr = stress_addr ((i / 2 + c) % 16, 0);
+        return (i & 1) ? 'w' : 'r';
+    }
+
+    if (!strcmp (pattern, "producer_consumer"))
+    {
+        /** Even cores fill a ring that the next odd core drains.  */
+        *addr = stress_addr ((c / 2) * 32 + i % 32, i / 32);
+        return (c & 1) ? 'r' : 'w';
+    }
+
+    if (!strcmp (pattern, "random"))
+    {
+        *addr = stress_addr (rand_r (seed) % 64, rand_r (seed));
+        return (rand_r (seed) % 10 < 3) ? 'w' : 'r';
+    }
+
+    fatal_error ("Stress: unknown pattern %s\n", pattern);
+}
+
+void stress_generate (const char *spec, const char *dir)
+{
+    char pattern[64];
+    char path[1000];
+    int cores = 8;
+    int accesses = 10000;
+    FILE *out;
+
+    if (sscanf (spec, "%63[^,],%d,%d", pattern, &cores, &accesses) < 1 ||
+        cores <= 0 || accesses <= 0)
+        fatal_error ("Stress: bad pattern spec %s\n", spec);
+
+    if (mkdir (dir, 0755) && errno != EEXIST)
+        fatal_error ("Stress: unable to create %s\n", dir);
+
+    sprintf (path, "%s/config", dir);
+    out = fopen (path, "w");
+    if (out == NULL)
+        fatal_error ("Stress: unable to create %s\n", path);
+    fprintf (out, "%d\n", cores);
+    fclose (out);
+
+    for (int c = 0; c < cores; c++)
+    {
+        unsigned int seed = 1023 + c;
+
+        sprintf (path, "%s/p%d.trace", dir, c);
+        out = fopen (path, "w");
+        if (out == NULL)
+            fatal_error ("Stress: unable to create %s\n", path);
+
+        for (int i = 0; i < accesses; i++)
+        {
+            paddr_t addr;
+            char op = stress_access (pattern, c, cores, i, &seed, &addr);
+
+            fprintf (out, "%c 0x%llx\n", op, (unsigned long long int) addr);
+        }
+        fclose (out);
+
+        /** A binary trace from an earlier pattern no longer matches.  */
+        sprintf (path, "%s/p%d.btrace", dir, c);
+        if (unlink (path) && errno != ENOENT)
+            fatal_error ("Stress: unable to remove %s\n", path);
+    }
+}
+
+/***************************************************************************
+ * Coherence_checker constructor, destructor, and functions.
+ ***************************************************************************/
+Coherence_checker::Coherence_checker ()
+{
+    transactions = 0;
+    line_checks = 0;
+    pending.resize (settings.num_nodes);
+    fills.resize (settings.num_nodes);
+}
+
+Coherence_checker::~Coherence_checker ()
+{
+}
+
+Checker_line &Coherence_checker::get_line (paddr_t line)
+{
+    MAP<paddr_t, Checker_line>::iterator it = lines.find (line);
+
+    if (it != lines.end ())
+        return it->second;
+
+    Checker_line &l = lines[line];
+    l.version = 1;
+    l.memory = 1;
+    l.copy.assign (settings.num_nodes, 0);
+    l.writeback.assign (settings.num_nodes, 0);
+    return l;
+}
+
+int Coherence_checker::permission (int node, paddr_t line)
+{
+    Hash_entry *entry = Sim->get_L1 (node)->find_entry (line);
+
+    return entry ? entry->permission () : PERM_NONE;
+}
+
+void Coherence_checker::violation (paddr_t line, int node, const char *what)
+{
+    fprintf (stderr, "Coherence violation: %s -- line 0x%llx node %d clock %lld\n", what,
+             (unsigned long long int) line, node, (long long int) Global_Clock);
+    for (int i = 0; i < settings.num_nodes; i++)
+    {
+        fprintf (stderr, "  L1 %d: ", i);
+        if (Sim->get_L1 (i)->find_entry (line))
+            Sim->dump_cache_block (i, line);
+        else
+            fprintf (stderr, "not resident\n");
+    }
+    fatal_error ("Coherence check failed\n");
+}
+
+/** The line's state changed this cycle.  */
+void Coherence_checker::note (paddr_t line)
+{
+    noted.push_back (line);
+}
+
+/** The L1 took a processor request for the line.  */
+void Coherence_checker::request (int node, const Mreq *request)
+{
+    pending[node][request->addr] = request->msg;
+    fills[node].erase (request->addr);
+}
+
+/** The L1 answered the processor; the line is in the state the request
+ *  left it in.  */
+void Coherence_checker::complete (int node, paddr_t line)
+{
+    MAP<paddr_t, message_t>::iterator it = pending[node].find (line);
+    MAP<paddr_t, Checker_fill>::iterator f = fills[node].find (line);
+    Checker_line &l = get_line (line);
+    int perm = permission (node, line);
+
+    if (it == pending[node].end ())
+        violation (line, node, "data returned with no request outstanding");
+
+    if (it->second == STORE && perm != PERM_WRITE)
+        violation (line, node, "store completed without write permission");
+    if (it->second == LOAD && perm == PERM_NONE)
+        violation (line, node, "load completed without read permission");
+
+    /** A core that kept its copy through the miss (an upgrade) ignores the
+     *  DATA; otherwise the DATA is the copy.  Either way it must have seen
+     *  every store so far.  */
+    if (l.copy[node] == 0)
+    {
+        if (f == fills[node].end ())
+            violation (line, node, "request completed with no data");
+        if (f->second.version != l.version)
+            violation (line, node, f->second.from_memory ? "memory supplied a stale value"
+                                                         : "a cache supplied a stale value");
+        l.copy[node] = f->second.version;
+    }
+    else if (l.copy[node] != l.version)
+    {
+        violation (line, node, it->second == STORE ? "store to a stale copy"
+                                                   : "load returned a stale value");
+    }
+
+    if (it->second == STORE)
+        l.copy[node] = ++l.version;
+
+    if (f != fills[node].end ())
+        fills[node].erase (f);
+    pending[node].erase (it);
+    noted.push_back (line);
+    transactions++;
+}
+
+/** The copy is still held when a PUT leaves, and the writeback buffer
+ *  answers from the PUT once it is gone.  */
+void Coherence_checker::cache_send (int node, Mreq *data)
+{
+    Checker_line &l = get_line (data->addr);
+
+    if (data->msg == PUTS || data->msg == PUTM)
+        l.writeback[node] = l.copy[node];
+    data->data_version = l.copy[node] ? l.copy[node] : l.writeback[node];
+}
+
+counter_t Coherence_checker::memory_version (paddr_t line)
+{
+    return get_line (line).memory;
+}
+
+void Coherence_checker::memory_write (const Mreq *data)
+{
+    if (data->data_version)
+        get_line (data->addr).memory = data->data_version;
+}
+
+void Coherence_checker::fill (int node, const Mreq *data)
+{
+    Checker_fill &f = fills[node][data->addr];
+
+    f.version = data->data_version;
+    f.from_memory = (data->src_mid.module_index != L1_M);
+}
+
+void Coherence_checker::check (void)
+{
+    if (noted.empty ())
+        return;
+
+    sort (noted.begin (), noted.end ());
+    noted.erase (unique (noted.begin (), noted.end ()), noted.end ());
+
+    for (unsigned int i = 0; i < noted.size (); i++)
+    {
+        paddr_t line = noted[i];
+        Checker_line &l = get_line (line);
+        int writer = -1;
+        int reader = -1;
+
+        for (int node = 0; node < settings.num_nodes; node++)
+        {
+            switch (permission (node, line)) {
+            case PERM_WRITE:
+                if (writer >= 0)
+                    violation (line, node, "two cores can write the line");
+                writer = node;
+                break;
+            case PERM_READ:
+                reader = node;
+                break;
+            default:
+                /** Copy dropped; the next fill starts a new one.  */
+                l.copy[node] = 0;
+            }
+        }
+
+        if (writer >= 0 && reader >= 0)
+            violation (line, reader, "a core can read the line while another can write it");
+
+        line_checks++;
+    }
+    noted.clear ();
+}
+
+/** On stdout, so a stress run can keep just this line.  */
+void Coherence_checker::report (const char *protocol, double seconds)
+{
+    printf ("Coherence check passed: %s %llu transactions, %llu line checks, %.0f transactions/sec\n",
+            protocol, (unsigned long long int) transactions, (unsigned long long int) line_checks,
+            seconds > 0 ? transactions / seconds : 0.0);
+}
@@ -0,0 +1,89 @@
+#ifndef STRESS_H_
+#define STRESS_H_
+
+#include "mreq.h"
+#include "types.h"
+
+/** Synthetic traces.  spec is <pattern>[,<cores>[,<accesses per core>]]
+ *  with pattern one of false_sharing, migratory, producer_consumer or
+ *  random; writes config and p<N>.trace into dir.  */
+void stress_generate (const char *spec, const char *dir);
+
+/** Checker's view of one line.  */
+class Checker_line {
+public:
+    /** Bumped by every completed store; 1 is the initial memory value.  */
+    counter_t version;
+
+    /** Version memory holds, brought up to date by writebacks and flushes.  */
+    counter_t memory;
+
+    /** Version each core's copy holds, 0 for no copy.  */
+    VECTOR<counter_t> copy;
+
+    /** Version of each core's last PUT, which its writeback buffer keeps
+     *  supplying after the copy itself is gone.  */
+    VECTOR<counter_t> writeback;
+};
+
+/** A DATA that reached a core and has not completed its request yet.  */
+class Checker_fill {
+public:
+    counter_t version;
+    bool from_memory;
+};
+
+/**
+ * Coherence invariants, checked on the lock-step engine.  Every line whose
+ * state changed during a cycle is checked for single writer / multiple
+ * readers across the L1s at the end of the cycle.  Every completed
+ * processor request is checked against the access its line grants, and
+ * loads must see the last store to the line (data value invariant).  Every
+ * DATA and PUTM is stamped with the version it carries, so a fill must
+ * bring the last store whether an owner or memory supplied it.  Any
+ * violation is fatal.
+ */
+class Coherence_checker {
+public:
+    Coherence_checker ();
+    ~Coherence_checker ();
+
+    /** Called by the L1s.  */
+    void note (paddr_t line);
+    void request (int node, const Mreq *request);
+    void complete (int node, paddr_t line);
+
+    /** Stamp the DATA or PUT a cache puts on the interconnect.  */
+    void cache_send (int node, Mreq *data);
+    /** What memory would return for the line now.  */
+    counter_t memory_version (paddr_t line);
+    /** A PUTM or a cache's DATA reached memory.  */
+    void memory_write (const Mreq *data);
+    /** A DATA arrived at node.  */
+    void fill (int node, const Mreq *data);
+
+    /** End of cycle.  */
+    void check (void);
+
+    void report (const char *protocol, double seconds);
+
+    counter_t transactions;
+    counter_t line_checks;
+
+private:
+    MAP<paddr_t, Checker_line> lines;
+
+    /** Per core, the processor request in flight for each line.  */
+    VECTOR<MAP<paddr_t, message_t> > pending;
+
+    /** Per core, the DATA each pending request was filled with.  */
+    VECTOR<MAP<paddr_t, Checker_fill> > fills;
+
+    VECTOR<paddr_t> noted;
+
+    Checker_line &get_line (paddr_t line);
+    int permission (int node, paddr_t line);
+    void violation (paddr_t line, int node, const char *what);
+};
+
+#endif /* STRESS_H_ */
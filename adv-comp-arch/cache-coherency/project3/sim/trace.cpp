@@ -0,0 +1,162 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+extern Sim_settings settings;
+
+/** Binary trace file: this header, then Trace_records in the order the
+ *  rings were written out.  Each thread's records are in clock order.  */
+#define TRACE_MAGIC   "CSXTRACE"
+#define TRACE_VERSION 1
+
+class Trace_header {
+public:
+    char magic[8];
+    int version;
+    int record_size;
+};
+
+__thread Trace_ring *trace_ring = NULL;
+
+static FILE *trace_out = NULL;
+
+/** Every thread's ring, so trace_close () can write out what is left.  */
+static VECTOR<Trace_ring *> trace_rings;
+static pthread_mutex_t trace_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void trace_ring_write (Trace_ring *ring)
+{
+    if (trace_out)
+    {
+        if (fwrite (ring->records, sizeof (Trace_record), ring->count, trace_out)
+            != (size_t) ring->count)
+            fatal_error ("Trace: write to %s failed\n", settings.trace_file);
+    }
+    else
+    {
+        /** A record takes several stdio calls; keep quantum workers' lines whole.  */
+        flockfile (stderr);
+        for (int i = 0; i < ring->count; i++)
+            trace_print (stderr, &ring->records[i]);
+        funlockfile (stderr);
+    }
+    ring->count = 0;
+}
+
+/** Empty the calling thread's ring, allocating it on first use.  */
+Trace_ring *trace_ring_drain (void)
+{
+    if (trace_ring == NULL)
+    {
+        trace_ring = new Trace_ring;
+        trace_ring->count = 0;
+
+        pthread_mutex_lock (&trace_rings_lock);
+        trace_rings.push_back (trace_ring);
+        pthread_mutex_unlock (&trace_rings_lock);
+        return trace_ring;
+    }
+
+    trace_ring_write (trace_ring);
+    return trace_ring;
+}
+
+void trace_open (void)
+{
+    Trace_header header;
+
+    if (settings.trace_file == NULL)
+        return;
+
+    trace_out = fopen (settings.trace_file, "wb");
+    if (trace_out == NULL)
+        fatal_error ("Trace: unable to open %s\n", settings.trace_file);
+
+    memcpy (header.magic, TRACE_MAGIC, sizeof (header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof (Trace_record);
+    fwrite (&header, sizeof (header), 1, trace_out);
+}
+
+/** Called once the workers have stopped.  */
+void trace_close (void)
+{
+    for (unsigned int i = 0; i < trace_rings.size (); i++)
+    {
+        trace_ring_write (trace_rings[i]);
+        delete trace_rings[i];
+    }
+    trace_rings.clear ();
+    trace_ring = NULL;
+
+    if (trace_out)
+    {
+        fclose (trace_out);
+        trace_out = NULL;
+    }
+}
+
+/** Same text the simulator used to print for each event.  */
+void trace_print (FILE *out, const Trace_record *r)
+{
+    static const char *prefix[TRACE_EVENT_NUM] = {
+        "", "", "** PROC REQUEST -- ", "*** SNOOP REQUEST -- ",
+        "*** NETWORK REQUEST -- ", "*** DIR REQUEST -- ", "", ""};
+
+    switch (r->event) {
+    case TRACE_FETCH:
+        fprintf (out, "* FETCH -- PR: %d -- Clock: %lld -- %c 0x%llx\n", r->node,
+                 (long long int) r->clock, r->op, (unsigned long long int) r->addr);
+        break;
+    case TRACE_COMPLETE:
+        fprintf (out, "* COMPLETE -- PR: %d -- Clock: %lld\n", r->node, (long long int) r->clock);
+        break;
+    case TRACE_PROC_REQUEST:
+    case TRACE_SNOOP_REQUEST:
+    case TRACE_NETWORK_REQUEST:
+    case TRACE_DIR_REQUEST:
+        fputs (prefix[r->event], out);
+        print_id ("node", (ModuleID){r->node, (module_t) r->module}, out);
+        print_id ("src", (ModuleID){r->src_node, (module_t) r->src_module}, out);
+        print_id ("dest", (ModuleID){r->dest_node, (module_t) r->dest_module}, out);
+        fprintf (out, "tag: 0x%8llx clock: %8lld ", (long long int) r->addr, (long long int) r->clock);
+        fprintf (out, " %8s\n", Mreq::message_t_str[r->msg]);
+        break;
+    case TRACE_DATA_SEND_CACHE:
+        fprintf (out, "**** DATA_SEND Cache: %d -- Clock: %lld\n", r->node, (long long int) r->clock);
+        break;
+    case TRACE_DATA_SEND_MC:
+        fprintf (out, "**** DATA SEND MC -- Clock: %lld\n", (long long int) r->clock);
+        break;
+    default:
+        fatal_error ("Trace: bad event %d\n", r->event);
+    }
+}
+
+/** Offline decoder: print a binary trace as text on stdout.  */
+void trace_decode (const char *path)
+{
+    Trace_header header;
+    Trace_record *records = new Trace_record[TRACE_RING_RECORDS];
+    FILE *in = fopen (path, "rb");
+    size_t n;
+
+    if (in == NULL)
+        fatal_error ("Trace: unable to open %s\n", path);
+
+    if (fread (&header, sizeof (header), 1, in) != 1 ||
+        memcmp (header.magic, TRACE_MAGIC, sizeof (header.magic)) ||
+        header.version != TRACE_VERSION ||
+        header.record_size != (int) sizeof (Trace_record))
+        fatal_error ("Trace: %s is not a version %d trace\n", path, TRACE_VERSION);
+
+    while ((n = fread (records, sizeof (Trace_record), TRACE_RING_RECORDS, in)) > 0)
+        for (size_t i = 0; i < n; i++)
+            trace_print (stdout, &records[i]);
+
+    fclose (in);
+    delete [] records;
+}
@@ -0,0 +1,152 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdio.h>
+
+#include "module.h"
+#include "mreq.h"
+#include "settings.h"
+#include "sim.h"
+#include "types.h"
+
+extern Sim_settings settings;
+
+/** Event levels.  settings.trace_level selects them at run time; anything
+ *  above TRACE_MAX_LEVEL is compiled out, e.g. make DBG=-DTRACE_MAX_LEVEL=0.  */
+#define TRACE_NONE          0
+#define TRACE_PROC          1   /** FETCH, COMPLETE.  */
+#define TRACE_CACHE         2   /** PROC REQUEST.  */
+#define TRACE_COHERENCE     3   /** SNOOP/NETWORK/DIR REQUEST, DATA SEND.  */
+
+#ifndef TRACE_MAX_LEVEL
+#define TRACE_MAX_LEVEL     TRACE_COHERENCE
+#endif
+
+typedef enum {
+    TRACE_FETCH = 0,
+    TRACE_COMPLETE,
+    TRACE_PROC_REQUEST,
+    TRACE_SNOOP_REQUEST,
+    TRACE_NETWORK_REQUEST,
+    TRACE_DIR_REQUEST,
+    TRACE_DATA_SEND_CACHE,
+    TRACE_DATA_SEND_MC,
+    TRACE_EVENT_NUM
+} trace_event_t;
+
+/** One event.  Only raw fields are stored; trace_print () turns a record
+ *  into the text line the simulator used to fprintf.  */
+class Trace_record {
+public:
+    timestamp_t clock;
+    paddr_t addr;           /** Line tag for requests, byte address for FETCH.  */
+    short node;
+    short src_node;
+    short dest_node;
+    unsigned char event;
+    unsigned char module;
+    unsigned char src_module;
+    unsigned char dest_module;
+    unsigned char msg;
+    char op;
+};
+
+#define TRACE_RING_RECORDS  4096
+
+/** Per-thread event buffer.  With a trace file it is written out in one
+ *  block when full; on the text sink every record is printed right away so
+ *  it interleaves correctly with the rest of stderr.  */
+class Trace_ring {
+public:
+    int count;
+    Trace_record records[TRACE_RING_RECORDS];
+};
+
+extern __thread Trace_ring *trace_ring;
+
+Trace_ring *trace_ring_drain (void);
+void trace_open (void);
+void trace_close (void);
+void trace_print (FILE *out, const Trace_record *r);
+void trace_decode (const char *path);
+
+inline bool trace_enabled (int level)
+{
+    return level <= TRACE_MAX_LEVEL && level <= settings.trace_level;
+}
+
+inline Trace_record *trace_claim (void)
+{
+    Trace_ring *ring = trace_ring;
+
+    if (ring == NULL || ring->count == TRACE_RING_RECORDS)
+        ring = trace_ring_drain ();
+    return &ring->records[ring->count++];
+}
+
+inline void trace_commit (void)
+{
+    if (settings.trace_file == NULL)
+        trace_ring_drain ();
+}
+
+/** Event recorders.  */
+inline void trace_fetch (ModuleID pr, char op, paddr_t addr)
+{
+    if (!trace_enabled (TRACE_PROC))
+        return;
+
+    Trace_record *r = trace_claim ();
+    r->event = TRACE_FETCH;
+    r->clock = Global_Clock;
+    r->node = pr.nodeID;
+    r->op = op;
+    r->addr = addr;
+    trace_commit ();
+}
+
+inline void trace_complete (ModuleID pr)
+{
+    if (!trace_enabled (TRACE_PROC))
+        return;
+
+    Trace_record *r = trace_claim ();
+    r->event = TRACE_COMPLETE;
+    r->clock = Global_Clock;
+    r->node = pr.nodeID;
+    trace_commit ();
+}
+
+/** A request as seen by module mid (PROC, SNOOP, NETWORK or DIR REQUEST).  */
+inline void trace_request (trace_event_t event, ModuleID mid, const Mreq *request)
+{
+    if (!trace_enabled (event == TRACE_PROC_REQUEST ? TRACE_CACHE : TRACE_COHERENCE))
+        return;
+
+    Trace_record *r = trace_claim ();
+    r->event = event;
+    r->clock = Global_Clock;
+    r->node = mid.nodeID;
+    r->module = mid.module_index;
+    r->src_node = request->src_mid.nodeID;
+    r->src_module = request->src_mid.module_index;
+    r->dest_node = request->dest_mid.nodeID;
+    r->dest_module = request->dest_mid.module_index;
+    r->msg = request->msg;
+    r->addr = request->addr >> settings.cache_line_size_log2;
+    trace_commit ();
+}
+
+inline void trace_data_send (trace_event_t event, ModuleID mid)
+{
+    if (!trace_enabled (TRACE_COHERENCE))
+        return;
+
+    Trace_record *r = trace_claim ();
+    r->event = event;
+    r->clock = Global_Clock;
+    r->node = mid.nodeID;
+    trace_commit ();
+}
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,336 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "trace_reader.h"
+
+/** Binary trace: this header, then one LEB128 varint per access holding
+ *  the zigzagged address delta from the previous access, shifted left one,
+ *  with the low bit set for a write.  The header records the size and
+ *  modification time of the text trace it was converted from.  */
+#define BTRACE_MAGIC   "CSXBTRC"
+#define BTRACE_VERSION 2
+
+class Btrace_header {
+public:
+    char magic[8];
+    int version;
+    int reserved;
+    unsigned long long count;
+    long long source_size;
+    long long source_mtime_sec;
+    long long source_mtime_nsec;
+};
+
+/** True if header was converted from the text trace described by st.  */
+static bool btrace_matches (const Btrace_header *header, const struct stat *st)
+{
+    return header->source_size == (long long) st->st_size &&
+           header->source_mtime_sec == (long long) st->st_mtim.tv_sec &&
+           header->source_mtime_nsec == (long long) st->st_mtim.tv_nsec;
+}
+
+/** p<N>.trace -> p<N>.btrace; NULL if the name does not end in .trace.  */
+static char *binary_name (const char *trace_file)
+{
+    size_t len = strlen (trace_file);
+    char *name;
+
+    if (len < 6 || strcmp (trace_file + len - 6, ".trace"))
+        return NULL;
+
+    name = (char *) malloc (len + 2);
+    memcpy (name, trace_file, len - 6);
+    strcpy (name + len - 6, ".btrace");
+    return name;
+}
+
+/***************************************************************************
+ * Trace_reader constructor, destructor, and functions.
+ ***************************************************************************/
+Trace_reader::Trace_reader (const char *trace_file)
+{
+    char *bin = binary_name (trace_file);
+    int fd = bin ? open (bin, O_RDONLY) : -1;
+
+    text = NULL;
+    map = NULL;
+    map_size = 0;
+    cursor = NULL;
+    last_addr = 0;
+    head = 0;
+    tail = 0;
+    eof = false;
+    async = false;
+
+    if (fd >= 0)
+    {
+        struct stat st;
+        struct stat source;
+        const Btrace_header *header;
+
+        if (fstat (fd, &st) || st.st_size < (off_t) sizeof (Btrace_header))
+            fatal_error ("Trace_reader: %s is truncated\n", bin);
+
+        map_size = st.st_size;
+        map = (const unsigned char *) mmap (NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close (fd);
+        if (map == MAP_FAILED)
+            fatal_error ("Trace_reader: unable to map %s\n", bin);
+        madvise ((void *) map, map_size, MADV_SEQUENTIAL);
+
+        header = (const Btrace_header *) map;
+        if (memcmp (header->magic, BTRACE_MAGIC, sizeof (BTRACE_MAGIC)) ||
+            header->version != BTRACE_VERSION)
+            fatal_error ("Trace_reader: %s is not a version %d binary trace\n", bin, BTRACE_VERSION);
+
+        /** A text trace rewritten since the conversion wins over its
+         *  binary form.  Without the text trace the binary one stands.  */
+        if (stat (trace_file, &source) == 0 && !btrace_matches (header, &source))
+        {
+            fprintf (stderr, "Trace_reader: ignoring stale %s\n", bin);
+            munmap ((void *) map, map_size);
+            map = NULL;
+            map_size = 0;
+        }
+        else
+            cursor = map + sizeof (Btrace_header);
+    }
+
+    if (map == NULL)
+    {
+        text = fopen (trace_file, "r");
+        if (text == NULL)
+            fatal_error ("Trace_reader: unable to open %s\n", trace_file);
+    }
+
+    free (bin);
+}
+
+Trace_reader::~Trace_reader ()
+{
+    if (text)
+        fclose (text);
+    if (map)
+        munmap ((void *) map, map_size);
+}
+
+bool Trace_reader::decode (Trace_op *op)
+{
+    if (text)
+    {
+        char c;
+        unsigned long long int addr;
+
+        if (fscanf (text, "%c 0x%llx\n", &c, &addr) != 2)
+            return false;
+        op->op = c;
+        op->addr = addr;
+        return true;
+    }
+
+    const unsigned char *end = map + map_size;
+    unsigned long long int v = 0;
+    unsigned long long int zz;
+    long long int delta;
+    int shift = 0;
+
+    if (cursor == end)
+        return false;
+
+    do {
+        if (cursor == end || shift > 63)
+            fatal_error ("Trace_reader: corrupt binary trace\n");
+        v |= (unsigned long long int)(*cursor & 0x7f) << shift;
+        shift += 7;
+    } while (*cursor++ & 0x80);
+
+    zz = v >> 1;
+    delta = (long long int)(zz >> 1) ^ -(long long int)(zz & 1);
+    last_addr += delta;
+
+    op->op = (v & 1) ? 'w' : 'r';
+    op->addr = last_addr;
+    return true;
+}
+
+bool Trace_reader::next (char *op, paddr_t *addr)
+{
+    Trace_op t;
+
+    if (!async)
+    {
+        if (!decode (&t))
+            return false;
+        *op = t.op;
+        *addr = t.addr;
+        return true;
+    }
+
+    /** Only this side writes head; the acquire on tail makes the slots the
+     *  producer published visible, and the release on head hands the slot
+     *  back only after it has been copied out.  */
+    unsigned int h = head;
+
+    while (h == __atomic_load_n (&tail, __ATOMIC_ACQUIRE))
+    {
+        if (__atomic_load_n (&eof, __ATOMIC_ACQUIRE))
+        {
+            /** eof is published after the last tail update.  */
+            if (h == __atomic_load_n (&tail, __ATOMIC_ACQUIRE))
+                return false;
+            break;
+        }
+        sched_yield ();
+    }
+
+    t = ring[h % TRACE_READER_RING];
+    __atomic_store_n (&head, h + 1, __ATOMIC_RELEASE);
+
+    *op = t.op;
+    *addr = t.addr;
+    return true;
+}
+
+int Trace_reader::fill (void)
+{
+    int n = 0;
+    unsigned int t = tail;
+
+    if (eof)
+        return 0;
+
+    while (n < TRACE_READER_BATCH &&
+           t - __atomic_load_n (&head, __ATOMIC_ACQUIRE) < TRACE_READER_RING)
+    {
+        if (!decode (&ring[t % TRACE_READER_RING]))
+        {
+            __atomic_store_n (&eof, true, __ATOMIC_RELEASE);
+            break;
+        }
+        __atomic_store_n (&tail, ++t, __ATOMIC_RELEASE);
+        n++;
+    }
+    return n;
+}
+
+/***************************************************************************
+ * Background prefetcher.
+ ***************************************************************************/
+static pthread_t prefetch_thread;
+static bool prefetch_running = false;
+static bool prefetch_stop;
+static Trace_reader **prefetch_readers;
+static int prefetch_num_readers;
+
+static void *trace_prefetch_loop (void *arg)
+{
+    while (!__atomic_load_n (&prefetch_stop, __ATOMIC_ACQUIRE))
+    {
+        int progress = 0;
+        bool done = true;
+
+        for (int i = 0; i < prefetch_num_readers; i++)
+        {
+            progress += prefetch_readers[i]->fill ();
+            done = done && prefetch_readers[i]->at_eof ();
+        }
+
+        if (done)
+            break;
+        if (!progress)
+            usleep (50);
+    }
+    return NULL;
+}
+
+void trace_prefetch_start (Trace_reader **readers, int num_readers)
+{
+    prefetch_readers = readers;
+    prefetch_num_readers = num_readers;
+    prefetch_stop = false;
+
+    for (int i = 0; i < num_readers; i++)
+        readers[i]->async = true;
+
+    if (pthread_create (&prefetch_thread, NULL, trace_prefetch_loop, NULL))
+        fatal_error ("Trace_reader: unable to start the prefetch thread\n");
+    prefetch_running = true;
+}
+
+void trace_prefetch_stop (void)
+{
+    if (!prefetch_running)
+        return;
+
+    __atomic_store_n (&prefetch_stop, true, __ATOMIC_RELEASE);
+    pthread_join (prefetch_thread, NULL);
+    prefetch_running = false;
+}
+
+/***************************************************************************
+ * Text to binary conversion.
+ ***************************************************************************/
+void trace_convert (const char *trace_file)
+{
+    char *bin = binary_name (trace_file);
+    FILE *in = fopen (trace_file, "r");
+    FILE *out;
+    Btrace_header header;
+    struct stat source;
+    paddr_t last = 0;
+    char c;
+    unsigned long long int addr;
+
+    if (bin == NULL || in == NULL || fstat (fileno (in), &source))
+        fatal_error ("Trace_reader: cannot convert %s\n", trace_file);
+
+    out = fopen (bin, "wb");
+    if (out == NULL)
+        fatal_error ("Trace_reader: unable to create %s\n", bin);
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, BTRACE_MAGIC, sizeof (BTRACE_MAGIC));
+    header.version = BTRACE_VERSION;
+    header.source_size = source.st_size;
+    header.source_mtime_sec = source.st_mtim.tv_sec;
+    header.source_mtime_nsec = source.st_mtim.tv_nsec;
+    fwrite (&header, sizeof (header), 1, out);
+
+    while (fscanf (in, "%c 0x%llx\n", &c, &addr) == 2)
+    {
+        long long int delta = (long long int)(addr - last);
+        unsigned long long int zz = ((unsigned long long int) delta << 1) ^ (unsigned long long int)(delta >> 63);
+        unsigned long long int v;
+
+        if (c != 'r' && c != 'w')
+            fatal_error ("Trace_reader: %s has unknown operation %c\n", trace_file, c);
+        if (zz >> 63)
+            fatal_error ("Trace_reader: %s has an address stride too large to encode\n", trace_file);
+
+        v = (zz << 1) | (c == 'w');
+        do {
+            unsigned char byte = v & 0x7f;
+            v >>= 7;
+            fputc (v ? byte | 0x80 : byte, out);
+        } while (v);
+
+        last = addr;
+        header.count++;
+    }
+
+    /** Rewrite the header with the final count.  */
+    fseek (out, 0, SEEK_SET);
+    fwrite (&header, sizeof (header), 1, out);
+
+    fclose (out);
+    fclose (in);
+    free (bin);
+}
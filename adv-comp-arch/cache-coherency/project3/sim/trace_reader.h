@@ -0,0 +1,71 @@
+#ifndef TRACE_READER_H_
+#define TRACE_READER_H_
+
+#include <stdio.h>
+
+#include "types.h"
+
+/** Decoded accesses buffered per core.  */
+#define TRACE_READER_RING   4096
+
+/** Accesses the prefetcher decodes for one core before moving on.  */
+#define TRACE_READER_BATCH  256
+
+class Trace_op {
+public:
+    paddr_t addr;
+    char op;
+};
+
+/**
+ * Per-core input trace.  Reads p<N>.btrace through mmap when the converter
+ * has produced one from the current p<N>.trace, and the text trace otherwise.  With prefetching on,
+ * a background thread decodes into the ring ahead of the processor, which
+ * only pops; otherwise next () decodes in place.
+ */
+class Trace_reader {
+public:
+    Trace_reader (const char *trace_file);
+    ~Trace_reader ();
+
+    /** Consumer side.  False at the end of the trace.  */
+    bool next (char *op, paddr_t *addr);
+
+    /** Producer side.  Decodes up to TRACE_READER_BATCH accesses into the
+     *  ring and returns how many.  */
+    int fill (void);
+
+    /** Producer has decoded the whole trace.  */
+    bool at_eof (void) { return __atomic_load_n (&eof, __ATOMIC_ACQUIRE); }
+
+    /** Set once the prefetcher owns decoding.  */
+    bool async;
+
+private:
+    FILE *text;
+
+    /** Binary trace mapping.  */
+    const unsigned char *map;
+    size_t map_size;
+    const unsigned char *cursor;
+    paddr_t last_addr;
+
+    /** Single-producer single-consumer ring.  The producer owns tail and
+     *  eof, the consumer head; each side publishes its index with a release
+     *  store and reads the other's with an acquire load.  */
+    Trace_op ring[TRACE_READER_RING];
+    unsigned int head;
+    unsigned int tail;
+    bool eof;
+
+    bool decode (Trace_op *op);
+};
+
+/** Background decoding for every core's reader.  */
+void trace_prefetch_start (Trace_reader **readers, int num_readers);
+void trace_prefetch_stop (void);
+
+/** Write trace_file's binary form next to it: p<N>.trace -> p<N>.btrace.  */
+void trace_convert (const char *trace_file);
+
+#endif /* TRACE_READER_H_ */
@@ -1,4 +1,5 @@
 #include "cachesim.hpp"
+#include "cachesim_repl.hpp"
 #include <assert.h>
 #include <math.h>
 #include <time.h>
@@ -11,15 +12,6 @@
 #include <sys/time.h>
 using namespace std;
 
-struct c_entry {
-	uint64_t tag;
-	//uint32_t data;
-	uint64_t lru_time;
-	bool b_dirty;
-	bool b_valid;
-	bool prefetch;
-	bool across_page;
-};
 //#define DEBUG
 #ifdef DEBUG
 #define	print_dbg(fmt, arg...) 					\
@@ -30,43 +22,132 @@ do {											\
 #define	print_dbg(fmt, arg...)
 #endif
 
-typedef std::map<uint64_t, vector<c_entry> > L1CacheMap;
-typedef std::map<uint64_t, vector<c_entry> > L2CacheMap;
+typedef std::map<uint64_t, vector<c_entry> > CacheMap;
+
+struct _CacheParams {
+	uint64_t cache_sz;
+	uint64_t tag_mask;
+	uint64_t index_mask;
+	uint64_t offset_mask;
+	uint32_t nWays; /*Associativity*/
+	uint8_t offset_bits; /*B*/
+	uint8_t tag_bits;
+	uint8_t index_bits; /*C-B-S*/
+};
+
+/*How a level's contents relate to the levels above it*/
+enum {
+	POLICY_NONINCLUSIVE, /*Fills go to every level, evictions are independent*/
+	POLICY_INCLUSIVE, /*Evicting a block drops it from every level above*/
+	POLICY_EXCLUSIVE /*Holds only what the level above evicted; a hit moves the block up*/
+};
 
-void L1ReadReq(uint64_t address, cache_stats_t* p_stats);
-c_entry L2ReadReq(uint64_t address, cache_stats_t* p_stats);
-void L1WriteReq(uint64_t address, cache_stats_t* p_stats);
-void L2WriteReq(uint64_t address, cache_stats_t* p_stats);
+/*Requests into a level*/
+enum {
+	REQ_READ, /*Load from the CPU, or a fill for the level above*/
+	REQ_WRITE, /*Store from the CPU, or a dirty block written back from above*/
+	REQ_VICTIM /*Clean block evicted from above, for an exclusive level*/
+};
+
+/*Extra cycles for a miss served by a level's victim or writeback buffer*/
+#define BUFFER_HIT_TIME 1
+/*Main memory*/
+#define MEMORY_PENALTY 500
+
+struct cache_level {
+	_CacheParams params;
+	CacheMap sets;
+	uint32_t policy;
+	double hit_time;
+	uint32_t victim_entries;
+	vector<c_entry> victim; /*Fully associative, MRU last; tag holds the block address*/
+	uint32_t wb_entries;
+	vector<c_entry> wb; /*Dirty blocks on their way down, oldest first*/
+	repl_policy* repl;
+	string repl_spec;
+	uint32_t mshrs; /*Timing mode*/
+	vector<pair<uint64_t, double> > mshr; /*Block and the cycle its data arrives*/
+};
+
+bool LevelReq(uint32_t lvl, uint64_t address, int req, cache_stats_t* p_stats);
+void Evict_Block(uint32_t lvl, c_entry blk, uint64_t evict_blk, cache_stats_t* p_stats);
 void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats);
-void Improve_granularity(std::vector<c_entry> *m_entry, uint32_t nCnt,
-		uint32_t nWays);
-void add_lru_info(uint64_t* lru_time);
-uint32_t find_lru_blk(std::vector<c_entry> *m_entry, uint32_t nWays);
 extern uint64_t conversion(uint64_t address);
-L1CacheMap L1Map;
-L2CacheMap L2Map;
+vector<cache_level> levels;
+const char* repl_default = "lru";
 uint64_t LastMBlk = 0;
-volatile uint64_t glrutime = 10000; /*For prefetched blocks, 0-9999 is used*/
 int64_t pending_stride = 0;
 int64_t diff = 0;
 int k_prefetch = 0;
-uint64_t gs1, gs2;
 extern int count_across_pages;
 extern int count_across_page_successful;
 extern std::map<uint64_t, physical_frame_LRU> page_table; //This is the page table
 extern std::map<uint64_t, virtual_frame> inverted_pg_table;
 extern uint64_t count;
 extern uint64_t actual_table_size;
-struct _CacheParams {
-	uint64_t cache_sz;
-	uint64_t tag_mask;
-	uint64_t index_mask;
-	uint64_t offset_mask;
-	uint32_t nWays; /*Associativity*/
-	uint8_t offset_bits; /*B*/
-	uint8_t tag_bits;
-	uint8_t index_bits; /*C-B-S*/
-} L1Params, L2Params;
+
+/*Set sampling: only addresses in the picked units are simulated. A unit is a
+ * value of index bits that every level shares, so a picked set at any level
+ * sees exactly the accesses it would in a full run. Each picked unit keeps its
+ * own counters so the estimates can be given error bars*/
+#define SAMPLE_MAX_BITS 16 /*Coarser units beyond this, to bound the tables*/
+#define SAMPLE_Z 1.96 /*95% confidence*/
+struct sample_counts {
+	uint64_t requests[MAX_LEVELS];
+	uint64_t fetches[MAX_LEVELS];
+	uint64_t buffered[MAX_LEVELS];
+	uint64_t tlb_misses;
+};
+uint32_t sample_rate = 1;
+uint8_t sample_shift;
+uint64_t sample_mask;
+vector<int32_t> sample_slot; /*Unit to its counters, -1 when not simulated*/
+vector<sample_counts> sample_units;
+
+/*Multi-core: each core has its own copy of the levels above the last, which
+ * is shared. The running core's copies are in levels; every other core's wait
+ * in its context, with its prefetcher's stride state*/
+#define UMON_SETS 32 /*Shared-level sets each UCP utility monitor follows*/
+#define UCP_EPOCH 32768 /*Shared-level reads between repartitions*/
+struct core_context {
+	vector<cache_level> priv; /*Spare copies while the core runs*/
+	uint64_t LastMBlk;
+	int64_t pending_stride;
+	int64_t diff;
+	uint32_t quota; /*Shared-level ways it may fill in a full set; 0 any*/
+	uint64_t lost; /*Its shared-level blocks evicted by other cores*/
+	/*Utility monitor: an LRU tag stack per followed set, hits by stack position*/
+	map<uint64_t, vector<uint64_t> > umon;
+	vector<uint64_t> umon_hits;
+};
+vector<core_context> cores;
+uint32_t cur_core = 0;
+bool ucp = 0;
+uint64_t ucp_reads = 0;
+uint64_t umon_stride = 1;
+vector<int32_t> bank_owner; /*Core that used each shared-level bank this round, -1 none*/
+
+/*Timing mode: the core issues one access a cycle and stalls only while L1 has
+ * no free MSHR. Each miss holds an MSHR in every level it misses in until its
+ * data arrives; later misses to that block wait for the same data, and hits the
+ * functional model already counts on a block still in flight pay what is left
+ * of its latency. Memory requests queue for a channel that moves bytes_per_cycle*/
+#define ISSUE_CYCLES 1
+#define PF_SWEEP 4096 /*Prefetch fills between sweeps of the landed ones*/
+uint32_t mshr_default = 0;
+double channel_bw = 0; /*Bytes per cycle; 0 timing off*/
+double timing_now = 0; /*Cycle the next access issues*/
+double channel_free = 0; /*Cycle the memory channel is next idle*/
+double mlp_covered = 0; /*Demand memory requests outstanding up to this cycle*/
+double mlp_busy = 0, mlp_total = 0; /*Cycles with any outstanding, request cycles*/
+double latency_total = 0;
+double channel_busy = 0;
+int32_t demand_served; /*Level that had the block, levels.size() for memory, -1 not yet*/
+bool demand_buffered; /*Served from a victim or writeback buffer*/
+bool demand_prefetched; /*First use of a prefetched block*/
+vector<uint64_t> pf_pending; /*Last-level blocks this access prefetched*/
+map<uint64_t, double> pf_ready; /*Prefetched last-level blocks still in flight*/
+uint32_t pf_fills = 0;
 
 /**
  * Subroutine for initializing the cache. You many add and initialize any global or heap
@@ -83,25 +164,498 @@ struct _CacheParams {
 void setup_cache(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2,
 		uint64_t b2, uint64_t s2, uint32_t k) {
 
-	L1Params.index_bits = c1 - b1 - s1;
-	L1Params.offset_bits = b1;
-	L1Params.index_mask = ((uint64_t) pow(2, (c1 - b1 - s1)) - 1) << b1;
-	L1Params.offset_mask = pow(2, b1) - 1;
-	L1Params.cache_sz = pow(2, c1);
-	L1Params.tag_bits = 64 - (c1 - s1);
-	L1Params.tag_mask = ((uint64_t) pow(2, (64 - (c1 - s1))) - 1) << (c1 - s1);
-	L2Params.offset_mask = pow(2, b2) - 1;
-	L2Params.index_mask = ((uint64_t) pow(2, (c2 - b2 - s2)) - 1) << b2;
-	L2Params.offset_bits = b2;
-	L2Params.index_bits = c2 - b2 - s2;
-	L2Params.cache_sz = pow(2, c2);
-	L2Params.tag_mask = ((uint64_t) pow(2, (64 - (c2 - s2))) - 1)
-			<< ((c2 - s2));
-	L1Params.nWays = pow(2, s1);
-	L2Params.nWays = pow(2, s2);
+	add_cache_level(c1, b1, s1, "");
+	add_cache_level(c2, b2, s2, "");
+	setup_hierarchy(k);
+}
+
+/**
+ * Append a level below the ones added so far; the first one is L1.
+ *
+ * @c, @b, @s As for setup_cache
+ * @opts Comma separated: "i" inclusive or "e" exclusive of the levels above (default
+ *       non-inclusive), "v<N>" N-entry victim buffer, "w<N>" N-entry writeback buffer,
+ *       "t<N>" hit time in cycles, "r<policy>" replacement (see cachesim_repl.hpp),
+ *       "m<N>" MSHRs in timing mode
+ */
+void add_cache_level(uint64_t c, uint64_t b, uint64_t s, const char* opts) {
+	cache_level L;
+	_CacheParams& P = L.params;
+	uint32_t lvl = levels.size();
+	const char* repl = repl_default;
+
+	if (lvl == MAX_LEVELS || c < b + s) {
+		fprintf(stderr, "Bad cache level L%u (C=%" PRIu64 " B=%" PRIu64 " S=%" PRIu64 ")\n",
+				lvl + 1, c, b, s);
+		exit(1);
+	}
+	P.index_bits = c - b - s;
+	P.offset_bits = b;
+	P.index_mask = ((uint64_t) pow(2, (c - b - s)) - 1) << b;
+	P.offset_mask = pow(2, b) - 1;
+	P.cache_sz = pow(2, c);
+	P.tag_bits = 64 - (c - s);
+	P.tag_mask = ((uint64_t) pow(2, (64 - (c - s))) - 1) << (c - s);
+	P.nWays = pow(2, s);
+	L.policy = POLICY_NONINCLUSIVE;
+	L.victim_entries = 0;
+	L.wb_entries = 0;
+	L.mshrs = mshr_default;
+	if (lvl == 0)
+		L.hit_time = (double) ((double) 2 + (double) (0.2 * (double) s));
+	else
+		L.hit_time = (double) ((double) 4 + (double) (0.4 * (double) s));
+
+	for (const char* o = opts; *o; o++) {
+		switch (*o) {
+		case 'i':
+			L.policy = POLICY_INCLUSIVE;
+			break;
+		case 'e':
+			L.policy = POLICY_EXCLUSIVE;
+			break;
+		case 'v':
+			L.victim_entries = strtoul(o + 1, (char**) &o, 10);
+			o--;
+			break;
+		case 'w':
+			L.wb_entries = strtoul(o + 1, (char**) &o, 10);
+			o--;
+			break;
+		case 't':
+			L.hit_time = strtod(o + 1, (char**) &o);
+			o--;
+			break;
+		case 'r':
+			repl = o + 1;
+			o += strcspn(o, ",") - 1;
+			break;
+		case 'm':
+			L.mshrs = strtoul(o + 1, (char**) &o, 10);
+			o--;
+			break;
+		case ',':
+			break;
+		default:
+			fprintf(stderr, "Bad option '%c' for cache level L%u\n", *o, lvl + 1);
+			exit(1);
+		}
+	}
+
+	/*A lower level's block must cover whole blocks of the level above; an exclusive
+	 * level swaps blocks with it, so they must be the same size*/
+	if (lvl && (b < levels[lvl - 1].params.offset_bits
+			|| (L.policy == POLICY_EXCLUSIVE && b != levels[lvl - 1].params.offset_bits))) {
+		fprintf(stderr, "Block size of L%u does not fit L%u\n", lvl + 1, lvl);
+		exit(1);
+	}
+	if (channel_bw && !L.mshrs) {
+		fprintf(stderr, "L%u needs at least one MSHR\n", lvl + 1);
+		exit(1);
+	}
+	if (lvl == 0 && L.policy != POLICY_NONINCLUSIVE) {
+		fprintf(stderr, "L1 has no level above to include or exclude\n");
+		exit(1);
+	}
+	L.repl_spec.assign(repl, strcspn(repl, ","));
+	L.repl = repl_create(L.repl_spec.c_str(), (uint64_t) 1 << P.index_bits, P.nWays);
+	if (!L.repl) {
+		fprintf(stderr, "Unknown replacement policy \"%s\" for cache level L%u\n", L.repl_spec.c_str(), lvl + 1);
+		exit(1);
+	}
+	levels.push_back(L);
+}
+
+/*Replacement for levels that do not name their own; must come before add_cache_level()*/
+void set_replacement(const char* spec) {
+	repl_default = spec;
+}
+
+/**
+ * Turn on timing mode; must come before add_cache_level().
+ *
+ * @mshrs MSHRs in levels that do not name their own number
+ * @bytes_per_cycle Width of the channel between the last level and memory
+ */
+void set_timing(uint32_t mshrs, double bytes_per_cycle) {
+	mshr_default = mshrs;
+	channel_bw = bytes_per_cycle;
+}
+
+void setup_hierarchy(uint32_t k) {
+	assert(levels.size() > 0);
 	k_prefetch = k;
-	gs1 = s1;
-	gs2 = s2;
+}
+
+/**
+ * Simulate only 1/rate of the sets, after the levels are set up. The units are
+ * picked by a bijective hash of the shared index bits, so exactly 1/rate of
+ * them are simulated and neighbouring sets are not picked together.
+ *
+ * @rate Power of two; 1 simulates everything
+ */
+void setup_sampling(uint32_t rate) {
+	uint32_t lo = 0, hi = 64, bits, units, picked;
+
+	if (rate <= 1)
+		return;
+	for (uint32_t lvl = 0; lvl < levels.size(); lvl++) {
+		_CacheParams& P = levels[lvl].params;
+
+		if (P.offset_bits > lo)
+			lo = P.offset_bits;
+		if (P.offset_bits + P.index_bits < hi)
+			hi = P.offset_bits + P.index_bits;
+	}
+	bits = hi > lo ? hi - lo : 0;
+	if (bits > SAMPLE_MAX_BITS)
+		bits = SAMPLE_MAX_BITS;
+	if (rate & (rate - 1) || ((uint64_t) 1 << bits) < 2 * (uint64_t) rate) {
+		fprintf(stderr, "Cannot sample 1/%u of the sets: the levels share %u index bits, "
+				"and the rate must be a power of two leaving at least two units\n", rate, bits);
+		exit(1);
+	}
+	units = 1u << bits;
+	picked = units / rate;
+	sample_rate = rate;
+	sample_shift = lo;
+	sample_mask = units - 1;
+	sample_slot.assign(units, -1);
+	sample_units.assign(picked, sample_counts());
+	for (uint32_t u = 0, n = 0; u < units; u++) {
+		uint64_t h = (u * 0x9E3779B97F4A7C15ULL) & sample_mask;
+
+		h ^= h >> (bits / 2 + 1);
+		if (h < picked)
+			sample_slot[u] = n++;
+	}
+}
+
+/**
+ * Give every core its own copy of the levels above the last one, and share the
+ * last among them, after the levels are set up. Core 0 runs first.
+ *
+ * @n Number of cores
+ * @nbanks Banks in the shared level, interleaved by set
+ * @partition Shared-level ways: "none", "ways:<N>,<N>,..." one quota per core,
+ *       or "ucp" for utility-based repartitioning as the run goes
+ */
+void setup_cores(uint32_t n, uint32_t nbanks, const char* partition) {
+	uint32_t shared = levels.size() - 1;
+	_CacheParams& P = levels[shared].params;
+	const char* p = partition;
+
+	if (n < 1 || n > MAX_CORES || !shared) {
+		fprintf(stderr, "Need 1 to %d cores and at least two cache levels\n", MAX_CORES);
+		exit(1);
+	}
+	cores.assign(n, core_context());
+	for (uint32_t c = 0; c < n; c++) {
+		for (uint32_t j = 0; j < shared; j++) {
+			cache_level L = levels[j];
+
+			L.repl = repl_create(L.repl_spec.c_str(), (uint64_t) 1 << L.params.index_bits, L.params.nWays);
+			cores[c].priv.push_back(L);
+		}
+	}
+	bank_owner.assign(nbanks ? nbanks : 1, -1);
+
+	if (!strcmp(p, "ucp")) {
+		ucp = 1;
+		umon_stride = ((uint64_t) 1 << P.index_bits) / UMON_SETS;
+		if (!umon_stride)
+			umon_stride = 1;
+		for (uint32_t c = 0; c < n; c++) {
+			cores[c].quota = P.nWays / n;
+			cores[c].umon_hits.assign(P.nWays, 0);
+		}
+	} else if (!strncmp(p, "ways:", 5)) {
+		uint32_t total = 0, c = 0;
+
+		for (p += 5; c < n && *p; c++) {
+			cores[c].quota = strtoul(p, (char**) &p, 10);
+			total += cores[c].quota;
+			if (*p == ',')
+				p++;
+		}
+		if (c != n || *p || total > P.nWays) {
+			fprintf(stderr, "Bad partition \"%s\": need %u quotas adding up to at most %u ways\n",
+					partition, n, P.nWays);
+			exit(1);
+		}
+	} else if (strcmp(p, "none")) {
+		fprintf(stderr, "Unknown partition \"%s\"\n", partition);
+		exit(1);
+	}
+	for (uint32_t c = 0; strcmp(partition, "none") && c < n; c++) {
+		if (!cores[c].quota || P.nWays > 64) {
+			fprintf(stderr, "Partitioning needs at most 64 ways and one way or more per core\n");
+			exit(1);
+		}
+	}
+}
+
+/*Switch the private levels and prefetcher state to those of core*/
+void select_core(uint32_t core) {
+	core_context& from = cores[cur_core];
+	core_context& to = cores[core];
+
+	if (core == cur_core)
+		return;
+	for (uint32_t j = 0; j + 1 < levels.size(); j++) {
+		swap(levels[j], from.priv[j]);
+		swap(levels[j], to.priv[j]);
+	}
+	from.LastMBlk = LastMBlk;
+	from.pending_stride = pending_stride;
+	from.diff = diff;
+	LastMBlk = to.LastMBlk;
+	pending_stride = to.pending_stride;
+	diff = to.diff;
+	cur_core = core;
+}
+
+/*Every core has had its turn; the shared-level banks are free again*/
+void cache_round(void) {
+	bank_owner.assign(bank_owner.size(), -1);
+}
+
+/*Ways of a full shared-level set the running core may replace: its own once it
+ * holds its quota, otherwise those of cores over theirs, else anyone's*/
+static uint64_t Partition_Ways(vector<c_entry>& row) {
+	uint32_t held[MAX_CORES] = { 0 };
+	uint64_t mine = 0, over = 0, others = 0;
+
+	if (cores.empty() || !cores[cur_core].quota)
+		return REPL_ALL_WAYS;
+	for (uint32_t nCnt = 0; nCnt < row.size(); nCnt++)
+		held[row[nCnt].core]++;
+	for (uint32_t nCnt = 0; nCnt < row.size(); nCnt++) {
+		uint32_t owner = row[nCnt].core;
+
+		if (owner == cur_core)
+			mine |= (uint64_t) 1 << nCnt;
+		else {
+			others |= (uint64_t) 1 << nCnt;
+			if (held[owner] > cores[owner].quota)
+				over |= (uint64_t) 1 << nCnt;
+		}
+	}
+	if (held[cur_core] >= cores[cur_core].quota)
+		return mine;
+	return over ? over : others;
+}
+
+/*Lookahead allocation (Qureshi and Patt): hand out ways a chunk at a time to
+ * the core that gains the most hits per way from them, then age the counters*/
+static void Ucp_Repartition(void) {
+	uint32_t n = cores.size();
+	uint32_t balance = levels.back().params.nWays;
+	vector<uint32_t> alloc(n, 1);
+
+	balance -= n;
+	while (balance) {
+		double best = -1;
+		uint32_t win = 0, win_ways = 1;
+
+		for (uint32_t c = 0; c < n; c++) {
+			uint64_t gain = 0;
+
+			for (uint32_t k = 1; k <= balance; k++) {
+				gain += cores[c].umon_hits[alloc[c] + k - 1];
+				if ((double) gain / k > best) {
+					best = (double) gain / k;
+					win = c;
+					win_ways = k;
+				}
+			}
+		}
+		alloc[win] += win_ways;
+		balance -= win_ways;
+	}
+	for (uint32_t c = 0; c < n; c++) {
+		cores[c].quota = alloc[c];
+		for (uint32_t w = 0; w < cores[c].umon_hits.size(); w++)
+			cores[c].umon_hits[w] /= 2;
+	}
+}
+
+/*A read reaching the shared level, as the running core would see it alone*/
+static void Umon_Access(uint64_t set, uint64_t tag) {
+	core_context& C = cores[cur_core];
+	vector<uint64_t>& stack = C.umon[set];
+	uint32_t pos;
+
+	for (pos = 0; pos < stack.size() && stack[pos] != tag; pos++)
+		;
+	if (pos < stack.size()) {
+		C.umon_hits[pos]++;
+		stack.erase(stack.begin() + pos);
+	} else if (stack.size() == C.umon_hits.size())
+		stack.pop_back();
+	stack.insert(stack.begin(), tag);
+	if (++ucp_reads % UCP_EPOCH == 0)
+		Ucp_Repartition();
+}
+
+/*A shared-level block left to make room for the running core's*/
+static void Shared_Evicted(const c_entry& blk, cache_stats_t* p_stats) {
+	if (!cores.empty() && blk.core != cur_core) {
+		p_stats->evicted_others++;
+		cores[blk.core].lost++;
+	}
+}
+
+/*The functional model found the demand block in lvl*/
+static inline void Timing_Served(int32_t lvl, bool buffered, bool prefetched) {
+	if (channel_bw && demand_served < 0) {
+		demand_served = lvl;
+		demand_buffered = buffered;
+		demand_prefetched = prefetched;
+	}
+}
+
+/*Book a block transfer on the memory channel no earlier than t; returns its start*/
+static double Channel_Take(double t) {
+	double xfer = (double) (levels.back().params.offset_mask + 1) / channel_bw;
+	double start = t > channel_free ? t : channel_free;
+
+	channel_free = start + xfer;
+	channel_busy += xfer;
+	return start;
+}
+
+/*In-flight entry of lvl for the block of address, if its data is not there by t*/
+static pair<uint64_t, double>* Mshr_Find(uint32_t lvl, uint64_t address, double t) {
+	cache_level& L = levels[lvl];
+	uint64_t blk = address >> L.params.offset_bits;
+
+	for (uint32_t i = 0; i < L.mshr.size(); i++)
+		if (L.mshr[i].first == blk && L.mshr[i].second > t)
+			return &L.mshr[i];
+	return NULL;
+}
+
+/**
+ * When the demand block is ready at lvl for a request that reaches it at t. Misses
+ * take an MSHR, waiting for one if need be, and go on to the level below.
+ *
+ * @p_issue Where the request stands when L1 had to wait for an MSHR
+ */
+static double Timing_Fetch(uint32_t lvl, uint64_t address, double t, double* p_issue,
+		cache_stats_t* p_stats) {
+	pair<uint64_t, double>* inflight;
+	double ready;
+
+	if (lvl == levels.size()) {
+		double start = Channel_Take(t);
+		double from = t > mlp_covered ? t : mlp_covered;
+
+		ready = start + MEMORY_PENALTY;
+		/*Requests come about in issue order, so only the end of the busy span moves*/
+		mlp_total += ready - t;
+		if (ready > from)
+			mlp_busy += ready - from;
+		if (ready > mlp_covered)
+			mlp_covered = ready;
+		for (uint32_t i = 0; i < pf_pending.size(); i++)
+			pf_ready[pf_pending[i]] = Channel_Take(t) + MEMORY_PENALTY;
+		pf_pending.clear();
+		return ready;
+	}
+
+	cache_level& L = levels[lvl];
+	ready = t + L.hit_time;
+	if ((inflight = Mshr_Find(lvl, address, t))) {
+		/*Secondary miss, or a hit on a block still on its way*/
+		p_stats->coalesced_misses++;
+		return inflight->second > ready ? inflight->second : ready;
+	}
+	if ((int32_t) lvl == demand_served) {
+		if (demand_buffered)
+			ready += BUFFER_HIT_TIME;
+		if (demand_prefetched && lvl + 1 == levels.size()) {
+			map<uint64_t, double>::iterator pf = pf_ready.find(address >> L.params.offset_bits);
+
+			if (pf != pf_ready.end()) {
+				if (pf->second > ready) {
+					p_stats->late_prefetches++;
+					ready = pf->second;
+				}
+				pf_ready.erase(pf);
+			}
+		}
+		return ready;
+	}
+
+	/*A miss: take a free MSHR, or wait for the one freeing first*/
+	uint32_t slot = 0;
+	bool found = 0;
+
+	for (uint32_t i = 0; i < L.mshr.size(); i++) {
+		if (L.mshr[i].second <= t) {
+			slot = i;
+			found = 1;
+			break;
+		}
+		if (L.mshr[i].second < L.mshr[slot].second)
+			slot = i;
+	}
+	if (!found && L.mshr.size() < L.mshrs) {
+		L.mshr.push_back(pair<uint64_t, double>());
+		slot = L.mshr.size() - 1;
+	} else if (!found) {
+		p_stats->mshr_stall_cycles += L.mshr[slot].second - t;
+		t = L.mshr[slot].second;
+		if (!lvl)
+			*p_issue = t;
+	}
+	ready = Timing_Fetch(lvl + 1, address, t + L.hit_time, p_issue, p_stats);
+	L.mshr[slot] = make_pair(address >> L.params.offset_bits, ready);
+	return ready;
+}
+
+/*Time the access the functional model just ran, with write_backs dirty blocks
+ * it pushed out of the last level going to memory behind it*/
+static void Timing_Access(uint64_t address, uint64_t write_backs, cache_stats_t* p_stats) {
+	double issue = timing_now, ready;
+
+	ready = Timing_Fetch(0, address, issue, &timing_now, p_stats);
+	latency_total += ready - issue;
+	while (write_backs--)
+		Channel_Take(timing_now);
+	/*Prefetches set off by a write back or a buffer hit go out now*/
+	for (uint32_t i = 0; i < pf_pending.size(); i++)
+		pf_ready[pf_pending[i]] = Channel_Take(timing_now) + MEMORY_PENALTY;
+	pf_pending.clear();
+	if (++pf_fills % PF_SWEEP == 0) {
+		for (map<uint64_t, double>::iterator pf = pf_ready.begin(); pf != pf_ready.end();) {
+			if (pf->second <= timing_now)
+				pf_ready.erase(pf++);
+			else
+				++pf;
+		}
+	}
+	if (ready > p_stats->cycles)
+		p_stats->cycles = ready;
+	timing_now += ISSUE_CYCLES;
+}
+
+static inline int32_t Sample_Slot(uint64_t address) {
+	return sample_slot[(address >> sample_shift) & sample_mask];
+}
+
+/*Add (sign 1) or take away (sign -1) the current totals, so that a unit's
+ * counters pick up everything one access sets off*/
+static void Sample_Count(sample_counts* u, cache_stats_t* p_stats, int sign) {
+	for (uint32_t lvl = 0; lvl < levels.size(); lvl++) {
+		level_stats_t* ls = &p_stats->levels[lvl];
+
+		u->requests[lvl] += sign * (lvl ? ls->reads : ls->reads + ls->writes);
+		u->fetches[lvl] += sign * ls->fetches;
+		u->buffered[lvl] += sign * (ls->victim_hits + ls->wb_hits);
+	}
+	u->tlb_misses += sign * p_stats->TLB_Misses;
 }
 
 /**
@@ -112,436 +666,310 @@ void setup_cache(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2,
  * @p_stats Pointer to the statistics structure
  */
 void cache_access(char rw, uint64_t address, cache_stats_t* p_stats) {
+	int32_t slot = -1;
+	uint64_t write_backs = 0;
 
 	print_dbg("\n"); print_dbg("%lld|%c|%llx", p_stats->accesses, rw, address);
 	//p_stats->accesses++;
+	if (sample_rate > 1) {
+		if ((slot = Sample_Slot(address)) < 0) {
+			p_stats->sample_skipped++;
+			return;
+		}
+		Sample_Count(&sample_units[slot], p_stats, -1);
+	}
+	if (channel_bw) {
+		demand_served = -1;
+		demand_buffered = 0;
+		demand_prefetched = 0;
+		write_backs = p_stats->levels[levels.size() - 1].write_backs;
+	}
 	switch (rw) {
 	case 'r':
 		p_stats->reads++;
-		L1ReadReq(address, p_stats);
+		LevelReq(0, address, REQ_READ, p_stats);
 
 		break;
 	case 'w':
 		p_stats->writes++;
-		L1WriteReq(address, p_stats);
+		LevelReq(0, address, REQ_WRITE, p_stats);
 		break;
 	default:
 		print_dbg("Request Type Error \n");
 	}
+	if (slot >= 0)
+		Sample_Count(&sample_units[slot], p_stats, 1);
+	if (channel_bw)
+		Timing_Access(address, p_stats->levels[levels.size() - 1].write_backs - write_backs, p_stats);
 }
-/*L1 Read*/
-void L1ReadReq(uint64_t address, cache_stats_t* p_stats) {
-	uint64_t CurTag = 0;
-	uint64_t L1RowDecoder = 0;
-	uint64_t evict_blk = 0;
-	struct c_entry L2_RowData;
-	L1CacheMap::iterator kpos;
-	uint32_t nWays = 0;
-	uint32_t nCnt = 0;
-	uint32_t nIndex = 0;
-	bool bFlag = 0;
-	bool hit = 0;
-	bool slotavailable = 0;
-
-	p_stats->L1_accesses++;
-	/*Construct Index and Tag using pre-set parameters*/
-	L1RowDecoder = (address & (L1Params.index_mask)) >> L1Params.offset_bits;
-	CurTag = (address & L1Params.tag_mask) >> (L1Params.index_bits
-			+ L1Params.offset_bits);
-	nWays = L1Params.nWays;
+/*Take a missing block back from the level's victim or writeback buffer*/
+static bool Buffer_Take(cache_level& L, uint64_t blk, bool* dirty, level_stats_t* ls) {
+	uint32_t nCnt;
 
-	if ((kpos = L1Map.find(L1RowDecoder)) != L1Map.end()) /*Row already present*/
-	{
-		/*Row is present, check for tag*/
-		for (nCnt = 0; nCnt < nWays; nCnt++) {
-			if (CurTag == kpos->second[nCnt].tag) {
-				print_dbg("|L1ReadHit(%llx)", (address&(~L1Params.offset_mask)));
-				hit = 1;
-				add_lru_info(&kpos->second[nCnt].lru_time);/*Set the lru time stamp*/
-				break;
-			} else if (!kpos->second[nCnt].tag)
-				slotavailable = 1; /*Indicates no eviction required*/
+	for (nCnt = 0; nCnt < L.victim.size(); nCnt++) {
+		if (L.victim[nCnt].tag == blk) {
+			*dirty = L.victim[nCnt].b_dirty;
+			L.victim.erase(L.victim.begin() + nCnt);
+			ls->victim_hits++;
+			return 1;
 		}
-		if (!hit) /*L1 Cache Read MISS*/
-		{
-			p_stats->L1_read_misses++;
-			print_dbg("|L1ReadMiss(%llx)", (address&(~L1Params.offset_mask)));
-			/*Fetch block from L2 before doing anything else*/
-			L2_RowData = L2ReadReq(address, p_stats);
-			if (!slotavailable)/*Check if eviction is required*/
-			{
-				nIndex = find_lru_blk(&kpos->second, nWays);
-				evict_blk = ((L1Map[L1RowDecoder][nIndex].tag
-						<< (L1Params.offset_bits + L1Params.index_bits))
-						| (L1RowDecoder << L1Params.offset_bits));
-				if (L1Map[L1RowDecoder][nIndex].b_dirty)/*Write to L2 if dirty*/
-				{/*Allocate Block L1 in next available slot, This is the copied block coming from L2. Update TS*/
-					L1Map[L1RowDecoder][nIndex].tag = CurTag;
-					L1Map[L1RowDecoder][nIndex].b_dirty = 0;
-					L1Map[L1RowDecoder][nIndex].b_valid = 1;
-					L1Map[L1RowDecoder][nIndex].prefetch = 0;
-					add_lru_info(&(L1Map[L1RowDecoder][nIndex].lru_time));
-					/*In some cases time-stamp for different blks show up as the same due to lack of granularity*/
-					print_dbg("|L1Put[tag=%llx, dirty=%d]", CurTag, L1Map[L1RowDecoder][nIndex].b_dirty); print_dbg("|L1Evict(%llx)", evict_blk); print_dbg("|L1WB(%llx)", evict_blk);
-					bFlag = 1;
-					L2WriteReq(evict_blk, p_stats);
+	}
+	for (nCnt = 0; nCnt < L.wb.size(); nCnt++) {
+		if (L.wb[nCnt].tag == blk) {
+			*dirty = 1;
+			L.wb.erase(L.wb.begin() + nCnt);
+			ls->wb_hits++;
+			return 1;
+		}
+	}
+	return 0;
+}
+/*Write a dirty block below lvl; past the last level it goes to memory*/
+static void Write_Down(uint32_t lvl, uint64_t evict_blk, cache_stats_t* p_stats) {
+	if (lvl + 1 < levels.size())
+		LevelReq(lvl + 1, evict_blk, REQ_WRITE, p_stats);
+}
+/*Drop every copy of [address, address + size) in U; true if any was dirty*/
+static bool Drop_Copies(cache_level& U, uint64_t address, uint64_t size, level_stats_t* ls) {
+	_CacheParams& P = U.params;
+	bool dirty = 0;
+
+	for (uint64_t a = address; a < address + size; a += P.offset_mask + 1) {
+		uint64_t row = (a & P.index_mask) >> P.offset_bits;
+		uint64_t tag = (a & P.tag_mask) >> (P.index_bits + P.offset_bits);
+		CacheMap::iterator kpos = U.sets.find(row);
+
+		if (kpos != U.sets.end()) {
+			for (uint32_t nCnt = 0; nCnt < P.nWays; nCnt++) {
+				if (tag && kpos->second[nCnt].tag == tag) {
+					dirty |= kpos->second[nCnt].b_dirty;
+					kpos->second[nCnt] = c_entry();
+					ls->back_invalidations++;
+					break;
 				}
-			} else /*Update index to next available slot*/
-			{
-				nIndex = 0;
-				while (L1Map[L1RowDecoder][nIndex].tag != 0)
-					nIndex++;
 			}
-			if (!bFlag) {/*Allocate Block L1 in next available slot, This is the copied block coming from L2. Update TS*/
-				L1Map[L1RowDecoder][nIndex].tag = CurTag;
-				L1Map[L1RowDecoder][nIndex].b_dirty = 0;
-				L1Map[L1RowDecoder][nIndex].b_valid = 1;
-				add_lru_info(&(L1Map[L1RowDecoder][nIndex].lru_time));
-				print_dbg("|L1Put[tag=%llx, dirty=%d]", CurTag, L1Map[L1RowDecoder][nIndex].b_dirty);
-				if (evict_blk)
-					print_dbg("|L1Evict(%llx)", evict_blk);
+		}
+		for (uint32_t nCnt = 0; nCnt < U.victim.size(); nCnt++) {
+			if (U.victim[nCnt].tag == (a >> P.offset_bits)) {
+				dirty |= U.victim[nCnt].b_dirty;
+				U.victim.erase(U.victim.begin() + nCnt);
+				ls->back_invalidations++;
+				break;
 			}
 		}
-	} else /*Row being accessed for the first time*/
-	{
-		/*No eviction required since row is accessed the first time.  */
-		p_stats->L1_read_misses++;
-		print_dbg("|L1ReadMiss(%llx)", (address&(~L1Params.offset_mask)));
-		L2_RowData = L2ReadReq(address, p_stats); /*Fetch block from L2*/
-		for (nCnt = 0; nCnt < nWays; nCnt++) /*Allocating row entries depending on associativity*/
-		{
-			L1Map[L1RowDecoder].push_back(c_entry());
+	}
+	return dirty;
+}
+/*Drop every copy of [address, address + size) above lvl; true if any was dirty.
+ * Above the shared level that means every core's copies*/
+static bool Back_Invalidate(uint32_t lvl, uint64_t address, uint64_t size,
+		cache_stats_t* p_stats) {
+	bool dirty = 0;
+
+	for (uint32_t j = 0; j < lvl; j++)
+		dirty |= Drop_Copies(levels[j], address, size, &p_stats->levels[lvl]);
+	if (!cores.empty() && lvl + 1 == levels.size()) {
+		for (uint32_t c = 0; c < cores.size(); c++) {
+			if (c == cur_core)
+				continue;
+			for (uint32_t j = 0; j < lvl; j++)
+				dirty |= Drop_Copies(cores[c].priv[j], address, size, &p_stats->levels[lvl]);
 		}
-		/*Copy Block to L1, Don't mark as dirty as this is a read operation*/
-		L1Map[L1RowDecoder][0].tag = CurTag;
-		L1Map[L1RowDecoder][0].b_dirty = 0;
-		L1Map[L1RowDecoder][0].b_valid = 1;
-		L1Map[L1RowDecoder][0].prefetch = 0;
-		add_lru_info(&(L1Map[L1RowDecoder][0].lru_time));
-		print_dbg("|L1Put[tag=%llx, dirty=%d]", CurTag, L1Map[L1RowDecoder][0].b_dirty);
 	}
+	return dirty;
 }
-/*L1 Write*/
-void L1WriteReq(uint64_t address, cache_stats_t* p_stats) {
-	uint64_t CurTag = 0;
-	uint64_t L1RowDecoder = 0;
-	uint64_t evict_blk = 0;
-	L1CacheMap::iterator kpos;
-	struct c_entry L2_RowData;
-	uint32_t nWays = 0;
-	uint32_t nCnt = 0;
-	uint32_t nIndex = 0;
-	bool bFlag = 0;
-	bool hit = 0;
-	bool slotavailable = 0;
+/*A block leaves level lvl: through its victim buffer, then down the hierarchy*/
+void Evict_Block(uint32_t lvl, c_entry blk, uint64_t evict_blk, cache_stats_t* p_stats) {
+	cache_level& L = levels[lvl];
+	level_stats_t* ls = &p_stats->levels[lvl];
 
-	p_stats->L1_accesses++;
+	ls->evictions++;
+	if (L.policy == POLICY_INCLUSIVE)
+		blk.b_dirty |= Back_Invalidate(lvl, evict_blk, L.params.offset_mask + 1, p_stats);
 
-	L1RowDecoder = (address & (L1Params.index_mask)) >> L1Params.offset_bits;
-	CurTag = (address & L1Params.tag_mask) >> (L1Params.index_bits
-			+ L1Params.offset_bits);
+	if (L.victim_entries) {
+		blk.tag = evict_blk >> L.params.offset_bits;
+		L.victim.push_back(blk);
+		if (L.victim.size() <= L.victim_entries)
+			return;
+		blk = L.victim.front();
+		L.victim.erase(L.victim.begin());
+		evict_blk = blk.tag << L.params.offset_bits;
+	}
 
-	nWays = L1Params.nWays;
-	if ((kpos = L1Map.find(L1RowDecoder)) != L1Map.end()) /*Row already present*/
-	{
-		/*Row is present, check for tag*/
-		for (nCnt = 0; nCnt < nWays; nCnt++) {
-			if (CurTag == kpos->second[nCnt].tag) {
-				print_dbg("|L1WriteHit(%llx)", (address&(~L1Params.offset_mask)));
-				/*Cache HIT, Update timestamp and set dirty bit*/
-				hit = 1;
-				add_lru_info(&kpos->second[nCnt].lru_time);
-				kpos->second[nCnt].b_dirty = 1;
-				/*In some cases time-stamp for different blks show up as the same due to lack of granularity*/
-				break;
-			} else if (!kpos->second[nCnt].tag)
-				slotavailable = 1; /*Indicates no eviction required*/
-		}
-		if (!hit) /*L1 Cache Write MISS*/
-		{
-			p_stats->L1_write_misses++;
-			print_dbg("|L1WriteMiss(%llx)", (address&(~L1Params.offset_mask)));
-			L2_RowData = L2ReadReq(address, p_stats); /*Fetch block from L2 before anything else*/
-			/*Check if eviction is required*/
-			if (!slotavailable) {
-				nIndex = find_lru_blk(&kpos->second, nWays);
-				evict_blk = ((L1Map[L1RowDecoder][nIndex].tag
-						<< (L1Params.offset_bits + L1Params.index_bits))
-						| (L1RowDecoder << L1Params.offset_bits));
-				/*Write to L2 if dirty*/
-				if (L1Map[L1RowDecoder][nIndex].b_dirty) {
-					/*Allocate Block L1 in next available slot, This is the copied block coming from L2. Update TS*/
-					L1Map[L1RowDecoder][nIndex].tag = CurTag;
-					L1Map[L1RowDecoder][nIndex].b_dirty = 1;
-					L1Map[L1RowDecoder][nIndex].b_valid = 1;
-					L1Map[L1RowDecoder][nIndex].prefetch = 0;
-					add_lru_info(&(L1Map[L1RowDecoder][nIndex].lru_time));
-					print_dbg("|L1Put[tag=%llx, dirty=%d]", CurTag, L1Map[L1RowDecoder][nIndex].b_dirty); print_dbg("|L1Evict(%llx)", evict_blk); print_dbg("|L1WB(%llx)", evict_blk);
-					bFlag = 1;
-					L2WriteReq(evict_blk, p_stats);
-				}
-			} else /*Update index to next available slot*/
-			{
-				nIndex = 0;
-				while (L1Map[L1RowDecoder][nIndex].tag != 0)
-					nIndex++;
-				if (nIndex >= nWays)
-					print_dbg("ERROR IN LOGIC[%d]", nIndex);
-			}
-			if (!bFlag) {
-				/*Update L1 Block in next available slot. Set dirty bit. Update TS*/
-				L1Map[L1RowDecoder][nIndex].tag = CurTag;
-				L1Map[L1RowDecoder][nIndex].b_dirty = 1;
-				L1Map[L1RowDecoder][nIndex].b_valid = 1;
-				L1Map[L1RowDecoder][nIndex].prefetch = 0;
-				add_lru_info(&(L1Map[L1RowDecoder][nIndex].lru_time));
-				print_dbg("|L1Put[tag=%llx, dirty=%d]", CurTag, L1Map[L1RowDecoder][nIndex].b_dirty);
-				if (evict_blk)
-					print_dbg("|L1Evict(%llx)", evict_blk);
-			}
+	if (blk.b_dirty) {
+		print_dbg("|L%uWB(%llx)", lvl + 1, evict_blk);
+		ls->write_backs++;
+		if (L.wb_entries) {
+			blk.tag = evict_blk >> L.params.offset_bits;
+			L.wb.push_back(blk);
+			if (L.wb.size() <= L.wb_entries)
+				return;
+			evict_blk = L.wb.front().tag << L.params.offset_bits;
+			L.wb.erase(L.wb.begin());
 		}
-	} else /*Add row entry in L1*/
-	{
-		print_dbg("|L1WriteMiss(%llx)", (address&(~L1Params.offset_mask)));
-		p_stats->L1_write_misses++;
-		for (nCnt = 0; nCnt < nWays; nCnt++)
-			L1Map[L1RowDecoder].push_back(c_entry());
-		L2_RowData = L2ReadReq(address, p_stats); /*Fetch block from L2*/
-		L1Map[L1RowDecoder][0].tag = CurTag;
-		L1Map[L1RowDecoder][0].b_dirty = 1;
-		L1Map[L1RowDecoder][0].b_valid = 1;
-		L1Map[L1RowDecoder][0].prefetch = 0;
-		add_lru_info(&(L1Map[L1RowDecoder][0].lru_time));
-		print_dbg("|L1Put[tag=%llx, dirty=%d]", CurTag, L1Map[L1RowDecoder][0].b_dirty);
+		Write_Down(lvl, evict_blk, p_stats);
+	} else if (lvl + 1 < levels.size() && levels[lvl + 1].policy == POLICY_EXCLUSIVE) {
+		LevelReq(lvl + 1, evict_blk, REQ_VICTIM, p_stats);
 	}
 }
-/*L2 Read*/
-c_entry L2ReadReq(uint64_t address, cache_stats_t* p_stats) {
+/**
+ * One request into level lvl. Misses fetch from the level below first, then the
+ * block is placed, then the victim is evicted. Prefetching runs on misses in the last level.
+ *
+ * Returns whether the block handed to the level above is dirty, which only happens
+ * when an exclusive level gives up a dirty block.
+ */
+bool LevelReq(uint32_t lvl, uint64_t address, int req, cache_stats_t* p_stats) {
+	cache_level& L = levels[lvl];
+	_CacheParams& P = L.params;
+	level_stats_t* ls = &p_stats->levels[lvl];
+	bool last = (lvl + 1 == levels.size());
 	uint64_t CurTag = 0;
-	uint64_t L2RowDecoder = 0;
-	struct c_entry L2_RowData;
-	L1CacheMap::iterator kpos;
-	uint64_t evict_blk = 0;
-	uint32_t nWays = 0;
+	uint64_t RowDecoder = 0;
+	CacheMap::iterator kpos;
+	c_entry victim;
 	uint32_t nCnt = 0;
 	uint32_t nIndex = 0;
+	bool fresh = 0;
 	bool hit = 0;
-	bool bFlag = 0;
 	bool slotavailable = 0;
+	bool dirty = 0;
+
+	if (lvl)
+		address = address & ~levels[lvl - 1].params.offset_mask;
+	/*Construct Index and Tag using pre-set parameters*/
+	RowDecoder = (address & (P.index_mask)) >> P.offset_bits;
+	CurTag = (address & P.tag_mask) >> (P.index_bits + P.offset_bits);
+
+	if (req == REQ_READ)
+		ls->reads++;
+	else if (req == REQ_WRITE)
+		ls->writes++;
+	else
+		ls->victim_fills++;
+
+	if (last && !cores.empty()) {
+		int32_t& owner = bank_owner[RowDecoder % bank_owner.size()];
 
-	//	p_stats->L2_accesses++;
-	address = address & ~L1Params.offset_mask;
-	L2RowDecoder = (address & (L2Params.index_mask)) >> L2Params.offset_bits;
-	CurTag = (address & L2Params.tag_mask) >> (L2Params.index_bits
-			+ L2Params.offset_bits);
-	nWays = L2Params.nWays;
+		if (owner >= 0 && owner != (int32_t) cur_core)
+			p_stats->bank_conflicts++;
+		owner = cur_core;
+		if (ucp && req == REQ_READ && RowDecoder % umon_stride == 0)
+			Umon_Access(RowDecoder, CurTag);
+	}
 
-	if ((kpos = L2Map.find(L2RowDecoder)) != L2Map.end()) /*Row already present*/
+	if ((kpos = L.sets.find(RowDecoder)) == L.sets.end()) /*Row being accessed for the first time*/
 	{
-		for (nCnt = 0; nCnt < nWays; nCnt++) {
-			if (CurTag == kpos->second[nCnt].tag) {
-				/*Cache HIT, Update timestamp*/
-				hit = 1;
-				add_lru_info(&kpos->second[nCnt].lru_time);
-				memcpy(&L2_RowData, &kpos->second[nCnt], sizeof(struct c_entry));
-				print_dbg("|L2ReadHit(%llx)", (address&(~L2Params.offset_mask)));
-				if (kpos->second[nCnt].prefetch) {
-					if (kpos->second[nCnt].across_page){
-						kpos->second[nCnt].across_page= 0;
-						count_across_page_successful++;
-					}
-					p_stats->successful_prefetches++;
-					kpos->second[nCnt].prefetch = 0;
-					print_dbg("|PrefetchSuccess(%llx) TraceLine[%d]\n\n", (address&(~L2Params.offset_mask)), count);
-				}
-				break;
-			} else if (!kpos->second[nCnt].tag)
-				slotavailable = 1; /*Indicates no eviction required*/
-		}
-		if (!hit) /*L2 Cache Read MISS*/
-		{
-			p_stats->L2_read_misses++;
-			print_dbg("|L2ReadMiss(%llx)", (address&(~L2Params.offset_mask)));
-			/*Fetch from main memory, not required*/
-			/*Check if eviction is required*/
-			if (!slotavailable) {
-				nIndex = find_lru_blk(&kpos->second, nWays);
-				evict_blk = ((L2Map[L2RowDecoder][nIndex].tag
-						<< (L2Params.offset_bits + L2Params.index_bits))
-						| (L2RowDecoder << L2Params.offset_bits));
-				/*Write to memory if dirty*/
-				if (L2Map[L2RowDecoder][nIndex].b_dirty) {
-					bFlag = 1;
-					p_stats->write_backs++;
-				}
-			} else /*Update index to next available slot*/
-			{
-				nIndex = 0;
-				while (L2Map[L2RowDecoder][nIndex].tag != 0)
-					nIndex++;
-				if (nIndex >= nWays)
-					print_dbg("ERROR IN LOGIC[%d]", nIndex);
-			}
-			/*Allocate Block L2 in next available slot,
-			 * This is the copied block coming from memory(in theory). Update TS*/
-			L2Map[L2RowDecoder][nIndex].tag = CurTag;
-			L2Map[L2RowDecoder][nIndex].b_dirty = 0;
-			L2Map[L2RowDecoder][nIndex].b_valid = 1;
-			L2Map[L2RowDecoder][nIndex].prefetch = 0;
-			add_lru_info(&(L2Map[L2RowDecoder][nIndex].lru_time));
-			print_dbg("|L2Put[tag=%llx, dirty=%d]", CurTag, L2Map[L2RowDecoder][nIndex].b_dirty);
-			if (evict_blk) {
-				print_dbg("|L2Evict(%llx)", evict_blk);
-				if (bFlag)
-					print_dbg("|L2WB(%llx)", evict_blk);
+		kpos = L.sets.insert(std::make_pair(RowDecoder, vector<c_entry>(P.nWays))).first;
+		fresh = 1;
+	}
+	vector<c_entry>& row = kpos->second;
+
+	/*Row is present, check for tag*/
+	for (nCnt = 0; !fresh && nCnt < P.nWays; nCnt++) {
+		if (CurTag == row[nCnt].tag) {
+			hit = 1;
+			break;
+		} else if (!row[nCnt].tag)
+			slotavailable = 1; /*Indicates no eviction required*/
+	}
+
+	if (hit) {
+		print_dbg("|L%u%sHit(%llx)", lvl + 1, req == REQ_READ ? "Read" : "Write", (address&(~P.offset_mask)));
+		L.repl->hit(RowDecoder, nCnt, row);
+		if (req != REQ_VICTIM)
+			Timing_Served(lvl, 0, row[nCnt].prefetch);
+		if (last && !cores.empty() && row[nCnt].core != cur_core)
+			p_stats->shared_hits++;
+		if (req == REQ_WRITE)
+			row[nCnt].b_dirty = 1;
+		if (row[nCnt].prefetch) {
+			if (row[nCnt].across_page) {
+				row[nCnt].across_page = 0;
+				count_across_page_successful++;
 			}
+			p_stats->successful_prefetches++;
+			row[nCnt].prefetch = 0;
+			print_dbg("|PrefetchSuccess(%llx) TraceLine[%d]\n\n", (address&(~P.offset_mask)), count);
 		}
-	} else /*Row being accessed for the first time*/
-	{
-		/*No eviction required since row is accessed the first time.  */
-		p_stats->L2_read_misses++;
-		print_dbg("|L2ReadMiss(%llx)", (address&(~L2Params.offset_mask)));
-		for (nCnt = 0; nCnt < nWays; nCnt++) /*Adding row entries*/
-			L2Map[L2RowDecoder].push_back(c_entry());
-		/*Copy Block to L2, Don't mark as dirty as this is a read operation*/
-		L2Map[L2RowDecoder][0].tag = CurTag;
-		L2Map[L2RowDecoder][0].b_dirty = 0;
-		L2Map[L2RowDecoder][0].b_valid = 1;
-		L2Map[L2RowDecoder][0].prefetch = 0;
-		add_lru_info(&(L2Map[L2RowDecoder][0].lru_time));
-		print_dbg("|L2Put[tag=%llx, dirty=%d]", CurTag, L2Map[L2RowDecoder][0].b_dirty);
-	}
-	/*if (!hit)
-	 {
-
-	 uint64_t CurBlk = (address>>L2Params.offset_bits);
-
-	 diff = (CurBlk) - (LastMBlk);
-	 print_dbg("|dist=%lld,last_miss_block_addr=%llx,pending_stride=%lld", \
-								diff, LastMBlk, pending_stride);
-
-	 if (diff == pending_stride)Prefetch
-	 Prefetch_Blocks(CurBlk, p_stats);
-
-	 LastMBlk = CurBlk;
-	 pending_stride = diff;
-	 }*/
-	if (!hit) {
-		//uint64_t CurBlk = (address>>L2Params.offset_bits);
-		Prefetch_Blocks(address, p_stats);
+		/*The block moves up out of an exclusive level*/
+		if (req == REQ_READ && L.policy == POLICY_EXCLUSIVE) {
+			dirty = row[nCnt].b_dirty;
+			row[nCnt] = c_entry();
+		}
+		return dirty;
 	}
-	return L2_RowData;
-}
-/*L2 Write*/
-void L2WriteReq(uint64_t address, cache_stats_t* p_stats) {
-	uint64_t CurTag = 0;
-	uint64_t L2RowDecoder = 0;
-	uint64_t evict_blk = 0;
-	L1CacheMap::iterator kpos;
-	uint32_t nWays = 0;
-	uint32_t nCnt = 0;
-	uint32_t nIndex = 0;
-	bool hit = 0;
-	bool bFlag = 0;
-	bool slotavailable = 0;
 
-	//	p_stats->L2_accesses++;
-	address = address & ~L1Params.offset_mask;
-	L2RowDecoder = (address & (L2Params.index_mask)) >> L2Params.offset_bits;
-	CurTag = (address & L2Params.tag_mask) >> (L2Params.index_bits
-			+ L2Params.offset_bits);
-	nWays = L2Params.nWays;
+	if (req == REQ_READ)
+		ls->read_misses++;
+	else if (req == REQ_WRITE)
+		ls->write_misses++;
+	print_dbg("|L%u%sMiss(%llx)", lvl + 1, req == REQ_READ ? "Read" : "Write", (address&(~P.offset_mask)));
 
-	if ((kpos = L2Map.find(L2RowDecoder)) != L2Map.end()) /*Row already present*/
+	/*Fetch block from below before doing anything else. A block written back
+	 * from above is whole, so only L1 fetches on a write*/
+	if (Buffer_Take(L, address >> P.offset_bits, &dirty, ls))
+		Timing_Served(lvl, 1, 0);
+	else if (req == REQ_READ || (lvl == 0 && req == REQ_WRITE)) {
+		ls->fetches++;
+		if (!last)
+			dirty = LevelReq(lvl + 1, address, REQ_READ, p_stats);
+		else
+			Timing_Served(levels.size(), 0, 0);
+	}
+
+	if (req == REQ_READ && L.policy == POLICY_EXCLUSIVE) {
+		/*Passes straight through to the level above*/
+		if (last)
+			Prefetch_Blocks(address, p_stats);
+		return dirty;
+	}
+
+	victim.tag = 0;
+	if (fresh)
+		nIndex = 0;
+	else if (!slotavailable)/*Check if eviction is required*/
 	{
-		for (nCnt = 0; nCnt < nWays; nCnt++) {
-			if (CurTag == kpos->second[nCnt].tag) {
-				print_dbg("|L2WriteHit(%llx)", (address&(~L2Params.offset_mask)));
-				/*Cache HIT, Update timestamp, mark as dirty*/
-				hit = 1;
-				kpos->second[nCnt].b_dirty = 1;
-				if (kpos->second[nCnt].prefetch)/*Check if block is a prefetched block*/
-				{
-					p_stats->successful_prefetches++;
-					kpos->second[nCnt].prefetch = 0;
-					if (kpos->second[nCnt].across_page){
-						kpos->second[nCnt].across_page= 0;
-						count_across_page_successful++;
-					}
-					//count_across_page_successful++;
-					//kpos->second[nCnt].across_page = 0;
-					print_dbg("|PrefetchSuccess(%llx)\n\n", (address&(~L2Params.offset_mask)));
-				}
-				add_lru_info(&kpos->second[nCnt].lru_time);
-				break;
-			} else if (!kpos->second[nCnt].tag)
-				slotavailable = 1; /*Indicates no eviction required*/
-		}
-		if (!hit) /*L2 Cache Write MISS*/
-		{
-			p_stats->L2_write_misses++;
-			print_dbg("|L2WriteMiss(%llx)", (address&(~L2Params.offset_mask)));
-			/*Fetch from main memory, not required*/
-			/*Check if eviction is required*/
-			if (!slotavailable) {
-				nIndex = find_lru_blk(&kpos->second, nWays);
-				/*Write to memory if dirty*/
-				evict_blk = ((L2Map[L2RowDecoder][nIndex].tag
-						<< (L2Params.offset_bits + L2Params.index_bits))
-						| (L2RowDecoder << L2Params.offset_bits));
-				if (L2Map[L2RowDecoder][nIndex].b_dirty) {
-					p_stats->write_backs++;
-					bFlag = 1;
-				}
-			} else /*Update index to next available slot*/
-			{
-				nIndex = 0;
-				while (L2Map[L2RowDecoder][nIndex].tag != 0)
-					nIndex++;
-				if (nIndex >= nWays)
-					print_dbg("ERROR IN LOGIC[%d]", nIndex);
-			}
-			/*Allocate Block L2 in next available slot,
-			 * This is the copied block coming from memory(in theory). Update TS
-			 * */
-			L2Map[L2RowDecoder][nIndex].tag = CurTag;
-			L2Map[L2RowDecoder][nIndex].b_dirty = 1;
-			L2Map[L2RowDecoder][nIndex].b_valid = 1;
-			L2Map[L2RowDecoder][nIndex].prefetch = 0;
-			add_lru_info(&(L2Map[L2RowDecoder][nIndex].lru_time));
-			if (evict_blk) {
-				print_dbg("|L2Evict(%llx)", evict_blk);
-				if (bFlag)
-					print_dbg("|L2WB(%llx)", evict_blk);
-			}
-		}
-	} else /*Row being accessed for the first time*/
+		nIndex = L.repl->victim(RowDecoder, row, last ? Partition_Ways(row) : REPL_ALL_WAYS);
+		victim = row[nIndex];
+	} else /*Update index to next available slot*/
 	{
-		/*No eviction required since row is accessed the first time.  */
-		p_stats->L2_write_misses++;
-		print_dbg("L2WriteMiss(%llx)|", (address&(~L2Params.offset_mask)));
-
-		for (nCnt = 0; nCnt < nWays; nCnt++) /*Adding row entries*/
-			L2Map[L2RowDecoder].push_back(c_entry());
-		/*Copy Block to L2, Don't mark as dirty as this is a read operation*/
-		L2Map[L2RowDecoder][0].tag = CurTag;
-		L2Map[L2RowDecoder][0].b_dirty = 1;
-		L2Map[L2RowDecoder][0].b_valid = 1;
-		L2Map[L2RowDecoder][0].prefetch = 0;
-		add_lru_info(&(L2Map[L2RowDecoder][0].lru_time));
-		print_dbg("L2Put[tag=%llx, dirty=%d]|", CurTag, L2Map[L2RowDecoder][0].b_dirty);
-	}
-	if (!hit) {
-		//uint64_t CurBlk = (address>>L2Params.offset_bits);
-		Prefetch_Blocks(address, p_stats);
+		nIndex = 0;
+		while (row[nIndex].tag != 0)
+			nIndex++;
 	}
+
+	/*Allocate the block; a fill from below keeps its across_page mark*/
+	row[nIndex].tag = CurTag;
+	row[nIndex].b_dirty = (req == REQ_WRITE) || dirty;
+	row[nIndex].b_valid = 1;
+	row[nIndex].prefetch = 0;
+	row[nIndex].core = cur_core;
+	L.repl->fill(RowDecoder, nIndex, row, address, 0);
+	print_dbg("|L%uPut[tag=%llx, dirty=%d]", lvl + 1, CurTag, row[nIndex].b_dirty);
+
+	if (victim.tag) {
+		uint64_t evict_blk = ((victim.tag << (P.offset_bits + P.index_bits))
+				| (RowDecoder << P.offset_bits));
+		print_dbg("|L%uEvict(%llx)", lvl + 1, evict_blk);
+		if (last)
+			Shared_Evicted(victim, p_stats);
+		Evict_Block(lvl, victim, evict_blk, p_stats);
+	}
+
+	if (last)
+		Prefetch_Blocks(address, p_stats);
+	return 0;
 }
-/*Prefetch Blocks if stride matches*/
+/*Prefetch Blocks into the last level if stride matches*/
 void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
+	_CacheParams& LLCParams = levels.back().params;
+	CacheMap& LLCMap = levels.back().sets;
 	uint64_t trigger = address;
 	uint64_t prev_addr;
 	uint64_t Curvirtaddr = 0;
-	address = address >> L2Params.offset_bits;
+	address = address >> LLCParams.offset_bits;
 	prev_addr = trigger;
 #if IPT_PREFETCH && MAPPING
 
@@ -558,7 +986,7 @@ void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
 	} else {
 		Curvirtaddr = ipt_itr->second.vpf * page_size + (trigger & (page_size- 1));
 		//Curvirtaddr = Blk2Invert;
-		CurBlk = Curvirtaddr >> L2Params.offset_bits;
+		CurBlk = Curvirtaddr >> LLCParams.offset_bits;
 	}
 	diff = (CurBlk) - (LastMBlk); //Virtual stride
 
@@ -605,7 +1033,8 @@ void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
 		
 		uint64_t evict_blk = 0;
 		uint64_t CurTag = 0;
-		L1CacheMap::iterator kpos;
+		CacheMap::iterator kpos;
+		c_entry victim;
 		uint32_t nWays = 0;
 		uint32_t nCnt = 0;
 		uint32_t nIndex = 0;
@@ -617,7 +1046,7 @@ void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
 #if IPT_PREFETCH && MAPPING
 
 		std::map<uint64_t, physical_frame_LRU>::iterator pt_itr;
-		Curvirtaddr = Curvirtaddr + (pending_stride << L2Params.offset_bits);
+		Curvirtaddr = Curvirtaddr + (pending_stride << LLCParams.offset_bits);
 		pt_itr = page_table.find(Curvirtaddr/page_size);
 		/*TODO: check in IPT also*/
 		if (pt_itr == page_table.end()) {
@@ -630,16 +1059,16 @@ void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
 			 pending_stride = diff;
 			 return;*/
 		}/*else{
-		 address = (pt_itr->second.ppf + (Curvirtaddr & L2Params.offset_mask)) >> L2Params.offset_bits;
+		 address = (pt_itr->second.ppf + (Curvirtaddr & LLCParams.offset_mask)) >> LLCParams.offset_bits;
 		 }
 		 */
-		//address = (pt_itr->second.ppf + (Curvirtaddr & L2Params.offset_mask)) >> L2Params.offset_bits;
-		address = (pt_itr->second.ppf + (Curvirtaddr & (page_size- 1))) >> L2Params.offset_bits;
+		//address = (pt_itr->second.ppf + (Curvirtaddr & LLCParams.offset_mask)) >> LLCParams.offset_bits;
+		address = (pt_itr->second.ppf + (Curvirtaddr & (page_size- 1))) >> LLCParams.offset_bits;
 #else
 		address = address + pending_stride;
 #endif
 		print_dbg("Prefetching %llx <VA [%llx]>, count %lld TraceLine[%d]\n", address, Curvirtaddr, p_stats->prefetched_blocks, count);
-		curr_addr = address << L2Params.offset_bits;
+		curr_addr = address << LLCParams.offset_bits;
 		
 		if (prev_addr / 4096 != curr_addr / 4096) {
 #if IPT_PREFETCH
@@ -668,11 +1097,13 @@ void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
 			across_pg = 1;
 			//printf("Pending stride %lu last miss address %lu address %lu... prefetch from %lu TO %lu \n", pending_stride, temp, address, temp/4096, block_address(address)/4096);
 		}
-		L2RowDecoder = (address & (L2Params.index_mask >> L2Params.offset_bits));
-		nWays = L2Params.nWays;
-		CurTag = (address & (L2Params.tag_mask >> L2Params.offset_bits)) >> (L2Params.index_bits);
+		if (sample_rate > 1 && Sample_Slot(curr_addr) < 0)
+			continue; /*Nothing would ever look in that set*/
+		L2RowDecoder = (address & (LLCParams.index_mask >> LLCParams.offset_bits));
+		nWays = LLCParams.nWays;
+		CurTag = (address & (LLCParams.tag_mask >> LLCParams.offset_bits)) >> (LLCParams.index_bits);
 
-		if ((kpos = L2Map.find(L2RowDecoder)) != L2Map.end()) /*Row already present*/
+		if ((kpos = LLCMap.find(L2RowDecoder)) != LLCMap.end()) /*Row already present*/
 		{
 			for (nCnt = 0; nCnt < nWays; nCnt++) {
 				if (CurTag == kpos->second[nCnt].tag) {
@@ -684,88 +1115,136 @@ void Prefetch_Blocks(uint64_t address, cache_stats_t* p_stats) {
 			}
 			if (!hit) /*L2 Cache Prefetch Read MISS*/
 			{
-				uint32_t itr = 0;
 				p_stats->prefetched_blocks++;
-				/*Find LRU*/
-				for (nCnt = 0; nCnt < nWays; nCnt++) {/*Prefetched blks are given timestamp values from 0 to 2^s2*/
-					if (kpos->second[nCnt].prefetch)
-						;
-					itr++;
-				}
 				if (!slotavailable)/*Check if eviction is required*/
 				{
-					nIndex = find_lru_blk(&kpos->second, nWays);
-					evict_blk = ((L2Map[L2RowDecoder][nIndex].tag << (L2Params.offset_bits + L2Params.index_bits))
-							| (L2RowDecoder << L2Params.offset_bits));
-					/*Write to memory if dirty*/
-					if (L2Map[L2RowDecoder][nIndex].b_dirty) {
-						p_stats->write_backs++;
-						bFlag = 1;
-					}
+					nIndex = levels.back().repl->victim(L2RowDecoder, kpos->second, Partition_Ways(kpos->second));
+					evict_blk = ((LLCMap[L2RowDecoder][nIndex].tag << (LLCParams.offset_bits + LLCParams.index_bits))
+							| (L2RowDecoder << LLCParams.offset_bits));
+					victim = LLCMap[L2RowDecoder][nIndex];
+					bFlag = 1;
 				} else /*Update index to next available slot*/
 				{
 					nIndex = 0;
-					while (L2Map[L2RowDecoder][nIndex].tag != 0)
+					while (LLCMap[L2RowDecoder][nIndex].tag != 0)
 						nIndex++;
 				}
-				L2Map[L2RowDecoder][nIndex].tag = CurTag;
-				L2Map[L2RowDecoder][nIndex].b_dirty = 0;
-				L2Map[L2RowDecoder][nIndex].b_valid = 1;
-				L2Map[L2RowDecoder][nIndex].prefetch = 1;
-				L2Map[L2RowDecoder][nIndex].lru_time = itr;
+				LLCMap[L2RowDecoder][nIndex].tag = CurTag;
+				LLCMap[L2RowDecoder][nIndex].b_dirty = 0;
+				LLCMap[L2RowDecoder][nIndex].b_valid = 1;
+				LLCMap[L2RowDecoder][nIndex].prefetch = 1;
+				LLCMap[L2RowDecoder][nIndex].core = cur_core;
+				if (channel_bw)
+					pf_pending.push_back(address);
+				levels.back().repl->fill(L2RowDecoder, nIndex, kpos->second, address << LLCParams.offset_bits, 1);
 
 				if (across_pg) {
-					L2Map[L2RowDecoder][nIndex].across_page = 1;
-				} print_dbg("|Prefetch(%llx)", address<<L2Params.offset_bits);
+					LLCMap[L2RowDecoder][nIndex].across_page = 1;
+				} print_dbg("|Prefetch(%llx)", address<<LLCParams.offset_bits);
 
-				if (evict_blk) {
+				if (bFlag) {
 					print_dbg("|L2Evict(%llx)", evict_blk);
-					if (bFlag)
-						print_dbg("|L2WB(%llx)", evict_blk);
-				} print_dbg("|L2Put[tag=%llx, dirty=%d]", CurTag, L2Map[L2RowDecoder][nIndex].b_dirty);
+					Shared_Evicted(victim, p_stats);
+					Evict_Block(levels.size() - 1, victim, evict_blk, p_stats);
+				} print_dbg("|L2Put[tag=%llx, dirty=%d]", CurTag, LLCMap[L2RowDecoder][nIndex].b_dirty);
 			}
 			else{
 				print_dbg("Prefetching block that's already present\n\n");
 			}
 		} else {
-			for (nCnt = 0; nCnt <= nWays; nCnt++) /*Adding row entries*/
-				L2Map[L2RowDecoder].push_back(c_entry());
-			L2Map[L2RowDecoder][0].tag = CurTag;
-			L2Map[L2RowDecoder][0].b_dirty = 0;
-			L2Map[L2RowDecoder][0].b_valid = 1;
-			L2Map[L2RowDecoder][0].prefetch = 1;
-			L2Map[L2RowDecoder][0].lru_time = 0;
+			for (nCnt = 0; nCnt < nWays; nCnt++) /*Adding row entries*/
+				LLCMap[L2RowDecoder].push_back(c_entry());
+			LLCMap[L2RowDecoder][0].tag = CurTag;
+			LLCMap[L2RowDecoder][0].b_dirty = 0;
+			LLCMap[L2RowDecoder][0].b_valid = 1;
+			LLCMap[L2RowDecoder][0].prefetch = 1;
+			LLCMap[L2RowDecoder][0].core = cur_core;
+			if (channel_bw)
+				pf_pending.push_back(address);
+			levels.back().repl->fill(L2RowDecoder, 0, LLCMap[L2RowDecoder], address << LLCParams.offset_bits, 1);
 			if (across_pg) {
-				L2Map[L2RowDecoder][nIndex].across_page = 1;
-			} print_dbg("|Prefetch(%llx)", address<<L2Params.offset_bits);
+				LLCMap[L2RowDecoder][nIndex].across_page = 1;
+			} print_dbg("|Prefetch(%llx)", address<<LLCParams.offset_bits);
 			p_stats->prefetched_blocks++;
-			print_dbg("L2Put[tag=%llx, dirty=%d]|", CurTag, L2Map[L2RowDecoder][0].b_dirty);
+			print_dbg("L2Put[tag=%llx, dirty=%d]|", CurTag, LLCMap[L2RowDecoder][0].b_dirty);
 		}
 	}
 	LastMBlk = CurBlk;
 	pending_stride = diff;
 }
-/*This is made as a function in case of future changes in LRU implementation*/
-void add_lru_info(uint64_t* lru_time) {
-	*lru_time = ++glrutime;
+/*Miss penalty of each level is the access time of the one below; TLB misses
+ * for prefetches count as extra memory accesses in the modified AAT*/
+static void Compute_AAT(const sample_counts* c, double* miss_rate, double* aat, double* aat_mod) {
+	double AAT = MEMORY_PENALTY, AAT_mod = MEMORY_PENALTY, MR_TLB = 0;
+
+	for (uint32_t lvl = levels.size(); lvl-- > 0;) {
+		uint64_t requests = c->requests[lvl];
+
+		if (!requests)
+			requests = 1;
+		miss_rate[lvl] = (double) ((double) c->fetches[lvl] / (double) requests);
+		MR_TLB = miss_rate[lvl];
+		if (lvl == levels.size() - 1)
+			MR_TLB = (double) ((double) (c->fetches[lvl] + c->tlb_misses) / (double) requests);
+		AAT = levels[lvl].hit_time + miss_rate[lvl] * AAT;
+		AAT_mod = levels[lvl].hit_time + MR_TLB * AAT_mod;
+		if (c->buffered[lvl]) {
+			AAT += BUFFER_HIT_TIME * (double) c->buffered[lvl] / (double) requests;
+			AAT_mod += BUFFER_HIT_TIME * (double) c->buffered[lvl] / (double) requests;
+		}
+	}
+	*aat = AAT;
+	*aat_mod = AAT_mod;
 }
-/*Find LRU block for given array*/
-uint32_t find_lru_blk(std::vector<c_entry> *m_entry, uint32_t nWays) {
 
-	uint64_t s_min = 0;
-	uint32_t nIndex = 0;
-	uint32_t nCnt = 0;
+/*Jackknife the sampled units: recompute the estimates leaving each one out in
+ * turn. The spread, less the finite population share, gives the error bars*/
+static void Sample_Error(cache_stats_t* p_stats) {
+	uint32_t n = levels.size(), units = sample_units.size();
+	sample_counts all = sample_counts();
+	vector<double> est(units * (n + 2));
+	double scale = (1.0 - 1.0 / sample_rate) * (units - 1) / units;
 
-	s_min = m_entry->at(0).lru_time;
-	/*Find LRU*/
-	for (nCnt = 1; nCnt < nWays; nCnt++) {
-		if (s_min >= m_entry->at(nCnt).lru_time) {
-			s_min = m_entry->at(nCnt).lru_time;
-			nIndex = nCnt;
+	for (uint32_t i = 0; i < units; i++) {
+		for (uint32_t lvl = 0; lvl < n; lvl++) {
+			all.requests[lvl] += sample_units[i].requests[lvl];
+			all.fetches[lvl] += sample_units[i].fetches[lvl];
+			all.buffered[lvl] += sample_units[i].buffered[lvl];
 		}
+		all.tlb_misses += sample_units[i].tlb_misses;
 	}
-	return nIndex;
+	for (uint32_t i = 0; i < units; i++) {
+		sample_counts rest = all;
+		double* e = &est[i * (n + 2)];
+
+		for (uint32_t lvl = 0; lvl < n; lvl++) {
+			rest.requests[lvl] -= sample_units[i].requests[lvl];
+			rest.fetches[lvl] -= sample_units[i].fetches[lvl];
+			rest.buffered[lvl] -= sample_units[i].buffered[lvl];
+		}
+		rest.tlb_misses -= sample_units[i].tlb_misses;
+		Compute_AAT(&rest, e, &e[n], &e[n + 1]);
+	}
+	for (uint32_t j = 0; j < n + 2; j++) {
+		double mean = 0, var = 0, ci;
+
+		for (uint32_t i = 0; i < units; i++)
+			mean += est[i * (n + 2) + j] / units;
+		for (uint32_t i = 0; i < units; i++)
+			var += (est[i * (n + 2) + j] - mean) * (est[i * (n + 2) + j] - mean);
+		ci = SAMPLE_Z * sqrt(scale * var);
+
+		if (j < n)
+			p_stats->levels[j].miss_rate_ci = ci;
+		else if (j == n)
+			p_stats->avg_access_time_ci = ci;
+		else
+			p_stats->modified_AAT_ci = ci;
+	}
+	p_stats->sample_units = units;
+	p_stats->sample_population = sample_slot.size();
 }
+
 /**
  * Subroutine for cleaning up any outstanding memory operations and calculating overall statistics
  * such as miss rate or average access time.
@@ -773,22 +1252,58 @@ uint32_t find_lru_blk(std::vector<c_entry> *m_entry, uint32_t nWays) {
  * @p_stats Pointer to the statistics structure
  */
 void complete_cache(cache_stats_t *p_stats) {
-	double AAT, MP1, MP2, HT1, HT2, MP1_mod;
-	double MissRate_L1 = 0, MissRate_L2 = 0, MR_L2_TLB = 0;
-
-	MissRate_L1 = (double) ((double) (p_stats->L1_write_misses
-			+ p_stats->L1_read_misses) / (double) p_stats->L1_accesses);
-	MissRate_L2 = (double) ((double) p_stats->L2_read_misses
-			/ ((double) (p_stats->L1_write_misses + p_stats->L1_read_misses)));
-	MR_L2_TLB = (double) ((double) (p_stats->L2_read_misses + p_stats->TLB_Misses)
-				/ ((double) (p_stats->L1_write_misses + p_stats->L1_read_misses)));
-	HT1 = (double) ((double) 2 + (double) (0.2 * (double) gs1));
-	HT2 = (double) ((double) 4 + (double) (0.4 * (double) gs2));
-	MP2 = 500;
-	MP1 = HT2 + MissRate_L2 * MP2;
-	MP1_mod = HT2 + MR_L2_TLB * MP2;
-	AAT = (double) HT1 + (double) (MissRate_L1 * MP1);
-	p_stats->modified_AAT = (double) HT1 + (double) (MissRate_L1 * MP1_mod);
-	p_stats->avg_access_time = AAT;
-}
+	sample_counts all = sample_counts();
+	double miss_rate[MAX_LEVELS];
+	uint32_t n = levels.size();
+	uint32_t lvl;
+
+	/*Drain the writeback buffers, top down*/
+	for (lvl = 0; lvl < n; lvl++) {
+		while (!levels[lvl].wb.empty()) {
+			uint64_t evict_blk = levels[lvl].wb.front().tag << levels[lvl].params.offset_bits;
+			int32_t slot = sample_rate > 1 ? Sample_Slot(evict_blk) : -1;
 
+			levels[lvl].wb.erase(levels[lvl].wb.begin());
+			if (slot >= 0)
+				Sample_Count(&sample_units[slot], p_stats, -1);
+			Write_Down(lvl, evict_blk, p_stats);
+			if (slot >= 0)
+				Sample_Count(&sample_units[slot], p_stats, 1);
+		}
+	}
+
+	for (lvl = 0; lvl < n; lvl++) {
+		level_stats_t* ls = &p_stats->levels[lvl];
+
+		all.requests[lvl] = lvl ? ls->reads : ls->reads + ls->writes;
+		all.fetches[lvl] = ls->fetches;
+		all.buffered[lvl] = ls->victim_hits + ls->wb_hits;
+		ls->hit_time = levels[lvl].hit_time;
+	}
+	all.tlb_misses = p_stats->TLB_Misses;
+	Compute_AAT(&all, miss_rate, &p_stats->avg_access_time, &p_stats->modified_AAT);
+	for (lvl = 0; lvl < n; lvl++)
+		p_stats->levels[lvl].miss_rate = miss_rate[lvl];
+	if (sample_rate > 1)
+		Sample_Error(p_stats);
+	if (channel_bw) {
+		p_stats->effective_AAT = latency_total / (double) (p_stats->reads + p_stats->writes);
+		p_stats->mlp = mlp_busy ? mlp_total / mlp_busy : 0;
+		p_stats->channel_utilization = p_stats->cycles ? channel_busy / p_stats->cycles : 0;
+	}
+	if (!cores.empty()) {
+		p_stats->lost_to_others = cores[cur_core].lost;
+		p_stats->ways_quota = cores[cur_core].quota;
+	}
+
+	/*The two-level counters the driver has always printed*/
+	p_stats->num_levels = n;
+	p_stats->L1_accesses = p_stats->levels[0].reads + p_stats->levels[0].writes;
+	p_stats->L1_read_misses = p_stats->levels[0].read_misses;
+	p_stats->L1_write_misses = p_stats->levels[0].write_misses;
+	if (n > 1) {
+		p_stats->L2_read_misses = p_stats->levels[1].read_misses;
+		p_stats->L2_write_misses = p_stats->levels[1].write_misses;
+	}
+	p_stats->write_backs = p_stats->levels[n - 1].write_backs;
+}
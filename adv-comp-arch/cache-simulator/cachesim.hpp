@@ -3,6 +3,28 @@
 #include <inttypes.h>
 #include <stdint.h>
 
+#define MAX_LEVELS 8
+#define MAX_CORES 16
+
+/* Per-level counters. Reads are fills requested by the level above (CPU loads for L1),
+ * writes are dirty blocks written back into the level (CPU stores for L1) */
+struct level_stats_t {
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t read_misses;
+	uint64_t write_misses;
+	uint64_t fetches;		// misses passed on to the next level or memory
+	uint64_t write_backs;	// dirty blocks sent down
+	uint64_t evictions;
+	uint64_t victim_fills;	// clean blocks dropped in by the level above (exclusive)
+	uint64_t victim_hits;	// misses served by the victim buffer
+	uint64_t wb_hits;		// misses served by the writeback buffer
+	uint64_t back_invalidations;	// upper-level blocks dropped to keep inclusion
+	double	hit_time;
+	double	miss_rate;
+	double	miss_rate_ci;	// 95% half-width when sampling sets
+};
+
 struct cache_stats_t {
 	uint64_t accesses;
     uint64_t reads;
@@ -19,7 +41,39 @@ struct cache_stats_t {
     uint64_t successful_prefetches; // The number of cache misses reduced by prefetching
     double   avg_access_time;
     double	modified_AAT;
+    uint32_t num_levels;
+    level_stats_t levels[MAX_LEVELS];
+    /* Set sampling only: the counters above cover the simulated units alone */
+    uint32_t sample_units;		// set groups simulated
+    uint32_t sample_population;	// set groups in all
+    uint64_t sample_skipped;	// accesses to groups not simulated
+    double	avg_access_time_ci;	// 95% half-widths
+    double	modified_AAT_ci;
+    /* Multi-core only; each core has its own copy of these statistics */
+    uint64_t evicted_others;	// shared-level blocks of other cores it evicted
+    uint64_t lost_to_others;	// its shared-level blocks other cores evicted
+    uint64_t shared_hits;		// shared-level hits on blocks another core brought in
+    uint64_t bank_conflicts;	// shared-level requests to a bank another core used in the same round
+    uint32_t ways_quota;		// shared-level ways it may fill at the end, 0 unpartitioned
+    /* Timing mode only */
+    double	cycles;				// when the last access had its data
+    double	effective_AAT;		// mean cycles from issue to data, misses overlapping
+    double	mlp;				// demand memory requests outstanding, over cycles with any
+    double	channel_utilization;	// share of the cycles the memory channel was busy
+    double	mshr_stall_cycles;	// cycles requests waited for a free MSHR
+    uint64_t coalesced_misses;	// requests that waited on a block already on its way
+    uint64_t late_prefetches;	// first uses of prefetched blocks still on their way
+};
 
+struct c_entry {
+	uint64_t tag;
+	//uint32_t data;
+	uint64_t lru_time;
+	bool b_dirty;
+	bool b_valid;
+	bool prefetch;
+	bool across_page;
+	uint8_t core;	// core that brought it into the shared level
 };
 
 struct pf //This is the entry in the free page data structure
@@ -49,6 +103,14 @@ struct table
 
 void cache_access(char rw, uint64_t address, cache_stats_t* p_stats);
 void setup_cache(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2, uint64_t b2, uint64_t s2, uint32_t k);
+void add_cache_level(uint64_t c, uint64_t b, uint64_t s, const char* opts);
+void setup_hierarchy(uint32_t k);
+void set_replacement(const char* spec);
+void setup_sampling(uint32_t rate);
+void set_timing(uint32_t mshrs, double bytes_per_cycle);
+void setup_cores(uint32_t n, uint32_t nbanks, const char* partition);
+void select_core(uint32_t core);
+void cache_round(void);
 void complete_cache(cache_stats_t *p_stats);
 
 static const uint64_t DEFAULT_C1 = 12;   /* 4KB Cache */
@@ -58,6 +120,7 @@ static const uint64_t DEFAULT_C2 = 15;   /* 32KB Cache */
 static const uint64_t DEFAULT_B2 = 6;    /* 64-byte blocks */
 static const uint64_t DEFAULT_S2 = 5;    /* 32 blocks per set */
 static const uint32_t DEFAULT_K = 2;    /* prefetch 2 subsequent blocks */
+#define DEFAULT_CHANNEL_BW 8	/* bytes per cycle between the last level and memory */
 //extern uint64_t count;
 /** Argument to cache_access rw. Indicates a load */
 static const char     READ = 'r';
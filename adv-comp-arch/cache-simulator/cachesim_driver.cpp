@@ -5,7 +5,10 @@
 #include <cstring>
 #include <unistd.h>
 #include <math.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include "cachesim.hpp"
+#include "cachesim_trace.hpp"
 
 #define physical_address_size 1024*1024*1024*4
 #define page_size 4096
@@ -161,6 +164,33 @@ uint64_t conversion(uint64_t address) {
  }
  }*/
 
+/* Levels given with -L, L1 first; none means the -c/-b/-s/-C/-B/-S pair */
+static const char* level_specs[MAX_LEVELS];
+static uint32_t num_level_specs = 0;
+
+/* "C,B,S[,opts]", see add_cache_level() */
+static void add_level_spec(const char* spec) {
+	char* p;
+	uint64_t c, b, s;
+
+	c = strtoull(spec, &p, 10);
+	if (*p++ != ',')
+		goto bad;
+	b = strtoull(p, &p, 10);
+	if (*p++ != ',')
+		goto bad;
+	s = strtoull(p, &p, 10);
+	if (*p == ',')
+		p++;
+	else if (*p)
+		goto bad;
+	add_cache_level(c, b, s, p);
+	return;
+bad:
+	fprintf(stderr, "Bad cache level \"%s\", expected C,B,S[,opts]\n", spec);
+	exit(1);
+}
+
 void print_help_and_exit(void) {
 	printf("cachesim [OPTIONS] < traces/file.trace\n");
 	printf("  -c C1\t\tTotal size of L1 in bytes is 2^C1\n");
@@ -170,11 +200,173 @@ void print_help_and_exit(void) {
 	printf("  -B B2\t\tSize of each block in L2 in bytes is 2^B2\n");
 	printf("  -S S2\t\tNumber of blocks per set in L2 is 2^S2\n");
 	printf("  -k K\t\tNumber of prefetch blocks\n");
+	printf("  -L C,B,S[,opts]\tAdd a cache level; repeat for each level, L1 first. Replaces -c/-b/-s/-C/-B/-S\n");
+	printf("\t\topts: i inclusive or e exclusive of the levels above, v<N> victim buffer entries,\n");
+	printf("\t\t      w<N> writeback buffer entries, t<N> hit time, r<policy> replacement,\n");
+	printf("\t\t      m<N> MSHRs (with -M)\n");
+	printf("  -R POLICY\tReplacement for every level: lru (default), plru, srrip, brrip, shipm,\n");
+	printf("\t\t  drrip[:leaders[:stride|hash]]\n");
+	printf("  -M N[,BW]\tTime overlapping misses with N MSHRs per level and a\n");
+	printf("\t\t  memory channel of BW bytes per cycle (default %d)\n", DEFAULT_CHANNEL_BW);
+	printf("  -p N\t\tSimulate only 1/N of the sets (N a power of two) and estimate the rest\n");
+	printf("  -V\t\tWith -p, also run everything and report the sampling error\n");
+	printf("  -T FILE\tAdd a core running the trace in FILE; repeat for each core. The cores have\n");
+	printf("\t\t  their own copies of every level but the last, which they share\n");
+	printf("  -I rr|time\tInterleave the cores' accesses round robin (default) or by time stamp\n");
+	printf("  -W POLICY\tShared-level ways per core: none (default), ways:N,N,... or ucp\n");
+	printf("  -n N\t\tBanks in the shared level\n");
+	printf("  -A\t\tThe cores share one address space (default: one each)\n");
+	printf("  -i FILE\tRead the trace from FILE, text or binary (default: stdin)\n");
+	printf("  -o FILE\tWrite the trace to FILE in binary and exit\n");
+	printf("  -d\t\tPrint the trace as text and exit\n");
 	printf("  -h\t\tThis helpful output\n");
 	exit(0);
 }
 
 void print_statistics(cache_stats_t* p_stats);
+void print_sampling(cache_stats_t* p_stats, cache_stats_t* p_full);
+void print_interference(cache_stats_t* p_stats);
+void print_timing(cache_stats_t* p_stats);
+
+static void print_pages(void) {
+	printf("NUMBER OF PAGES: %d \n", count_num_pages);
+	printf("PREFETCHES ACROSS PAGES: %d \n", count_across_pages);
+	printf("PREFETCHES ACROSS PAGES SUCCESSFUL: %d \n",
+			count_across_page_successful);
+	printf("RATIO OF PREFETCHES ACROSS PAGES %f \n", float(count_across_pages)/float(count_across_page_successful));
+}
+
+/* Feed the whole trace through the cache and finish the statistics */
+static void run_trace(FILE* fin, cache_stats_t* p_stats) {
+	trace_access* batch;
+	trace_file* t;
+	size_t n;
+
+	memset(p_stats, 0, sizeof(cache_stats_t));
+	/* Begin reading the file; a helper thread decodes it ahead of us */
+	t = trace_open(fin);
+	while ((n = trace_next(t, &batch)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			count++;
+
+			//printf("Converted addresses %lu \n", conversion(address));
+#if MAPPING
+			cache_access(batch[i].rw, conversion(batch[i].address), p_stats);
+#else
+			cache_access(batch[i].rw, batch[i].address, p_stats);
+#endif
+			//cache_access(rw, address , p_stats);
+		}
+	}
+	trace_close(t);
+
+	complete_cache(p_stats);
+}
+
+/* Multi-core: per-core traces, one given with each -T */
+static const char* core_files[MAX_CORES];
+static uint32_t num_cores = 0;
+/* Each core's addresses get its number in these bits, unless they share one address space */
+#define CORE_ASID_SHIFT 48
+
+/* One core's place in its trace */
+struct core_input {
+	trace_file* t;
+	trace_access* batch;
+	size_t n;
+	size_t i;
+};
+
+/* Next access of a core, or NULL once its trace is done */
+static trace_access* core_peek(core_input* in) {
+	if (in->t && in->i == in->n) {
+		in->n = trace_next(in->t, &in->batch);
+		in->i = 0;
+		if (!in->n) {
+			trace_close(in->t);
+			in->t = NULL;
+		}
+	}
+	return in->t ? &in->batch[in->i] : NULL;
+}
+
+/* Simulate the access core_peek() returned for core c */
+static void core_step(core_input* in, uint32_t c, bool shared_space, cache_stats_t* core_stats) {
+	trace_access* a = &in->batch[in->i++];
+	uint64_t address = a->address;
+
+	count++;
+	if (!shared_space)
+		address |= (uint64_t) c << CORE_ASID_SHIFT;
+	select_core(c);
+#if MAPPING
+	cache_access(a->rw, conversion(address), &core_stats[c]);
+#else
+	cache_access(a->rw, address, &core_stats[c]);
+#endif
+}
+
+/* Run the per-core traces against the shared hierarchy. Round robin takes one
+ * access from each core in turn; by time always runs the core whose next access
+ * has the lowest time stamp, the lower core first on a tie. A round, for bank
+ * conflicts, is one access per core or one time stamp */
+static void run_cores(bool by_time, bool shared_space, cache_stats_t* core_stats) {
+	core_input in[MAX_CORES];
+	uint64_t now = 0;
+	bool any = 1;
+
+	for (uint32_t c = 0; c < num_cores; c++) {
+		FILE* f = fopen(core_files[c], "r");
+
+		if (!f) {
+			perror(core_files[c]);
+			exit(1);
+		}
+		memset(&core_stats[c], 0, sizeof(cache_stats_t));
+		in[c].t = trace_open(f);
+		in[c].n = in[c].i = 0;
+		fclose(f);
+		if (by_time && !trace_has_time(in[c].t)) {
+			fprintf(stderr, "%s is a binary trace without its time stamps; convert it again for -I time\n", core_files[c]);
+			exit(1);
+		}
+	}
+	while (by_time) {
+		trace_access* first = NULL;
+		uint32_t c = 0;
+
+		for (uint32_t d = 0; d < num_cores; d++) {
+			trace_access* next = core_peek(&in[d]);
+
+			if (next && (!first || next->time < first->time)) {
+				first = next;
+				c = d;
+			}
+		}
+		if (!first)
+			break;
+		if (first->time != now) {
+			cache_round();
+			now = first->time;
+		}
+		core_step(&in[c], c, shared_space, core_stats);
+	}
+	while (!by_time && any) {
+		any = 0;
+		for (uint32_t c = 0; c < num_cores; c++) {
+			if (core_peek(&in[c])) {
+				core_step(&in[c], c, shared_space, core_stats);
+				any = 1;
+			}
+		}
+		cache_round();
+	}
+
+	for (uint32_t c = 0; c < num_cores; c++) {
+		select_core(c);
+		complete_cache(&core_stats[c]);
+	}
+}
 
 int main(int argc, char* argv[]) {
 	int opt;
@@ -187,11 +379,23 @@ int main(int argc, char* argv[]) {
 	uint32_t k = DEFAULT_K;
 
 	FILE* fin = stdin;
+	char* bin_out = NULL;
+	bool dump_text = 0;
+	char* repl = NULL;
+	uint32_t sample = 1;
+	bool validate = 0;
+	int full_pipe[2];
+	pid_t full_pid = 0;
+	bool by_time = 0;
+	bool shared_space = 0;
+	char* timing = NULL;
+	const char* partition = "none";
+	uint32_t banks = 1;
 
 	count_num_pages = 0;
 	count_across_pages = 0;
 	/* Read arguments */
-	while (-1 != (opt = getopt(argc, argv, "c:b:s:C:B:S:k:i:h"))) {
+	while (-1 != (opt = getopt(argc, argv, "c:b:s:C:B:S:k:i:o:dL:R:p:VT:I:W:n:AM:h"))) {
 		switch (opt) {
 		case 'c':
 			c1 = atoi(optarg);
@@ -216,6 +420,56 @@ int main(int argc, char* argv[]) {
 			break;
 		case 'i':
 			fin = fopen(optarg, "r");
+			if (!fin) {
+				perror(optarg);
+				exit(1);
+			}
+			break;
+		case 'o':
+			bin_out = optarg;
+			break;
+		case 'd':
+			dump_text = 1;
+			break;
+		case 'L':
+			if (num_level_specs == MAX_LEVELS) {
+				fprintf(stderr, "At most %d cache levels\n", MAX_LEVELS);
+				exit(1);
+			}
+			level_specs[num_level_specs++] = optarg;
+			break;
+		case 'R':
+			repl = optarg;
+			break;
+		case 'p':
+			sample = atoi(optarg);
+			break;
+		case 'V':
+			validate = 1;
+			break;
+		case 'T':
+			if (num_cores == MAX_CORES) {
+				fprintf(stderr, "At most %d cores\n", MAX_CORES);
+				exit(1);
+			}
+			core_files[num_cores++] = optarg;
+			break;
+		case 'I':
+			if (strcmp(optarg, "rr") && strcmp(optarg, "time"))
+				print_help_and_exit();
+			by_time = !strcmp(optarg, "time");
+			break;
+		case 'W':
+			partition = optarg;
+			break;
+		case 'n':
+			banks = atoi(optarg);
+			break;
+		case 'A':
+			shared_space = 1;
+			break;
+		case 'M':
+			timing = optarg;
 			break;
 		case 'h':
 			/* Fall through */
@@ -225,55 +479,147 @@ int main(int argc, char* argv[]) {
 		}
 	}
 
+	/* Convert once, run many: the binary trace decodes much faster */
+	if (bin_out || dump_text) {
+		FILE* fout = dump_text ? stdout : fopen(bin_out, "wb");
+		uint64_t n;
+
+		if (!fout) {
+			perror(bin_out);
+			exit(1);
+		}
+		trace_file* t = trace_open(fin);
+		n = dump_text ? trace_write_text(t, fout) : trace_write_binary(t, fout);
+		trace_close(t);
+		if (!dump_text) {
+			fclose(fout);
+			fprintf(stderr, "Wrote %" PRIu64 " accesses to %s\n", n, bin_out);
+		}
+		return 0;
+	}
+
 	printf("Cache Settings\n");
-	printf("C1: %" PRIu64 "\n", c1);
-	printf("B1: %" PRIu64 "\n", b1);
-	printf("S1: %" PRIu64 "\n", s1);
-	printf("C2: %" PRIu64 "\n", c2);
-	printf("B2: %" PRIu64 "\n", b2);
-	printf("S2: %" PRIu64 "\n", s2);
+	if (num_level_specs) {
+		for (uint32_t i = 0; i < num_level_specs; i++)
+			printf("L%u: %s\n", i + 1, level_specs[i]);
+	} else {
+		printf("C1: %" PRIu64 "\n", c1);
+		printf("B1: %" PRIu64 "\n", b1);
+		printf("S1: %" PRIu64 "\n", s1);
+		printf("C2: %" PRIu64 "\n", c2);
+		printf("B2: %" PRIu64 "\n", b2);
+		printf("S2: %" PRIu64 "\n", s2);
+	}
 	printf("K: %" PRIu32 "\n", k);
+	if (repl)
+		printf("Replacement: %s\n", repl);
+	if (sample > 1)
+		printf("Sampling: 1/%u of the sets\n", sample);
+	if (num_cores) {
+		printf("Cores: %u, interleaved %s, %s address space%s\n", num_cores,
+				by_time ? "by time" : "round robin", shared_space ? "one" : "an", shared_space ? "" : " each");
+		printf("Shared level: %u bank%s, partition %s\n", banks, banks == 1 ? "" : "s", partition);
+	}
+	if (timing)
+		printf("Timing: %s\n", timing);
 	printf("\n");
 
-	assert(c2 >= c1);
-	assert(b2 >= b1);
-	assert(s2 >= s1);
 	assert(k >= 0 && k <= 4);
 
 	/* Setup the cache */
-	setup_cache(c1, b1, s1, c2, b2, s2, k);
+	if (repl)
+		set_replacement(repl);
+	if (timing) {
+		char* p;
+		uint32_t mshrs = strtoul(timing, &p, 10);
+		double bw = *p == ',' ? strtod(p + 1, &p) : DEFAULT_CHANNEL_BW;
+
+		if (*p || bw <= 0 || num_cores || sample > 1) {
+			fprintf(stderr, "Bad -M \"%s\", or used with -T or -p\n", timing);
+			exit(1);
+		}
+		set_timing(mshrs, bw);
+	}
+	if (num_level_specs) {
+		for (uint32_t i = 0; i < num_level_specs; i++)
+			add_level_spec(level_specs[i]);
+		setup_hierarchy(k);
+	} else {
+		assert(c2 >= c1);
+		assert(b2 >= b1);
+		assert(s2 >= s1);
+		setup_cache(c1, b1, s1, c2, b2, s2, k);
+	}
 
 	/* Setup statistics */
 	cache_stats_t stats;
-	memset(&stats, 0, sizeof(cache_stats_t));
+	cache_stats_t full;
 
 	initialize();
-	/* Begin reading the file */
-	char rw;
-	uint64_t address;
-	while (!feof(fin)) {
-		int ret = fscanf(fin, "%c %" PRIx64 "\n", &rw, &address);
-		if (ret == 2) {
-			count++;
+	if (num_cores) {
+		cache_stats_t core_stats[MAX_CORES];
 
-			//printf("Converted addresses %lu \n", conversion(address));
-#if MAPPING
-			cache_access(rw, conversion(address), &stats);
-#else
-			cache_access(rw, address, &stats);
-#endif
-			//cache_access(rw, address , &stats);
+		if (sample > 1) {
+			fprintf(stderr, "-p does not work with -T\n");
+			exit(1);
+		}
+		setup_cores(num_cores, banks, partition);
+		run_cores(by_time, shared_space, core_stats);
+		for (uint32_t c = 0; c < num_cores; c++) {
+			printf("Core %u: %s\n", c, core_files[c]);
+			print_statistics(&core_stats[c]);
+			print_interference(&core_stats[c]);
 		}
+		print_pages();
+		return 0;
 	}
-
-	complete_cache(&stats);
+	/* The full run for -V goes on in a child, which shares every bit of state
+	 * set up so far and reads the trace through its own mapping */
+	if (validate) {
+		struct stat st;
+
+		if (sample <= 1) {
+			fprintf(stderr, "-V needs -p\n");
+			exit(1);
+		}
+		if (fstat(fileno(fin), &st) || !S_ISREG(st.st_mode)) {
+			fprintf(stderr, "-V needs the trace in a file, not a pipe\n");
+			exit(1);
+		}
+		fflush(stdout);
+		if (pipe(full_pipe) || (full_pid = fork()) < 0) {
+			perror("fork");
+			exit(1);
+		}
+		if (!full_pid) {
+			close(full_pipe[0]);
+			if (!freopen("/dev/null", "w", stdout))
+				_exit(1);
+			run_trace(fin, &full);
+			if (write(full_pipe[1], &full, sizeof(full)) != sizeof(full))
+				_exit(1);
+			_exit(0);
+		}
+		close(full_pipe[1]);
+	}
+	setup_sampling(sample);
+	run_trace(fin, &stats);
 
 	print_statistics(&stats);
-	printf("NUMBER OF PAGES: %d \n", count_num_pages);
-	printf("PREFETCHES ACROSS PAGES: %d \n", count_across_pages);
-	printf("PREFETCHES ACROSS PAGES SUCCESSFUL: %d \n",
-			count_across_page_successful);
-	printf("RATIO OF PREFETCHES ACROSS PAGES %f \n", float(count_across_pages)/float(count_across_page_successful));
+	if (timing)
+		print_timing(&stats);
+	if (validate) {
+		int status;
+
+		if (read(full_pipe[0], &full, sizeof(full)) != sizeof(full)
+				|| waitpid(full_pid, &status, 0) != full_pid || status) {
+			fprintf(stderr, "The full run for -V failed\n");
+			exit(1);
+		}
+		print_sampling(&stats, &full);
+	} else if (sample > 1)
+		print_sampling(&stats, NULL);
+	print_pages();
 
 	/*for(int i=0;i<page_table_size;i++)	//1024*1024 because i initially assumed 4 GB divided by 4KB				//mapping a virtual page number to physical page number
 	 {
@@ -307,5 +653,77 @@ void print_statistics(cache_stats_t* p_stats) {
 			float(p_stats->prefetched_blocks) / float(
 					p_stats->successful_prefetches));
 
+	if (!num_level_specs)
+		return;
+	for (uint32_t i = 0; i < p_stats->num_levels; i++) {
+		level_stats_t* ls = &p_stats->levels[i];
+
+		printf("L%u Reads: %" PRIu64 "\n", i + 1, ls->reads);
+		printf("L%u Read misses: %" PRIu64 "\n", i + 1, ls->read_misses);
+		printf("L%u Writes: %" PRIu64 "\n", i + 1, ls->writes);
+		printf("L%u Write misses: %" PRIu64 "\n", i + 1, ls->write_misses);
+		printf("L%u Write backs: %" PRIu64 "\n", i + 1, ls->write_backs);
+		printf("L%u Evictions: %" PRIu64 "\n", i + 1, ls->evictions);
+		printf("L%u Victim fills: %" PRIu64 "\n", i + 1, ls->victim_fills);
+		printf("L%u Victim buffer hits: %" PRIu64 "\n", i + 1, ls->victim_hits);
+		printf("L%u Writeback buffer hits: %" PRIu64 "\n", i + 1, ls->wb_hits);
+		printf("L%u Back-invalidations: %" PRIu64 "\n", i + 1, ls->back_invalidations);
+		printf("L%u Miss rate: %f\n", i + 1, ls->miss_rate);
+		printf("L%u Hit time: %f\n", i + 1, ls->hit_time);
+	}
+
+}
+
+/* Estimates from the sampled sets, and how far they are from a full run */
+void print_sampling(cache_stats_t* p_stats, cache_stats_t* p_full) {
+	uint64_t simulated = p_stats->reads + p_stats->writes;
+
+	printf("Sampled set groups: %" PRIu32 " of %" PRIu32 "\n", p_stats->sample_units,
+			p_stats->sample_population);
+	printf("Simulated accesses: %" PRIu64 " of %" PRIu64 "\n", simulated,
+			simulated + p_stats->sample_skipped);
+	for (uint32_t i = 0; i < p_stats->num_levels; i++)
+		printf("L%u Miss rate: %f +/- %f\n", i + 1, p_stats->levels[i].miss_rate,
+				p_stats->levels[i].miss_rate_ci);
+	printf("AAT: %f +/- %f\n", p_stats->avg_access_time, p_stats->avg_access_time_ci);
+	printf("Modified AAT: %f +/- %f\n", p_stats->modified_AAT, p_stats->modified_AAT_ci);
+	if (!p_full)
+		return;
+
+	printf("Sampling error against the full run\n");
+	for (uint32_t i = 0; i < p_stats->num_levels; i++) {
+		double err = p_stats->levels[i].miss_rate - p_full->levels[i].miss_rate;
+
+		printf("L%u Miss rate: full %f, error %+f (%s the interval)\n", i + 1,
+				p_full->levels[i].miss_rate, err,
+				fabs(err) <= p_stats->levels[i].miss_rate_ci ? "inside" : "outside");
+	}
+	printf("AAT: full %f, error %+f (%s the interval)\n", p_full->avg_access_time,
+			p_stats->avg_access_time - p_full->avg_access_time,
+			fabs(p_stats->avg_access_time - p_full->avg_access_time) <= p_stats->avg_access_time_ci ? "inside" : "outside");
+	printf("Modified AAT: full %f, error %+f (%s the interval)\n", p_full->modified_AAT,
+			p_stats->modified_AAT - p_full->modified_AAT,
+			fabs(p_stats->modified_AAT - p_full->modified_AAT) <= p_stats->modified_AAT_ci ? "inside" : "outside");
+}
+
+/* What one core did to the others in the shared level, and they to it */
+void print_interference(cache_stats_t* p_stats) {
+	printf("Evicted blocks of other cores: %" PRIu64 "\n", p_stats->evicted_others);
+	printf("Blocks evicted by other cores: %" PRIu64 "\n", p_stats->lost_to_others);
+	printf("Hits on blocks of other cores: %" PRIu64 "\n", p_stats->shared_hits);
+	printf("Bank conflicts: %" PRIu64 "\n", p_stats->bank_conflicts);
+	if (p_stats->ways_quota)
+		printf("Shared-level ways: %" PRIu32 "\n", p_stats->ways_quota);
+	printf("\n");
 }
 
+/* Timing mode: what the misses cost once they overlap */
+void print_timing(cache_stats_t* p_stats) {
+	printf("Cycles: %f\n", p_stats->cycles);
+	printf("Effective AAT: %f\n", p_stats->effective_AAT);
+	printf("Memory-level parallelism: %f\n", p_stats->mlp);
+	printf("Memory channel utilization: %f\n", p_stats->channel_utilization);
+	printf("MSHR stall cycles: %f\n", p_stats->mshr_stall_cycles);
+	printf("Coalesced misses: %" PRIu64 "\n", p_stats->coalesced_misses);
+	printf("Late prefetches: %" PRIu64 "\n", p_stats->late_prefetches);
+}
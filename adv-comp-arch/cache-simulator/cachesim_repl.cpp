@@ -0,0 +1,296 @@
+#include "cachesim_repl.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+#define RRPV_MAX 3 /*2-bit re-reference prediction values*/
+#define BRRIP_LONG_EVERY 32 /*BRRIP inserts one fill in this many at long rather than distant*/
+#define PSEL_BITS 10
+#define SHCT_SIZE 16384 /*Signature history counters*/
+#define SHCT_MAX 7
+#define SHIP_REGION_BITS 12 /*No PCs in the trace; sign blocks by 4KB region*/
+
+static inline bool way_allowed(uint64_t allowed, uint32_t way) {
+	return way >= 64 || ((allowed >> way) & 1);
+}
+
+/*Global time stamp shared by every lru level*/
+static uint64_t glrutime = 10000; /*For prefetched blocks, 0-9999 is used*/
+
+/*n fields of width bits (1 or 2), packed into words*/
+class packed_bits {
+	vector<uint64_t> words;
+	uint32_t width;
+public:
+	packed_bits(uint64_t n, uint32_t w) :
+			words((n * w + 63) / 64), width(w) {
+	}
+	uint32_t get(uint64_t i) const {
+		uint64_t bit = i * width;
+		return (words[bit / 64] >> (bit % 64)) & ((1u << width) - 1);
+	}
+	void set(uint64_t i, uint32_t v) {
+		uint64_t bit = i * width;
+		uint64_t m = (uint64_t) ((1u << width) - 1) << (bit % 64);
+		words[bit / 64] = (words[bit / 64] & ~m) | ((uint64_t) v << (bit % 64) & m);
+	}
+};
+
+/*Time stamp LRU, the original policy*/
+class lru_policy: public repl_policy {
+	uint32_t nWays;
+public:
+	lru_policy(uint32_t ways) :
+			nWays(ways) {
+	}
+	void hit(uint64_t, uint32_t way, vector<c_entry>& row) {
+		row[way].lru_time = ++glrutime;
+	}
+	void fill(uint64_t, uint32_t way, vector<c_entry>& row, uint64_t, bool prefetch) {
+		/*Prefetched blks are given timestamp values below 10000*/
+		row[way].lru_time = prefetch ? nWays : ++glrutime;
+	}
+	/*Find LRU block for given array*/
+	uint32_t victim(uint64_t, vector<c_entry>& row, uint64_t allowed) {
+		uint32_t nIndex = 0;
+		uint64_t s_min;
+
+		while (!way_allowed(allowed, nIndex))
+			nIndex++;
+		s_min = row[nIndex].lru_time;
+		for (uint32_t nCnt = nIndex + 1; nCnt < nWays; nCnt++) {
+			if (way_allowed(allowed, nCnt) && s_min >= row[nCnt].lru_time) {
+				s_min = row[nCnt].lru_time;
+				nIndex = nCnt;
+			}
+		}
+		return nIndex;
+	}
+};
+
+/*Tree pseudo-LRU: ways bits per set (node 0 unused), each pointing towards the colder half*/
+class plru_policy: public repl_policy {
+	packed_bits tree;
+	uint32_t nWays;
+
+	void touch(uint64_t set, uint32_t way) {
+		uint32_t node = 1;
+
+		for (uint32_t span = nWays / 2; span; span /= 2) {
+			uint32_t bit = (way & span) ? 1 : 0;
+			tree.set(set * nWays + node, !bit);
+			node = 2 * node + bit;
+		}
+	}
+public:
+	plru_policy(uint64_t sets, uint32_t ways) :
+			tree(sets * ways, 1), nWays(ways) {
+	}
+	void hit(uint64_t set, uint32_t way, vector<c_entry>&) {
+		touch(set, way);
+	}
+	void fill(uint64_t set, uint32_t way, vector<c_entry>&, uint64_t, bool prefetch) {
+		/*A prefetched block stays where the tree points, first in line to go*/
+		if (!prefetch)
+			touch(set, way);
+	}
+	/*Follow the tree, turning away from halves with no allowed way*/
+	uint32_t victim(uint64_t set, vector<c_entry>&, uint64_t allowed) {
+		uint32_t node = 1, first = 0;
+
+		for (uint32_t span = nWays / 2; span; span /= 2) {
+			uint32_t bit = tree.get(set * nWays + node);
+
+			if (allowed != REPL_ALL_WAYS
+					&& !((allowed >> (first + bit * span)) & (((uint64_t) 1 << span) - 1)))
+				bit = !bit;
+			first += bit * span;
+			node = 2 * node + bit;
+		}
+		return first;
+	}
+};
+
+/*Re-reference interval prediction; subclasses pick the insertion value*/
+class rrip_policy: public repl_policy {
+protected:
+	packed_bits rrpv;
+	uint32_t nWays;
+	uint32_t brrip_fills;
+
+	uint32_t brrip_insert() {
+		return (++brrip_fills % BRRIP_LONG_EVERY) ? RRPV_MAX : RRPV_MAX - 1;
+	}
+	virtual uint32_t insert(uint64_t set, uint64_t address) = 0;
+public:
+	rrip_policy(uint64_t sets, uint32_t ways) :
+			rrpv(sets * ways, 2), nWays(ways), brrip_fills(0) {
+	}
+	void hit(uint64_t set, uint32_t way, vector<c_entry>&) {
+		rrpv.set(set * nWays + way, 0);
+	}
+	void fill(uint64_t set, uint32_t way, vector<c_entry>&, uint64_t address, bool prefetch) {
+		rrpv.set(set * nWays + way, prefetch ? RRPV_MAX : insert(set, address));
+	}
+	/*First allowed block predicted distant, ageing the allowed ones until there is one*/
+	uint32_t victim(uint64_t set, vector<c_entry>&, uint64_t allowed) {
+		for (;;) {
+			for (uint32_t nCnt = 0; nCnt < nWays; nCnt++)
+				if (way_allowed(allowed, nCnt) && rrpv.get(set * nWays + nCnt) == RRPV_MAX)
+					return nCnt;
+			for (uint32_t nCnt = 0; nCnt < nWays; nCnt++)
+				if (way_allowed(allowed, nCnt))
+					rrpv.set(set * nWays + nCnt, rrpv.get(set * nWays + nCnt) + 1);
+		}
+	}
+};
+
+class srrip_policy: public rrip_policy {
+	uint32_t insert(uint64_t, uint64_t) {
+		return RRPV_MAX - 1;
+	}
+public:
+	srrip_policy(uint64_t sets, uint32_t ways) :
+			rrip_policy(sets, ways) {
+	}
+};
+
+/*Distant insertion protects the rest of the set from scans*/
+class brrip_policy: public rrip_policy {
+	uint32_t insert(uint64_t, uint64_t) {
+		return brrip_insert();
+	}
+public:
+	brrip_policy(uint64_t sets, uint32_t ways) :
+			rrip_policy(sets, ways) {
+	}
+};
+
+/*Set dueling between SRRIP and BRRIP: misses in either's leader sets steer
+ * PSEL, and the follower sets insert as the one missing less*/
+class drrip_policy: public rrip_policy {
+	uint64_t region;
+	bool hashed;
+	uint32_t psel;
+
+	/*0 follower, 1 SRRIP leader, 2 BRRIP leader*/
+	uint32_t leader(uint64_t set) const {
+		uint64_t slot = set;
+
+		if (hashed) {
+			slot = set * 0x9E3779B97F4A7C15ULL;
+			slot ^= slot >> 29;
+		}
+		slot %= region;
+		if (slot == 0)
+			return 1;
+		if (slot == region / 2)
+			return 2;
+		return 0;
+	}
+	uint32_t insert(uint64_t set, uint64_t) {
+		switch (leader(set)) {
+		case 1:
+			if (psel < (1u << PSEL_BITS) - 1)
+				psel++;
+			return RRPV_MAX - 1;
+		case 2:
+			if (psel > 0)
+				psel--;
+			return brrip_insert();
+		default:
+			return (psel >> (PSEL_BITS - 1)) ? brrip_insert() : RRPV_MAX - 1;
+		}
+	}
+public:
+	drrip_policy(uint64_t sets, uint32_t ways, uint64_t leaders, bool hash) :
+			rrip_policy(sets, ways), hashed(hash), psel(1u << (PSEL_BITS - 1)) {
+		region = leaders ? sets / leaders : sets;
+		if (region < 2)
+			region = 2;
+	}
+};
+
+/*SHiP on SRRIP with memory-region signatures: blocks from regions whose
+ * blocks tend to die unreferenced are inserted distant*/
+class ship_policy: public rrip_policy {
+	vector<uint16_t> sig;
+	packed_bits outcome;
+	vector<uint8_t> shct;
+
+	static uint32_t signature(uint64_t address) {
+		uint64_t h = (address >> SHIP_REGION_BITS) * 0x9E3779B97F4A7C15ULL;
+		return (h >> 40) % SHCT_SIZE;
+	}
+	uint32_t insert(uint64_t, uint64_t address) {
+		return shct[signature(address)] ? RRPV_MAX - 1 : RRPV_MAX;
+	}
+public:
+	ship_policy(uint64_t sets, uint32_t ways) :
+			rrip_policy(sets, ways), sig(sets * ways), outcome(sets * ways, 1), shct(SHCT_SIZE, 1) {
+	}
+	void hit(uint64_t set, uint32_t way, vector<c_entry>& row) {
+		uint64_t i = set * nWays + way;
+
+		rrip_policy::hit(set, way, row);
+		outcome.set(i, 1);
+		if (shct[sig[i]] < SHCT_MAX)
+			shct[sig[i]]++;
+	}
+	void fill(uint64_t set, uint32_t way, vector<c_entry>& row, uint64_t address, bool prefetch) {
+		uint64_t i = set * nWays + way;
+
+		rrip_policy::fill(set, way, row, address, prefetch);
+		sig[i] = signature(address);
+		outcome.set(i, 0);
+	}
+	uint32_t victim(uint64_t set, vector<c_entry>& row, uint64_t allowed) {
+		uint32_t way = rrip_policy::victim(set, row, allowed);
+		uint64_t i = set * nWays + way;
+
+		if (!outcome.get(i) && shct[sig[i]])
+			shct[sig[i]]--;
+		return way;
+	}
+};
+
+repl_policy* repl_create(const char* spec, uint64_t sets, uint32_t ways) {
+	char name[16];
+	const char* p = spec;
+	size_t len = strcspn(spec, ":");
+
+	if (len >= sizeof(name))
+		return NULL;
+	memcpy(name, spec, len);
+	name[len] = 0;
+	p += len;
+
+	if (!strcmp(name, "lru"))
+		return *p ? NULL : new lru_policy(ways);
+	if (!strcmp(name, "plru"))
+		return *p ? NULL : new plru_policy(sets, ways);
+	if (!strcmp(name, "srrip"))
+		return *p ? NULL : new srrip_policy(sets, ways);
+	if (!strcmp(name, "brrip"))
+		return *p ? NULL : new brrip_policy(sets, ways);
+	if (!strcmp(name, "shipm"))
+		return *p ? NULL : new ship_policy(sets, ways);
+	if (!strcmp(name, "drrip")) {
+		uint64_t leaders = 32;
+		bool hash = 0;
+
+		if (*p == ':')
+			leaders = strtoull(p + 1, (char**) &p, 10);
+		if (*p == ':') {
+			p++;
+			if (!strcmp(p, "hash"))
+				hash = 1;
+			else if (strcmp(p, "stride"))
+				return NULL;
+		} else if (*p)
+			return NULL;
+		return new drrip_policy(sets, ways, leaders, hash);
+	}
+	return NULL;
+}
@@ -0,0 +1,36 @@
+#ifndef CACHESIM_REPL_HPP
+#define CACHESIM_REPL_HPP
+#include <vector>
+#include "cachesim.hpp"
+
+/*
+ * Replacement policies. One instance per cache level; the level tells it
+ * about hits, fills and evictions by set index and way, and asks it for a
+ * victim when a set is full. Everything except lru keeps its state in
+ * packed per-set arrays rather than in the c_entry.
+ *
+ * Spec strings: lru, plru, srrip, brrip, shipm, drrip[:<leaders>[:stride|hash]].
+ * drrip duels srrip against brrip on <leaders> sets each (default 32), picked
+ * every sets/<leaders> sets (stride) or by hashing the set index (hash).
+ */
+class repl_policy {
+public:
+	virtual ~repl_policy() {}
+
+	/* Demand hit on a resident block */
+	virtual void hit(uint64_t set, uint32_t way, std::vector<c_entry>& row) = 0;
+	/* Block placed in way; prefetched blocks go in at low priority */
+	virtual void fill(uint64_t set, uint32_t way, std::vector<c_entry>& row,
+			uint64_t address, bool prefetch) = 0;
+	/* Way to replace in a full set, one of the allowed ones (bit per way); the
+	 * block is gone once this returns */
+	virtual uint32_t victim(uint64_t set, std::vector<c_entry>& row, uint64_t allowed) = 0;
+};
+
+/* Any way may go; also covers sets of more than 64 ways, which cannot be partitioned */
+#define REPL_ALL_WAYS (~(uint64_t) 0)
+
+/* NULL if spec names no policy */
+repl_policy* repl_create(const char* spec, uint64_t sets, uint32_t ways);
+
+#endif /* CACHESIM_REPL_HPP */
@@ -0,0 +1,364 @@
+#include "cachesim_trace.hpp"
+#include <assert.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct trace_file {
+	/*Input image, either mapped or read from a pipe*/
+	const unsigned char* buf;
+	size_t len;
+	bool mapped;
+	bool binary;
+	bool v1; /*Binary without a flags word, so without time stamps*/
+	uint64_t records; /*Binary only, from the header*/
+	uint64_t flags; /*Binary only, from the header*/
+
+	/*Decode position, owned by the helper thread*/
+	size_t decode_pos;
+	uint64_t decode_prev;
+	uint64_t decode_prev_time;
+	uint64_t decode_done;
+
+	/*Batches handed from the helper to the simulator, used in ring order*/
+	trace_access* batch_buf[TRACE_BATCHES];
+	size_t batch_count[TRACE_BATCHES];
+	bool batch_full[TRACE_BATCHES];
+	int batch_head; /*Next batch the simulator takes*/
+	bool batch_held; /*Simulator still holds the batch before batch_head*/
+	pthread_t decode_thread;
+	pthread_mutex_t batch_lock;
+	pthread_cond_t batch_cond;
+};
+
+static inline int hex_digit(unsigned char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static inline uint64_t zigzag(uint64_t delta) {
+	return (delta << 1) ^ (uint64_t) ((int64_t) delta >> 63);
+}
+
+static inline uint64_t unzigzag(uint64_t v) {
+	return (v >> 1) ^ -(v & 1);
+}
+
+static inline bool is_space(unsigned char c) {
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/*Same records the old fscanf("%c %llx\n") loop accepted, plus an optional
+ * decimal time stamp after the address on the same line*/
+static size_t decode_text(trace_file* t, trace_access* out, size_t max) {
+	const unsigned char* p = t->buf;
+	size_t pos = t->decode_pos;
+	size_t len = t->len;
+	size_t n = 0;
+
+	while (n < max && pos < len) {
+		char rw = p[pos++];
+		uint64_t address = 0;
+		uint64_t time = t->decode_done + n;
+		int digits = 0;
+		int d;
+
+		while (pos < len && is_space(p[pos]))
+			pos++;
+		if (pos + 1 < len && p[pos] == '0' && (p[pos + 1] == 'x' || p[pos + 1] == 'X'))
+			pos += 2;
+		while (pos < len && (d = hex_digit(p[pos])) >= 0) {
+			address = (address << 4) | d;
+			digits++;
+			pos++;
+		}
+		while (pos < len && (p[pos] == ' ' || p[pos] == '\t'))
+			pos++;
+		if (pos < len && p[pos] >= '0' && p[pos] <= '9') {
+			time = 0;
+			while (pos < len && p[pos] >= '0' && p[pos] <= '9')
+				time = time * 10 + (p[pos++] - '0');
+		}
+		while (pos < len && is_space(p[pos]))
+			pos++;
+		if (!digits)
+			continue;
+		out[n].rw = rw;
+		out[n].address = address;
+		out[n].time = time;
+		n++;
+	}
+	t->decode_pos = pos;
+	t->decode_done += n;
+	return n;
+}
+
+static size_t decode_binary(trace_file* t, trace_access* out, size_t max) {
+	const unsigned char* p = t->buf;
+	size_t pos = t->decode_pos;
+	uint64_t prev = t->decode_prev;
+	uint64_t prev_time = t->decode_prev_time;
+	size_t n = 0;
+
+	if (max > t->records - t->decode_done)
+		max = t->records - t->decode_done;
+	while (n < max) {
+		unsigned char byte;
+		uint64_t v;
+		int shift = 6;
+
+		if (pos >= t->len) {
+			fprintf(stderr, "Truncated binary trace after %" PRIu64 " accesses\n", t->decode_done + n);
+			exit(1);
+		}
+		byte = p[pos++];
+		out[n].rw = (byte & 1) ? WRITE : READ;
+		v = (byte >> 1) & 0x3f;
+		while ((byte & 0x80) && pos < t->len) {
+			byte = p[pos++];
+			v |= (uint64_t) (byte & 0x7f) << shift;
+			shift += 7;
+		}
+		prev += unzigzag(v);
+		out[n].address = prev;
+		out[n].time = t->decode_done + n;
+		if (t->flags & TRACE_TIME) {
+			v = 0;
+			shift = 0;
+			do {
+				if (pos >= t->len) {
+					fprintf(stderr, "Truncated binary trace after %" PRIu64 " accesses\n", t->decode_done + n);
+					exit(1);
+				}
+				byte = p[pos++];
+				v |= (uint64_t) (byte & 0x7f) << shift;
+				shift += 7;
+			} while (byte & 0x80);
+			prev_time += unzigzag(v);
+			out[n].time = prev_time;
+		}
+		n++;
+	}
+	t->decode_pos = pos;
+	t->decode_prev = prev;
+	t->decode_prev_time = prev_time;
+	t->decode_done += n;
+	return n;
+}
+
+static void* decode_main(void* arg) {
+	trace_file* t = (trace_file*) arg;
+	int slot = 0;
+	size_t n;
+
+	do {
+		pthread_mutex_lock(&t->batch_lock);
+		while (t->batch_full[slot])
+			pthread_cond_wait(&t->batch_cond, &t->batch_lock);
+		pthread_mutex_unlock(&t->batch_lock);
+
+		n = t->binary ? decode_binary(t, t->batch_buf[slot], TRACE_BATCH)
+				: decode_text(t, t->batch_buf[slot], TRACE_BATCH);
+
+		pthread_mutex_lock(&t->batch_lock);
+		t->batch_count[slot] = n;
+		t->batch_full[slot] = 1;
+		pthread_cond_broadcast(&t->batch_cond);
+		pthread_mutex_unlock(&t->batch_lock);
+		slot = (slot + 1) % TRACE_BATCHES;
+	} while (n);
+	return NULL;
+}
+
+/*Pipes cannot be mapped; read them to the end*/
+static void read_stream(trace_file* t, FILE* fin) {
+	size_t cap = 1 << 20;
+	unsigned char* buf = (unsigned char*) malloc(cap);
+	size_t len = 0;
+	size_t got;
+
+	while ((got = fread(buf + len, 1, cap - len, fin)) > 0) {
+		len += got;
+		if (len == cap) {
+			cap *= 2;
+			buf = (unsigned char*) realloc(buf, cap);
+		}
+	}
+	t->buf = buf;
+	t->len = len;
+	t->mapped = 0;
+}
+
+trace_file* trace_open(FILE* fin) {
+	trace_file* t = new trace_file();
+	struct stat st;
+	int fd;
+
+	assert(fin);
+	fd = fileno(fin);
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) {
+			perror("mmap");
+			exit(1);
+		}
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+		madvise(map, st.st_size, MADV_WILLNEED);
+		t->buf = (const unsigned char*) map;
+		t->len = st.st_size;
+		t->mapped = 1;
+	} else {
+		read_stream(t, fin);
+	}
+
+	if (t->len >= TRACE_MAGIC_LEN + 2 * sizeof(uint64_t) && !memcmp(t->buf, TRACE_MAGIC, TRACE_MAGIC_LEN)) {
+		t->binary = 1;
+		memcpy(&t->records, t->buf + TRACE_MAGIC_LEN, sizeof(uint64_t));
+		memcpy(&t->flags, t->buf + TRACE_MAGIC_LEN + sizeof(uint64_t), sizeof(uint64_t));
+		t->decode_pos = TRACE_MAGIC_LEN + 2 * sizeof(uint64_t);
+	} else if (t->len >= TRACE_MAGIC_LEN + sizeof(uint64_t) && !memcmp(t->buf, TRACE_MAGIC_V1, TRACE_MAGIC_LEN)) {
+		t->binary = t->v1 = 1;
+		memcpy(&t->records, t->buf + TRACE_MAGIC_LEN, sizeof(uint64_t));
+		t->decode_pos = TRACE_MAGIC_LEN + sizeof(uint64_t);
+	}
+
+	for (int i = 0; i < TRACE_BATCHES; i++)
+		t->batch_buf[i] = (trace_access*) malloc(sizeof(trace_access) * TRACE_BATCH);
+	pthread_mutex_init(&t->batch_lock, NULL);
+	pthread_cond_init(&t->batch_cond, NULL);
+	pthread_create(&t->decode_thread, NULL, decode_main, t);
+	return t;
+}
+
+size_t trace_next(trace_file* t, trace_access** batch) {
+	size_t n;
+
+	pthread_mutex_lock(&t->batch_lock);
+	if (t->batch_held) {
+		/*Hand the previous batch back to the helper*/
+		t->batch_full[(t->batch_head + TRACE_BATCHES - 1) % TRACE_BATCHES] = 0;
+		t->batch_held = 0;
+		pthread_cond_broadcast(&t->batch_cond);
+	}
+	while (!t->batch_full[t->batch_head])
+		pthread_cond_wait(&t->batch_cond, &t->batch_lock);
+	n = t->batch_count[t->batch_head];
+	*batch = t->batch_buf[t->batch_head];
+	if (n) {
+		t->batch_head = (t->batch_head + 1) % TRACE_BATCHES;
+		t->batch_held = 1;
+	}
+	pthread_mutex_unlock(&t->batch_lock);
+	return n;
+}
+
+void trace_close(trace_file* t) {
+	pthread_join(t->decode_thread, NULL);
+	for (int i = 0; i < TRACE_BATCHES; i++)
+		free(t->batch_buf[i]);
+	if (t->mapped)
+		munmap((void*) t->buf, t->len);
+	else
+		free((void*) t->buf);
+	pthread_mutex_destroy(&t->batch_lock);
+	pthread_cond_destroy(&t->batch_cond);
+	delete t;
+}
+
+bool trace_has_time(trace_file* t) {
+	return !t->v1;
+}
+
+/*Whether any access in the batch, the first at position first, has a time stamp other than its position*/
+static bool batch_has_time(const trace_access* batch, size_t n, uint64_t first) {
+	for (size_t i = 0; i < n; i++)
+		if (batch[i].time != first + i)
+			return 1;
+	return 0;
+}
+
+/*Time stamps are kept if the first batch has any; one turning up later cannot be, and is an error*/
+static void check_time(const trace_access* batch, size_t n, uint64_t first, bool timed) {
+	if (!timed && batch_has_time(batch, n, first)) {
+		fprintf(stderr, "Time stamps start after the first %" PRIu64 " accesses; they would be lost\n", first);
+		exit(1);
+	}
+}
+
+uint64_t trace_write_binary(trace_file* t, FILE* out) {
+	trace_access* batch;
+	uint64_t records = 0;
+	uint64_t prev = 0;
+	uint64_t prev_time = 0;
+	uint64_t flags = 0;
+	size_t n = trace_next(t, &batch);
+
+	if (batch_has_time(batch, n, 0))
+		flags |= TRACE_TIME;
+	/*The count is patched in once the whole trace has been written*/
+	fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_LEN, out);
+	fwrite(&records, sizeof(records), 1, out);
+	fwrite(&flags, sizeof(flags), 1, out);
+	for (; n > 0; n = trace_next(t, &batch)) {
+		check_time(batch, n, records, flags & TRACE_TIME);
+		for (size_t i = 0; i < n; i++) {
+			uint64_t v = zigzag(batch[i].address - prev);
+			unsigned char byte;
+
+			if (batch[i].rw != READ && batch[i].rw != WRITE) {
+				fprintf(stderr, "Access %" PRIu64 " is neither a read nor a write\n", records + i);
+				exit(1);
+			}
+			byte = (batch[i].rw == WRITE) | ((v & 0x3f) << 1);
+			v >>= 6;
+			while (v) {
+				fputc(byte | 0x80, out);
+				byte = v & 0x7f;
+				v >>= 7;
+			}
+			fputc(byte, out);
+			prev = batch[i].address;
+			if (flags & TRACE_TIME) {
+				v = zigzag(batch[i].time - prev_time);
+				while (v >= 0x80) {
+					fputc((v & 0x7f) | 0x80, out);
+					v >>= 7;
+				}
+				fputc(v, out);
+				prev_time = batch[i].time;
+			}
+		}
+		records += n;
+	}
+	fseek(out, TRACE_MAGIC_LEN, SEEK_SET);
+	fwrite(&records, sizeof(records), 1, out);
+	return records;
+}
+
+uint64_t trace_write_text(trace_file* t, FILE* out) {
+	trace_access* batch;
+	uint64_t records = 0;
+	size_t n = trace_next(t, &batch);
+	bool timed = batch_has_time(batch, n, 0);
+
+	for (; n > 0; n = trace_next(t, &batch)) {
+		check_time(batch, n, records, timed);
+		for (size_t i = 0; i < n; i++) {
+			if (timed)
+				fprintf(out, "%c %" PRIx64 " %" PRIu64 "\n", batch[i].rw, batch[i].address, batch[i].time);
+			else
+				fprintf(out, "%c %" PRIx64 "\n", batch[i].rw, batch[i].address);
+		}
+		records += n;
+	}
+	return records;
+}
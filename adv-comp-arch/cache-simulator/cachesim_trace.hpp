@@ -0,0 +1,50 @@
+#ifndef CACHESIM_TRACE_HPP
+#define CACHESIM_TRACE_HPP
+#include <stdio.h>
+#include "cachesim.hpp"
+
+/*
+ * Trace input. The trace file is mapped and a helper thread decodes it into
+ * batches of accesses ahead of the simulator. Text traces ("r 7fffe1b0",
+ * optionally followed by a decimal time stamp) and packed binary traces are
+ * both accepted; the format is picked from the first bytes of the file.
+ * Several traces may be open at once, each with its own helper.
+ *
+ * Binary layout: the TRACE_MAGIC string, the number of accesses and a flags
+ * word, both uint64_t, then one record per access. A record is the zig-zag
+ * encoded delta from the previous address, v, stored as a varint whose first
+ * byte holds the r/w bit in bit 0 and the low 6 bits of v in bits 1-6; the
+ * following bytes hold 7 bits of v each. Bit 7 is the continuation bit. With
+ * TRACE_TIME set, each record goes on with the zig-zag encoded delta from the
+ * previous time stamp as a plain varint of 7 bits per byte. Traces written
+ * with TRACE_MAGIC_V1 have no flags word and no time stamps.
+ */
+#define TRACE_MAGIC		"CSIMBTR2"
+#define TRACE_MAGIC_V1	"CSIMBTR1"
+#define TRACE_MAGIC_LEN	8
+#define TRACE_TIME		1		/* flags: records carry time stamps */
+#define TRACE_BATCH		16384	/* accesses per decoded batch */
+#define TRACE_BATCHES	4		/* batches the helper may run ahead */
+
+struct trace_access {
+	uint64_t address;
+	uint64_t time;	/* from the trace, else the access's position in it */
+	char rw;
+};
+
+struct trace_file;
+
+/* Map fin and start decoding. fin may be a pipe, in which case it is read into memory first */
+trace_file* trace_open(FILE* fin);
+/* Next batch of decoded accesses; returns 0 at the end of the trace. The batch is valid until the next call */
+size_t trace_next(trace_file* t, trace_access** batch);
+void trace_close(trace_file* t);
+/* False for a binary trace written before time stamps were kept: its times are only positions */
+bool trace_has_time(trace_file* t);
+
+/* Converters: write the open trace to out and return the number of accesses. Time stamps are kept
+ * when the first batch of the trace has any */
+uint64_t trace_write_binary(trace_file* t, FILE* out);
+uint64_t trace_write_text(trace_file* t, FILE* out);
+
+#endif /* CACHESIM_TRACE_HPP */
@@ -1,25 +1,30 @@
 #include "procsim.hpp"
+#include "procsim_timeline.hpp"
 #include <iostream>
 #include <cstring>
+#include <cmath>
 
 #define nFU_TYPE	3
 #define nREGS		32
+#define nSTAGES		3	/*Depth of the deepest FU pipeline*/
 //#define DEBUG
-#define OUTPUT
 
 #ifdef DEBUG
 #define	print_dbg(fmt, arg...)  printf(fmt, ## arg);
 #else
 #define	print_dbg(fmt, arg...)
 #endif
-#ifdef OUTPUT
-#define	print_out(fmt, arg...) 	printf(fmt, ## arg);
-#else
-#define	print_out(fmt, arg...)
-#endif
 
 uint32_t R = 0, F = 0, M = 0, K0 = 0, K1 = 0, K2 = 0 ;
 uint64_t gline = 0, total_cycles = 0;
+uint64_t last_retired = 0;
+
+/*Sampled simulation: one unit of sample_unit instructions measured in every
+ * sample_period units, after sample_warmup instructions of detailed warm-up*/
+uint64_t sample_period = 0, sample_unit = 0, sample_warmup = 0;
+uint64_t sample_units = 0;
+double unit_cycles_sum = 0, unit_cycles_sq = 0;
+bool bDrain = 0;	/*Stop fetching and let the pipeline empty*/
 
 typedef struct rob_ent_st{
 	uint64_t line;
@@ -27,12 +32,6 @@ typedef struct rob_ent_st{
 	bool retire;
 }rob_ent_t;
 
-struct reorder_buffer{
-	uint32_t head;
-	uint32_t tail;
-	uint32_t num_used;
-	rob_ent_t* rob_ent;
-}rob;
 
 typedef struct print_ent_st{
 	uint32_t fetch;
@@ -42,15 +41,10 @@ typedef struct print_ent_st{
 	uint32_t state;
 }print_ent_t;
 
-struct print_buffer{
-	uint32_t size;
-	print_ent_t* print_ent;
-}buf;
-
 struct reg_file_entry{
 	uint64_t tag;
 	bool busy;
-}reg[nREGS];
+};
 
 typedef struct dispatchq_entry{
 	uint64_t line;
@@ -58,17 +52,12 @@ typedef struct dispatchq_entry{
 	int32_t dest_reg;
 	int32_t s1_reg;
 	int32_t s2_reg;
-	bool disp_done;
 	bool stall;
 	bool inROB;
+	char mem_rw;
+	uint64_t mem_address;
 }dispq_entry_t;
 
-/*Global*/
-struct dispatch_q{
-	uint32_t num_used;
-	dispq_entry_t* disp_ent;
-}dispq;
-
 typedef struct scheduler_entry{
 	uint64_t line;
 	int32_t dest_reg;
@@ -83,13 +72,6 @@ typedef struct scheduler_entry{
 	bool busy;
 }sch_entry_t;
 
-struct sched_queue_t{
-	uint32_t num_used;
-	uint32_t tail;
-	uint32_t size;
-	sch_entry_t* sched_ent;
-}sched_q[nFU_TYPE];
-
 typedef struct fu_pipeline{
 	uint64_t line;
 	int32_t dest_reg;	/*For CDB broadcast*/
@@ -98,27 +80,152 @@ typedef struct fu_pipeline{
 }fu_stages_t;
 
 typedef struct fu_entry{
-	fu_stages_t* fu_stg;
+	fu_stages_t fu_stg[nSTAGES];	/*FU type i uses the first i+1*/
 }fu_entry_t;
 
-struct function_unit{
-	uint32_t num_used;
-	uint32_t size;
-	fu_entry_t* fu_ent;
-}fu[nFU_TYPE];
+/*Loads and stores in program order, from dispatch to retirement. Loads go
+ * here once their FU has the address, leaving the scheduler free, and
+ * broadcast when the data is back*/
+typedef struct lsq_entry{
+	uint64_t line;
+	uint64_t address;
+	uint64_t ready_cycle;	/*Data back; 0 until the load is issued*/
+	uint64_t done_cycle;	/*Result broadcast*/
+	int32_t dest_reg;
+	uint32_t dest_tag;
+	char rw;
+	bool addr_known;
+	bool done;
+}lsq_entry_t;
+
+bool bMem = 0;	/*Memory model on; otherwise loads and stores are like any other op*/
 
 volatile bool bEOF = 0;
-void dispatch_first_half();
-void dispatch_second_half();
-void schedule_first_half();
-void schedule_second_half();
-void execute();
-void stateupdate_first_half();
-void stateupdate_second_half(proc_stats_t* p_stats);
-void add_to_rob(uint64_t line);
-void mark_for_del(uint64_t line);
-void delete_from_rob(proc_stats_t* p_stats);
-void fetch();
+
+/*Sizes a core is compiled for; 0 leaves that one to the runtime value*/
+template<uint32_t r, uint32_t f, uint32_t m, uint32_t k0, uint32_t k1, uint32_t k2>
+struct core_config{
+	enum { R = r, F = f, M = m, K0 = k0, K1 = k1, K2 = k2 };
+};
+typedef core_config<0, 0, 0, 0, 0, 0> generic_config;
+
+/*Configurations with a core of their own, first match wins; R, F, M, K0, K1, K2,
+ * 0 matching anything. The rest run on generic_config*/
+#define CORE_CONFIGS \
+	CORE_CONFIG(DEFAULT_R, DEFAULT_F, DEFAULT_M, DEFAULT_K0, DEFAULT_K1, DEFAULT_K2) \
+	CORE_CONFIG(8, 4, 2, 1, 2, 3)	/*make run*/
+
+/*n entries, in place when the configuration fixes n and calloc'd when it does not*/
+template<class T, uint32_t N>
+struct slots{
+	T ent[N];
+	void alloc(uint32_t) { memset(ent, 0, sizeof(ent)); }
+	void release() {}
+	T& operator[](uint32_t i) { return ent[i]; }
+};
+template<class T>
+struct slots<T, 0>{
+	T* ent;
+	void alloc(uint32_t n) { ent = (T*)calloc(n, sizeof(T)); }
+	void release() { free(ent); }
+	T& operator[](uint32_t i) { return ent[i]; }
+};
+
+class core_base{
+public:
+	virtual ~core_base() {}
+	virtual void run(proc_stats_t* p_stats) = 0;
+};
+core_base* core = NULL;
+
+/*
+ * The pipeline for one configuration. Sizes the configuration fixes are
+ * compile-time constants, so its arrays live in place and the loops over
+ * them have constant bounds; the per-FU-type loops are unrolled through
+ * templates. When the scheduling queues are fixed and fit in 64 entries,
+ * schedule_second_half() picks ready entries from a bitmask kept up to date
+ * as sources and issue state change, instead of scanning the queue.
+ */
+template<class C>
+class Core: public core_base{
+	enum { KMAX = (C::K0 != 0 && C::K1 != 0 && C::K2 != 0) ? (C::K0 > C::K1 ? (C::K0 > C::K2 ? C::K0 : C::K2) : (C::K1 > C::K2 ? C::K1 : C::K2)) : 0 };
+	enum { MASKS = C::M != 0 && KMAX != 0 && KMAX * C::M <= 64 };
+
+	struct reorder_buffer{
+		uint32_t head;
+		uint32_t tail;
+		uint32_t num_used;
+		slots<rob_ent_t, C::R> rob_ent;
+	}rob;
+	struct print_buffer{
+		slots<print_ent_t, 2 * C::R> print_ent;
+	}buf;
+	reg_file_entry reg[nREGS];
+	struct dispatch_q{
+		uint32_t num_used;
+		slots<dispq_entry_t, C::R> disp_ent;
+	}dispq;
+	struct sched_queue_t{
+		uint32_t num_used;
+		uint32_t tail;
+		uint64_t ready;	/*Entries not issued with both sources ready, MASKS only*/
+		slots<sch_entry_t, KMAX * C::M> sched_ent;
+	}sched_q[nFU_TYPE];
+	struct function_unit{
+		uint32_t num_used;
+		slots<fu_entry_t, KMAX> fu_ent;
+	}fu[nFU_TYPE];
+	struct load_store_queue{
+		uint32_t head;
+		uint32_t tail;
+		uint32_t num_used;
+		slots<lsq_entry_t, C::R> lsq_ent;
+	}lsq;
+
+	static uint32_t rob_size() { return C::R != 0 ? C::R : R; }
+	static uint32_t fetch_width() { return C::F != 0 ? C::F : F; }
+	static uint32_t fu_size(uint32_t i) {
+		return i == 0 ? (C::K0 != 0 ? C::K0 : K0) : i == 1 ? (C::K1 != 0 ? C::K1 : K1) : (C::K2 != 0 ? C::K2 : K2);
+	}
+	static uint32_t sched_size(uint32_t i) { return fu_size(i) * (C::M != 0 ? C::M : M); }
+	static uint32_t buf_size() { return 2 * rob_size(); }/*At any point, no more than 2*R instructions need to be traced.*/
+	/*Ring steps for the ROB and the LSQ; a compare is cheaper than % when R is only known at run time*/
+	static uint32_t rob_next(uint32_t i) { return i + 1 < rob_size() ? i + 1 : 0; }
+	static uint32_t rob_prev(uint32_t i) { return (i ? i : rob_size()) - 1; }
+	void update_ready(uint32_t i, uint32_t j) {
+		sch_entry_t* e = &sched_q[i].sched_ent[j];
+
+		if (!e->busy && !e->s1_busy && !e->s2_busy)
+			sched_q[i].ready |= (uint64_t)1 << j;
+		else
+			sched_q[i].ready &= ~((uint64_t)1 << j);
+	}
+
+	void dispatch_first_half();
+	void dispatch_second_half();
+	void schedule_first_half();
+	template<uint32_t i> void schedule_first_half_fu();
+	void schedule_second_half();
+	template<uint32_t i> void schedule_second_half_fu();
+	void execute();
+	template<uint32_t i> void execute_fu();
+	void stateupdate_first_half();
+	void stateupdate_second_half(proc_stats_t* p_stats);
+	void add_to_rob(uint64_t line);
+	void mark_for_del(uint64_t line);
+	void delete_from_rob(proc_stats_t* p_stats);
+	void fetch();
+	void memory(proc_stats_t* p_stats);
+	void issue_load(uint32_t idx, proc_stats_t* p_stats);
+	bool lsq_addr_ready(uint64_t line);
+	void fast_forward(uint64_t n, proc_stats_t* p_stats);
+	void run_sampled(proc_stats_t* p_stats);
+	inline void cycle(proc_stats_t* p_stats);
+public:
+	Core();
+	~Core();
+	void run(proc_stats_t* p_stats);
+};
 /**
  * Subroutine for initializing the processor. You many add and initialize any global or heap
  * variables as needed.
@@ -139,30 +246,46 @@ void setup_proc(uint64_t r, uint64_t k0, uint64_t k1, uint64_t k2, uint64_t f, u
 	K2 = k2;
 	F = f;
 
-	dispq.disp_ent = (dispq_entry_t*)calloc(1, sizeof(dispq_entry_t)*R);/*Dispatch Queue allocate*/
-	rob.rob_ent = (rob_ent_t*)calloc(1, sizeof(rob_ent_t)*R);/*ROB allocate*/
+#define CORE_CONFIG(r, f, m, k0, k1, k2) \
+	if ((!r || R == r) && (!f || F == f) && (!m || M == m) && (!k0 || K0 == k0) && (!k1 || K1 == k1) && (!k2 || K2 == k2)) \
+		core = new Core<core_config<r, f, m, k0, k1, k2> >(); \
+	else
+	CORE_CONFIGS
+		core = new Core<generic_config>();
+#undef CORE_CONFIG
+	timeline_begin();
+}
+template<class C>
+Core<C>::Core()
+{
+	memset(reg, 0, sizeof(reg));
+	dispq.disp_ent.alloc(rob_size());/*Dispatch Queue allocate*/
+	rob.rob_ent.alloc(rob_size());/*ROB allocate*/
 	dispq.num_used = rob.num_used = rob.head = rob.tail = 0;
-	buf.size = R*2;/*Print buffer size. At any point, no more than 2*R instructions need to be traced.*/
-	buf.print_ent = (print_ent_t*)calloc(1, sizeof(print_ent_t)*buf.size);
-	sched_q[0].sched_ent = (sch_entry_t*)calloc(1, sizeof(sch_entry_t)*K0*M);/*Schedule Queue allocate*/
-	sched_q[0].size = K0*M;
-	sched_q[1].sched_ent = (sch_entry_t*)calloc(1, sizeof(sch_entry_t)*K1*M);
-	sched_q[1].size = K1*M;
-	sched_q[2].sched_ent = (sch_entry_t*)calloc(1, sizeof(sch_entry_t)*K2*M);
-	sched_q[2].size = K2*M;
-	fu[0].fu_ent = (fu_entry_t*)calloc(1, sizeof(fu_entry_t)*K0);/*FU allocate*/
-	fu[0].size = K0;
-	fu[1].fu_ent = (fu_entry_t*)calloc(1, sizeof(fu_entry_t)*K1);
-	fu[1].size = K1;
-	fu[2].fu_ent = (fu_entry_t*)calloc(1, sizeof(fu_entry_t)*K2);
-	fu[2].size = K2;
-	for (uint32_t i = 0; i < K0; i++)
-		fu[0].fu_ent[i].fu_stg = (fu_stages_t*)calloc(1, sizeof(fu_stages_t)*1);
-	for (uint32_t i = 0; i < K1; i++)
-		fu[1].fu_ent[i].fu_stg = (fu_stages_t*)calloc(1, sizeof(fu_stages_t)*2);
-	for (uint32_t i = 0; i < K2; i++)
-		fu[2].fu_ent[i].fu_stg = (fu_stages_t*)calloc(1, sizeof(fu_stages_t)*3);
-	print_out("INST\tFETCH\tDISP\tSCHED\tEXEC\tSTATE\tRETIRE");
+	buf.print_ent.alloc(buf_size());
+	for (uint32_t i = 0; i < nFU_TYPE; i++)
+	{
+		sched_q[i].sched_ent.alloc(sched_size(i));/*Schedule Queue allocate*/
+		sched_q[i].num_used = sched_q[i].tail = 0;
+		sched_q[i].ready = 0;
+		fu[i].fu_ent.alloc(fu_size(i));/*FU allocate*/
+		fu[i].num_used = 0;
+	}
+	lsq.lsq_ent.alloc(rob_size());/*Every load and store is in the ROB too*/
+	lsq.num_used = lsq.head = lsq.tail = 0;
+}
+template<class C>
+Core<C>::~Core()
+{
+	rob.rob_ent.release();
+	buf.print_ent.release();
+	dispq.disp_ent.release();
+	for (uint32_t i = 0; i < nFU_TYPE; i++)
+	{
+		sched_q[i].sched_ent.release();
+		fu[i].fu_ent.release();
+	}
+	lsq.lsq_ent.release();
 }
 
 /**
@@ -173,23 +296,142 @@ void setup_proc(uint64_t r, uint64_t k0, uint64_t k1, uint64_t k2, uint64_t f, u
  * @p_stats Pointer to the statistics structure
  *
  */
+template<class C>
+inline void Core<C>::cycle(proc_stats_t* p_stats)
+{
+	total_cycles = ++p_stats->cycle_count;
+	stateupdate_first_half();
+	execute();
+	if (bMem)
+		memory(p_stats);
+	schedule_first_half();
+	dispatch_first_half();
+	dispatch_second_half();
+	fetch();
+	stateupdate_second_half(p_stats);
+	schedule_second_half();
+}
+template<class C>
+void Core<C>::run(proc_stats_t* p_stats)
+{
+	if (sample_period)
+		run_sampled(p_stats);
+	else
+		while (!bEOF || rob.num_used)
+			cycle(p_stats);
+}
 void run_proc(proc_stats_t* p_stats)
 {
-	while (!bEOF || rob.num_used)
+	core->run(p_stats);
+	timeline_end();
+}
+/**
+ * Enables sampled simulation (SMARTS). The trace is cut into units of u instructions
+ * and the last unit of every period units is measured in detail. Everything else is
+ * fast-forwarded, except the w instructions before each measured unit, which are
+ * simulated in detail to refill the pipeline.
+ *
+ * @period Units per sample period; one of them is measured
+ * @u Instructions per unit
+ * @w Detailed warm-up before each measured unit, in instructions
+ */
+void setup_sampling(uint64_t period, uint64_t u, uint64_t w)
+{
+	sample_period = period;
+	sample_unit = u;
+	sample_warmup = w;
+}
+/**
+ * Enables the memory model. Loads and stores of extended traces go through a
+ * load/store queue to the cache, which sets their latency; see procsim_cache.hpp.
+ * A load waits for the addresses of all older stores and takes its data from
+ * the youngest one to the same address if there is one. Stores write the cache
+ * when they retire.
+ *
+ * @c1, @b1, @s1, @c2, @b2, @s2 Cache geometry as in cachesim
+ * @mshrs Outstanding L1 misses
+ */
+void setup_memory(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2, uint64_t b2, uint64_t s2, uint32_t mshrs)
+{
+	bMem = 1;
+	setup_cache(c1, b1, s1, c2, b2, s2, mshrs);
+}
+/*Functional simulation: instructions complete as they are read, so the only
+ * state to keep is the register file, all ready and tagged by the last writer,
+ * and the cache contents*/
+template<class C>
+void Core<C>::fast_forward(uint64_t n, proc_stats_t* p_stats)
+{
+	proc_inst_t instr;
+
+	while (n--)
+	{
+		if (!read_instruction(&instr))
+		{
+			bEOF = 1;
+			break;
+		}
+		++gline;
+		if (instr.dest_reg >= 0)
+		{
+			reg[instr.dest_reg].tag = gline;
+			reg[instr.dest_reg].busy = 0;
+		}
+		if (bMem && instr.mem_rw)
+		{
+			cache_warm(instr.mem_rw, instr.mem_address);
+			if (instr.mem_rw == READ)
+				p_stats->loads++;
+			else
+				p_stats->stores++;
+		}
+		p_stats->retired_instruction++;
+	}
+	last_retired = gline;
+}
+template<class C>
+void Core<C>::run_sampled(proc_stats_t* p_stats)
+{
+	uint64_t period = sample_period * sample_unit;
+
+	for (uint64_t base = 0; !bEOF; base += period)
 	{
-		total_cycles = ++p_stats->cycle_count;
-		stateupdate_first_half();
-		execute();
-		schedule_first_half();
-		dispatch_first_half();
-		dispatch_second_half();
-		fetch();
-		stateupdate_second_half(p_stats);
-		schedule_second_half();
+		uint64_t start = base + period - sample_unit;/*Measure the cycles from the retirement of this line*/
+		uint64_t start_cycle, retired;
+		bool measuring;
+
+		if (gline < start - sample_warmup)
+			fast_forward(start - sample_warmup - gline, p_stats);
+		retired = p_stats->retired_instruction;
+		measuring = (last_retired >= start);
+		start_cycle = total_cycles;
+		bDrain = 0;
+		while (!bEOF || rob.num_used)
+		{
+			cycle(p_stats);
+			if (!measuring && last_retired >= start)
+			{
+				start_cycle = total_cycles;
+				measuring = 1;
+			}
+			if (measuring && last_retired >= start + sample_unit)
+			{
+				double c = total_cycles - start_cycle;
+
+				unit_cycles_sum += c;
+				unit_cycles_sq += c * c;
+				sample_units++;
+				break;
+			}
+		}
+		bDrain = 1;/*Finish what is in flight before fast-forwarding again*/
+		while (rob.num_used || dispq.num_used)
+			cycle(p_stats);
+		p_stats->detailed_instructions += p_stats->retired_instruction - retired;
 	}
-	print_out("\n\n");
 }
-void stateupdate_first_half()
+template<class C>
+void Core<C>::stateupdate_first_half()
 {
 	for (uint32_t i = 0; i < nFU_TYPE; i++)
 	{
@@ -197,90 +439,189 @@ void stateupdate_first_half()
 			if (sched_q[i].sched_ent[j].complete)
 			{
 				print_dbg("\n%lld\tSTATE UPDATE\t%lld", total_cycles, sched_q[i].sched_ent[j].line);
-				buf.print_ent[(sched_q[i].sched_ent[j].line-1)%buf.size].state = total_cycles;
+				buf.print_ent[(sched_q[i].sched_ent[j].line-1)%buf_size()].state = total_cycles;
 				sched_q[i].sched_ent[j].free = 1;
 				sched_q[i].sched_ent[j].complete = 0;
 				mark_for_del(sched_q[i].sched_ent[j].line);
 			}
 	}
+	for (uint32_t i = 0, idx = lsq.head; i < lsq.num_used; i++, idx = rob_next(idx))
+		if (lsq.lsq_ent[idx].done && lsq.lsq_ent[idx].done_cycle == total_cycles - 1)
+		{/*Loads completed in memory(); they left the scheduler long ago*/
+			print_dbg("\n%lld\tSTATE UPDATE\t%lld", total_cycles, lsq.lsq_ent[idx].line);
+			buf.print_ent[(lsq.lsq_ent[idx].line-1)%buf_size()].state = total_cycles;
+			mark_for_del(lsq.lsq_ent[idx].line);
+		}
 }
-void execute()
+template<class C>
+void Core<C>::execute()
 {
-	for (uint32_t i = 0; i < nFU_TYPE; i++)
+	execute_fu<0>();
+	execute_fu<1>();
+	execute_fu<2>();
+}
+template<class C> template<uint32_t i>
+void Core<C>::execute_fu()
+{
+	for (uint32_t j=0; j < fu_size(i); j++)
 	{
-		for (uint32_t j=0; j < fu[i].size; j++)
-		{
-			if (fu[i].fu_ent[j].fu_stg[i].busy)
-			{/*1. Update register file 2. Delete fu entry 3. mark schq as complete*/
-				if (fu[i].fu_ent[j].fu_stg[i].dest_reg >= 0)
-					if (reg[fu[i].fu_ent[j].fu_stg[i].dest_reg].tag == fu[i].fu_ent[j].fu_stg[i].dest_tag)/*Update future file here*/
-						reg[fu[i].fu_ent[j].fu_stg[i].dest_reg].busy = 0;
-				for (uint32_t p =0; p < nFU_TYPE; p++)
+		if (fu[i].fu_ent[j].fu_stg[i].busy && bMem && lsq_addr_ready(fu[i].fu_ent[j].fu_stg[i].line))
+		{/*A load with its address: free the scheduler entry, memory() does the rest*/
+			for (uint32_t p =0; p < nFU_TYPE; p++)
+				for (uint32_t k =0; k < sched_q[p].num_used; k++)
+					if (sched_q[p].sched_ent[k].line == fu[i].fu_ent[j].fu_stg[i].line)
+						sched_q[p].sched_ent[k].free = 1;
+			memset(&fu[i].fu_ent[j].fu_stg[i], 0, sizeof(fu_stages_t));/*Set to zero*/
+		}
+		else if (fu[i].fu_ent[j].fu_stg[i].busy)
+		{/*1. Update register file 2. Delete fu entry 3. mark schq as complete*/
+			if (fu[i].fu_ent[j].fu_stg[i].dest_reg >= 0)
+				if (reg[fu[i].fu_ent[j].fu_stg[i].dest_reg].tag == fu[i].fu_ent[j].fu_stg[i].dest_tag)/*Update future file here*/
+					reg[fu[i].fu_ent[j].fu_stg[i].dest_reg].busy = 0;
+			for (uint32_t p =0; p < nFU_TYPE; p++)
+			{
+				for (uint32_t k =0; k < sched_q[p].num_used; k++)
 				{
-					for (uint32_t k =0; k < sched_q[p].num_used; k++)
-					{
-						if (sched_q[p].sched_ent[k].line == fu[i].fu_ent[j].fu_stg[i].line)
-							sched_q[p].sched_ent[k].complete = 1;
-						if (sched_q[p].sched_ent[k].s1_tag == fu[i].fu_ent[j].fu_stg[i].dest_tag)
-							sched_q[p].sched_ent[k].s1_busy = 0;
-						if (sched_q[p].sched_ent[k].s2_tag == fu[i].fu_ent[j].fu_stg[i].dest_tag)
-							sched_q[p].sched_ent[k].s2_busy = 0;
-					}
+					if (sched_q[p].sched_ent[k].line == fu[i].fu_ent[j].fu_stg[i].line)
+						sched_q[p].sched_ent[k].complete = 1;
+					if (sched_q[p].sched_ent[k].s1_tag == fu[i].fu_ent[j].fu_stg[i].dest_tag)
+						sched_q[p].sched_ent[k].s1_busy = 0;
+					if (sched_q[p].sched_ent[k].s2_tag == fu[i].fu_ent[j].fu_stg[i].dest_tag)
+						sched_q[p].sched_ent[k].s2_busy = 0;
+					if (MASKS && (sched_q[p].sched_ent[k].s1_tag == fu[i].fu_ent[j].fu_stg[i].dest_tag || sched_q[p].sched_ent[k].s2_tag == fu[i].fu_ent[j].fu_stg[i].dest_tag))
+						update_ready(p, k);/*A broadcast only wakes sources, so only these entries can become ready*/
 				}
-				memset(&fu[i].fu_ent[j].fu_stg[i], 0, sizeof(fu_stages_t));/*Set to zero*/
-			}/*Move instructions to next stage*/
-			if ((i == 2) && (fu[i].fu_ent[j].fu_stg[1].busy))
-			{
-				fu[i].fu_ent[j].fu_stg[2] = fu[i].fu_ent[j].fu_stg[1];
-				memset(&fu[i].fu_ent[j].fu_stg[1], 0, sizeof(fu_stages_t));/*Set to zero*/
 			}
-			if (fu[i].fu_ent[j].fu_stg[0].busy)/*Move to next stage*/
-			{/*Make this generic*/
-				fu[i].fu_ent[j].fu_stg[1] = fu[i].fu_ent[j].fu_stg[0];
-				memset(&fu[i].fu_ent[j].fu_stg[0], 0, sizeof(fu_stages_t));/*Set to zero*/
-			}
-
+			memset(&fu[i].fu_ent[j].fu_stg[i], 0, sizeof(fu_stages_t));/*Set to zero*/
+		}/*Move instructions to next stage*/
+		if ((i == 2) && (fu[i].fu_ent[j].fu_stg[1].busy))
+		{
+			fu[i].fu_ent[j].fu_stg[2] = fu[i].fu_ent[j].fu_stg[1];
+			memset(&fu[i].fu_ent[j].fu_stg[1], 0, sizeof(fu_stages_t));/*Set to zero*/
+		}
+		if (fu[i].fu_ent[j].fu_stg[0].busy)/*Move to next stage*/
+		{/*Make this generic*/
+			fu[i].fu_ent[j].fu_stg[1] = fu[i].fu_ent[j].fu_stg[0];
+			memset(&fu[i].fu_ent[j].fu_stg[0], 0, sizeof(fu_stages_t));/*Set to zero*/
 		}
+
 	}
 }
 
-void schedule_first_half()
+/*Marks the address of a load or store known; true for a load, which still has to get its data*/
+template<class C>
+bool Core<C>::lsq_addr_ready(uint64_t line)
 {
-	for (uint32_t i = 0; i < nFU_TYPE; i++)
+	for (uint32_t i = 0, idx = lsq.head; i < lsq.num_used; i++, idx = rob_next(idx))
+		if (lsq.lsq_ent[idx].line == line)
+		{
+			lsq.lsq_ent[idx].addr_known = 1;
+			return lsq.lsq_ent[idx].rw == READ;
+		}
+	return 0;
+}
+template<class C>
+void Core<C>::issue_load(uint32_t idx, proc_stats_t* p_stats)
+{
+	lsq_entry_t* ld = &lsq.lsq_ent[idx];
+
+	for (uint32_t j = idx; j != lsq.head; )
+	{/*Youngest older store to the same address forwards its data*/
+		j = rob_prev(j);
+		if (lsq.lsq_ent[j].rw == WRITE && lsq.lsq_ent[j].address == ld->address)
+		{
+			ld->ready_cycle = total_cycles + 1;
+			p_stats->forwarded_loads++;
+			return;
+		}
+	}
+	ld->ready_cycle = cache_access(READ, ld->address, total_cycles, &p_stats->cache);/*0 to try again*/
+}
+/*Issue loads whose address and older store addresses are known, and broadcast the ones with data*/
+template<class C>
+void Core<C>::memory(proc_stats_t* p_stats)
+{
+	bool store_pending = 0;
+
+	for (uint32_t i = 0, idx = lsq.head; i < lsq.num_used; i++, idx = rob_next(idx))
 	{
-		uint32_t tail = 0;
-		for (uint32_t j = 0; j < sched_q[i].num_used; j++)
+		lsq_entry_t* e = &lsq.lsq_ent[idx];
+
+		if (e->rw == WRITE)
+		{
+			store_pending |= !e->addr_known;
+			continue;
+		}
+		if (e->addr_known && !e->ready_cycle && !store_pending)
+			issue_load(idx, p_stats);
+		if (e->ready_cycle && !e->done && e->ready_cycle <= total_cycles)
 		{
-			if (sched_q[i].sched_ent[j].rdy_to_fire)
-			{/*Adding new entry in FU at the tail*/
-				print_dbg("\n%lld\tSCHEDULED\t%lld", total_cycles, sched_q[i].sched_ent[j].line);
-				buf.print_ent[(sched_q[i].sched_ent[j].line-1)%buf.size].ex = total_cycles+1;
-				fu[i].fu_ent[tail].fu_stg[0].line = sched_q[i].sched_ent[j].line;
-				fu[i].fu_ent[tail].fu_stg[0].dest_reg = sched_q[i].sched_ent[j].dest_reg;
-				if (sched_q[i].sched_ent[j].dest_reg >= 0)
-					fu[i].fu_ent[tail].fu_stg[0].dest_tag = sched_q[i].sched_ent[j].dest_tag;
-				fu[i].fu_ent[tail].fu_stg[0].busy = 1;
-				sched_q[i].sched_ent[j].rdy_to_fire = 0;
-				sched_q[i].sched_ent[j].busy = 1;
-				tail++;
+			print_dbg("\n%lld\tLOAD DATA\t%lld", total_cycles, e->line);
+			if (e->dest_reg >= 0 && reg[e->dest_reg].tag == e->dest_tag)
+				reg[e->dest_reg].busy = 0;
+			for (uint32_t p =0; p < nFU_TYPE; p++)
+			{
+				for (uint32_t k =0; k < sched_q[p].num_used; k++)
+				{
+					if (sched_q[p].sched_ent[k].s1_tag == e->dest_tag)
+						sched_q[p].sched_ent[k].s1_busy = 0;
+					if (sched_q[p].sched_ent[k].s2_tag == e->dest_tag)
+						sched_q[p].sched_ent[k].s2_busy = 0;
+					if (MASKS && (sched_q[p].sched_ent[k].s1_tag == e->dest_tag || sched_q[p].sched_ent[k].s2_tag == e->dest_tag))
+						update_ready(p, k);/*A broadcast only wakes sources, so only these entries can become ready*/
+				}
 			}
+			e->done = 1;
+			e->done_cycle = total_cycles;
 		}
-		fu[i].num_used = 0; /*We can be sure that in the next cycle all FU slots will be free*/
 	}
 }
 
+template<class C>
+void Core<C>::schedule_first_half()
+{
+	schedule_first_half_fu<0>();
+	schedule_first_half_fu<1>();
+	schedule_first_half_fu<2>();
+}
+template<class C> template<uint32_t i>
+void Core<C>::schedule_first_half_fu()
+{
+	uint32_t tail = 0;
+	for (uint32_t j = 0; j < sched_q[i].num_used; j++)
+	{
+		if (sched_q[i].sched_ent[j].rdy_to_fire)
+		{/*Adding new entry in FU at the tail*/
+			print_dbg("\n%lld\tSCHEDULED\t%lld", total_cycles, sched_q[i].sched_ent[j].line);
+			buf.print_ent[(sched_q[i].sched_ent[j].line-1)%buf_size()].ex = total_cycles+1;
+			fu[i].fu_ent[tail].fu_stg[0].line = sched_q[i].sched_ent[j].line;
+			fu[i].fu_ent[tail].fu_stg[0].dest_reg = sched_q[i].sched_ent[j].dest_reg;
+			if (sched_q[i].sched_ent[j].dest_reg >= 0)
+				fu[i].fu_ent[tail].fu_stg[0].dest_tag = sched_q[i].sched_ent[j].dest_tag;
+			fu[i].fu_ent[tail].fu_stg[0].busy = 1;
+			sched_q[i].sched_ent[j].rdy_to_fire = 0;
+			sched_q[i].sched_ent[j].busy = 1;
+			if (MASKS)
+				update_ready(i, j);
+			tail++;
+		}
+	}
+	fu[i].num_used = 0; /*We can be sure that in the next cycle all FU slots will be free*/
+}
 
 
-void dispatch_first_half()
+
+template<class C>
+void Core<C>::dispatch_first_half()
 {
 	uint32_t i = 0, cur_fu = 0;
 
-	if (rob.num_used == R)
+	if (rob.num_used == rob_size())
 	{
 		for (i = 0; i < dispq.num_used; i++) /*Set instructions as stall if there's no space in shedq*/
 		{
 			cur_fu = dispq.disp_ent[i].fu_type;
-			if ((dispq.disp_ent[i].inROB) && sched_q[cur_fu].num_used < sched_q[cur_fu].size)
+			if ((dispq.disp_ent[i].inROB) && sched_q[cur_fu].num_used < sched_size(cur_fu))
 			{
 				dispq.disp_ent[i].stall = 0;
 				sched_q[cur_fu].num_used++;
@@ -299,7 +640,7 @@ void dispatch_first_half()
 	{
 		for (i = 0; i < dispq.num_used; i++) /*Set all active instructions as stall if SchQ is busy*/
 		{
-			if ((rob.num_used) < R)
+			if ((rob.num_used) < rob_size())
 			{
 				if (dispq.disp_ent[i].inROB == 0)
 				{
@@ -307,7 +648,7 @@ void dispatch_first_half()
 					dispq.disp_ent[i].inROB = 1;
 				}
 				cur_fu = dispq.disp_ent[i].fu_type;
-				if (sched_q[cur_fu].num_used == sched_q[cur_fu].size)
+				if (sched_q[cur_fu].num_used == sched_size(cur_fu))
 				{
 					dispq.disp_ent[i].stall = 1;
 					while (++i < dispq.num_used)/*Stall the instructions which cannot fit into the ROB*/
@@ -331,69 +672,67 @@ void dispatch_first_half()
 
 }
 
-void dispatch_second_half()
+template<class C>
+void Core<C>::dispatch_second_half()
 {
 	uint32_t i = 0, cur_fu = 0;
 
-	while (i < dispq.num_used)
-	{	/*Iterate through all elements of dispatch queue.*/
-		if (dispq.disp_ent[i].stall == 0)
-		{  /*Add to schedule Q and ROB*/
-			print_dbg("\n%lld\tDISPATCHED\t%lld", total_cycles, dispq.disp_ent[i].line);
-			buf.print_ent[(dispq.disp_ent[i].line-1)%buf.size].sch = total_cycles+1;
-			cur_fu = dispq.disp_ent[i].fu_type;
-			uint32_t idx = sched_q[cur_fu].tail;
-			sched_q[cur_fu].sched_ent[idx].line = dispq.disp_ent[i].line; //?required??
-			if ((dispq.disp_ent[i].s1_reg >= 0) && reg[dispq.disp_ent[i].s1_reg].busy)
-			{
-				sched_q[cur_fu].sched_ent[idx].s1_tag = reg[dispq.disp_ent[i].s1_reg].tag;
-				sched_q[cur_fu].sched_ent[idx].s1_busy = 1;
-			}
-			else /*This is similar to taking only the register value.*/
-				sched_q[cur_fu].sched_ent[idx].s1_busy = 0;
-			if ((dispq.disp_ent[i].s2_reg >= 0) && reg[dispq.disp_ent[i].s2_reg].busy)
-			{
-				sched_q[cur_fu].sched_ent[idx].s2_tag = reg[dispq.disp_ent[i].s2_reg].tag;
-				sched_q[cur_fu].sched_ent[idx].s2_busy = 1;
-			}
-			else /*This is similar to taking only the register value.*/
-				sched_q[cur_fu].sched_ent[idx].s2_busy = 0;
-			if (dispq.disp_ent[i].dest_reg >= 0)
-			{
-				sched_q[cur_fu].sched_ent[idx].dest_reg = dispq.disp_ent[i].dest_reg;
-				sched_q[cur_fu].sched_ent[idx].dest_tag = dispq.disp_ent[i].line;
-				reg[dispq.disp_ent[i].dest_reg].tag = dispq.disp_ent[i].line;
-				reg[dispq.disp_ent[i].dest_reg].busy = 1;
-			}
-			dispq.disp_ent[i].disp_done = 1;
-			sched_q[cur_fu].tail++;
-			i++;
+	while (i < dispq.num_used && dispq.disp_ent[i].stall == 0)
+	{	/*Add to schedule Q and ROB; dispatch_first_half() stalls everything after the first stall*/
+		print_dbg("\n%lld\tDISPATCHED\t%lld", total_cycles, dispq.disp_ent[i].line);
+		buf.print_ent[(dispq.disp_ent[i].line-1)%buf_size()].sch = total_cycles+1;
+		cur_fu = dispq.disp_ent[i].fu_type;
+		uint32_t idx = sched_q[cur_fu].tail;
+		sched_q[cur_fu].sched_ent[idx].line = dispq.disp_ent[i].line; //?required??
+		if ((dispq.disp_ent[i].s1_reg >= 0) && reg[dispq.disp_ent[i].s1_reg].busy)
+		{
+			sched_q[cur_fu].sched_ent[idx].s1_tag = reg[dispq.disp_ent[i].s1_reg].tag;
+			sched_q[cur_fu].sched_ent[idx].s1_busy = 1;
 		}
-		else
-			i++;
-	}/*Delete dispatch entries*/
-	i = 0;
-	while (i < dispq.num_used)
-	{
-		if (dispq.disp_ent[i].disp_done)
+		else /*This is similar to taking only the register value.*/
+			sched_q[cur_fu].sched_ent[idx].s1_busy = 0;
+		if ((dispq.disp_ent[i].s2_reg >= 0) && reg[dispq.disp_ent[i].s2_reg].busy)
 		{
-			uint32_t j;
-			for (j = i; j < (dispq.num_used-1); j++)/*Shift entries upwards*/
-			{
-				dispq.disp_ent[j] = dispq.disp_ent[j+1];
-			}/*Reset value of last entry since everything has been moved up by one*/
-			memset(&dispq.disp_ent[dispq.num_used-1], 0, sizeof(dispq_entry_t));
-			dispq.num_used--;
+			sched_q[cur_fu].sched_ent[idx].s2_tag = reg[dispq.disp_ent[i].s2_reg].tag;
+			sched_q[cur_fu].sched_ent[idx].s2_busy = 1;
 		}
-		else/*Since we are anyway shifting the entries up, we only need to move to next entry if there is no delete*/
-			i++;
-	}
+		else /*This is similar to taking only the register value.*/
+			sched_q[cur_fu].sched_ent[idx].s2_busy = 0;
+		if (dispq.disp_ent[i].dest_reg >= 0)
+		{
+			sched_q[cur_fu].sched_ent[idx].dest_reg = dispq.disp_ent[i].dest_reg;
+			sched_q[cur_fu].sched_ent[idx].dest_tag = dispq.disp_ent[i].line;
+			reg[dispq.disp_ent[i].dest_reg].tag = dispq.disp_ent[i].line;
+			reg[dispq.disp_ent[i].dest_reg].busy = 1;
+		}
+		if (bMem && dispq.disp_ent[i].mem_rw)
+		{
+			lsq_entry_t* e = &lsq.lsq_ent[lsq.tail];
+
+			memset(e, 0, sizeof(lsq_entry_t));
+			e->line = dispq.disp_ent[i].line;
+			e->address = dispq.disp_ent[i].mem_address;
+			e->rw = dispq.disp_ent[i].mem_rw;
+			e->dest_reg = dispq.disp_ent[i].dest_reg;
+			e->dest_tag = dispq.disp_ent[i].line;
+			lsq.tail = rob_next(lsq.tail);
+			lsq.num_used++;
+		}
+		if (MASKS)
+			update_ready(cur_fu, idx);
+		sched_q[cur_fu].tail++;
+		i++;
+	}/*Delete the i dispatched entries and move the stalled ones up*/
+	memmove(&dispq.disp_ent[0], &dispq.disp_ent[i], (dispq.num_used - i) * sizeof(dispq_entry_t));
+	memset(&dispq.disp_ent[dispq.num_used - i], 0, i * sizeof(dispq_entry_t));/*Reset the entries freed at the end*/
+	dispq.num_used -= i;
 }
 
-void fetch()
+template<class C>
+void Core<C>::fetch()
 {
-	uint32_t fetchWidth = F;
-	while (fetchWidth && (dispq.num_used < R))
+	uint32_t fetchWidth = fetch_width();
+	while (fetchWidth && (dispq.num_used < rob_size()) && !bDrain)
 	{
 		proc_inst_t instr;
 		int ret = read_instruction(&instr);
@@ -402,12 +741,14 @@ void fetch()
 			dispq.disp_ent[dispq.num_used].s1_reg = instr.src_reg[0];
 			dispq.disp_ent[dispq.num_used].s2_reg = instr.src_reg[1];
 			dispq.disp_ent[dispq.num_used].dest_reg = instr.dest_reg;
+			dispq.disp_ent[dispq.num_used].mem_rw = instr.mem_rw;
+			dispq.disp_ent[dispq.num_used].mem_address = instr.mem_address;
 			if (instr.op_code >= 0)	dispq.disp_ent[dispq.num_used].fu_type = instr.op_code;
 			else	dispq.disp_ent[dispq.num_used].fu_type = 0;
 			dispq.disp_ent[dispq.num_used].line = ++gline;
 			print_dbg("\n%lld\tFETCHED\t%lld", total_cycles, gline);
-			buf.print_ent[(gline-1)%buf.size].fetch = total_cycles;
-			buf.print_ent[(gline-1)%buf.size].disp = total_cycles+1;
+			buf.print_ent[(gline-1)%buf_size()].fetch = total_cycles;
+			buf.print_ent[(gline-1)%buf_size()].disp = total_cycles+1;
 			dispq.num_used++;
 			fetchWidth--;
 		}
@@ -419,49 +760,68 @@ void fetch()
 	}
 }
 
-void stateupdate_second_half(proc_stats_t* p_stats)
+template<class C>
+void Core<C>::stateupdate_second_half(proc_stats_t* p_stats)
 {
-	uint32_t j = 0, k = 0;
 	for (uint32_t i = 0; i < nFU_TYPE; i++)
-	{
-		j = 0;
-		while (j < sched_q[i].num_used)
-		{
-			if (sched_q[i].sched_ent[j].free)/*Delete from sched q*/
+	{/*Delete the freed entries from the sched q, moving the rest up in one pass*/
+		uint32_t kept = 0, freed;
+		uint64_t ready = 0;
+
+		for (uint32_t j = 0; j < sched_q[i].num_used; j++)
+			if (!sched_q[i].sched_ent[j].free)
 			{
-				for (k = j; k < (sched_q[i].num_used-1); k++)
-					sched_q[i].sched_ent[k] = sched_q[i].sched_ent[k+1];
-				memset(&sched_q[i].sched_ent[sched_q[i].num_used-1], 0, sizeof(sch_entry_t));
-				sched_q[i].tail--;
-				sched_q[i].num_used--;
+				if (MASKS && (sched_q[i].ready >> j & 1))/*Ready bits move with their entries*/
+					ready |= (uint64_t)1 << kept;
+				sched_q[i].sched_ent[kept++] = sched_q[i].sched_ent[j];
 			}
-			else
-				j++;
-		}
+		freed = sched_q[i].num_used - kept;
+		memset(&sched_q[i].sched_ent[kept], 0, freed * sizeof(sch_entry_t));
+		sched_q[i].ready = ready;
+		sched_q[i].tail -= freed;
+		sched_q[i].num_used = kept;
 	}
 	delete_from_rob(p_stats);
 }
 
-void schedule_second_half()
+template<class C>
+void Core<C>::schedule_second_half()
 {
-	for (uint32_t i = 0; i < nFU_TYPE; i++)
-		for (uint32_t j = 0; j < sched_q[i].num_used; j++)
-			if ((!sched_q[i].sched_ent[j].busy) && (sched_q[i].sched_ent[j].s1_busy == 0) \
-					&& (sched_q[i].sched_ent[j].s2_busy == 0) && (fu[i].num_used < fu[i].size))
-			{/*Set as ready to fire*/
-				sched_q[i].sched_ent[j].rdy_to_fire = 1;
-				fu[i].num_used++;
-			}
+	schedule_second_half_fu<0>();
+	schedule_second_half_fu<1>();
+	schedule_second_half_fu<2>();
+}
+template<class C> template<uint32_t i>
+void Core<C>::schedule_second_half_fu()
+{
+	if (MASKS)
+	{/*Oldest ready entries first, as in the scan below*/
+		for (uint64_t ready = sched_q[i].ready; ready && (fu[i].num_used < fu_size(i)); ready &= ready - 1)
+		{
+			sched_q[i].sched_ent[__builtin_ctzll(ready)].rdy_to_fire = 1;
+			fu[i].num_used++;
+		}
+		return;
+	}
+	for (uint32_t j = 0; j < sched_q[i].num_used; j++)
+		if ((!sched_q[i].sched_ent[j].busy) && (sched_q[i].sched_ent[j].s1_busy == 0) \
+				&& (sched_q[i].sched_ent[j].s2_busy == 0) && (fu[i].num_used < fu_size(i)))
+		{/*Set as ready to fire*/
+			sched_q[i].sched_ent[j].rdy_to_fire = 1;
+			fu[i].num_used++;
+		}
 }
 
-void add_to_rob(uint64_t line)
+template<class C>
+void Core<C>::add_to_rob(uint64_t line)
 {
 	uint32_t tail = rob.tail;
 	rob.rob_ent[tail].line = line;
-	rob.tail = (rob.tail + 1) % R;
+	rob.tail = rob_next(rob.tail);
 	rob.num_used++;
 }
-void mark_for_del(uint64_t line)
+template<class C>
+void Core<C>::mark_for_del(uint64_t line)
 {
 	uint32_t head = rob.head;
 	uint32_t i = 0;
@@ -470,12 +830,13 @@ void mark_for_del(uint64_t line)
 	{
 		if(rob.rob_ent[head].line == line)
 			rob.rob_ent[head].completion_cycle = total_cycles;
-		head = (head + 1) % R;
+		head = rob_next(head);
 	}
 }
-void delete_from_rob(proc_stats_t* p_stats)
+template<class C>
+void Core<C>::delete_from_rob(proc_stats_t* p_stats)
 {
-	uint32_t fetchWidth = F;
+	uint32_t fetchWidth = fetch_width();
 	uint32_t head = rob.head;
 	uint32_t i =0;
 
@@ -483,19 +844,65 @@ void delete_from_rob(proc_stats_t* p_stats)
 	{
 		if ((rob.rob_ent[head].completion_cycle == (total_cycles - 1)) && (rob.rob_ent[head].completion_cycle))
 			rob.rob_ent[head].retire = 1;
-		head = (head + 1) % R;
+		head = rob_next(head);
 	}
 	while (fetchWidth && rob.rob_ent[rob.head].retire)
 	{
 		print_dbg("\n%lld\tRETIRED\t%lld", total_cycles, rob.rob_ent[rob.head].line);
-		print_out("\n%lld\t%d\t%d\t%d\t%d\t%d\t%lld", rob.rob_ent[rob.head].line, buf.print_ent[(rob.rob_ent[rob.head].line-1)%buf.size].fetch,buf.print_ent[(rob.rob_ent[rob.head].line-1)%buf.size].disp,buf.print_ent[(rob.rob_ent[rob.head].line-1)%buf.size].sch,buf.print_ent[(rob.rob_ent[rob.head].line-1)%buf.size].ex,buf.print_ent[(rob.rob_ent[rob.head].line-1)%buf.size].state,total_cycles);
+		last_retired = rob.rob_ent[rob.head].line;
+		if (lsq.num_used && lsq.lsq_ent[lsq.head].line == rob.rob_ent[rob.head].line)
+		{
+			if (lsq.lsq_ent[lsq.head].rw == WRITE)
+			{
+				cache_access(WRITE, lsq.lsq_ent[lsq.head].address, total_cycles, &p_stats->cache);
+				p_stats->stores++;
+			}
+			else
+				p_stats->loads++;
+			lsq.head = rob_next(lsq.head);
+			lsq.num_used--;
+		}
+		if (timeline_mode)
+		{
+			print_ent_t* p = &buf.print_ent[(rob.rob_ent[rob.head].line-1)%buf_size()];
+			timeline_retire(rob.rob_ent[rob.head].line, p->fetch, p->disp, p->sch, p->ex, p->state, total_cycles);
+		}
 		memset(&rob.rob_ent[rob.head], 0, sizeof(rob_ent_t));
-		rob.head = (rob.head + 1) % R;
+		rob.head = rob_next(rob.head);
 		rob.num_used--;
 		fetchWidth--;
 		p_stats->retired_instruction++;
 	}
 }
+/*IPC is the inverse of the mean cycles per unit; total cycles and the 95% confidence
+ * interval follow from the units' sample variance, with the finite population correction*/
+static void complete_sampling(proc_stats_t *p_stats)
+{
+	double mean, var, population, fpc;
+
+	p_stats->sample_units = sample_units;
+	p_stats->sample_population = p_stats->retired_instruction / sample_unit;
+	if (!sample_units)
+	{/*Trace too short for a whole period; all there is are the detailed cycles*/
+		fprintf(stderr, "No unit measured, IPC is over the detailed instructions only\n");
+		if (p_stats->cycle_count)
+			p_stats->avg_inst_retired = (float)p_stats->detailed_instructions / (float)p_stats->cycle_count;
+		if (p_stats->avg_inst_retired > 0)
+			p_stats->cycle_count = (unsigned long)(p_stats->retired_instruction / p_stats->avg_inst_retired + 0.5);
+		return;
+	}
+	mean = unit_cycles_sum / sample_units;
+	p_stats->avg_inst_retired = sample_unit / mean;
+	p_stats->cycle_count = (unsigned long)(p_stats->retired_instruction * mean / sample_unit + 0.5);
+	if (sample_units < 2)
+		return;
+	var = (unit_cycles_sq - sample_units * mean * mean) / (sample_units - 1);
+	population = (double)p_stats->retired_instruction / sample_unit;
+	fpc = (sample_units < population) ? 1 - sample_units / population : 0;
+	if (var < 0)
+		var = 0;
+	p_stats->ipc_ci = 1.96 * sqrt(var * fpc / sample_units) / mean * p_stats->avg_inst_retired;
+}
 /**
  * Subroutine for cleaning up any outstanding instructions and calculating overall statistics
  * such as average IPC or branch prediction percentage
@@ -504,17 +911,12 @@ void delete_from_rob(proc_stats_t* p_stats)
  * @p_stats Pointer to the statistics structure
  */
 void complete_proc(proc_stats_t *p_stats) {
-		p_stats->avg_inst_retired = (float)p_stats->retired_instruction / (float)p_stats->cycle_count;
-		free(rob.rob_ent);
-		for (uint32_t i = 0; i < K0; i++)
-			free(fu[0].fu_ent[i].fu_stg);
-		for (uint32_t i = 0; i < K1; i++)
-			free(fu[1].fu_ent[i].fu_stg);
-		for (uint32_t i = 0; i < K2; i++)
-			free(fu[2].fu_ent[i].fu_stg);
-		for (uint32_t i=0; i < nFU_TYPE; i++){
-		free(sched_q[i].sched_ent);
-		free(fu[i].fu_ent);
-		}
-		free(buf.print_ent);
+		if (sample_period)
+			complete_sampling(p_stats);
+		else
+			p_stats->avg_inst_retired = (float)p_stats->retired_instruction / (float)p_stats->cycle_count;
+		delete core;
+		core = NULL;
+		if (bMem)
+			complete_cache();
 }
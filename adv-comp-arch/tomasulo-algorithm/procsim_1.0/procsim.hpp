@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <cinttypes>
 #include <cstdlib>
+#include "procsim_cache.hpp"
 
 #define DEFAULT_K0 3
 #define DEFAULT_K1 1
@@ -12,6 +13,7 @@
 #define DEFAULT_R 8
 #define DEFAULT_M 2
 #define DEFAULT_F 2
+#define DEFAULT_SAMPLE_UNIT 1000
 
 typedef struct _proc_inst_t
 {
@@ -21,6 +23,8 @@ typedef struct _proc_inst_t
     int32_t dest_reg;
     
     // You may introduce other fields as needed
+    char mem_rw;                // READ or WRITE, extended traces only; 0 otherwise
+    uint64_t mem_address;
     
 } proc_inst_t;
 
@@ -29,11 +33,25 @@ typedef struct _proc_stats_t
     float avg_inst_retired;
     unsigned long retired_instruction;
     unsigned long cycle_count;
+
+    // Sampled simulation only; cycle_count is then an estimate
+    unsigned long sample_units;
+    unsigned long sample_population;
+    unsigned long detailed_instructions;
+    float ipc_ci;
+
+    // Memory model only
+    unsigned long loads;
+    unsigned long stores;
+    unsigned long forwarded_loads;  // served by an older store in the LSQ
+    cache_stats_t cache;
 } proc_stats_t;
 
 bool read_instruction(proc_inst_t* p_inst);
 
 void setup_proc(uint64_t r, uint64_t k0, uint64_t k1, uint64_t k2, uint64_t f, uint64_t m);
+void setup_sampling(uint64_t period, uint64_t u, uint64_t w);
+void setup_memory(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2, uint64_t b2, uint64_t s2, uint32_t mshrs);
 void run_proc(proc_stats_t* p_stats);
 void complete_proc(proc_stats_t* p_stats);
 
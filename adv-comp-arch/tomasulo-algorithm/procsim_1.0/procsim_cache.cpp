@@ -0,0 +1,179 @@
+#include "procsim_cache.hpp"
+#include <cmath>
+#include <vector>
+
+#define MEMORY_PENALTY 500
+
+typedef struct blk_entry{
+	uint64_t block;		/*Address >> B; the set index is its low bits*/
+	uint64_t lru_time;
+	bool valid;
+	bool dirty;
+}blk_entry_t;
+
+struct cache_level{
+	uint32_t b;
+	uint64_t sets;
+	uint32_t ways;
+	uint32_t hit_time;
+	std::vector<blk_entry_t> blk;	/*sets * ways, a set's ways together*/
+}L1, L2;
+
+typedef struct mshr_entry{
+	uint64_t block;		/*L1 block on its way*/
+	uint64_t ready;		/*Cycle its data is back*/
+}mshr_entry_t;
+
+std::vector<mshr_entry_t> mshr;
+uint64_t glrutime = 0;
+
+static void level_setup(cache_level* L, uint64_t c, uint64_t b, uint64_t s, double hit_time)
+{
+	L->b = b;
+	L->ways = 1u << s;
+	L->sets = (uint64_t)1 << (c - b - s);
+	L->hit_time = (uint32_t)ceil(hit_time);
+	L->blk.assign(L->sets * L->ways, blk_entry_t());
+}
+/**
+ * Subroutine for initializing the cache.
+ *
+ * @c1, @b1, @s1 L1 is 2^C1 bytes in 2^B1 byte blocks, 2^S1 per set
+ * @c2, @b2, @s2 Same for L2
+ * @mshrs Misses L1 can have outstanding
+ */
+void setup_cache(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2, uint64_t b2, uint64_t s2, uint32_t mshrs)
+{
+	level_setup(&L1, c1, b1, s1, 2 + 0.2 * s1);
+	level_setup(&L2, c2, b2, s2, 4 + 0.4 * s2);
+	mshr.assign(mshrs, mshr_entry_t());
+}
+static blk_entry_t* level_find(cache_level* L, uint64_t address)
+{
+	uint64_t block = address >> L->b;
+	blk_entry_t* set = &L->blk[(block & (L->sets - 1)) * L->ways];
+
+	for (uint32_t i = 0; i < L->ways; i++)
+		if (set[i].valid && set[i].block == block)
+			return &set[i];
+	return NULL;
+}
+/*Put the block in an empty or the LRU way; the victim is handed back if it was dirty*/
+static bool level_fill(cache_level* L, uint64_t address, bool dirty, uint64_t* victim)
+{
+	uint64_t block = address >> L->b;
+	blk_entry_t* set = &L->blk[(block & (L->sets - 1)) * L->ways];
+	blk_entry_t* v = &set[0];
+	bool wb;
+
+	for (uint32_t i = 0; i < L->ways && v->valid; i++)
+		if (!set[i].valid || set[i].lru_time < v->lru_time)
+			v = &set[i];
+	wb = v->valid && v->dirty;
+	*victim = v->block << L->b;
+	v->block = block;
+	v->valid = 1;
+	v->dirty = dirty;
+	v->lru_time = ++glrutime;
+	return wb;
+}
+/*Dirty block coming down from L1; L2 is non-inclusive so it may have to be allocated*/
+static void l2_write(uint64_t address, cache_stats_t* p_stats)
+{
+	blk_entry_t* e = level_find(&L2, address);
+	uint64_t victim;
+
+	if (e)
+	{
+		e->dirty = 1;
+		e->lru_time = ++glrutime;
+	}
+	else if (level_fill(&L2, address, 1, &victim))
+		p_stats->write_backs++;
+}
+/*Functional access; the level that had the block, 2 for memory*/
+static uint32_t access_blocks(char rw, uint64_t address, cache_stats_t* p_stats)
+{
+	blk_entry_t* e = level_find(&L1, address);
+	uint64_t victim;
+	uint32_t lvl = 0;
+
+	if (e)
+	{
+		e->lru_time = ++glrutime;
+		e->dirty |= (rw == WRITE);
+		return 0;
+	}
+	p_stats->l1_misses++;
+	if (level_fill(&L1, address, rw == WRITE, &victim))
+		l2_write(victim, p_stats);
+	if ((e = level_find(&L2, address)))
+	{
+		e->lru_time = ++glrutime;
+		lvl = 1;
+	}
+	else
+	{
+		p_stats->l2_misses++;
+		if (level_fill(&L2, address, 0, &victim))
+			p_stats->write_backs++;
+		lvl = 2;
+	}
+	return lvl;
+}
+/**
+ * Subroutine that simulates one load or store.
+ *
+ * @rw Either READ or WRITE
+ * @address The target memory address
+ * @now Current cycle
+ * @p_stats Pointer to the statistics structure
+ */
+uint64_t cache_access(char rw, uint64_t address, uint64_t now, cache_stats_t* p_stats)
+{
+	uint64_t block = address >> L1.b;
+	mshr_entry_t* free_mshr = NULL;
+	uint32_t lvl;
+
+	if (rw == WRITE)
+	{
+		p_stats->writes++;
+		access_blocks(rw, address, p_stats);
+		return now;
+	}
+	for (uint32_t i = 0; i < mshr.size(); i++)
+	{
+		if (mshr[i].ready > now && mshr[i].block == block)
+		{/*Wait for the fill already on its way*/
+			p_stats->reads++;
+			p_stats->mshr_merges++;
+			return mshr[i].ready;
+		}
+		if (mshr[i].ready <= now)
+			free_mshr = &mshr[i];
+	}
+	if (!free_mshr && !level_find(&L1, address))
+	{
+		p_stats->mshr_full++;
+		return 0;
+	}
+	p_stats->reads++;
+	lvl = access_blocks(rw, address, p_stats);
+	if (!lvl)
+		return now + L1.hit_time;
+	free_mshr->block = block;
+	free_mshr->ready = now + L1.hit_time + L2.hit_time + (lvl == 2 ? MEMORY_PENALTY : 0);
+	return free_mshr->ready;
+}
+void cache_warm(char rw, uint64_t address)
+{
+	cache_stats_t scratch;
+
+	access_blocks(rw, address, &scratch);
+}
+void complete_cache()
+{
+	L1.blk.clear();
+	L2.blk.clear();
+	mshr.clear();
+}
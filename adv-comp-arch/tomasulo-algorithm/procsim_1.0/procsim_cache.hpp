@@ -0,0 +1,49 @@
+#ifndef PROCSIM_CACHE_HPP
+#define PROCSIM_CACHE_HPP
+
+#include <cstdint>
+
+/*
+ * Two level write-back, write-allocate LRU cache in front of memory, for the
+ * loads and stores of extended traces. Sizes are given as in cachesim
+ * (2^C bytes, 2^B byte blocks, 2^S ways) and so are the hit times
+ * (2 + 0.2*S cycles for L1, 4 + 0.4*S for L2, 500 more for memory).
+ *
+ * Misses are non-blocking: L1 has a number of MSHRs, each holding a block
+ * until its data is back. Reads to a block already on its way wait for the
+ * same fill. Tags are updated at access time, only the data comes late.
+ */
+#define DEFAULT_C1 12
+#define DEFAULT_B1 5
+#define DEFAULT_S1 3
+#define DEFAULT_C2 15
+#define DEFAULT_B2 6
+#define DEFAULT_S2 5
+#define DEFAULT_MSHRS 8
+
+typedef struct _cache_stats_t
+{
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t l1_misses;
+    uint64_t l2_misses;
+    uint64_t write_backs;       // dirty blocks written to memory
+    uint64_t mshr_merges;       // reads that waited on a fill already outstanding
+    uint64_t mshr_full;         // reads turned away, all MSHRs busy
+} cache_stats_t;
+
+/** Argument to cache_access rw. Indicates a load */
+static const char READ = 'r';
+/** Argument to cache_access rw. Indicates a store */
+static const char WRITE = 'w';
+
+void setup_cache(uint64_t c1, uint64_t b1, uint64_t s1, uint64_t c2, uint64_t b2, uint64_t s2, uint32_t mshrs);
+/* Cycle the data of a READ issued at now is back, or 0 if no MSHR is free and it
+ * has to try again. WRITEs come from retired stores through a write buffer and
+ * only update the cache; they return now */
+uint64_t cache_access(char rw, uint64_t address, uint64_t now, cache_stats_t* p_stats);
+/* Functional access for fast-forwarding: tags and LRU only, no stats */
+void cache_warm(char rw, uint64_t address);
+void complete_cache();
+
+#endif /* PROCSIM_CACHE_HPP */
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <unistd.h>
 #include "procsim.hpp"
+#include "procsim_timeline.hpp"
 
 FILE* inFile = stdin;
 //#define DEBUG
@@ -16,6 +17,13 @@ void print_help_and_exit(void) {
     printf("  -f N\t\tNumber of instructions to fetch\n");
     printf("  -r R\t\tROB Size\n");
     printf("  -i traces/file.trace\n");
+    printf("  -c C1,B1,S1,C2,B2,S2[,N]\tMemory model: L1 and L2 as in cachesim (default %d,%d,%d,%d,%d,%d),\n",
+           DEFAULT_C1, DEFAULT_B1, DEFAULT_S1, DEFAULT_C2, DEFAULT_B2, DEFAULT_S2);
+    printf("\t\tN MSHRs (default %d); for traces with load/store addresses\n", DEFAULT_MSHRS);
+    printf("  -s N[,U[,W]]\tSampled simulation: measure one unit of U instructions (default %d)\n", DEFAULT_SAMPLE_UNIT);
+    printf("\t\tin every N, after W instructions of detailed warm-up (default 2*R)\n");
+    printf("  -t FILE\tWrite the pipeline timeline to FILE as binary records, not to stdout\n");
+    printf("  -q\t\tNo pipeline timeline\n");
     printf("  -h\t\tThis helpful output\n");
     exit(0);
 }
@@ -25,9 +33,13 @@ void print_help_and_exit(void) {
 //
 //  returns true if an instruction was read successfully
 //
+//  Extended traces may follow the registers with L or S and the effective
+//  address in hex, for loads and stores.
+//
 bool read_instruction(proc_inst_t* p_inst)
 {
     int ret;
+    char line[128], rw;
     
     if (p_inst == NULL)
     {
@@ -35,16 +47,32 @@ bool read_instruction(proc_inst_t* p_inst)
         return false;
     }
     
-    ret = fscanf(stdin, "%x %d %d %d %d\n", &p_inst->instruction_address,
-                 &p_inst->op_code, &p_inst->dest_reg, &p_inst->src_reg[0], &p_inst->src_reg[1]); 
-    if (ret != 5) {
+    do {
+        if (!fgets(line, sizeof(line), stdin))
+            return false;
+        ret = sscanf(line, "%x %d %d %d %d %c %" SCNx64, &p_inst->instruction_address,
+                     &p_inst->op_code, &p_inst->dest_reg, &p_inst->src_reg[0], &p_inst->src_reg[1],
+                     &rw, &p_inst->mem_address);
+    } while (ret == EOF);
+    if (ret != 5 && ret != 7) {
         return false;
     }
+    p_inst->mem_rw = 0;
+    if (ret == 7) {
+        if (rw == 'L')
+            p_inst->mem_rw = READ;
+        else if (rw == 'S')
+            p_inst->mem_rw = WRITE;
+        else
+            return false;
+    }
     
     return true;
 }
 
 void print_statistics(proc_stats_t* p_stats);
+void print_sampling(proc_stats_t* p_stats);
+void print_memory(proc_stats_t* p_stats);
 
 int main(int argc, char* argv[]) {
     int opt;
@@ -54,9 +82,17 @@ int main(int argc, char* argv[]) {
     uint64_t k1 = DEFAULT_K1;
     uint64_t k2 = DEFAULT_K2;
     uint64_t r = DEFAULT_R;
+    uint64_t s_period = 0, s_unit = DEFAULT_SAMPLE_UNIT, s_warmup = 0;
+    bool s_warmup_set = 0;
+    uint64_t c[6] = {DEFAULT_C1, DEFAULT_B1, DEFAULT_S1, DEFAULT_C2, DEFAULT_B2, DEFAULT_S2};
+    uint64_t mshrs = DEFAULT_MSHRS;
+    bool mem = 0;
+    int timeline = TIMELINE_TEXT;
+    FILE* timeline_file = NULL;
+    char* end;
 
     /* Read arguments */ 
-    while(-1 != (opt = getopt(argc, argv, "r:i:j:k:l:f:m:h"))) {
+    while(-1 != (opt = getopt(argc, argv, "r:i:j:k:l:f:m:s:c:t:qh"))) {
         switch(opt) {
         case 'r':
             r = atoi(optarg);
@@ -84,6 +120,47 @@ int main(int argc, char* argv[]) {
                 print_help_and_exit();
             }
             break;
+        case 's':
+            s_period = strtoull(optarg, &end, 10);
+            if (*end == ',')
+                s_unit = strtoull(end + 1, &end, 10);
+            if (*end == ',') {
+                s_warmup = strtoull(end + 1, &end, 10);
+                s_warmup_set = 1;
+            }
+            if (*end || s_period < 2 || !s_unit) {
+                fprintf(stderr, "Bad sampling spec %s\n", optarg);
+                print_help_and_exit();
+            }
+            break;
+        case 'c':
+            end = optarg;
+            for (int i = 0; i < 6; i++) {
+                c[i] = strtoull(end, &end, 10);
+                if (i == 5 || *end != ',')
+                    break;
+                end++;
+            }
+            if (*end == ',')
+                mshrs = strtoull(end + 1, &end, 10);
+            if (*end || !mshrs || c[0] < c[1] + c[2] || c[3] < c[4] + c[5]) {
+                fprintf(stderr, "Bad cache spec %s\n", optarg);
+                print_help_and_exit();
+            }
+            mem = 1;
+            break;
+        case 't':
+            timeline_file = fopen(optarg, "wb");
+            if (timeline_file == NULL)
+            {
+                fprintf(stderr, "Failed to open %s for writing\n", optarg);
+                print_help_and_exit();
+            }
+            timeline = TIMELINE_BINARY;
+            break;
+        case 'q':
+            timeline = TIMELINE_OFF;
+            break;
         case 'h':
             /* Fall through */
         default:
@@ -92,6 +169,17 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (s_period) {
+        if (!s_warmup_set)
+            s_warmup = 2 * r;
+        /* Up to 2*R instructions are still in flight when a unit ends; the next
+         * warm-up has to start after them */
+        if ((s_period - 1) * s_unit < s_warmup + 2 * r) {
+            fprintf(stderr, "Sampling period too short for the warm-up\n");
+            exit(1);
+        }
+    }
+
     printf("Processor Settings\n");
     printf("R: %" PRIu64 "\n", r);
     printf("k0: %" PRIu64 "\n", k0);
@@ -99,10 +187,23 @@ int main(int argc, char* argv[]) {
     printf("k2: %" PRIu64 "\n", k2);
     printf("F: %"  PRIu64 "\n", f);
     printf("M: %" PRIu64 "\n", m);
+    if (mem) {
+        printf("L1: C=%" PRIu64 " B=%" PRIu64 " S=%" PRIu64 "\n", c[0], c[1], c[2]);
+        printf("L2: C=%" PRIu64 " B=%" PRIu64 " S=%" PRIu64 "\n", c[3], c[4], c[5]);
+        printf("MSHRs: %" PRIu64 "\n", mshrs);
+    }
+    if (s_period)
+        printf("Sampling: 1 in every %" PRIu64 " units of %" PRIu64
+               ", %" PRIu64 " warm-up\n", s_period, s_unit, s_warmup);
     printf("\n");
 
     /* Setup the processor */
+    setup_timeline(timeline, timeline_file);
     setup_proc(r, k0, k1, k2, f, m);
+    if (s_period)
+        setup_sampling(s_period, s_unit, s_warmup);
+    if (mem)
+        setup_memory(c[0], c[1], c[2], c[3], c[4], c[5], mshrs);
 
     /* Setup statistics */
     proc_stats_t stats;
@@ -116,6 +217,10 @@ int main(int argc, char* argv[]) {
     complete_proc(&stats);
 
     print_statistics(&stats);
+    if (s_period)
+        print_sampling(&stats);
+    if (mem)
+        print_memory(&stats);
 
     return 0;
 }
@@ -128,3 +233,25 @@ void print_statistics(proc_stats_t* p_stats) {
 	printf("Total run time (cycles): %lu\n", p_stats->cycle_count);
 }
 
+
+void print_sampling(proc_stats_t* p_stats) {
+
+    printf("Sampling stats:\n");
+    printf("Units measured: %lu of %lu\n", p_stats->sample_units, p_stats->sample_population);
+    printf("Instructions simulated in detail: %lu\n", p_stats->detailed_instructions);
+    printf("IPC 95%% confidence interval: +/- %f (%.2f%%)\n", p_stats->ipc_ci,
+           p_stats->avg_inst_retired > 0 ? 100 * p_stats->ipc_ci / p_stats->avg_inst_retired : 0);
+}
+
+void print_memory(proc_stats_t* p_stats) {
+
+    printf("Memory stats:\n");
+    printf("Loads: %lu\n", p_stats->loads);
+    printf("Stores: %lu\n", p_stats->stores);
+    printf("Loads forwarded from stores: %lu\n", p_stats->forwarded_loads);
+    printf("L1 misses: %" PRIu64 "\n", p_stats->cache.l1_misses);
+    printf("L2 misses: %" PRIu64 "\n", p_stats->cache.l2_misses);
+    printf("Write backs: %" PRIu64 "\n", p_stats->cache.write_backs);
+    printf("Loads merged into outstanding misses: %" PRIu64 "\n", p_stats->cache.mshr_merges);
+    printf("Load issues turned away, MSHRs full: %" PRIu64 "\n", p_stats->cache.mshr_full);
+}
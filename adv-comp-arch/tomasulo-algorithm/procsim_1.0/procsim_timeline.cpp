@@ -0,0 +1,80 @@
+#include "procsim_timeline.hpp"
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#define TIMELINE_BUF 4096	/*Records written per fwrite*/
+
+int timeline_mode = TIMELINE_TEXT;
+FILE* timeline_out = NULL;
+timeline_rec_t timeline_buf[TIMELINE_BUF];
+uint32_t timeline_used = 0;
+
+static void timeline_flush()
+{
+	if (timeline_used && fwrite(timeline_buf, sizeof(timeline_rec_t), timeline_used, timeline_out) != timeline_used)
+	{
+		fprintf(stderr, "Failed to write the timeline\n");
+		exit(1);
+	}
+	timeline_used = 0;
+}
+/**
+ * Subroutine for choosing where the timeline goes.
+ *
+ * @mode TIMELINE_OFF, TIMELINE_TEXT or TIMELINE_BINARY
+ * @out File for the binary records
+ */
+void setup_timeline(int mode, FILE* out)
+{
+	timeline_mode = mode;
+	timeline_out = out;
+}
+void timeline_begin()
+{
+	timeline_header_t h;
+
+	if (timeline_mode == TIMELINE_TEXT)
+		printf("INST\tFETCH\tDISP\tSCHED\tEXEC\tSTATE\tRETIRE");
+	else if (timeline_mode == TIMELINE_BINARY)
+	{
+		memcpy(h.magic, TIMELINE_MAGIC, sizeof(h.magic));
+		h.rec_size = sizeof(timeline_rec_t);
+		if (fwrite(&h, sizeof(h), 1, timeline_out) != 1)
+		{
+			fprintf(stderr, "Failed to write the timeline\n");
+			exit(1);
+		}
+	}
+}
+void timeline_retire(uint64_t line, uint32_t fetch, uint32_t disp, uint32_t sched,
+		uint32_t exec, uint32_t state, uint32_t retire)
+{
+	timeline_rec_t* r;
+
+	if (timeline_mode == TIMELINE_TEXT)
+	{
+		printf("\n%" PRIu64 "\t%u\t%u\t%u\t%u\t%u\t%u", line, fetch, disp, sched, exec, state, retire);
+		return;
+	}
+	r = &timeline_buf[timeline_used];
+	r->line = line;
+	r->fetch = fetch;
+	r->disp = disp;
+	r->sched = sched;
+	r->exec = exec;
+	r->state = state;
+	r->retire = retire;
+	if (++timeline_used == TIMELINE_BUF)
+		timeline_flush();
+}
+void timeline_end()
+{
+	if (timeline_mode == TIMELINE_TEXT)
+		printf("\n\n");
+	else if (timeline_mode == TIMELINE_BINARY)
+	{
+		timeline_flush();
+		fclose(timeline_out);
+	}
+}
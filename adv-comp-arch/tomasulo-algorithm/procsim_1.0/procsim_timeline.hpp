@@ -0,0 +1,48 @@
+#ifndef PROCSIM_TIMELINE_HPP
+#define PROCSIM_TIMELINE_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Per-instruction pipeline timeline, one record per retired instruction in
+ * retirement order. It goes to stdout as the INST/FETCH/.../RETIRE table
+ * (the default), to a file as binary records, or nowhere.
+ *
+ * Binary files are a timeline_header_t followed by timeline_rec_t records,
+ * in host byte order; the timeline tool turns them back into the table or
+ * into a pipeline visualizer log.
+ */
+#define TIMELINE_OFF    0
+#define TIMELINE_TEXT   1
+#define TIMELINE_BINARY 2
+
+#define TIMELINE_MAGIC "PTL1"
+
+typedef struct _timeline_header_t
+{
+    char magic[4];
+    uint32_t rec_size;
+} timeline_header_t;
+
+typedef struct _timeline_rec_t
+{
+    uint64_t line;
+    uint32_t fetch;
+    uint32_t disp;
+    uint32_t sched;
+    uint32_t exec;
+    uint32_t state;
+    uint32_t retire;
+} timeline_rec_t;
+
+extern int timeline_mode;
+
+/* out is only used for TIMELINE_BINARY */
+void setup_timeline(int mode, FILE* out);
+void timeline_begin();
+void timeline_retire(uint64_t line, uint32_t fetch, uint32_t disp, uint32_t sched,
+                     uint32_t exec, uint32_t state, uint32_t retire);
+void timeline_end();
+
+#endif /* PROCSIM_TIMELINE_HPP */
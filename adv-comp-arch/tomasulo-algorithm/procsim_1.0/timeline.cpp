@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <vector>
+#include <unistd.h>
+#include "procsim_timeline.hpp"
+
+//
+// Renders a binary timeline written by procsim -t: as the table procsim
+// prints to stdout, or as a Kanata log for the Konata pipeline visualizer.
+//
+
+void print_help_and_exit(void) {
+    printf("timeline [OPTIONS] FILE\n");
+    printf("  -k\t\tKanata log instead of the INST/FETCH/.../RETIRE table\n");
+    printf("  -h\t\tThis helpful output\n");
+    exit(0);
+}
+
+struct kanata_event {
+    uint32_t cycle;
+    uint64_t id;
+    uint64_t line;
+    int stage;      // 0 fetch, up to 5 retire; the order within a cycle
+
+    bool operator>(const kanata_event& e) const {
+        if (cycle != e.cycle)
+            return cycle > e.cycle;
+        if (id != e.id)
+            return id > e.id;
+        return stage > e.stage;
+    }
+};
+
+static const char* kanata_stage[] = { "F", "Ds", "Sc", "X", "Su" };
+
+typedef std::priority_queue<kanata_event, std::vector<kanata_event>,
+        std::greater<kanata_event> > event_queue;
+
+static uint32_t kanata_cycle = 0;
+
+/* Events before cycle `until' */
+void kanata_emit(event_queue& q, uint32_t until) {
+    while (!q.empty() && q.top().cycle < until) {
+        kanata_event e = q.top();
+
+        q.pop();
+        if (e.cycle != kanata_cycle) {
+            printf("C\t%u\n", e.cycle - kanata_cycle);
+            kanata_cycle = e.cycle;
+        }
+        if (e.stage == 0) {
+            printf("I\t%" PRIu64 "\t%" PRIu64 "\t0\n", e.id, e.line);
+            printf("L\t%" PRIu64 "\t0\t%" PRIu64 "\n", e.id, e.line);
+        }
+        if (e.stage < 5)
+            printf("S\t%" PRIu64 "\t0\t%s\n", e.id, kanata_stage[e.stage]);
+        else
+            printf("R\t%" PRIu64 "\t%" PRIu64 "\t0\n", e.id, e.id);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int opt;
+    bool kanata = 0;
+    FILE* in;
+    timeline_header_t h;
+    timeline_rec_t r;
+    event_queue q;
+    uint64_t id = 0;
+
+    while (-1 != (opt = getopt(argc, argv, "kh"))) {
+        switch (opt) {
+        case 'k':
+            kanata = 1;
+            break;
+        case 'h':
+            /* Fall through */
+        default:
+            print_help_and_exit();
+            break;
+        }
+    }
+    if (optind != argc - 1)
+        print_help_and_exit();
+    in = fopen(argv[optind], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Failed to open %s for reading\n", argv[optind]);
+        return 1;
+    }
+    if (fread(&h, sizeof(h), 1, in) != 1 || memcmp(h.magic, TIMELINE_MAGIC, sizeof(h.magic))
+            || h.rec_size != sizeof(timeline_rec_t)) {
+        fprintf(stderr, "%s is not a procsim timeline\n", argv[optind]);
+        return 1;
+    }
+
+    if (!kanata)
+        printf("INST\tFETCH\tDISP\tSCHED\tEXEC\tSTATE\tRETIRE");
+    else
+        printf("Kanata\t0004\nC=\t0\n");
+    while (fread(&r, sizeof(r), 1, in) == 1) {
+        if (!kanata) {
+            printf("\n%" PRIu64 "\t%u\t%u\t%u\t%u\t%u\t%u", r.line, r.fetch, r.disp, r.sched,
+                   r.exec, r.state, r.retire);
+            continue;
+        }
+        /* Retirement is in order and so is fetch: nothing later in the
+         * file happens before this fetch */
+        kanata_emit(q, r.fetch);
+        kanata_event e = { r.fetch, id++, r.line, 0 };
+        uint32_t cycles[] = { r.fetch, r.disp, r.sched, r.exec, r.state, r.retire };
+
+        for (e.stage = 0; e.stage < 6; e.stage++) {
+            e.cycle = cycles[e.stage];
+            q.push(e);
+        }
+    }
+    if (!kanata)
+        printf("\n\n");
+    else
+        kanata_emit(q, UINT32_MAX);
+    fclose(in);
+
+    return 0;
+}
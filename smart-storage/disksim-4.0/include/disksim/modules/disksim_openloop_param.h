@@ -0,0 +1,38 @@
+
+#ifndef _DISKSIM_OPENLOOP_PARAM_H
+#define _DISKSIM_OPENLOOP_PARAM_H  
+
+#include <libparam/libparam.h>
+#ifdef __cplusplus
+extern"C"{
+#endif
+struct dm_disk_if;
+
+/* prototype for disksim_openloop param loader function */
+int disksim_openloop_loadparams(struct lp_block *b);
+
+typedef enum {
+   DISKSIM_OPENLOOP_NUMBER_OF_IO_REQUESTS_TO_GENERATE,
+   DISKSIM_OPENLOOP_MAXIMUM_TIME_OF_TRACE_GENERATED,
+   DISKSIM_OPENLOOP_STREAMS
+} disksim_openloop_param_t;
+
+#define DISKSIM_OPENLOOP_MAX_PARAM		DISKSIM_OPENLOOP_STREAMS
+extern void * DISKSIM_OPENLOOP_loaders[];
+extern lp_paramdep_t DISKSIM_OPENLOOP_deps[];
+
+
+static struct lp_varspec disksim_openloop_params [] = {
+   {"Number of I/O requests to generate", I, 1 },
+   {"Maximum time of trace generated", D, 1 },
+   {"Streams", LIST, 1 },
+   {0,0,0}
+};
+#define DISKSIM_OPENLOOP_MAX 3
+static struct lp_mod disksim_openloop_mod = { "disksim_openloop", disksim_openloop_params, DISKSIM_OPENLOOP_MAX, (lp_modloader_t)disksim_openloop_loadparams,  0, 0, DISKSIM_OPENLOOP_loaders, DISKSIM_OPENLOOP_deps };
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _DISKSIM_OPENLOOP_PARAM_H
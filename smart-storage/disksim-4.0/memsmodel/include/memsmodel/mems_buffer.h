@@ -12,6 +12,9 @@ mems_buffer_check (int firstblock,
 		   int lastblock,
 		   mems_t *dev);
 
+void
+mems_buffer_initialize (mems_t *dev);
+
 void
 mems_buffer_insert (int firstblock,
 		    int lastblock,
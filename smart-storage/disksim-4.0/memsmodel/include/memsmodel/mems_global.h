@@ -38,7 +38,8 @@
 #include "disksim_stat.h"
 
 #define MEMS_MAXSLEDS		9
-#define MEMS_SEEKCACHE		2	/* Number of entries in seekcache */
+#define MEMS_SEEKCACHE		1024	/* Number of entries in seekcache (power of 2) */
+#define MEMS_SEEK_SURFACE_TOLERANCE	0.01	/* Max relative interpolation error */
 
 #define getmems(d) (disksim->memsinfo->devices[d])
 
@@ -79,8 +80,17 @@ struct mems_prefetch_info {
 };
 
 
+/* Base seek times on a grid of (start, end) sled offsets */
+struct mems_seek_surface {
+  double  min_nm;	/* offset of the first grid point */
+  double  step_nm;	/* grid spacing */
+  double *times;	/* seek times (s), indexed [start * points + end] */
+  char   *exact;	/* cells that must be solved rather than interpolated */
+};
+
 /* Marshalling structure for mems_seek_time_checkcache() */
 struct mems_seekcache {
+  int     valid;
   double  time;		/* total time returned by mems_seek_time() */
   coord_t begin;	/* begin coordinate */
   coord_t end;		/* end coordinate */
@@ -97,6 +107,7 @@ struct mems_segment {
   struct mems_segment *prev;
   int    startblkno;
   int    endblkno;
+  int    index;		/* Position in dev->segindex */
 };
 
 
@@ -131,6 +142,9 @@ struct mems_stat {
 
   int num_buffer_accesses;	/* Number of times buffer is checked */
   int num_buffer_hits;		/* Number of hits in the buffer */
+  int num_buffer_partial_hits;	/* Checks that found some but not all blocks */
+  int num_buffer_blocks;	/* Blocks looked up in the buffer */
+  int num_buffer_hit_blocks;	/* Blocks found in the buffer */
 
   statgen prefetched_blocks;	/* Number of blocks prefetched each request */
   statgen batch_response_time;  /* Response time for batches */
@@ -186,7 +200,6 @@ typedef struct {
 
   /* Variables used by mems_seek_time_seekcache */
   struct mems_seekcache seekcache[MEMS_SEEKCACHE];
-  int seekcache_next;		/* Next available cache entry */
 
   double active_power_mw;	/* Per-sled power when sled active */
   double inactive_power_mw;	/* Per-sled power when sled inactive */
@@ -224,6 +237,9 @@ typedef struct mems {
   int numsegs;			/* Number of buffer segments */
   int segsize;			/* Segment size (in blks) */
   struct mems_segment *seglist;	/* Buffer segments */
+  struct mems_segment *segtail;	/* LRU end of seglist */
+  struct mems_segment **segindex;	/* Segments sorted by startblkno */
+  struct mems_segment **segmaxend;	/* Max endblkno over segindex[0..i] */
 
   int seek_function;
 
@@ -232,6 +248,10 @@ typedef struct mems {
   double *precompute_x_seek_times; /* X seek times in precomputed seek curve */
   double *precompute_y_seek_times; /* Y seek times in precomputed seek curve */
 
+  int seek_surface_points;	/* Grid points per axis in the seek surface */
+  struct mems_seek_surface x_seek_surface;
+  struct mems_seek_surface y_seek_surface;
+
 } mems_t;
 
 
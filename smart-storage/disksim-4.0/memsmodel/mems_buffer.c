@@ -6,6 +6,20 @@
  *
  * FIXME: This is by no means a good/comprehensive way to account
  * for block buffering, but it works for quick comparisons with disks.
+ *
+ * Segments hold inclusive block ranges [startblkno, endblkno].  Recency
+ * is kept in the doubly-linked dev->seglist (MRU at the head, LRU at
+ * dev->segtail); lookups go through dev->segindex, an array of the same
+ * segments sorted by startblkno.  dev->segmaxend[i] is the segment with
+ * the largest endblkno among segindex[0..i], so the segment reaching
+ * furthest past any block is found with one binary search even when
+ * segments overlap.  An unused segment is empty, endblkno below
+ * startblkno, and never matches.
+ *
+ * Moving a segment in the index shifts the entries between its old and
+ * new position and recomputes segmaxend from there until it stops
+ * changing.  That is usually a few entries, but it is O(numsegs) at
+ * worst, e.g. when a segment becomes the furthest reaching one.
  ************************************************************************/
 
 void
@@ -14,6 +28,10 @@ move_segment_to_head (struct mems_segment *tmpseg,
 {
   if ((dev->numsegs > 1) && (tmpseg != dev->seglist))
     {
+      if (tmpseg == dev->segtail)
+	{
+	  dev->segtail = tmpseg->prev;
+	}
       tmpseg->prev->next = tmpseg->next;
       if (tmpseg->next)
 	{
@@ -27,6 +45,124 @@ move_segment_to_head (struct mems_segment *tmpseg,
     }
 }
 
+/* Number of indexed segments whose startblkno is <= blk */
+static int
+segindex_upper_bound (mems_t *dev, int blk)
+{
+  int lo = 0;
+  int hi = dev->numsegs;
+
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (dev->segindex[mid]->startblkno <= blk)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/* Recompute segmaxend[from..] after the entries up to segindex[last]
+ * moved or seg's range changed.  Past last nothing else changed, so
+ * once an entry comes out the same (and is not seg) the rest will too. */
+static void
+segindex_update_maxend (mems_t *dev, int from, int last,
+			struct mems_segment *seg)
+{
+  int i;
+
+  for (i = from; i < dev->numsegs; i++)
+    {
+      struct mems_segment *max = dev->segindex[i];
+      if ((i > 0) && (dev->segmaxend[i-1]->endblkno >= max->endblkno))
+	max = dev->segmaxend[i-1];
+      if ((i > last) && (max == dev->segmaxend[i]) && (max != seg))
+	break;
+      dev->segmaxend[i] = max;
+    }
+}
+
+/* Restore the index after seg's range changed */
+static void
+segindex_reposition (mems_t *dev, struct mems_segment *seg)
+{
+  int pos = seg->index;
+
+  while ((pos > 0) &&
+	 (dev->segindex[pos-1]->startblkno > seg->startblkno))
+    {
+      dev->segindex[pos] = dev->segindex[pos-1];
+      dev->segindex[pos]->index = pos;
+      pos--;
+    }
+  while ((pos < (dev->numsegs - 1)) &&
+	 (dev->segindex[pos+1]->startblkno < seg->startblkno))
+    {
+      dev->segindex[pos] = dev->segindex[pos+1];
+      dev->segindex[pos]->index = pos;
+      pos++;
+    }
+  dev->segindex[pos] = seg;
+  segindex_update_maxend(dev, min(pos, seg->index), max(pos, seg->index), seg);
+  seg->index = pos;
+}
+
+/* Segment covering blk that extends furthest, or NULL */
+static struct mems_segment *
+segindex_lookup (mems_t *dev, int blk, int *next)
+{
+  int k = segindex_upper_bound(dev, blk);
+
+  if (next)
+    {
+      *next = (k < dev->numsegs) ? dev->segindex[k]->startblkno : -1;
+    }
+  if ((k > 0) && (dev->segmaxend[k-1]->endblkno >= blk))
+    {
+      return dev->segmaxend[k-1];
+    }
+  return NULL;
+}
+
+/* Segment initialization stuff taken in part from disksim_disk.c */
+void
+mems_buffer_initialize (mems_t *dev)
+{
+  struct mems_segment *seg;
+  int i;
+
+  dev->seglist = NULL;
+  for (i = 0; i < dev->numsegs; i++)
+    {
+      seg = (struct mems_segment *)DISKSIM_malloc(sizeof(struct mems_segment));
+      seg->next = dev->seglist;
+      seg->prev = NULL;
+      seg->time = 0.0;
+      seg->startblkno = 0;
+      seg->endblkno   = -1;	/* Empty until first used */
+      if (dev->seglist)
+	{
+	  dev->seglist->prev = seg;
+	}
+      dev->seglist = seg;
+    }
+
+  dev->segindex = (struct mems_segment **)
+    DISKSIM_malloc(dev->numsegs * sizeof(struct mems_segment *));
+  dev->segmaxend = (struct mems_segment **)
+    DISKSIM_malloc(dev->numsegs * sizeof(struct mems_segment *));
+  i = 0;
+  for (seg = dev->seglist; seg; seg = seg->next)
+    {
+      dev->segtail = seg;
+      dev->segindex[i] = seg;
+      seg->index = i++;
+    }
+  assert(i == dev->numsegs);
+  segindex_update_maxend(dev, 0, dev->numsegs - 1, NULL);
+}
+
 /* Returns zero if all blocks not found in buffer; otherwise success */
 int
 mems_buffer_check (int firstblock,
@@ -35,33 +171,48 @@ mems_buffer_check (int firstblock,
 {
   struct mems_segment *seg;
   int blk = firstblock;
+  int next;
+  int found = 0;
 
   if (!dev->numsegs) return 0;
 
   dev->stat.num_buffer_accesses++;
+  dev->stat.num_buffer_blocks += lastblock - firstblock + 1;
 
-  /* For each block in the range [firstblock,lastblock], check to
-   * see if the block is cached.  If ALL blocks are cached, return
-   * success.
-   *
-   * This looks convoluted but really isn't. */
+  /* Walk the range [firstblock,lastblock], jumping over each cached
+   * run and to the next segment start over each uncached gap, so every
+   * cached block is counted exactly once.  Segments that supply blocks
+   * become most recently used. */
 
-  seg = dev->seglist;
-  while (seg)
+  while (blk <= lastblock)
     {
-      if ((blk >= seg->startblkno && blk < seg->endblkno))
+      seg = segindex_lookup(dev, blk, &next);
+      if (seg)
+	{
+	  found += min(seg->endblkno, lastblock) - blk + 1;
+	  blk = seg->endblkno + 1;
+	  move_segment_to_head(seg, dev);
+	}
+      else if ((next < 0) || (next > lastblock))
+	{
+	  break;
+	}
+      else
 	{
-	  blk = seg->endblkno;
-	  move_segment_to_head(seg, dev);	/* seg points to head of list */
-	  if (blk >= lastblock)
-	    {
-	      dev->stat.num_buffer_hits++;
-	      return 1;
-	    }
+	  blk = next;
 	}
-      seg = seg->next;	/* seg now points to second element in list */
     }
 
+  dev->stat.num_buffer_hit_blocks += found;
+  if (found == (lastblock - firstblock + 1))
+    {
+      dev->stat.num_buffer_hits++;
+      return 1;
+    }
+  if (found)
+    {
+      dev->stat.num_buffer_partial_hits++;
+    }
   return 0;	/* Failure */
 }
 
@@ -86,16 +237,16 @@ mems_buffer_insert (int firstblock,
    * is the "next" block for a segment.  For example, if a segment
    * contains blocks 10--20, then firstblock==[10,21] matches the
    * segment. */
-  for (seg = dev->seglist; seg; seg = seg->next)
+  seg = segindex_lookup(dev, firstblock - 1, NULL);
+  if (seg == NULL)
     {
-      if ((firstblock >= seg->startblkno) && 
-	  (firstblock <= (seg->endblkno + 1))) break;
+      seg = segindex_lookup(dev, firstblock, NULL);
     }
   if (seg)
     {
       /* If the segment already contains firstblock--lastblock,
        * all we need to do is move the segment to the head of MRU list */
-      if ((firstblock >= seg->startblkno) && (lastblock <= seg->endblkno))
+      if (lastblock <= seg->endblkno)
 	{
 	  move_segment_to_head(seg, dev);
 	  return;
@@ -106,27 +257,23 @@ mems_buffer_insert (int firstblock,
        * to below to put the rest of the blocks in the LRU segment. */
       if ((seg->endblkno - seg->startblkno + 1) < dev->segsize)
 	{
+	  int full = seg->startblkno + dev->segsize - 1;
+
 	  move_segment_to_head(seg, dev);
-	  for (blk = firstblock; blk <= lastblock; blk++)
-	    {
-	      if (seg->endblkno < blk)
-		{
-		  seg->endblkno = blk;
-		  if ((seg->endblkno - seg->startblkno + 1) >= dev->segsize)
-		    break;
-		}
-	    }
-	  if (blk >= lastblock) return;
+	  seg->endblkno = min(lastblock, full);
+	  segindex_reposition(dev, seg);
+	  blk = seg->endblkno + 1;
+	  if (blk > lastblock) return;
 	}
     }
 
   /* If we reach here, there are still blocks to put in the buffer.
-   * Find the LRU segment, and put the remaining blocks there. */
-  seg = dev->seglist;
-  while (seg->next) seg = seg->next;
+   * Reuse the LRU segment for the remaining blocks. */
+  seg = dev->segtail;
   move_segment_to_head(seg, dev);
   seg->startblkno = blk;
   seg->endblkno = lastblock;
+  segindex_reposition(dev, seg);
 
   return;
 }
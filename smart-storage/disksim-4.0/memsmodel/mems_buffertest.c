@@ -0,0 +1,160 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+/*
+ * Checks the segment buffer (mems_buffer.c) against a plain scan of the
+ * segment list.  Exits non-zero if anything differs.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mems_global.h"
+#include "mems_buffer.h"
+
+/* mems_buffer.o is linked on its own, without the rest of libdisksim */
+void *DISKSIM_malloc (int size)
+{
+  return calloc(1, size);
+}
+
+static int failures = 0;
+
+static void expect(int cond, char *what) {
+  if (!cond) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static void setup_buffer(mems_t *dev, int numsegs, int segsize) {
+  memset(dev, 0, sizeof(mems_t));
+  dev->numsegs = numsegs;
+  dev->segsize = segsize;
+  mems_buffer_initialize(dev);
+}
+
+/* Blocks of [first,last] held by some segment */
+static int scan_found(mems_t *dev, int first, int last) {
+  struct mems_segment *seg;
+  int blk, found = 0;
+
+  for (blk = first; blk <= last; blk++) {
+    for (seg = dev->seglist; seg; seg = seg->next) {
+      if ((blk >= seg->startblkno) && (blk <= seg->endblkno)) {
+	found++;
+	break;
+      }
+    }
+  }
+  return found;
+}
+
+static void test_cold(void) {
+  mems_t dev;
+
+  setup_buffer(&dev, 8, 16);
+  expect(mems_buffer_check(0, 0, &dev) == 0, "cold buffer hit on block 0");
+  expect(mems_buffer_check(0, 3, &dev) == 0, "cold buffer hit on blocks 0-3");
+  expect(dev.stat.num_buffer_hits == 0, "cold buffer counted a hit");
+  expect(dev.stat.num_buffer_partial_hits == 0, "cold buffer counted a partial hit");
+  expect(dev.stat.num_buffer_hit_blocks == 0, "cold buffer counted hit blocks");
+
+  mems_buffer_insert(0, 3, &dev);
+  expect(mems_buffer_check(0, 0, &dev) == 1, "block 0 missed after insert");
+  expect(mems_buffer_check(0, 3, &dev) == 1, "blocks 0-3 missed after insert");
+  expect(mems_buffer_check(4, 4, &dev) == 0, "block 4 hit after inserting 0-3");
+  expect(mems_buffer_check(2, 5, &dev) == 0, "blocks 2-5 hit after inserting 0-3");
+  expect(dev.stat.num_buffer_partial_hits == 1, "blocks 2-5 not a partial hit");
+}
+
+static void test_random(int numsegs, int segsize, int maxblk, int ops) {
+  mems_t dev;
+  int i;
+
+  setup_buffer(&dev, numsegs, segsize);
+  srand48(numsegs);
+  for (i = 0; i < ops; i++) {
+    int first = lrand48() % maxblk;
+    int last = first + (lrand48() % segsize);
+    int found = scan_found(&dev, first, last);
+    int hits = dev.stat.num_buffer_hit_blocks;
+    int ret = mems_buffer_check(first, last, &dev);
+
+    if ((dev.stat.num_buffer_hit_blocks - hits != found) ||
+	(ret != (found == (last - first + 1)))) {
+      printf("FAIL: %d segments, check %d-%d found %d, expected %d\n",
+	     numsegs, first, last, dev.stat.num_buffer_hit_blocks - hits, found);
+      failures++;
+      return;
+    }
+    mems_buffer_insert(first, last, &dev);
+  }
+}
+
+/* After every insert, look up each block of a small range one by one */
+static void test_sweep(int seed, int ops) {
+  mems_t dev;
+  int numsegs = 2 + (seed % 7);
+  int segsize = 2 + (seed % 5);
+  int i, blk;
+
+  setup_buffer(&dev, numsegs, segsize);
+  srand48(seed);
+  for (i = 0; i < ops; i++) {
+    int first = lrand48() % 40;
+
+    mems_buffer_insert(first, first + (lrand48() % segsize), &dev);
+    for (blk = 0; blk < 40 + segsize; blk++) {
+      if (mems_buffer_check(blk, blk, &dev) != scan_found(&dev, blk, blk)) {
+	printf("FAIL: seed %d, block %d after %d inserts\n", seed, blk, i + 1);
+	failures++;
+	return;
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+
+  test_cold();
+  test_random(1, 8, 64, 10000);
+  test_random(4, 16, 256, 10000);
+  test_random(64, 32, 4096, 100000);
+  for (i = 0; i < 2000; i++) {
+    test_sweep(i, 200);
+  }
+  printf("%s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
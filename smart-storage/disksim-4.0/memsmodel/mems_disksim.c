@@ -41,6 +41,7 @@
 #include "mems_global.h"
 #include "mems_internals.h"
 #include "mems_mapping.h"
+#include "mems_buffer.h"
 #include "disksim_ioqueue.h"	/* Provides ioqueue_cleanstats() */
 #include "disksim_bus.h"	/* Provides bus_get_transfer_time() */
 
@@ -449,6 +450,9 @@ mems_statinit (int devno, int firsttime)
   dev->stat.num_spindowns  = 0;
   dev->stat.num_buffer_accesses = 0;
   dev->stat.num_buffer_hits     = 0;
+  dev->stat.num_buffer_partial_hits = 0;
+  dev->stat.num_buffer_blocks     = 0;
+  dev->stat.num_buffer_hit_blocks = 0;
   dev->stat.num_initial_turnarounds = 0;
   dev->stat.num_stream_turnarounds  = 0;
 
@@ -506,6 +510,9 @@ mems_statinit (int devno, int firsttime)
     dev->sled[j].stat.num_spindowns  = 0;
     dev->sled[j].stat.num_buffer_accesses = 0;
     dev->sled[j].stat.num_buffer_hits     = 0;
+    dev->sled[j].stat.num_buffer_partial_hits = 0;
+    dev->sled[j].stat.num_buffer_blocks     = 0;
+    dev->sled[j].stat.num_buffer_hit_blocks = 0;
     dev->sled[j].stat.num_initial_turnarounds = 0;
     dev->sled[j].stat.num_stream_turnarounds  = 0;
   }
@@ -923,6 +930,9 @@ mems_buffer_printstats (int *set, int setsize, char *prefix)
   mems_t *dev;
   int total_accesses = 0;
   int total_hits     = 0;
+  int total_partial  = 0;
+  int total_blocks   = 0;
+  int total_hitblks  = 0;
   double hit_ratio;
 
   /* Overall statistics */
@@ -931,6 +941,9 @@ mems_buffer_printstats (int *set, int setsize, char *prefix)
     dev = getmems(set[i]);
     total_accesses += dev->stat.num_buffer_accesses;
     total_hits += dev->stat.num_buffer_hits;
+    total_partial += dev->stat.num_buffer_partial_hits;
+    total_blocks += dev->stat.num_buffer_blocks;
+    total_hitblks += dev->stat.num_buffer_hit_blocks;
   }
   hit_ratio = (double)total_hits / (double)total_accesses;
 
@@ -942,6 +955,10 @@ mems_buffer_printstats (int *set, int setsize, char *prefix)
 	  prefix, hit_ratio);
   fprintf(outputfile, "%sBuffer miss ratio:         %f\n", 
 	  prefix, 1.0 - hit_ratio);
+  fprintf(outputfile, "%sNumber of partial hits:    %d\n",
+	  prefix, total_partial);
+  fprintf(outputfile, "%sBuffer block hit ratio:    %f\n",
+	  prefix, (total_blocks ? ((double)total_hitblks / (double)total_blocks) : 0.0));
   fprintf(outputfile, "\n");
 
   /* Per-device statistics */
@@ -1288,7 +1305,7 @@ struct mems *memsmodel_mems_loadparams(struct lp_block *b,
 
 
   for(c = 0; c < result->num_sleds; c++) {
-    memcpy(&result->sled[c], &result->sled[0], result->num_sleds * sizeof(mems_sled_t));
+    memcpy(&result->sled[c], &result->sled[0], sizeof(mems_sled_t));
     result->sled[c].queue = ioqueue_copy(result->queue);
   }
 
@@ -1302,7 +1319,8 @@ mems_t *mems_copy(mems_t *src) {
   bzero(result, sizeof(mems_t));
   memcpy(result, src, sizeof(mems_t));
   result->queue = ioqueue_copy(src->queue);
-  memcpy(&result->sled, src->sled, src->num_sleds * sizeof(mems_sled_t));
+  result->sled = malloc(src->num_sleds * sizeof(mems_sled_t));
+  memcpy(result->sled, src->sled, src->num_sleds * sizeof(mems_sled_t));
   return result;
 }
 
@@ -1315,7 +1333,6 @@ mems_initialize (void)
 {
   int i;
   int j;
-  int k;
   mems_t *dev;
 
   if (disksim->memsinfo == NULL) return;
@@ -1332,23 +1349,8 @@ mems_initialize (void)
       dev->dataxfer_req = NULL;
       dev->dataxfer_queue = NULL;
 
-      /* Segment initialization stuff taken in part from disksim_disk.c */
       if ((dev->numsegs > 0) && (dev->seglist == NULL)) {
-	dev->seglist = (struct mems_segment *)DISKSIM_malloc(sizeof(struct mems_segment));
-	dev->seglist->next = NULL;
-	dev->seglist->prev = NULL;
-	dev->seglist->time = 0.0;
-	dev->seglist->startblkno = 0;
-	dev->seglist->endblkno   = 0;
-	for (k = 1; k < dev->numsegs; k++) {
-	  struct mems_segment *tmpseg = (struct mems_segment *)DISKSIM_malloc(sizeof(struct mems_segment));
-	  tmpseg->next = dev->seglist;
-	  dev->seglist = tmpseg;
-	  tmpseg->next->prev = tmpseg;
-	  tmpseg->prev = NULL;
-	  tmpseg->startblkno = 0;
-	  tmpseg->endblkno   = 0;
-	}
+	mems_buffer_initialize(dev);
       }
       if (dev->numsegs == 0) addlisttoextraq((event **)&dev->seglist);
 
@@ -1374,6 +1376,10 @@ mems_initialize (void)
       if (dev->precompute_seek_count > 0) {
 	mems_precompute_seek_curve(dev);
       }
+      if ((dev->seek_surface_points > 0) &&
+	  (dev->x_seek_surface.times == NULL)) {
+	mems_precompute_seek_surface(dev);
+      }
     }
   }
 }
@@ -482,7 +482,12 @@ mems_seek_time (mems_sled_t *sled,
 	+
 	settling_time_x;
     } else {
-      if (sled->dev->precompute_seek_count > 0) {
+      if ((sled->dev->seek_surface_points > 0) &&
+	  mems_find_seek_surface_time(sled,
+				      (begin->x_pos * bit_width), (end->x_pos * bit_width),
+				      _X_SEEK_, &seek_time_x)) {
+	seek_time_x += settling_time_x;
+      } else if (sled->dev->precompute_seek_count > 0) {
 	seek_time_x =
 	  mems_find_precomputed_seek_time(sled,
 					  (begin->x_pos * bit_width), (end->x_pos * bit_width),
@@ -674,7 +679,12 @@ mems_seek_time (mems_sled_t *sled,
       +
       turnaround_time;
   } else {
-    if (sled->dev->precompute_seek_count > 0) {
+    if ((sled->dev->seek_surface_points > 0) &&
+	mems_find_seek_surface_time(sled,
+				    (begin->y_pos * bit_width), (end->y_pos * bit_width),
+				    _Y_SEEK_, &seek_time_y)) {
+      seek_time_y += turnaround_time;
+    } else if (sled->dev->precompute_seek_count > 0) {
       seek_time_y =
 	mems_find_precomputed_seek_time(sled,
 					(begin->y_pos * bit_width), (end->y_pos * bit_width),
@@ -748,22 +758,31 @@ mems_seek_time_seekcache (mems_sled_t *sled,
 			  int *return_turnaround_number)
 {
   struct mems_seekcache *s;
-  int i;
-
-  /* First check if value is cached */
-  for (i = 0; i < MEMS_SEEKCACHE; i++) {
-    s = &sled->seekcache[i];
-    if (mems_equal_coords(begin, &s->begin) &&
-	mems_equal_coords(end, &s->end)) {
-      if (return_x_seek_time) *return_x_seek_time = s->x_seek_time;
-      if (return_y_seek_time) *return_y_seek_time = s->y_seek_time;
-      if (return_turnaround_time) *return_turnaround_time = s->turnaround_time;
-      if (return_turnaround_number) *return_turnaround_number = s->turnaround_number;
-      return s->time;
-    }
+  unsigned int h;
+
+  /* The cache is direct-mapped on a hash of both coordinates, so a
+   * lookup is one probe however many entries there are.  SPTF probes
+   * the same (position, candidate) pairs repeatedly while a queue
+   * drains, so most probes hit. */
+  h = (unsigned int)begin->x_pos * 0x9e3779b1U;
+  h ^= (unsigned int)begin->y_pos * 0x85ebca77U;
+  h ^= (unsigned int)end->x_pos * 0xc2b2ae3dU;
+  h ^= (unsigned int)end->y_pos * 0x27d4eb2fU;
+  h ^= (unsigned int)(((begin->y_vel > 0) << 1) | (end->y_vel > 0));
+  h ^= h >> 15;
+  s = &sled->seekcache[h & (MEMS_SEEKCACHE - 1)];
+
+  if (s->valid &&
+      mems_equal_coords(begin, &s->begin) &&
+      mems_equal_coords(end, &s->end)) {
+    if (return_x_seek_time) *return_x_seek_time = s->x_seek_time;
+    if (return_y_seek_time) *return_y_seek_time = s->y_seek_time;
+    if (return_turnaround_time) *return_turnaround_time = s->turnaround_time;
+    if (return_turnaround_number) *return_turnaround_number = s->turnaround_number;
+    return s->time;
   }
 
-  s = &sled->seekcache[sled->seekcache_next];
+  s->valid = TRUE;
   mems_coord_t_copy(begin, &s->begin);
   mems_coord_t_copy(end, &s->end);
   s->time = mems_seek_time(sled, &s->begin, &s->end, &s->x_seek_time, &s->y_seek_time, &s->turnaround_time, &s->turnaround_number);
@@ -771,8 +790,6 @@ mems_seek_time_seekcache (mems_sled_t *sled,
   if (return_y_seek_time) *return_y_seek_time = s->y_seek_time;
   if (return_turnaround_time) *return_turnaround_time = s->turnaround_time;
   if (return_turnaround_number) *return_turnaround_number = s->turnaround_number;
-  sled->seekcache_next++;
-  if (sled->seekcache_next == MEMS_SEEKCACHE) sled->seekcache_next = 0;
   // fprintf(stderr, "mems_seek_time_seekcache::  s->time = %f\n", s->time);
   return s->time;
 }
@@ -793,6 +810,26 @@ mems_print_precomputed_seek_times(mems_t *dev) {
 
 }
 
+/* Base seek time (seconds, without settling or turnarounds) straight
+ * from the piecewise solver, for one axis. */
+static double
+mems_solve_seek_time(mems_sled_t *sled,
+		     double start_offset_nm, double end_offset_nm,
+		     int direction)
+{
+  if (direction == _X_SEEK_) {
+    return find_seek_time_piecewise(start_offset_nm, end_offset_nm,
+				    sled->spring_factor,
+				    (double)sled->x_accel_nm_s2,
+				    sled->x_length_nm, 0.0);
+  }
+  return find_seek_time_piecewise(start_offset_nm, end_offset_nm,
+				  sled->spring_factor,
+				  (double)sled->y_accel_nm_s2,
+				  sled->y_length_nm,
+				  (double)(sled->y_access_speed_bit_s * sled->bit_length_nm));
+}
+
 double
 mems_find_precomputed_seek_time(mems_sled_t *sled,
 				double start_offset_nm, double end_offset_nm,
@@ -817,53 +854,35 @@ mems_find_precomputed_seek_time(mems_sled_t *sled,
   // mems_print_precomputed_seek_times(dev);
 
   if (dist_nm) {
-    for (i=0; i <= dev->precompute_seek_count; i++) {
-      /*
-      printf("i = %d, dist = %d, x_seek = %f, y_seek = %f\n",
-	     i, dev->precompute_seek_distances[i], dev->precompute_x_seek_times[i], dev->precompute_y_seek_times[i]);
-      */
-      if (dist_nm <= dev->precompute_seek_distances[i]) {
-	if (dist_nm == dev->precompute_seek_distances[i]) {
-	  // fprintf(stderr, "found precomputed seek distance %d\n", dist_nm);
-	  seektime = (direction == _X_SEEK_) ?
-	    dev->precompute_x_seek_times[i] :
-	    dev->precompute_y_seek_times[i];
-	} else {
-	  double ddiff =
-	    (double) (dist_nm - dev->precompute_seek_distances[(i-1)])
-	    /
-	    (double) (dev->precompute_seek_distances[i] - dev->precompute_seek_distances[(i-1)]);
-	  /*
-	  fprintf(stderr, "did not find precompute seek distance %d\n", dist_nm);
-	  fprintf(stderr, "ddiff = %f\n", ddiff);
-	  fprintf(stderr, "i = %d\n", i);
-	  */
-	  if (direction == _X_SEEK_) {
-	    seektime = dev->precompute_x_seek_times[(i-1)];
-	    // fprintf(stderr, "seektime = %f\n", seektime);	    
-	    seektime += ddiff * (dev->precompute_x_seek_times[i] - dev->precompute_x_seek_times[(i-1)]);
-	    /*
-	    fprintf(stderr, "times[i] = %f, times[i-1] = %f\n",
-		    dev->precompute_x_seek_times[i], dev->precompute_x_seek_times[(i-1)]);
-	    fprintf(stderr, "seektime = %f\n", seektime);
-	    */
-	  } else {
-	    seektime = dev->precompute_y_seek_times[(i-1)];
-	    // fprintf(stderr, "seektime = %f\n", seektime);
-	    seektime += ddiff * (dev->precompute_y_seek_times[i] - dev->precompute_y_seek_times[(i-1)]);
-	    /*
-	    fprintf(stderr, "times[i] = %f, times[i-1] = %f\n",
-		    dev->precompute_y_seek_times[i], dev->precompute_y_seek_times[(i-1)]);
-	    fprintf(stderr, "seektime = %f\n", seektime);
-	    */
-	  }
-	}
-	break;
+    int lo = 0;
+    int hi = dev->precompute_seek_count;
+    double *times = (direction == _X_SEEK_) ?
+      dev->precompute_x_seek_times : dev->precompute_y_seek_times;
+
+    if (dist_nm > dev->precompute_seek_distances[hi]) {
+      /* Beyond the end of the curve; solve this one directly. */
+      return mems_solve_seek_time(sled, start_offset_nm, end_offset_nm, direction);
+    }
+
+    /* Binary search for the first point at or beyond dist_nm */
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (dev->precompute_seek_distances[mid] < dist_nm) {
+	lo = mid + 1;
+      } else {
+	hi = mid;
       }
     }
-    if (seektime == 0.0) {
-      fprintf(stderr, "Seek distance exceeds precompute seek curve: %d\n", dist_nm);
-      exit(0);
+    i = lo;
+
+    if ((i == 0) || (dist_nm == dev->precompute_seek_distances[i])) {
+      seektime = times[i];
+    } else {
+      double ddiff =
+	(double) (dist_nm - dev->precompute_seek_distances[(i-1)])
+	/
+	(double) (dev->precompute_seek_distances[i] - dev->precompute_seek_distances[(i-1)]);
+      seektime = times[(i-1)] + ddiff * (times[i] - times[(i-1)]);
     }
   }
 
@@ -1007,3 +1026,109 @@ mems_precompute_seek_curve(mems_t *dev) {
   dev->precompute_seek_count = precompute_seek_count;
 
 }
+
+/*-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ *  Precomputed seek surface
+ *
+ *  Unlike the seek curve above, which depends on the seek distance
+ *  only, the surface samples the piecewise solver over a grid of
+ *  (start, end) offsets covering the whole sled, so the position
+ *  dependence of the spring force is kept.  Times are bilinearly
+ *  interpolated between grid points.  Each cell is checked at its
+ *  centre when the surface is built; cells where interpolation is off
+ *  by more than MEMS_SEEK_SURFACE_TOLERANCE (and the cells on the
+ *  diagonal, where seek time has a cusp) are marked to be solved
+ *  exactly instead.
+ *-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-*/
+
+static double
+mems_seek_surface_interpolate(struct mems_seek_surface *surf, int n,
+			      int i, int j, double t, double u)
+{
+  double *v = surf->times;
+
+  return ((1.0 - t) * (1.0 - u) * v[i * n + j]
+	  + t * (1.0 - u) * v[(i + 1) * n + j]
+	  + (1.0 - t) * u * v[i * n + j + 1]
+	  + t * u * v[(i + 1) * n + j + 1]);
+}
+
+static void
+mems_build_seek_surface(mems_t *dev, struct mems_seek_surface *surf,
+			int length_nm, int direction)
+{
+  mems_sled_t *sled = &dev->sled[0];
+  int n = dev->seek_surface_points;
+  int i, j;
+
+  surf->min_nm = -(double)length_nm / 2.0;
+  surf->step_nm = (double)length_nm / (double)(n - 1);
+  surf->times = (double *)malloc(n * n * sizeof(double));
+  surf->exact = (char *)malloc((n - 1) * (n - 1) * sizeof(char));
+
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++) {
+      surf->times[i * n + j] = (i == j) ? 0.0 :
+	mems_solve_seek_time(sled,
+			     surf->min_nm + i * surf->step_nm,
+			     surf->min_nm + j * surf->step_nm,
+			     direction);
+    }
+  }
+
+  for (i = 0; i < (n - 1); i++) {
+    for (j = 0; j < (n - 1); j++) {
+      double exact, approx;
+
+      if (i == j) {
+	surf->exact[i * (n - 1) + j] = TRUE;
+	continue;
+      }
+      exact = mems_solve_seek_time(sled,
+				   surf->min_nm + (i + 0.5) * surf->step_nm,
+				   surf->min_nm + (j + 0.5) * surf->step_nm,
+				   direction);
+      approx = mems_seek_surface_interpolate(surf, n, i, j, 0.5, 0.5);
+      surf->exact[i * (n - 1) + j] =
+	(fabs(approx - exact) > (MEMS_SEEK_SURFACE_TOLERANCE * exact));
+    }
+  }
+}
+
+void
+mems_precompute_seek_surface(mems_t *dev)
+{
+  mems_build_seek_surface(dev, &dev->x_seek_surface,
+			  dev->sled[0].x_length_nm, _X_SEEK_);
+  mems_build_seek_surface(dev, &dev->y_seek_surface,
+			  dev->sled[0].y_length_nm, _Y_SEEK_);
+}
+
+/* Returns TRUE and the base seek time in seconds via *seektime, or
+ * FALSE if the seek falls in a cell that has to be solved exactly. */
+int
+mems_find_seek_surface_time(mems_sled_t *sled,
+			    double start_offset_nm, double end_offset_nm,
+			    int direction, double *seektime)
+{
+  mems_t *dev = sled->dev;
+  struct mems_seek_surface *surf = (direction == _X_SEEK_) ?
+    &dev->x_seek_surface : &dev->y_seek_surface;
+  int n = dev->seek_surface_points;
+  double fi = (start_offset_nm - surf->min_nm) / surf->step_nm;
+  double fj = (end_offset_nm - surf->min_nm) / surf->step_nm;
+  int i = (int)fi;
+  int j = (int)fj;
+
+  if ((fi < 0.0) || (fj < 0.0) || (i > (n - 1)) || (j > (n - 1))) {
+    return FALSE;
+  }
+  if (i == (n - 1)) i--;
+  if (j == (n - 1)) j--;
+  if (surf->exact[i * (n - 1) + j]) {
+    return FALSE;
+  }
+  *seektime = mems_seek_surface_interpolate(surf, n, i, j, fi - i, fj - j);
+  return TRUE;
+}
+
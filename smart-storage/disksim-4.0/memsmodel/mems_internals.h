@@ -214,6 +214,10 @@ void mems_commit_move(mems_sled_t *sled,
 		      coord_t *pos);
 
 void mems_precompute_seek_curve(mems_t *dev);
+void mems_precompute_seek_surface(mems_t *dev);
+int mems_find_seek_surface_time(mems_sled_t *sled,
+				double start_offset_nm, double end_offset_nm,
+				int direction, double *seektime);
 
 double mems_find_precomputed_seek_time(mems_sled_t *sled,
 				       double start_offset_nm,
@@ -22,6 +22,17 @@ if (! ((i >= 0))) { // foo
 
 }
 
+static int MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_SURFACE_depend(char *bv) {
+return -1;
+}
+
+static void MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_SURFACE_loader(struct mems * result, int i) { 
+if (! ((i == 0) || (i >= 2))) { // foo 
+ } 
+ result->seek_surface_points = i;
+
+}
+
 static int MEMSMODEL_MEMS_SEEK_FUNCTION_depend(char *bv) {
 return -1;
 }
@@ -379,6 +390,7 @@ if (! ((d >= 0.0))) { // foo
 void * MEMSMODEL_MEMS_loaders[] = {
 (void *)MEMSMODEL_MEMS_SCHEDULER_loader,
 (void *)MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_CURVE_loader,
+(void *)MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_SURFACE_loader,
 (void *)MEMSMODEL_MEMS_SEEK_FUNCTION_loader,
 (void *)MEMSMODEL_MEMS_MAX_QUEUE_LENGTH_loader,
 (void *)MEMSMODEL_MEMS_BULK_SECTOR_TRANSFER_TIME_loader,
@@ -414,6 +426,7 @@ void * MEMSMODEL_MEMS_loaders[] = {
 lp_paramdep_t MEMSMODEL_MEMS_deps[] = {
 MEMSMODEL_MEMS_SCHEDULER_depend,
 MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_CURVE_depend,
+MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_SURFACE_depend,
 MEMSMODEL_MEMS_SEEK_FUNCTION_depend,
 MEMSMODEL_MEMS_MAX_QUEUE_LENGTH_depend,
 MEMSMODEL_MEMS_BULK_SECTOR_TRANSFER_TIME_depend,
@@ -14,6 +14,7 @@ struct mems *memsmodel_mems_loadparams(struct lp_block *b, int *num);
 typedef enum {
    MEMSMODEL_MEMS_SCHEDULER,
    MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_CURVE,
+   MEMSMODEL_MEMS_POINTS_IN_PRECOMPUTED_SEEK_SURFACE,
    MEMSMODEL_MEMS_SEEK_FUNCTION,
    MEMSMODEL_MEMS_MAX_QUEUE_LENGTH,
    MEMSMODEL_MEMS_BULK_SECTOR_TRANSFER_TIME,
@@ -54,6 +55,7 @@ extern lp_paramdep_t MEMSMODEL_MEMS_deps[];
 static struct lp_varspec memsmodel_mems_params [] = {
    {"Scheduler", BLOCK, 1 },
    {"Points in precomputed seek curve", I, 1 },
+   {"Points in precomputed seek surface", I, 0 },
    {"Seek function", I, 1 },
    {"Max queue length", I, 1 },
    {"Bulk sector transfer time", D, 1 },
@@ -86,7 +88,7 @@ static struct lp_varspec memsmodel_mems_params [] = {
    {"Tip access power", D, 1 },
    {0,0,0}
 };
-#define MEMSMODEL_MEMS_MAX 32
+#define MEMSMODEL_MEMS_MAX 33
 static struct lp_mod memsmodel_mems_mod = { "memsmodel_mems", memsmodel_mems_params, MEMSMODEL_MEMS_MAX, (lp_modloader_t)memsmodel_mems_loadparams,  0, 0, MEMSMODEL_MEMS_loaders, MEMSMODEL_MEMS_deps };
 
 
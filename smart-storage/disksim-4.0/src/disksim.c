@@ -102,6 +102,8 @@
 #include "disksim_ioface.h"
 #include "disksim_pfface.h"
 #include "disksim_iotrace.h"
+#include "disksim_openloop.h"
+#include "disksim_telemetry.h"
 #include "config.h"
 
 #include "modules/disksim_global_param.h"
@@ -544,6 +546,7 @@ void disksim_printstats2()
    if (disksim->external_control | disksim->synthgen | disksim->iotrace) {
       io_printstats();
    }
+   openloop_printstats(outputfile);
 }
 
 
@@ -564,12 +567,14 @@ static void setcallbacks ()
    disksim->timerfunc_ioqueue = NULL;
    disksim->timerfunc_cachemem = NULL;
    disksim->timerfunc_cachedev = NULL;
+   disksim->timerfunc_telemetry = NULL;
 
    disksim->timerfunc_disksim = stat_warmup_done;
    disksim->external_io_done_notify = NULL;
 
    io_setcallbacks();
    pf_setcallbacks();
+   telemetry_setcallbacks();
 }
 
 
@@ -589,6 +594,9 @@ static void initialize ()
    } else {
       DISKSIM_srand48(disksim->seedval);
    }
+   if (disksim->openloop_info) {
+      openloop_initialize();
+   }
    simtime = 0.0;
 }
 
@@ -729,6 +737,7 @@ static void prime_simulation ()
    if (disksim->checkpoint_interval > 0.0) {
       disksim_register_checkpoint (disksim->checkpoint_interval);
    }
+   telemetry_initialize();
    if (disksim->iotrace) {
       if ((curr = io_get_next_external_event(disksim->iotracefile)) == NULL) {
          disksim_cleanstats();
@@ -871,7 +880,11 @@ static void disksim_setup_outputfile (char *filename, char *mode)
 
 static void disksim_setup_iotracefile (char *filename)
 {
-   if (strcmp(filename, "0") != 0) {
+   if (disksim->traceformat == OPENLOOP) {
+      assert (disksim->external_control == 0);
+      disksim->iotrace = 1;
+      disksim->iotracefile = NULL;
+   } else if (strcmp(filename, "0") != 0) {
       assert (disksim->external_control == 0);
       disksim->iotrace = 1;
       if (strcmp(filename, "stdin") == 0) {
@@ -1090,6 +1103,7 @@ void disksim_cleanup(void)
   
   
   iodriver_cleanup();
+  telemetry_cleanup();
   
   if(outios) 
   {
@@ -1126,6 +1140,8 @@ disksim_initialize_disksim_structure (struct disksim *disksim)
    simtime = 0.0;	/* gets remapped to disksim->warmuptime */
    disksim->lastphystime = 0.0;
    disksim->checkpoint_interval = 0.0;
+   disksim->stat_quantiles = 0;
+   disksim->stat_window = 0.0;
 
    return 0;
 }
@@ -587,12 +587,28 @@ int disksim_bus_stats_loadparams(struct lp_block *b) {
 
 
 
+/* Idle time accumulated since the last stats reset, including the */
+/* current idle period if the bus is free.                          */
+
+static double bus_get_idletime (struct bus *currbus)
+{
+   double idletime = currbus->runidletime;
+
+   if (currbus->state == BUS_FREE) {
+      idletime += simtime - currbus->lastowned;
+   }
+   return(idletime);
+}
+
+
 void bus_resetstats()
 {
    int i;
 
    for (i=0; i<numbuses; i++) {
       struct bus *currbus = getbus(i);
+      /* keep telemetry deltas continuous across the reset */
+      currbus->telemidle -= bus_get_idletime(currbus);
       currbus->lastowned = simtime;
       currbus->runidletime = 0.0;
       stat_reset (&currbus->busidlestats);
@@ -662,6 +678,26 @@ void bus_cleanstats()
    }
 }
 
+
+/* Telemetry columns: fraction of the last interval each bus was owned. */
+void bus_telemetry (FILE *outfile, int header, double interval)
+{
+   int i;
+   double idletime;
+
+   for (i=0; i<numbuses; i++) {
+      struct bus *currbus = getbus(i);
+      if (header) {
+         fprintf (outfile, ",bus%d_util", i);
+         currbus->telemidle = bus_get_idletime(currbus);
+         continue;
+      }
+      idletime = bus_get_idletime(currbus);
+      fprintf (outfile, ",%.4f", ((interval > 0.0) ? (1.0 - ((idletime - currbus->telemidle) / interval)) : 0.0));
+      currbus->telemidle = idletime;
+   }
+}
+
 bus *bus_copy(bus *orig) {
   bus *result = malloc(sizeof(bus));
   if(result) return memcpy(result, orig, sizeof(bus));
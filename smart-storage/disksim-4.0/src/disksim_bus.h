@@ -157,6 +157,7 @@ typedef struct bus {
   double	runidletime;
   statgen	arbwaitstats;
   statgen	busidlestats;
+  double        telemidle;	/* idle time at the last telemetry sample */
   char         *name;
 } bus;
 
@@ -184,6 +185,7 @@ void    bus_initialize (void);
 void    bus_resetstats (void);
 void    bus_printstats (void);
 void    bus_cleanstats (void);
+void    bus_telemetry (FILE *outfile, int header, double interval);
 struct bus *getbusbyname(char *name, int *num);
 
 int load_bus_topo(struct lp_topospec *t, int *parentctlno); 
@@ -149,6 +149,9 @@ struct cache_if {
   int (*cache_sync)(struct cache_if *cache);
 
   int (*cache_get_maxreqsize)(struct cache_if *cache);
+
+  /* number of valid blocks currently cached; dirty blocks in *dirty */
+  int (*cache_get_occupancy)(struct cache_if *cache, int *dirty);
 };
 
 struct cache_if *disksim_cache_loadparams(struct lp_block *b);
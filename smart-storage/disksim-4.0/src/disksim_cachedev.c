@@ -187,30 +187,40 @@ static struct cache_dev_event * cachedev_find_ongoing_request (struct cache_dev
 }
 
 
-/* Return a count of how many dirty blocks are on the cachedev. */
-static int cachedev_count_dirty_blocks (struct cache_dev *cache)
+static int cachedev_get_occupancy (struct cache_if *c, int *dirty)
 {
-   int dirtyblocks = 0;
-   int i;
+   struct cache_dev *cache = (struct cache_dev *)c;
 
-   for (i=0; i<cache->size; i++) {
-      if (bit_test(cache->dirtymap,i)) {
-         dirtyblocks++;
-      }
-   }
-   return (dirtyblocks);
+   *dirty = cache->dirtyblocks;
+   return (cache->validblocks);
 }
 
 
-static void cachedev_setbits (bitstr_t *bitmap, ioreq_event *req)
+/* Set the request's blocks in bitmap, adding newly set ones to *count */
+static void cachedev_setbits (bitstr_t *bitmap, int *count, ioreq_event *req)
 {
-   bit_nset (bitmap, req->blkno, (req->blkno+req->bcount-1));
+   int i;
+
+   for (i=req->blkno; i<(req->blkno+req->bcount); i++) {
+      if (bit_test(bitmap,i) == 0) {
+         bit_set(bitmap,i);
+         (*count)++;
+      }
+   }
 }
 
 
-static void cachedev_clearbits (bitstr_t *bitmap, ioreq_event *req)
+/* Clear the request's blocks in bitmap, taking cleared ones off *count */
+static void cachedev_clearbits (bitstr_t *bitmap, int *count, ioreq_event *req)
 {
-   bit_nclear (bitmap, req->blkno, (req->blkno+req->bcount-1));
+   int i;
+
+   for (i=req->blkno; i<(req->blkno+req->bcount); i++) {
+      if (bit_test(bitmap,i)) {
+         bit_clear(bitmap,i);
+         (*count)--;
+      }
+   }
 }
 
 
@@ -510,8 +520,8 @@ cachedev_disk_access_complete (struct cache_if *c,
 
       /* finished writing to cache-device */
       if (curr->devno == cache->cache_devno) {
-         cachedev_setbits (cache->validmap, curr);
-         cachedev_setbits (cache->dirtymap, curr);
+         cachedev_setbits (cache->validmap, &cache->validblocks, curr);
+         cachedev_setbits (cache->dirtymap, &cache->dirtyblocks, curr);
          if (cache->writescheme == CACHE_WRITE_THRU) {
             ioreq_event *flushreq = ioreq_copy(rwdesc->req);
             flushreq->type = IO_ACCESS_ARRIVE;
@@ -535,19 +545,19 @@ cachedev_disk_access_complete (struct cache_if *c,
       break;
 
    case CACHE_EVENT_POPULATE_ONLY:
-     cachedev_setbits (cache->validmap, curr);
+     cachedev_setbits (cache->validmap, &cache->validblocks, curr);
      cachedev_remove_ongoing_request (cache, rwdesc);
       addtoextraq ((event *) rwdesc);
       cache->bufferspace -= curr->bcount;
       break;
       
    case CACHE_EVENT_POPULATE_ALSO:
-     cachedev_setbits (cache->validmap, curr);
+     cachedev_setbits (cache->validmap, &cache->validblocks, curr);
      rwdesc->type = CACHE_EVENT_READ;
      break;
 
    case CACHE_EVENT_FLUSH:
-      cachedev_clearbits (cache->dirtymap, curr);
+      cachedev_clearbits (cache->dirtymap, &cache->dirtyblocks, curr);
       cachedev_remove_ongoing_request (cache, rwdesc);
       addtoextraq ((event *) rwdesc);
       cache->bufferspace -= curr->bcount;
@@ -566,7 +576,7 @@ cachedev_disk_access_complete (struct cache_if *c,
      } break;
 
    case CACHE_EVENT_IDLEFLUSH_FLUSH:
-     cachedev_clearbits (cache->dirtymap, curr);
+     cachedev_clearbits (cache->dirtymap, &cache->dirtyblocks, curr);
      cachedev_remove_ongoing_request (cache, rwdesc);
      addtoextraq ((event *) rwdesc);
      cachedev_idlework_callback (cache, curr->devno);
@@ -670,6 +680,8 @@ cachedev_initialize (struct cache_if *c,
    cache->ongoing_requests = NULL;
    bzero (cache->validmap, bitstr_size(cache->size));
    bzero (cache->dirtymap, bitstr_size(cache->size));
+   cache->validblocks = 0;
+   cache->dirtyblocks = 0;
    cachedev_resetstats(c);
 
    if (cache->flush_idledelay) {
@@ -734,7 +746,7 @@ cachedev_printstats (struct cache_if *c, char *prefix)
 
       fprintf(outputfile, "%scache block destages (write): %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.destagewriteblocks, ((double) cache->stat.destagewriteblocks / (double) blocks), ((double) cache->stat.destagewriteblocks / (double) cache->stat.writeblocks));
 
-      fprintf(outputfile, "%scache end dirty blocks:      %6d  \t%6.4f\n", prefix, cachedev_count_dirty_blocks(cache), ((double) cachedev_count_dirty_blocks(cache) / (double) cache->stat.writeblocks));
+      fprintf(outputfile, "%scache end dirty blocks:      %6d  \t%6.4f\n", prefix, cache->dirtyblocks, ((double) cache->dirtyblocks / (double) cache->stat.writeblocks));
    }
 
    fprintf (outputfile, "%scache bufferspace use end:             %6d\n", prefix, cache->bufferspace);
@@ -777,7 +789,8 @@ static struct cache_if disksim_cache_dev = {
   cachedev_disk_access_complete,
   cachedev_wakeup_complete,
   cachedev_sync,
-  cachedev_get_maxreqsize
+  cachedev_get_maxreqsize,
+  cachedev_get_occupancy
 };
 
 struct cache_if *disksim_cachedev_loadparams(struct lp_block *b)
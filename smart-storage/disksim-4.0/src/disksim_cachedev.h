@@ -188,6 +188,8 @@ struct cache_dev {
    struct cache_dev_event *ongoing_requests;
    bitstr_t *validmap;
    bitstr_t *dirtymap;
+   int validblocks;				/* bits set in validmap */
+   int dirtyblocks;				/* bits set in dirtymap */
    struct cache_dev_stats stat;
    char *name;
 };
@@ -150,6 +150,16 @@ int cachemem_get_maxreqsize (struct cache_if *c)
 }
 
 
+/* Counts are of resident (hashed) atoms, kept as their state changes */
+static int cachemem_get_occupancy (struct cache_if *c, int *dirty)
+{
+   struct cache_mem *cache = (struct cache_mem *)c;
+
+   *dirty = cache->dirtyatoms * cache->atomsize;
+   return(cache->validatoms * cache->atomsize);
+}
+
+
 static void cache_empty_donefunc (void *doneparam, ioreq_event *req)
 {
    addtoextraq((event *) req);
@@ -187,8 +197,35 @@ fprintf (outputfile, "IOwaiters %x, next %x, nextprev %x\n", cachereq, cachereq-
 }
 
 
+/* Add (sign 1) or remove (sign -1) an atom's VALID and DIRTY bits from the counts */
+static void cache_count_state (struct cache_mem *cache, int state, int sign)
+{
+   cache->validatoms += (state & CACHE_VALID) ? sign : 0;
+   cache->dirtyatoms += (state & CACHE_DIRTY) ? sign : 0;
+}
+
+
+/* Use for setting VALID and DIRTY on atoms in the hash */
+
+static void cache_atom_set_state (struct cache_mem *cache, cache_atom *atom, int mask)
+{
+   cache_count_state(cache, (mask & ~atom->state), 1);
+   atom->state |= mask;
+}
+
+
+/* Use for clearing VALID and DIRTY on atoms in the hash */
+
+static void cache_atom_reset_state (struct cache_mem *cache, cache_atom *atom, int mask)
+{
+   cache_count_state(cache, (mask & atom->state), -1);
+   atom->state &= ~mask;
+}
+
+
 static void cache_insert_new_into_hash (struct cache_mem *cache, cache_atom *new)
 {
+   cache_count_state(cache, new->state, 1);
    new->hash_next = cache->hash[(new->lbn & CACHE_HASHMASK)];
    cache->hash[(new->lbn & CACHE_HASHMASK)] = new;
    new->hash_prev = NULL;
@@ -203,6 +240,8 @@ static void cache_remove_entry_from_hash (struct cache_mem *cache, cache_atom *o
 	  /* Line must be in hash if to be removed! */
    ASSERT((old->hash_prev != NULL) || (old->hash_next != NULL) || (cache->hash[(old->lbn & CACHE_HASHMASK)] == old));
 
+   cache_count_state(cache, old->state, -1);
+
    if (old->hash_prev) {
       old->hash_prev->hash_next = old->hash_next;
    } else {
@@ -795,7 +834,7 @@ static int cache_flush_cluster (struct cache_mem *cache, int devno, int blkno, i
       }
       writelocked = cache_atom_iswritelocked(cache, line);
       if ((line->state & CACHE_DIRTY) && (!writelocked)) {
-         line->state &= ~CACHE_DIRTY;
+         cache_atom_reset_state(cache, line, CACHE_DIRTY);
 	 lastclean = 0;
 	 blkno = line->lbn;
       } else if ((writelocked) || (!(line->state & CACHE_VALID))) {
@@ -822,7 +861,7 @@ static int cache_initiate_dirty_block_flush (struct cache_mem *cache, cache_atom
    while (tmp) {
       int writelocked = cache_atom_iswritelocked(cache, tmp);
       if ((tmp->state & CACHE_DIRTY) && (!writelocked)) {
-         tmp->state &= ~CACHE_DIRTY;
+         cache_atom_reset_state(cache, tmp, CACHE_DIRTY);
          if (dirtystart == -1) {
             dirtyatom = tmp;
             dirtystart = tmp->lbn;
@@ -1298,7 +1337,7 @@ fprintf (outputfile, "already valid backwards: lbn %d\n", line->lbn);
             }
          }
          start--;
-         line->state |= CACHE_VALID;
+         cache_atom_set_state(cache, line, CACHE_VALID);
       }
 /* Need to free some locks if do this...
       if (validstart != -1) {
@@ -1337,7 +1376,7 @@ fprintf (outputfile, "already valid forwards: lbn %d\n", line->lbn);
             }
          }
          end++;
-         line->state |= CACHE_VALID;
+         cache_atom_set_state(cache, line, CACHE_VALID);
       }
 /* Need to free some locks if do this...
       if (validend != -1) {
@@ -1496,7 +1535,7 @@ read_cont_loop:
          }
          lockgran = cache->lockgran;
          if ((tmp->state & CACHE_VALID) == 0) {
-            tmp->state |= CACHE_VALID;
+            cache_atom_set_state(cache, tmp, CACHE_VALID);
             if (validpoint == -1) {
                validpoint = tmp->lbn;
                readdesc->validpoint = validpoint;
@@ -1629,7 +1668,7 @@ write_cont_loop:
          lockgran = cache->lockgran;
          if ((tmp->lbn < lbn) && ((tmp->state & CACHE_VALID) == 0)) {
             writedesc->allocstop |= 2;
-            tmp->state |= CACHE_VALID;
+            cache_atom_set_state(cache, tmp, CACHE_VALID);
             if (startfillstart == -1) {
                startfillstart = tmp->lbn;
             }
@@ -1638,7 +1677,7 @@ write_cont_loop:
             int tmpval = tmp->lbn - (lbn + size - 1);
             writedesc->allocstop |= 2;
             if ((tmpval > 0) && (tmpval < (cache->atomsperbit - ((lbn + size - 1) % cache->atomsperbit)))) {
-               tmp->state |= CACHE_VALID;
+               cache_atom_set_state(cache, tmp, CACHE_VALID);
                if (endfillstart == -1) {
                   endfillstart = tmp->lbn;
                }
@@ -1849,7 +1888,7 @@ cachemem_free_block_dirty (struct cache_if *c,
          line->busno = req->busno;
          line->slotno = req->slotno;
       }
-      line->state |= (writethru) ? CACHE_VALID : (CACHE_VALID|CACHE_DIRTY);
+      cache_atom_set_state(cache, line, ((writethru) ? CACHE_VALID : (CACHE_VALID|CACHE_DIRTY)));
       if (((line->lbn % cache->lockgran) != (cache->lockgran-1)) && (i != (flushbcount-1))) {
       } else if (writethru) {
          lockgran += cache_get_read_lock(cache, line, writedesc);
@@ -2178,6 +2217,8 @@ cachemem_initialize (struct cache_if *c,
    for (i=0; i<CACHE_HASHSIZE; i++) {
       cache->hash[i] = 0;
    }
+   cache->validatoms = 0;
+   cache->dirtyatoms = 0;
    for (j=0; j<(cache->mapmask+1); j++) {
       cache_mapentry *mapentry = &cache->map[j];
       for (i=0; i<CACHE_MAXSEGMENTS; i++) {
@@ -2424,7 +2465,8 @@ static struct cache_if disksim_cache_mem = {
   cachemem_disk_access_complete,
   cachemem_wakeup_complete,
   cachemem_sync,
-  cachemem_get_maxreqsize
+  cachemem_get_maxreqsize,
+  cachemem_get_occupancy
 };
 
 
@@ -197,6 +197,8 @@ typedef struct {                    /* per-set structure for set-associative */
 struct cache_mem {
   struct cache_if hdr;
    cache_atom *hash[CACHE_HASHSIZE];
+   int validatoms;				/* VALID atoms in hash */
+   int dirtyatoms;				/* DIRTY atoms in hash */
    void (**issuefunc)(void *,ioreq_event *);	/* to issue a disk access    */
    void *issueparam;				/* first param for issuefunc */
    struct ioq * (**queuefind)(void *,int);	/* to get ioqueue ptr for dev*/
@@ -778,6 +778,28 @@ void controller_cleanstats()
 }
 
 
+/* Telemetry columns: valid and dirty blocks in each controller cache. */
+void controller_telemetry (FILE *outfile, int header)
+{
+   int ctlno;
+   int valid;
+   int dirty;
+
+   for (ctlno=0; ctlno < disksim->ctlrinfo->numcontrollers; ctlno++) {
+      controller *currctlr = getctlr(ctlno);
+      if (currctlr->cache == NULL) {
+         continue;
+      }
+      if (header) {
+         fprintf (outfile, ",ctlr%d_cache_valid,ctlr%d_cache_dirty", ctlno, ctlno);
+      } else {
+         valid = currctlr->cache->cache_get_occupancy(currctlr->cache, &dirty);
+         fprintf (outfile, ",%d,%d", valid, dirty);
+      }
+   }
+}
+
+
 int load_ctlr_topo(struct lp_topospec *t, int *inbus) {
   int c;
   controller *ctlr;
@@ -113,6 +113,7 @@ void  controller_initialize (void);
 void  controller_resetstats (void);
 void  controller_printstats (void);
 void  controller_cleanstats (void);
+void  controller_telemetry (FILE *outfile, int header);
 int   controller_C700_based (int ctlno);
 int   controller_set_depth (int ctlno, int inbusno, int depth, int slotno);
 int   controller_get_numcontrollers (void);
@@ -173,6 +173,7 @@ typedef      unsigned u_int;
 #define EMCSYMM         9
 #define EMCBACKEND      10
 #define BATCH           11
+#define OPENLOOP        12
 #define DEFAULT		ASCII
 
 /* Time conversions */
@@ -335,6 +336,7 @@ struct ctlrinfo;
 struct pf_info;
 struct synthio_info;
 struct iotrace_info;
+struct openloop_info;
 struct rand48_info;
 
 typedef event*(*disksim_iodone_notify_t)(ioreq_event *, void *ctx);
@@ -385,6 +387,8 @@ typedef struct disksim {
    int    stop_sim;
    int    seedval;
    double lastphystime;
+   int    stat_quantiles;
+   double stat_window;
 
 /* call-back indirections for allowing checkpoint restores to deal with */
 /* functions whose addresses change on recompilation.                   */
@@ -403,6 +407,7 @@ typedef struct disksim {
    void         (*timerfunc_ioqueue)       (timer_event *);
    void         (*timerfunc_cachemem)      (timer_event *);
    void         (*timerfunc_cachedev)      (timer_event *);
+   void         (*timerfunc_telemetry)     (timer_event *);
 
 /* opaque structures for different modules */
    struct iosim_info *iosim_info;
@@ -417,6 +422,7 @@ typedef struct disksim {
    struct pf_info *pf_info;
    struct synthio_info *synthio_info;
    struct iotrace_info *iotrace_info;
+   struct openloop_info *openloop_info;
    struct rand48_info *rand48_info;
 
    char **overrides;
@@ -429,6 +435,11 @@ typedef struct disksim {
   FILE *exectrace;
   char *exectrace_fn;
 
+  FILE *telemetry;
+  char *telemetry_fn;
+  double telemetry_interval;
+  double telemetry_last;	/* time of the previous sample */
+
 } disksim_t;
 
 extern disksim_t *disksim;
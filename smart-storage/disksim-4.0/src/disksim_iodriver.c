@@ -1270,6 +1270,24 @@ void iodriver_cleanstats()
 }
 
 
+/* Telemetry columns: requests queued or outstanding per device queue. */
+void iodriver_telemetry (FILE *outfile, int header)
+{
+   int i;
+   int j;
+
+   for (i = 0; i < numiodrivers; i++) {
+      for (j = 0; j < iodrivers[i]->numdevices; j++) {
+         if (header) {
+            fprintf (outfile, ",drv%d_dev%d_queue", i, j);
+         } else {
+            fprintf (outfile, ",%d", ioqueue_get_number_in_queue(iodrivers[i]->devices[j].queue));
+         }
+      }
+   }
+}
+
+
 void iodriver_cleanup(void) {
   int i;
 
@@ -217,6 +217,7 @@ void    iodriver_initialize (int standalone);
 void    iodriver_resetstats (void);
 void    iodriver_printstats (void);
 void    iodriver_cleanstats (void);
+void    iodriver_telemetry (FILE *outfile, int header);
 event * iodriver_request (int iodriverno, ioreq_event *curr);
 void    iodriver_schedule (int iodriverno, ioreq_event *curr);
 double  iodriver_tick (void);
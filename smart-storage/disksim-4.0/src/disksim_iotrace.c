@@ -103,6 +103,7 @@
 #include "disksim_global.h"
 #include "disksim_hptrace.h"
 #include "disksim_iotrace.h"
+#include "disksim_openloop.h"
 
 
 static void iotrace_initialize_iotrace_info ()
@@ -165,6 +166,9 @@ void iotrace_set_format (char *formatname)
    } else if (strcmp(formatname, "batch") == 0) {
         /* ascii traces with added batch information */
       disksim->traceformat = BATCH;
+   } else if (strcmp(formatname, "openloop") == 0) {
+        /* no trace file: requests come from the open-loop generator */
+      disksim->traceformat = OPENLOOP;
    } else {
       fprintf(stderr, "Unknown trace format - %s\n", formatname);
       exit(1);
@@ -676,6 +680,10 @@ ioreq_event * iotrace_get_ioreq_event (FILE *tracefile, int traceformat, ioreq_e
       temp = iotrace_batch_get_ioreq_event(tracefile, temp);
       break;
 
+   case OPENLOOP:
+      temp = openloop_get_ioreq_event(temp);
+      break;
+
    default:
       fprintf(stderr, "Unknown traceformat in iotrace_get_ioreq_event - %d\n", traceformat);
       exit(1);
@@ -124,6 +124,9 @@ int disksim_loadparams(char *inputfile, int synthgen) {
     lp_instantiate("Proc", "Proc");
     lp_instantiate("Synthio", "Synthio");
   }
+  else if(disksim->traceformat == OPENLOOP) {
+    lp_instantiate("Openloop", "Openloop");
+  }
 
 
   fclose(disksim->parfile);
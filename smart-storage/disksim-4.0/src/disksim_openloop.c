@@ -0,0 +1,449 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+
+#include "disksim_openloop.h"
+#include "disksim_device.h"
+#include "disksim_logorg.h"
+#include "disksim_iodriver.h"
+#include "modules/modules.h"
+
+/* The next request is taken from whichever stream has the earliest     */
+/* pending arrival, so the merged output is in time order as required   */
+/* of any external event source.  Every stream draws from its own       */
+/* rand48 stream, so adding or retuning one stream never perturbs the   */
+/* requests produced by the others.                                     */
+
+
+static void openloop_initialize_info (void)
+{
+   disksim->openloop_info = DISKSIM_malloc (sizeof(openloop_info_t));
+   bzero ((char *)disksim->openloop_info, sizeof(openloop_info_t));
+}
+
+
+static double openloop_exponential (openloop_stream *s, double mean)
+{
+   return(- mean * log((double) 1.0 - DISKSIM_erand48(s->rand48_seed)));
+}
+
+
+/* Zipf constants for Gray et al.'s constant-time sampling method.  The */
+/* O(n) zeta sum is only computed once per stream.                      */
+
+static double openloop_zeta (int n, double theta)
+{
+   double sum = 0.0;
+   int i;
+
+   for (i=1; i<=n; i++) {
+      sum += 1.0 / pow((double) i, theta);
+   }
+   return(sum);
+}
+
+
+static void openloop_zipf_setup (openloop_stream *s)
+{
+   double zeta2;
+
+   s->zipfitems = min(s->blksperdev, OPENLOOP_ZIPF_ITEMS);
+   s->zipfzetan = openloop_zeta(s->zipfitems, s->zipftheta);
+   zeta2 = openloop_zeta(2, s->zipftheta);
+   s->zipfalpha = 1.0 / (1.0 - s->zipftheta);
+   s->zipfeta = (1.0 - pow(2.0 / (double) s->zipfitems, 1.0 - s->zipftheta)) /
+                (1.0 - zeta2 / s->zipfzetan);
+}
+
+
+static int openloop_zipf_rank (openloop_stream *s)
+{
+   double u = DISKSIM_erand48(s->rand48_seed);
+   double uz = u * s->zipfzetan;
+   int rank;
+
+   if (uz < 1.0) {
+      return(0);
+   }
+   if (uz < (1.0 + pow(0.5, s->zipftheta))) {
+      return(1);
+   }
+   rank = (int) ((double) s->zipfitems * pow((s->zipfeta * u) - s->zipfeta + 1.0, s->zipfalpha));
+   return(min(rank, s->zipfitems - 1));
+}
+
+
+static int openloop_get_blkno (openloop_stream *s, int bcount)
+{
+   int range = s->blksperdev - bcount;
+   int hotblks;
+   int rank;
+   int lo, hi;
+
+   switch (s->addrdist) {
+      case OPENLOOP_ADDR_UNIFORM:
+         return((int) (DISKSIM_erand48(s->rand48_seed) * (double) range));
+
+      case OPENLOOP_ADDR_ZIPF:
+         /* Rank r covers blocks [r*blksperdev/zipfitems, (r+1)*...), so */
+         /* the remainder is spread over the ranks instead of dropped.   */
+         rank = openloop_zipf_rank(s);
+         lo = (int) (((int64_t) rank * s->blksperdev) / s->zipfitems);
+         hi = (int) (((int64_t) (rank + 1) * s->blksperdev) / s->zipfitems);
+         return(min(lo + (int) (DISKSIM_erand48(s->rand48_seed) * (double) (hi - lo)), range));
+
+      case OPENLOOP_ADDR_HOTSET:
+         hotblks = max(1, (int) (s->hotfrac * (double) range));
+         if (DISKSIM_erand48(s->rand48_seed) < s->hotprob) {
+            return((int) (DISKSIM_erand48(s->rand48_seed) * (double) hotblks));
+         }
+         if (hotblks >= range) {
+            return((int) (DISKSIM_erand48(s->rand48_seed) * (double) range));
+         }
+         return(hotblks + (int) (DISKSIM_erand48(s->rand48_seed) * (double) (range - hotblks)));
+
+      default:
+         fprintf(stderr, "Unrecognized address distribution - %d\n", s->addrdist);
+         exit(1);
+   }
+}
+
+
+static int openloop_get_bcount (openloop_stream *s)
+{
+   double u;
+   int i;
+
+   if (s->numsizes == 0) {
+      return(1);
+   }
+   u = DISKSIM_erand48(s->rand48_seed);
+   for (i=0; i<(s->numsizes-1); i++) {
+      if (u < s->sizecdf[i]) {
+         break;
+      }
+   }
+   return(s->sizes[i]);
+}
+
+
+/* Advance the stream's arrival clock past "from": exponential gaps at  */
+/* the stream's rate, skipping OFF periods and honoring the rate limit. */
+
+static void openloop_schedule_next (openloop_stream *s, double from)
+{
+   double next = from + openloop_exponential(s, (1.0 / s->rate));
+
+   if (s->ontime > 0.0) {
+      while (next >= s->onend) {
+         next = s->onend + openloop_exponential(s, s->offtime);
+         s->onend = next + openloop_exponential(s, s->ontime);
+         next += openloop_exponential(s, (1.0 / s->rate));
+      }
+   }
+   if ((s->ratelimit > 0.0) && (next < (from + (1.0 / s->ratelimit)))) {
+      next = from + (1.0 / s->ratelimit);
+   }
+   s->nexttime = next;
+}
+
+
+void openloop_initialize (void)
+{
+   openloop_stream *s;
+   int i;
+
+   for (i=0; i<openloop_numstreams; i++) {
+      s = openloop_streams[i];
+      DISKSIM_rand48_stream(s->rand48_seed, disksim->seedval, s->number);
+      s->iocnt = 0;
+      s->reads = 0;
+      s->onend = (s->ontime > 0.0) ? openloop_exponential(s, s->ontime) : 0.0;
+      openloop_schedule_next(s, 0.0);
+   }
+   openloop_iocnt = 0;
+}
+
+
+ioreq_event * openloop_get_ioreq_event (ioreq_event *new)
+{
+   openloop_stream *s = NULL;
+   int i;
+
+   for (i=0; i<openloop_numstreams; i++) {
+      if ((s == NULL) || (openloop_streams[i]->nexttime < s->nexttime)) {
+         s = openloop_streams[i];
+      }
+   }
+
+   if ((s == NULL) || (openloop_iocnt >= openloop_endiocnt) || (s->nexttime >= openloop_endtime)) {
+      addtoextraq((event *) new);
+      return(NULL);
+   }
+
+   new->time = s->nexttime;
+   new->devno = s->devno[(int) (DISKSIM_erand48(s->rand48_seed) * (double) s->numdevs)];
+   new->bcount = openloop_get_bcount(s);
+   new->blkno = openloop_get_blkno(s, new->bcount) * s->blocksize;
+   new->bcount *= s->blocksize;
+   new->flags = (DISKSIM_erand48(s->rand48_seed) < s->probread) ? READ : WRITE;
+   new->buf = 0;
+   new->opid = 0;
+   new->busno = 0;
+   new->cause = 0;
+
+   s->iocnt++;
+   if (new->flags & READ) {
+      s->reads++;
+   }
+   openloop_iocnt++;
+   openloop_schedule_next(s, s->nexttime);
+   return(new);
+}
+
+
+void openloop_printstats (FILE *outfile)
+{
+   openloop_stream *s;
+   int i;
+
+   if (disksim->openloop_info == NULL) {
+      return;
+   }
+   fprintf(outfile, "\nOPEN-LOOP GENERATOR STATISTICS\n");
+   fprintf(outfile, "------------------------------\n\n");
+   for (i=0; i<openloop_numstreams; i++) {
+      s = openloop_streams[i];
+      fprintf(outfile, "Stream #%d requests:\t%d\n", s->number, s->iocnt);
+      fprintf(outfile, "Stream #%d read fraction:\t%f\n", s->number, (s->iocnt) ? ((double) s->reads / (double) s->iocnt) : 0.0);
+      fprintf(outfile, "Stream #%d request rate:\t%f\n", s->number, (simtime > 0.0) ? ((double) s->iocnt * 1000.0 / simtime) : 0.0);
+   }
+}
+
+
+int disksim_openloop_loadparams (struct lp_block *b)
+{
+   if (!disksim->openloop_info) {
+      openloop_initialize_info();
+   }
+   openloop_endiocnt = 0;
+   openloop_endtime = 0.0;
+
+   lp_loadparams(0, b, &disksim_openloop_mod);
+
+   return 1;
+}
+
+
+/* this is a dummy that should never be called */
+int disksim_openstream_loadparams (struct lp_block *b)
+{
+   ddbg_assert2(0, "this is a dummy that isn't supposed to be called");
+   return 0;
+}
+
+
+static int loadstream (struct lp_block *b, openloop_stream **result)
+{
+   openloop_stream *s;
+   int i;
+
+   s = malloc(sizeof(openloop_stream));
+   bzero(s, sizeof(openloop_stream));
+   s->blocksize = 1;
+   s->addrdist = OPENLOOP_ADDR_UNIFORM;
+   (*result) = s;
+
+   lp_loadparams(result, b, &disksim_openstream_mod);
+
+   s->blksperdev = s->sectsperdev / s->blocksize;
+   for (i=0; i<s->numsizes; i++) {
+      s->sizes[i] = (s->sizes[i] + s->blocksize - 1) / s->blocksize;
+      if (s->sizes[i] >= s->blksperdev) {
+         fprintf(stderr, "*** error: open-loop request size %d exceeds device capacity.\n", s->sizes[i] * s->blocksize);
+         return -1;
+      }
+   }
+   if (s->blksperdev <= 1) {
+      fprintf(stderr, "*** error: open-loop stream needs more than one block per device.\n");
+      return -1;
+   }
+   if (s->addrdist == OPENLOOP_ADDR_ZIPF) {
+      openloop_zipf_setup(s);
+   }
+   if ((s->addrdist == OPENLOOP_ADDR_HOTSET) && (s->hotfrac <= 0.0)) {
+      fprintf(stderr, "*** error: open-loop hotset distribution needs a nonzero hot set fraction.\n");
+      return -1;
+   }
+   return 0;
+}
+
+
+int loadopenstreams (struct lp_list *l)
+{
+   int c;
+   int slot = 0;
+
+   if (openloop_streams) {
+      fprintf(stderr, "*** error: tried to redefine open-loop streams.\n");
+      return -1;
+   }
+
+   openloop_streams = malloc(l->values_len * sizeof(openloop_stream *));
+   bzero(openloop_streams, l->values_len * sizeof(openloop_stream *));
+
+   for (c = 0; c < l->values_len; c++) {
+      if (!l->values[c]) continue;
+
+      if (l->values[c]->t != BLOCK) {
+         fprintf(stderr, "*** error: bad open-loop stream spec -- must be a block.\n");
+         return -1;
+      }
+
+      if (loadstream(l->values[c]->v.b, &openloop_streams[slot])) {
+         return -1;
+      }
+      openloop_streams[slot]->number = slot;
+      slot++;
+   }
+
+   openloop_numstreams = slot;
+   return 0;
+}
+
+
+int loadopendevs (openloop_stream *result, struct lp_list *l)
+{
+   int c;
+   int num, type;
+   char *name;
+   int slot = 0;
+
+   result->devno = malloc(l->values_len * sizeof(int));
+   bzero(result->devno, l->values_len * sizeof(int));
+
+   for (c = 0; c < l->values_len; c++) {
+      if (!l->values[c]) continue;
+      if (l->values[c]->t != S) {
+         return -1;
+      }
+      name = l->values[c]->v.s;
+
+      if (!getdevbyname(name, &num, 0, &type)) {
+         if (!getlogorgbyname(sysorgs, numsysorgs, name, &num)) {
+            fprintf(stderr, "*** error: bad device %s in open-loop stream spec: no such device or logorg.\n", name);
+            return -1;
+         }
+      }
+
+      result->devno[slot++] = num;
+   }
+
+   result->numdevs = slot;
+   return (slot > 0) ? 0 : -1;
+}
+
+
+static char *addrdistnames[] = {
+  "uniform",
+  "zipf",
+  "hotset"
+};
+
+int loadopenaddrdist (openloop_stream *result, char *s)
+{
+   int c;
+
+   for (c = OPENLOOP_ADDR_UNIFORM; c <= OPENLOOP_ADDR_HOTSET; c++) {
+      if (!strcmp(s, addrdistnames[c])) {
+         result->addrdist = c;
+         return 0;
+      }
+   }
+   fprintf(stderr, "*** error: unknown open-loop address distribution: %s\n", s);
+   return -1;
+}
+
+
+static int listval (struct lp_value *v, double *result)
+{
+   if (!v) {
+      return -1;
+   }
+   if (v->t == D) {
+      *result = v->v.d;
+   } else if (v->t == I) {
+      *result = (double) v->v.i;
+   } else {
+      return -1;
+   }
+   return 0;
+}
+
+
+/* The list alternates request size (in storage units) and its weight. */
+
+int loadopensizes (openloop_stream *result, struct lp_list *l)
+{
+   double size, weight;
+   double total = 0.0;
+   int c;
+
+   if ((l->values_len < 2) || (l->values_len % 2)) {
+      fprintf(stderr, "*** error: open-loop request sizes must be <size, weight> pairs.\n");
+      return -1;
+   }
+
+   result->numsizes = l->values_len / 2;
+   result->sizes = malloc(result->numsizes * sizeof(int));
+   result->sizecdf = malloc(result->numsizes * sizeof(double));
+
+   for (c = 0; c < result->numsizes; c++) {
+      if (listval(l->values[2*c], &size) || listval(l->values[2*c+1], &weight)
+          || (size <= 0.0) || (weight < 0.0)) {
+         fprintf(stderr, "*** error: bad open-loop request size entry %d.\n", c);
+         return -1;
+      }
+      /* rounded up to the blocking factor when the stream is loaded */
+      result->sizes[c] = (int) size;
+      total += weight;
+      result->sizecdf[c] = total;
+   }
+   if (total <= 0.0) {
+      fprintf(stderr, "*** error: open-loop request size weights sum to zero.\n");
+      return -1;
+   }
+   for (c = 0; c < result->numsizes; c++) {
+      result->sizecdf[c] /= total;
+   }
+   return 0;
+}
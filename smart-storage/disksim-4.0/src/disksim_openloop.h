@@ -0,0 +1,122 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+#include "config.h"
+#include "disksim_global.h"
+
+
+#ifndef DISKSIM_OPENLOOP_H
+#define DISKSIM_OPENLOOP_H
+
+/* Open-loop synthetic workload generation.  Unlike synthio, requests   */
+/* are not issued by processes of the system-level model: each stream   */
+/* produces arrivals at its own rate regardless of completions, and the */
+/* requests are fed to the I/O subsystem exactly like trace records     */
+/* (trace format "openloop").                                           */
+
+/* exported disksim_openloop.c functions */
+
+struct lp_block;
+struct lp_list;
+int disksim_openloop_loadparams (struct lp_block *b);
+int disksim_openstream_loadparams (struct lp_block *b);
+void openloop_initialize (void);
+ioreq_event * openloop_get_ioreq_event (ioreq_event *temp);
+void openloop_printstats (FILE *outfile);
+
+
+#define OPENLOOP_ADDR_UNIFORM	0
+#define OPENLOOP_ADDR_ZIPF	1
+#define OPENLOOP_ADDR_HOTSET	2
+
+/* Zipf ranks are assigned to at most this many equal slices of a device */
+#define OPENLOOP_ZIPF_ITEMS	(1 << 20)
+
+
+typedef struct openloop_stream {
+   int            number;
+   int            numdevs;
+   int           *devno;
+   int            sectsperdev;
+   int            blocksize;
+   int            blksperdev;
+   double         probread;
+   double         rate;         /* mean arrivals per ms while ON */
+   double         ratelimit;    /* max arrivals per ms, 0 = no limit */
+   double         ontime;       /* mean ON period (ms), 0 = always ON */
+   double         offtime;      /* mean OFF period (ms) */
+   int            addrdist;
+   double         zipftheta;
+   double         hotfrac;      /* fraction of each device in hot set */
+   double         hotprob;      /* probability of accessing the hot set */
+   int            numsizes;
+   int           *sizes;        /* request sizes, in blocks */
+   double        *sizecdf;      /* cumulative size probabilities */
+
+   /* Zipf sampling constants (Gray et al., SIGMOD 1994) */
+   int            zipfitems;
+   double         zipfzetan;
+   double         zipfalpha;
+   double         zipfeta;
+
+   /* run-time state */
+   unsigned short rand48_seed[3];
+   double         nexttime;     /* arrival time of the next request */
+   double         onend;        /* end of the current ON period */
+   int            iocnt;
+   int            reads;
+} openloop_stream;
+
+
+typedef struct openloop_info {
+   openloop_stream **streams;
+   int    numstreams;
+   int    iocnt;
+   int    endiocnt;
+   double endtime;
+} openloop_info_t;
+
+
+/* one remapping #define for each variable in openloop_info_t */
+#define openloop_streams        (disksim->openloop_info->streams)
+#define openloop_numstreams     (disksim->openloop_info->numstreams)
+#define openloop_iocnt          (disksim->openloop_info->iocnt)
+#define openloop_endiocnt       (disksim->openloop_info->endiocnt)
+#define openloop_endtime        (disksim->openloop_info->endtime)
+
+
+int loadopenstreams (struct lp_list *l);
+int loadopendevs (openloop_stream *result, struct lp_list *l);
+int loadopenaddrdist (openloop_stream *result, char *s);
+int loadopensizes (openloop_stream *result, struct lp_list *l);
+
+#endif    /* DISKSIM_OPENLOOP_H */
@@ -204,7 +204,7 @@ DISKSIM_ldexp (double x, int exp)
 
 /* FreeBSD's erand48.c */
 
-static double
+double
 DISKSIM_erand48(unsigned short xseed[3])
 {
 	disksim_rand48_initialize();
@@ -286,3 +286,45 @@ DISKSIM_srand48(long seed)
 	_rand48_add = RAND48_ADD;
 }
 
+
+/* Independent streams.  A stream is just a private xseed[3] state fed to */
+/* DISKSIM_erand48().  Stream n of a given seed starts n * 2^RAND48_STREAM_SHIFT */
+/* steps into the sequence srand48(seed) would produce, so streams never  */
+/* overlap unless one of them draws more than that many numbers, and the  */
+/* values a stream produces do not depend on what other streams do.       */
+
+#define RAND48_MASK		((((u_int64_t) 1) << 48) - 1)
+#define RAND48_STREAM_SHIFT	32
+
+void
+DISKSIM_rand48_stream(unsigned short xseed[3], long seed, int stream)
+{
+	u_int64_t x, mult, add, accmult, accadd;
+	u_int64_t steps;
+
+	disksim_rand48_initialize();
+	x = ((u_int64_t) (unsigned short) (seed >> 16) << 32) |
+	    ((u_int64_t) (unsigned short) seed << 16) | RAND48_SEED_0;
+	mult = ((u_int64_t) RAND48_MULT_2 << 32) |
+	       ((u_int64_t) RAND48_MULT_1 << 16) | RAND48_MULT_0;
+	add = RAND48_ADD;
+
+	/* jump ahead by computing the stepped multiplier/addend by squaring */
+	accmult = 1;
+	accadd = 0;
+	steps = ((u_int64_t) stream) << RAND48_STREAM_SHIFT;
+	while (steps) {
+		if (steps & 1) {
+			accmult = (accmult * mult) & RAND48_MASK;
+			accadd = (accadd * mult + add) & RAND48_MASK;
+		}
+		add = ((mult + 1) * add) & RAND48_MASK;
+		mult = (mult * mult) & RAND48_MASK;
+		steps >>= 1;
+	}
+	x = (accmult * x + accadd) & RAND48_MASK;
+
+	xseed[0] = (unsigned short) x;
+	xseed[1] = (unsigned short) (x >> 16);
+	xseed[2] = (unsigned short) (x >> 32);
+}
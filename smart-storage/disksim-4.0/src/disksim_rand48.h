@@ -70,5 +70,12 @@ void DISKSIM_srand48 (long int __seedval);
 /* Return non-negative integer in range [0,2**31-1] */
 long DISKSIM_lrand48 (void);
 
+/* Same as DISKSIM_drand48, but advancing the caller-supplied state.  */
+double DISKSIM_erand48 (unsigned short __xseed[3]);
+
+/* Initialize a private stream: stream N of SEED is disjoint from the  */
+/* other streams of SEED and independent of how often they are drawn.  */
+void DISKSIM_rand48_stream (unsigned short __xseed[3], long int __seedval, int __stream);
+
 #endif
 
@@ -127,6 +127,166 @@ double stat_get_runval (statgen *statptr)
 }
 
 
+static double stat_quant_pcts[STAT_QUANT_NUM] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+
+
+static void stat_hist_add (stat_hist *hist, double value)
+{
+   int exp;
+   int octave;
+   int sub;
+   double mant;
+
+   hist->count++;
+   mant = frexp(value, &exp);
+   octave = exp - STAT_QUANT_MINEXP;
+   if ((value <= 0.0) || (octave < 0)) {
+      hist->low++;
+      return;
+   }
+   if (octave >= STAT_QUANT_OCTAVES) {
+      octave = STAT_QUANT_OCTAVES - 1;
+      sub = STAT_QUANT_SUBBUCKETS - 1;
+   } else {
+      /* mant is in [0.5,1) */
+      sub = (int) ((mant - 0.5) * (double) (2 * STAT_QUANT_SUBBUCKETS));
+   }
+   if (hist->octaves[octave] == NULL) {
+      hist->octaves[octave] = (int *) DISKSIM_malloc(STAT_QUANT_SUBBUCKETS * sizeof(int));
+      ASSERT(hist->octaves[octave] != NULL);
+      bzero ((char *)hist->octaves[octave], STAT_QUANT_SUBBUCKETS * sizeof(int));
+   }
+   hist->octaves[octave][sub]++;
+}
+
+
+static void stat_hist_clear (stat_hist *hist)
+{
+   int i;
+
+   hist->count = 0;
+   hist->low = 0;
+   for (i=0; i<STAT_QUANT_OCTAVES; i++) {
+      if (hist->octaves[i]) {
+         bzero ((char *)hist->octaves[i], STAT_QUANT_SUBBUCKETS * sizeof(int));
+      }
+   }
+}
+
+
+/* Walk a set of histograms in lock step; the value returned for a     */
+/* bucket is its midpoint.  Histograms of a set merge bucket-by-bucket */
+/* because every statgen shares the same bucket layout.                */
+
+static double stat_hist_percentile (stat_hist **hists, int histcnt, double pct)
+{
+   int count = 0;
+   int target;
+   int seen = 0;
+   int i, j, k;
+
+   for (k=0; k<histcnt; k++) {
+      count += hists[k]->count;
+      seen += hists[k]->low;
+   }
+   if (count == 0) {
+      return(0.0);
+   }
+   target = (int) ceil((pct / 100.0) * (double) count);
+   if (target < 1) {
+      target = 1;
+   }
+   if (seen >= target) {
+      return(0.0);
+   }
+   for (i=0; i<STAT_QUANT_OCTAVES; i++) {
+      for (j=0; j<STAT_QUANT_SUBBUCKETS; j++) {
+         for (k=0; k<histcnt; k++) {
+            if (hists[k]->octaves[i]) {
+               seen += hists[k]->octaves[i][j];
+            }
+         }
+         if (seen >= target) {
+            return(ldexp(0.5 + (((double) j + 0.5) / (double) (2 * STAT_QUANT_SUBBUCKETS)), (i + STAT_QUANT_MINEXP)));
+         }
+      }
+   }
+   return(0.0);
+}
+
+
+/* Fold a finished time window into the worst-window percentiles and */
+/* start a new one at the window containing "now".                   */
+
+static void stat_quant_close_window (stat_quantiles *quant, double now)
+{
+   stat_hist *hist = &quant->window;
+   double val;
+   int i;
+
+   if (hist->count > 0) {
+      for (i=0; i<STAT_QUANT_NUM; i++) {
+         val = stat_hist_percentile(&hist, 1, stat_quant_pcts[i]);
+         if ((quant->windows == 0) || (val > quant->worst[i])) {
+            quant->worst[i] = val;
+         }
+      }
+      quant->windows++;
+      stat_hist_clear(hist);
+   }
+   quant->winstart += floor((now - quant->winstart) / disksim->stat_window) * disksim->stat_window;
+}
+
+
+double stat_get_percentile (statgen *statptr, double pct)
+{
+   stat_hist *hist;
+
+   if (statptr->quant == NULL) {
+      return(0.0);
+   }
+   hist = &statptr->quant->all;
+   return(stat_hist_percentile(&hist, 1, pct));
+}
+
+
+static void stat_print_quantiles (statgen **statset, int statcnt, char *identstr, FILE *outfile)
+{
+   stat_hist *hists[statcnt];
+   double worst;
+   int windows = 0;
+   int i, j;
+
+   for (i=0; i<statcnt; i++) {
+      if (statset[i]->quant == NULL) {
+         return;
+      }
+      hists[i] = &statset[i]->quant->all;
+      /* the open window only closes on a later sample; count it too */
+      if (disksim->stat_window > 0.0) {
+         stat_quant_close_window(statset[i]->quant, simtime);
+      }
+      windows += statset[i]->quant->windows;
+   }
+   for (j=0; j<STAT_QUANT_NUM; j++) {
+      fprintf(outfile, "%s%s p%g:\t%f\n", identstr, statset[0]->statdesc, stat_quant_pcts[j], stat_hist_percentile(hists, statcnt, stat_quant_pcts[j]));
+   }
+   if ((disksim->stat_window <= 0.0) || (windows == 0)) {
+      return;
+   }
+   /* windows are per-statgen, so a set reports its worst member */
+   for (j=0; j<STAT_QUANT_NUM; j++) {
+      worst = 0.0;
+      for (i=0; i<statcnt; i++) {
+         if ((statset[i]->quant->windows > 0) && (statset[i]->quant->worst[j] > worst)) {
+            worst = statset[i]->quant->worst[j];
+         }
+      }
+      fprintf(outfile, "%s%s worst window p%g:\t%f\n", identstr, statset[0]->statdesc, stat_quant_pcts[j], worst);
+   }
+}
+
+
 void stat_update (statgen *statptr, double value)
 {
    int  i = 0;
@@ -143,6 +303,15 @@ void stat_update (statgen *statptr, double value)
    }
    statptr->runval += value;
    statptr->runsquares += (value*value);
+   if (statptr->quant) {
+      stat_hist_add(&statptr->quant->all, value);
+      if (disksim->stat_window > 0.0) {
+         if (simtime >= (statptr->quant->winstart + disksim->stat_window)) {
+            stat_quant_close_window(statptr->quant, simtime);
+         }
+         stat_hist_add(&statptr->quant->window, value);
+      }
+   }
    if (buckets > DISTSIZE) {
       if (intval < start) {
       } else if (!grow) {
@@ -264,6 +433,7 @@ void stat_print_file (statgen *statptr, char *identstr, FILE *outfile){
    } else {
       fprintf(outfile, "%s%s maximum:\t%f\n", identstr, statdesc, statptr->maxval);
    }
+   stat_print_quantiles(&statptr, 1, identstr, outfile);
    if (buckets > DISTSIZE) {
       stat_print_large_dist(&statptr, 1, statptr->count, identstr);
       return;
@@ -334,6 +504,7 @@ void stat_print_set (statgen **statset, int statcnt, char *identstr)
    } else {
       fprintf(outputfile, "%s%s maximum:\t%f\n", identstr, statdesc, maxval);
    }
+   stat_print_quantiles(statset, statcnt, identstr, outputfile);
    if (buckets > DISTSIZE) {
       stat_print_large_dist(statset, statcnt, runcount, identstr);
       return;
@@ -381,6 +552,12 @@ void stat_reset (statgen *statptr)
    statptr->runval = 0.0;
    statptr->runsquares = 0.0;
    statptr->maxval = 0.0;
+   if (statptr->quant) {
+      stat_hist_clear(&statptr->quant->all);
+      stat_hist_clear(&statptr->quant->window);
+      statptr->quant->winstart = simtime;
+      statptr->quant->windows = 0;
+   }
    if (buckets > DISTSIZE) {
       for (i=0; i<buckets; i++) {
          statptr->largedistvals[i] = 0;
@@ -484,6 +661,13 @@ void stat_initialize (FILE *statdef_file, char *statdesc, statgen *statptr)
    statptr->distbrks[(DISTSIZE-1)] = buckets;
    statptr->largedistvals = NULL;
    statptr->largediststarts = NULL;
+   statptr->quant = NULL;
+   if (disksim->stat_quantiles) {
+      statptr->quant = (stat_quantiles *) DISKSIM_malloc(sizeof(stat_quantiles));
+      ASSERT(statptr->quant != NULL);
+      bzero ((char *)statptr->quant, sizeof(stat_quantiles));
+      statptr->quant->winstart = simtime;
+   }
 
    if (buckets > DISTSIZE) {
       stat_get_large_dist(statdef_file, statptr, buckets);
@@ -106,6 +106,32 @@
 
 #define DISTSIZE	10
 
+/* Percentile tracking (enabled by the global "Percentile statistics" */
+/* parameter) uses a log-linear histogram: each power of two is split */
+/* into STAT_QUANT_SUBBUCKETS linear buckets, so recording a value is */
+/* constant time and reported percentiles are within 1/64 (relative)  */
+/* of the exact value.  Octaves are only allocated once touched.      */
+
+#define STAT_QUANT_SUBBITS	6
+#define STAT_QUANT_SUBBUCKETS	(1 << STAT_QUANT_SUBBITS)
+#define STAT_QUANT_MINEXP	(-32)
+#define STAT_QUANT_OCTAVES	96
+#define STAT_QUANT_NUM		5
+
+typedef struct {
+   int     count;
+   int     low;                  /* values below 2^STAT_QUANT_MINEXP */
+   int    *octaves[STAT_QUANT_OCTAVES];
+} stat_hist;
+
+typedef struct {
+   stat_hist all;
+   stat_hist window;             /* current time window, if windowed */
+   double    winstart;
+   int       windows;            /* completed (non-empty) windows */
+   double    worst[STAT_QUANT_NUM];
+} stat_quantiles;
+
 typedef struct {
    int     count;
    char   *statdesc;
@@ -120,6 +146,7 @@ typedef struct {
    int    *largediststarts;
    int     distbrks[DISTSIZE];
    int     smalldistvals[DISTSIZE];
+   stat_quantiles *quant;
 } statgen;
 
 
@@ -134,6 +161,7 @@ void   stat_print (statgen *statptr, char *identstr);
 void   stat_print_file (statgen *statptr, char *identstr, FILE *outfile);
 void   stat_print_set (statgen **statset, int statcnt, char *identstr);
 int    stat_get_count_set (statgen **statset, int statcnt);
+double stat_get_percentile (statgen *statptr, double pct);
 
 #endif  /* DISKSIM_STAT_H */
 
@@ -109,39 +109,51 @@
 #define SYNTHIO_TWOVALUE	4
 
 
-static double synthio_get_uniform (synthio_distr *fromdistr)
+/* Draw from the generator's private stream when independent streams are */
+/* enabled, otherwise from the shared simulation-wide generator.         */
+
+static double synthio_drand48 (synthio_generator *gen)
 {
-   return(((fromdistr->var - fromdistr->base) * DISKSIM_drand48()) + fromdistr->base);
+   if (synthio_streams) {
+      return(DISKSIM_erand48(gen->rand48_seed));
+   }
+   return(DISKSIM_drand48());
 }
 
 
-static double synthio_get_normal (synthio_distr *fromdistr)
+static double synthio_get_uniform (synthio_generator *gen, synthio_distr *fromdistr)
+{
+   return(((fromdistr->var - fromdistr->base) * synthio_drand48(gen)) + fromdistr->base);
+}
+
+
+static double synthio_get_normal (synthio_generator *gen, synthio_distr *fromdistr)
 {
    double y1, y2;
    double y = 0;
 
    while (y <= 0.0) {
-      y2 = - log((double) 1.0 - DISKSIM_drand48());
-      y1 = - log((double) 1.0 - DISKSIM_drand48());
+      y2 = - log((double) 1.0 - synthio_drand48(gen));
+      y1 = - log((double) 1.0 - synthio_drand48(gen));
       y = y2 - ((y1 - (double) 1.0) * (y1 - (double) 1.0)) / 2;
    }
-   if (DISKSIM_drand48() < 0.5) {
+   if (synthio_drand48(gen) < 0.5) {
       y1 = -y1;
    }
    return((fromdistr->var * y1) + fromdistr->mean);
 }
 
 
-static double synthio_get_exponential (synthio_distr *fromdistr)
+static double synthio_get_exponential (synthio_generator *gen, synthio_distr *fromdistr)
 {
    double dtmp;
 
-   dtmp = log((double) 1.0 - DISKSIM_drand48());
+   dtmp = log((double) 1.0 - synthio_drand48(gen));
    return((fromdistr->base - (fromdistr->mean * dtmp)));
 }
 
 
-static double synthio_get_poisson (synthio_distr *fromdistr)
+static double synthio_get_poisson (synthio_generator *gen, synthio_distr *fromdistr)
 {
    double dtmp = 1.0;
    int count = 0;
@@ -149,7 +161,7 @@ static double synthio_get_poisson (synthio_distr *fromdistr)
 
    stop = exp(-fromdistr->mean);
    while (dtmp >= stop) {
-      dtmp *= DISKSIM_drand48();
+      dtmp *= synthio_drand48(gen);
       count++;
    }
    count--;
@@ -157,9 +169,9 @@ static double synthio_get_poisson (synthio_distr *fromdistr)
 }
 
 
-static double synthio_get_twovalue (synthio_distr *fromdistr)
+static double synthio_get_twovalue (synthio_generator *gen, synthio_distr *fromdistr)
 {
-   if (DISKSIM_drand48() < fromdistr->var) {
+   if (synthio_drand48(gen) < fromdistr->var) {
       return(fromdistr->mean);
    } else {
       return(fromdistr->base);
@@ -167,19 +179,19 @@ static double synthio_get_twovalue (synthio_distr *fromdistr)
 }
 
 
-static double synthio_getrand (synthio_distr *fromdistr)
+static double synthio_getrand (synthio_generator *gen, synthio_distr *fromdistr)
 {
    switch (fromdistr->type) {
       case SYNTHIO_UNIFORM:
-	                return(synthio_get_uniform(fromdistr));
+	                return(synthio_get_uniform(gen, fromdistr));
       case SYNTHIO_NORMAL:
-                        return(synthio_get_normal(fromdistr));
+                        return(synthio_get_normal(gen, fromdistr));
       case SYNTHIO_EXPONENTIAL:
-			return(synthio_get_exponential(fromdistr));
+			return(synthio_get_exponential(gen, fromdistr));
       case SYNTHIO_POISSON:
-			return(synthio_get_poisson(fromdistr));
+			return(synthio_get_poisson(gen, fromdistr));
       case SYNTHIO_TWOVALUE:
-			return(synthio_get_twovalue(fromdistr));
+			return(synthio_get_twovalue(gen, fromdistr));
       default:
 	                fprintf(stderr, "Unrecognized distribution type - %d\n", fromdistr->type);
 	                exit(1);
@@ -246,7 +258,7 @@ static void synthio_appendio (process *procp, ioreq_event *tmp)
 	new->next = (ioreq_event *) procp->eventlist;
 	newsleep->time = -1.0;
 	while (newsleep->time < 0.0) {
-	  newsleep->time = synthio_getrand (&gen->tmlimit);
+	  newsleep->time = synthio_getrand(gen, &gen->tmlimit);
 	}
 	newsleep->time += new->time;
 	limittmp = gen->limits;
@@ -320,23 +332,26 @@ void synthio_initialize_generator (process *procp)
       fprintf(stderr, "Process with no synthetic generator in synthio_initialize\n");
       exit(1);
    }
+   if (synthio_streams) {
+      DISKSIM_rand48_stream(gen->rand48_seed, disksim->seedval, gen->number);
+   }
    tmp = (ioreq_event *) getfromextraq();
    tmp->time = -1.0;
    while (tmp->time < 0.0) {
-      tmp->time = synthio_getrand(&gen->genintr);
+      tmp->time = synthio_getrand(gen, &gen->genintr);
    }
    tmp->flags = 0;
    tmp->cause = gen->number;
-   tmp->devno = gen->devno[(int) (DISKSIM_drand48() * (double) gen->numdisks)];
+   tmp->devno = gen->devno[(int) (synthio_drand48(gen) * (double) gen->numdisks)];
    tmp->blkno = tmp->bcount = gen->blksperdisk;
    while (((tmp->blkno + tmp->bcount) >= gen->blksperdisk) || (tmp->bcount == 0)) {
-      tmp->blkno = (int) (DISKSIM_drand48() * (double) gen->blksperdisk);
-      tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + gen->blocksize - 1) / gen->blocksize;
+      tmp->blkno = (int) (synthio_drand48(gen) * (double) gen->blksperdisk);
+      tmp->bcount = ((int) synthio_getrand(gen, &gen->sizedist) + gen->blocksize - 1) / gen->blocksize;
    }
-   if (DISKSIM_drand48() < gen->probread) {
+   if (synthio_drand48(gen) < gen->probread) {
       tmp->flags |= READ;
    }
-   reqclass = DISKSIM_drand48() - gen->probtmcrit;
+   reqclass = synthio_drand48(gen) - gen->probtmcrit;
    if (reqclass < 0.0) {
       tmp->flags |= TIME_CRITICAL;
    } else if (reqclass < gen->probtmlim) {
@@ -376,7 +391,7 @@ static int synthio_generatenextio (synthio_generator *gen)
       return 1;
    }
 
-   type = DISKSIM_drand48();
+   type = synthio_drand48(gen);
 
    if ((type < gen->probseq) && 
        ((tmp->blkno + 2*tmp->bcount) < gen->blksperdisk)) {
@@ -384,7 +399,7 @@ static int synthio_generatenextio (synthio_generator *gen)
      tmp->time = -1.0;
 
      while (tmp->time < 0.0) {
-       tmp->time = synthio_getrand(&gen->seqintr);
+       tmp->time = synthio_getrand(gen, &gen->seqintr);
      }
 
      tmp->flags = SEQ | (tmp->flags & READ);
@@ -396,7 +411,7 @@ static int synthio_generatenextio (synthio_generator *gen)
 
      tmp->time = -1.0;
      while (tmp->time < 0.0) {
-       tmp->time = synthio_getrand(&gen->locintr);
+       tmp->time = synthio_getrand(gen, &gen->locintr);
      }
      tmp->flags = LOCAL;
      tmp->cause = gen->number;
@@ -406,39 +421,39 @@ static int synthio_generatenextio (synthio_generator *gen)
 	    || (tmp->bcount <= 0)) 
        {
 	 blkno = tmp->blkno + 
-	   (int)synthio_getrand(&gen->locdist) / gen->blocksize;
-	 tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + 
+	   (int)synthio_getrand(gen, &gen->locdist) / gen->blocksize;
+	 tmp->bcount = ((int) synthio_getrand(gen, &gen->sizedist) + 
 			gen->blocksize - 1) / gen->blocksize;
        }
      tmp->blkno = blkno;
-     if (DISKSIM_drand48() < gen->probread) {
+     if (synthio_drand48(gen) < gen->probread) {
        tmp->flags |= READ;
      }
    } 
    else {
       tmp->time = -1.0;
       while (tmp->time < 0.0) {
-	tmp->time = synthio_getrand(&gen->genintr);
+	tmp->time = synthio_getrand(gen, &gen->genintr);
       }
       tmp->flags = 0;
       tmp->cause = gen->number;
-      tmp->devno = gen->devno[(int)(DISKSIM_drand48() * 
+      tmp->devno = gen->devno[(int)(synthio_drand48(gen) * 
 				    (double)gen->numdisks)];
 
       tmp->blkno = tmp->bcount = gen->blksperdisk;
       while (((tmp->blkno + tmp->bcount) >= gen->blksperdisk) || 
 	     (tmp->bcount <= 0)) {
 
-	tmp->blkno = (int) (DISKSIM_drand48() * (double)gen->blksperdisk);
-	tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + 
+	tmp->blkno = (int) (synthio_drand48(gen) * (double)gen->blksperdisk);
+	tmp->bcount = ((int) synthio_getrand(gen, &gen->sizedist) + 
 		       gen->blocksize - 1) / gen->blocksize;
       }
 
-      if (DISKSIM_drand48() < gen->probread) {
+      if (synthio_drand48(gen) < gen->probread) {
 	tmp->flags = READ;
       }
    }
-   reqclass = DISKSIM_drand48() - gen->probtmcrit;
+   reqclass = synthio_drand48(gen) - gen->probtmcrit;
 
    if (reqclass < 0.0) {
      tmp->flags |= TIME_CRITICAL;
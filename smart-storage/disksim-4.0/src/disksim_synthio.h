@@ -152,6 +152,7 @@ typedef struct gen {
    synthio_distr  locintr;
    synthio_distr  locdist;
    synthio_distr  sizedist;
+   unsigned short rand48_seed[3];   /* private stream (synthio_streams) */
 } synthio_generator;
 
 
@@ -166,6 +167,7 @@ typedef struct synthio_info {
    int    synthio_syscalls;
    double synthio_syscall_time;
    double synthio_sysret_time;
+   int    synthio_streams;
 } synthio_info_t;
 
 
@@ -178,6 +180,7 @@ typedef struct synthio_info {
 #define synthio_syscalls        (disksim->synthio_info->synthio_syscalls)
 #define synthio_syscall_time    (disksim->synthio_info->synthio_syscall_time)
 #define synthio_sysret_time     (disksim->synthio_info->synthio_sysret_time)
+#define synthio_streams         (disksim->synthio_info->synthio_streams)
 
 
 #endif    /* DISKSIM_SYNTHIO_H */
@@ -0,0 +1,105 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+
+
+#include "disksim_telemetry.h"
+#include "disksim_iodriver.h"
+#include "disksim_bus.h"
+#include "disksim_controller.h"
+#include "ssdmodel/ssd.h"
+
+/* Each module contributes its own columns through a <module>_telemetry */
+/* function that prints either the column names (header) or the current */
+/* values, each preceded by a comma.  The sampler itself only walks the */
+/* existing per-module tables, so the cost of a sample is a handful of  */
+/* loads and one buffered fprintf per column.                           */
+
+#define TELEMETRY_BUFSIZE	65536
+
+
+static void telemetry_print_row (FILE *outfile, int header)
+{
+   if (header) {
+      fprintf (outfile, "time");
+   } else {
+      fprintf (outfile, "%.6f", simtime);
+   }
+   iodriver_telemetry (outfile, header);
+   bus_telemetry (outfile, header, (simtime - disksim->telemetry_last));
+   controller_telemetry (outfile, header);
+   ssd_telemetry (outfile, header);
+   fprintf (outfile, "\n");
+}
+
+
+static void telemetry_sample (timer_event *timer)
+{
+   telemetry_print_row (disksim->telemetry, FALSE);
+   disksim->telemetry_last = simtime;
+   timer->time = simtime + disksim->telemetry_interval;
+   addtointq ((event *) timer);
+}
+
+
+void telemetry_setcallbacks ()
+{
+   disksim->timerfunc_telemetry = telemetry_sample;
+}
+
+
+void telemetry_initialize ()
+{
+   timer_event *timer;
+
+   if ((disksim->telemetry == NULL) || (disksim->telemetry_interval <= 0.0)) {
+      return;
+   }
+   setvbuf (disksim->telemetry, NULL, _IOFBF, TELEMETRY_BUFSIZE);
+   telemetry_print_row (disksim->telemetry, TRUE);
+   disksim->telemetry_last = simtime;
+
+   timer = (timer_event *) getfromextraq ();
+   timer->type = TIMER_EXPIRED;
+   timer->time = simtime + disksim->telemetry_interval;
+   timer->func = &disksim->timerfunc_telemetry;
+   addtointq ((event *) timer);
+}
+
+
+void telemetry_cleanup ()
+{
+   if (disksim->telemetry) {
+      fclose (disksim->telemetry);
+      disksim->telemetry = NULL;
+   }
+}
@@ -106,6 +106,50 @@ if (! ((disksim->exectrace = fopen(s, "w")) != NULL)) { // foo
 
 }
 
+static int DISKSIM_GLOBAL_PERCENTILE_STATISTICS_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_GLOBAL_PERCENTILE_STATISTICS_loader(int result, int i) { 
+if (! (RANGE(i,0,1))) { // foo 
+ } 
+ disksim->stat_quantiles = i;
+
+}
+
+static int DISKSIM_GLOBAL_PERCENTILE_WINDOW_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_GLOBAL_PERCENTILE_WINDOW_loader(int result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ disksim->stat_window = d;
+
+}
+
+static int DISKSIM_GLOBAL_TELEMETRY_FILE_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_GLOBAL_TELEMETRY_FILE_loader(int result, char *s) { 
+if (! ((disksim->telemetry = fopen(s, "w")) != NULL)) { // foo 
+ } 
+ disksim->telemetry_fn = strdup(s);
+
+}
+
+static int DISKSIM_GLOBAL_TELEMETRY_INTERVAL_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_GLOBAL_TELEMETRY_INTERVAL_loader(int result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ disksim->telemetry_interval = d;
+
+}
+
 void * DISKSIM_GLOBAL_loaders[] = {
 (void *)DISKSIM_GLOBAL_INIT_SEED_loader,
 (void *)DISKSIM_GLOBAL_INIT_SEED_WITH_TIME_loader,
@@ -115,7 +159,11 @@ void * DISKSIM_GLOBAL_loaders[] = {
 (void *)DISKSIM_GLOBAL_STATISTIC_WARM_UP_IOS_loader,
 (void *)DISKSIM_GLOBAL_STAT_DEFINITION_FILE_loader,
 (void *)DISKSIM_GLOBAL_OUTPUT_FILE_FOR_TRACE_OF_IO_REQUESTS_SIMULATED_loader,
-(void *)DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE_loader
+(void *)DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE_loader,
+(void *)DISKSIM_GLOBAL_PERCENTILE_STATISTICS_loader,
+(void *)DISKSIM_GLOBAL_PERCENTILE_WINDOW_loader,
+(void *)DISKSIM_GLOBAL_TELEMETRY_FILE_loader,
+(void *)DISKSIM_GLOBAL_TELEMETRY_INTERVAL_loader
 };
 
 lp_paramdep_t DISKSIM_GLOBAL_deps[] = {
@@ -127,6 +175,10 @@ DISKSIM_GLOBAL_STATISTIC_WARM_UP_TIME_depend,
 DISKSIM_GLOBAL_STATISTIC_WARM_UP_IOS_depend,
 DISKSIM_GLOBAL_STAT_DEFINITION_FILE_depend,
 DISKSIM_GLOBAL_OUTPUT_FILE_FOR_TRACE_OF_IO_REQUESTS_SIMULATED_depend,
-DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE_depend
+DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE_depend,
+DISKSIM_GLOBAL_PERCENTILE_STATISTICS_depend,
+DISKSIM_GLOBAL_PERCENTILE_WINDOW_depend,
+DISKSIM_GLOBAL_TELEMETRY_FILE_depend,
+DISKSIM_GLOBAL_TELEMETRY_INTERVAL_depend
 };
 
@@ -20,10 +20,14 @@ typedef enum {
    DISKSIM_GLOBAL_STATISTIC_WARM_UP_IOS,
    DISKSIM_GLOBAL_STAT_DEFINITION_FILE,
    DISKSIM_GLOBAL_OUTPUT_FILE_FOR_TRACE_OF_IO_REQUESTS_SIMULATED,
-   DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE
+   DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE,
+   DISKSIM_GLOBAL_PERCENTILE_STATISTICS,
+   DISKSIM_GLOBAL_PERCENTILE_WINDOW,
+   DISKSIM_GLOBAL_TELEMETRY_FILE,
+   DISKSIM_GLOBAL_TELEMETRY_INTERVAL
 } disksim_global_param_t;
 
-#define DISKSIM_GLOBAL_MAX_PARAM		DISKSIM_GLOBAL_DETAILED_EXECUTION_TRACE
+#define DISKSIM_GLOBAL_MAX_PARAM		DISKSIM_GLOBAL_TELEMETRY_INTERVAL
 extern void * DISKSIM_GLOBAL_loaders[];
 extern lp_paramdep_t DISKSIM_GLOBAL_deps[];
 
@@ -38,9 +42,13 @@ static struct lp_varspec disksim_global_params [] = {
    {"Stat definition file", S, 1 },
    {"Output file for trace of I/O requests simulated", S, 0 },
    {"Detailed execution trace", S, 0 },
+   {"Percentile statistics", I, 0 },
+   {"Percentile window", D, 0 },
+   {"Telemetry file", S, 0 },
+   {"Telemetry interval", D, 0 },
    {0,0,0}
 };
-#define DISKSIM_GLOBAL_MAX 9
+#define DISKSIM_GLOBAL_MAX 13
 static struct lp_mod disksim_global_mod = { "disksim_global", disksim_global_params, DISKSIM_GLOBAL_MAX, (lp_modloader_t)disksim_global_loadparams,  0, 0, DISKSIM_GLOBAL_loaders, DISKSIM_GLOBAL_deps };
 
 
@@ -0,0 +1,47 @@
+#include "disksim_openloop_param.h"
+#include <libparam/bitvector.h>
+#include "../disksim_openloop.h"
+static int DISKSIM_OPENLOOP_NUMBER_OF_IO_REQUESTS_TO_GENERATE_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENLOOP_NUMBER_OF_IO_REQUESTS_TO_GENERATE_loader(int result, int i) { 
+if (! (i > 0)) { // foo 
+ } 
+ openloop_endiocnt = i;
+
+}
+
+static int DISKSIM_OPENLOOP_MAXIMUM_TIME_OF_TRACE_GENERATED_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENLOOP_MAXIMUM_TIME_OF_TRACE_GENERATED_loader(int result, double d) { 
+if (! (d > 0.0)) { // foo 
+ } 
+ openloop_endtime = d * 1000.0;
+
+}
+
+static int DISKSIM_OPENLOOP_STREAMS_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENLOOP_STREAMS_loader(int result, struct lp_list *l) { 
+if (! (!loadopenstreams(l))) { // foo 
+ } 
+
+}
+
+void * DISKSIM_OPENLOOP_loaders[] = {
+(void *)DISKSIM_OPENLOOP_NUMBER_OF_IO_REQUESTS_TO_GENERATE_loader,
+(void *)DISKSIM_OPENLOOP_MAXIMUM_TIME_OF_TRACE_GENERATED_loader,
+(void *)DISKSIM_OPENLOOP_STREAMS_loader
+};
+
+lp_paramdep_t DISKSIM_OPENLOOP_deps[] = {
+DISKSIM_OPENLOOP_NUMBER_OF_IO_REQUESTS_TO_GENERATE_depend,
+DISKSIM_OPENLOOP_MAXIMUM_TIME_OF_TRACE_GENERATED_depend,
+DISKSIM_OPENLOOP_STREAMS_depend
+};
+
@@ -0,0 +1,175 @@
+#include "disksim_openstream_param.h"
+#include <libparam/bitvector.h>
+#include "../disksim_openloop.h"
+static int DISKSIM_OPENSTREAM_STORAGE_CAPACITY_PER_DEVICE_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_STORAGE_CAPACITY_PER_DEVICE_loader(openloop_stream ** result, int i) { 
+if (! (i > 0)) { // foo 
+ } 
+ (*result)->sectsperdev = i;
+
+}
+
+static int DISKSIM_OPENSTREAM_DEVICES_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_DEVICES_loader(openloop_stream ** result, struct lp_list *l) { 
+if (! (!loadopendevs((*result), l))) { // foo 
+ } 
+
+}
+
+static int DISKSIM_OPENSTREAM_BLOCKING_FACTOR_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_BLOCKING_FACTOR_loader(openloop_stream ** result, int i) { 
+if (! (i > 0)) { // foo 
+ } 
+ (*result)->blocksize = i;
+
+}
+
+static int DISKSIM_OPENSTREAM_PROBABILITY_OF_READ_ACCESS_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_PROBABILITY_OF_READ_ACCESS_loader(openloop_stream ** result, double d) { 
+if (! (RANGE(d,0.0,1.0))) { // foo 
+ } 
+ (*result)->probread = d;
+
+}
+
+static int DISKSIM_OPENSTREAM_ARRIVAL_RATE_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_ARRIVAL_RATE_loader(openloop_stream ** result, double d) { 
+if (! (d > 0.0)) { // foo 
+ } 
+ (*result)->rate = d / 1000.0;
+
+}
+
+static int DISKSIM_OPENSTREAM_MAXIMUM_ARRIVAL_RATE_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_MAXIMUM_ARRIVAL_RATE_loader(openloop_stream ** result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ (*result)->ratelimit = d / 1000.0;
+
+}
+
+static int DISKSIM_OPENSTREAM_MEAN_ON_PERIOD_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_MEAN_ON_PERIOD_loader(openloop_stream ** result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ (*result)->ontime = d;
+
+}
+
+static int DISKSIM_OPENSTREAM_MEAN_OFF_PERIOD_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_MEAN_OFF_PERIOD_loader(openloop_stream ** result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ (*result)->offtime = d;
+
+}
+
+static int DISKSIM_OPENSTREAM_ADDRESS_DISTRIBUTION_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_ADDRESS_DISTRIBUTION_loader(openloop_stream ** result, char *s) { 
+if (! (!loadopenaddrdist((*result), s))) { // foo 
+ } 
+
+}
+
+static int DISKSIM_OPENSTREAM_ZIPF_EXPONENT_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_ZIPF_EXPONENT_loader(openloop_stream ** result, double d) { 
+if (! (d > 0.0 && d < 1.0)) { // foo 
+ } 
+ (*result)->zipftheta = d;
+
+}
+
+static int DISKSIM_OPENSTREAM_HOT_SET_FRACTION_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_HOT_SET_FRACTION_loader(openloop_stream ** result, double d) { 
+if (! (RANGE(d,0.0,1.0))) { // foo 
+ } 
+ (*result)->hotfrac = d;
+
+}
+
+static int DISKSIM_OPENSTREAM_HOT_SET_PROBABILITY_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_HOT_SET_PROBABILITY_loader(openloop_stream ** result, double d) { 
+if (! (RANGE(d,0.0,1.0))) { // foo 
+ } 
+ (*result)->hotprob = d;
+
+}
+
+static int DISKSIM_OPENSTREAM_REQUEST_SIZES_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_OPENSTREAM_REQUEST_SIZES_loader(openloop_stream ** result, struct lp_list *l) { 
+if (! (!loadopensizes((*result), l))) { // foo 
+ } 
+
+}
+
+void * DISKSIM_OPENSTREAM_loaders[] = {
+(void *)DISKSIM_OPENSTREAM_STORAGE_CAPACITY_PER_DEVICE_loader,
+(void *)DISKSIM_OPENSTREAM_DEVICES_loader,
+(void *)DISKSIM_OPENSTREAM_BLOCKING_FACTOR_loader,
+(void *)DISKSIM_OPENSTREAM_PROBABILITY_OF_READ_ACCESS_loader,
+(void *)DISKSIM_OPENSTREAM_ARRIVAL_RATE_loader,
+(void *)DISKSIM_OPENSTREAM_MAXIMUM_ARRIVAL_RATE_loader,
+(void *)DISKSIM_OPENSTREAM_MEAN_ON_PERIOD_loader,
+(void *)DISKSIM_OPENSTREAM_MEAN_OFF_PERIOD_loader,
+(void *)DISKSIM_OPENSTREAM_ADDRESS_DISTRIBUTION_loader,
+(void *)DISKSIM_OPENSTREAM_ZIPF_EXPONENT_loader,
+(void *)DISKSIM_OPENSTREAM_HOT_SET_FRACTION_loader,
+(void *)DISKSIM_OPENSTREAM_HOT_SET_PROBABILITY_loader,
+(void *)DISKSIM_OPENSTREAM_REQUEST_SIZES_loader
+};
+
+lp_paramdep_t DISKSIM_OPENSTREAM_deps[] = {
+DISKSIM_OPENSTREAM_STORAGE_CAPACITY_PER_DEVICE_depend,
+DISKSIM_OPENSTREAM_DEVICES_depend,
+DISKSIM_OPENSTREAM_BLOCKING_FACTOR_depend,
+DISKSIM_OPENSTREAM_PROBABILITY_OF_READ_ACCESS_depend,
+DISKSIM_OPENSTREAM_ARRIVAL_RATE_depend,
+DISKSIM_OPENSTREAM_MAXIMUM_ARRIVAL_RATE_depend,
+DISKSIM_OPENSTREAM_MEAN_ON_PERIOD_depend,
+DISKSIM_OPENSTREAM_MEAN_OFF_PERIOD_depend,
+DISKSIM_OPENSTREAM_ADDRESS_DISTRIBUTION_depend,
+DISKSIM_OPENSTREAM_ZIPF_EXPONENT_depend,
+DISKSIM_OPENSTREAM_HOT_SET_FRACTION_depend,
+DISKSIM_OPENSTREAM_HOT_SET_PROBABILITY_depend,
+DISKSIM_OPENSTREAM_REQUEST_SIZES_depend
+};
+
@@ -0,0 +1,58 @@
+
+#ifndef _DISKSIM_OPENSTREAM_PARAM_H
+#define _DISKSIM_OPENSTREAM_PARAM_H  
+
+#include <libparam/libparam.h>
+#ifdef __cplusplus
+extern"C"{
+#endif
+struct dm_disk_if;
+
+/* prototype for disksim_openstream param loader function */
+int disksim_openstream_loadparams(struct lp_block *b);
+
+typedef enum {
+   DISKSIM_OPENSTREAM_STORAGE_CAPACITY_PER_DEVICE,
+   DISKSIM_OPENSTREAM_DEVICES,
+   DISKSIM_OPENSTREAM_BLOCKING_FACTOR,
+   DISKSIM_OPENSTREAM_PROBABILITY_OF_READ_ACCESS,
+   DISKSIM_OPENSTREAM_ARRIVAL_RATE,
+   DISKSIM_OPENSTREAM_MAXIMUM_ARRIVAL_RATE,
+   DISKSIM_OPENSTREAM_MEAN_ON_PERIOD,
+   DISKSIM_OPENSTREAM_MEAN_OFF_PERIOD,
+   DISKSIM_OPENSTREAM_ADDRESS_DISTRIBUTION,
+   DISKSIM_OPENSTREAM_ZIPF_EXPONENT,
+   DISKSIM_OPENSTREAM_HOT_SET_FRACTION,
+   DISKSIM_OPENSTREAM_HOT_SET_PROBABILITY,
+   DISKSIM_OPENSTREAM_REQUEST_SIZES
+} disksim_openstream_param_t;
+
+#define DISKSIM_OPENSTREAM_MAX_PARAM		DISKSIM_OPENSTREAM_REQUEST_SIZES
+extern void * DISKSIM_OPENSTREAM_loaders[];
+extern lp_paramdep_t DISKSIM_OPENSTREAM_deps[];
+
+
+static struct lp_varspec disksim_openstream_params [] = {
+   {"Storage capacity per device", I, 1 },
+   {"devices", LIST, 1 },
+   {"Blocking factor", I, 0 },
+   {"Probability of read access", D, 1 },
+   {"Arrival rate", D, 1 },
+   {"Maximum arrival rate", D, 0 },
+   {"Mean ON period", D, 0 },
+   {"Mean OFF period", D, 0 },
+   {"Address distribution", S, 0 },
+   {"Zipf exponent", D, 0 },
+   {"Hot set fraction", D, 0 },
+   {"Hot set probability", D, 0 },
+   {"Request sizes", LIST, 0 },
+   {0,0,0}
+};
+#define DISKSIM_OPENSTREAM_MAX 13
+static struct lp_mod disksim_openstream_mod = { "disksim_openstream", disksim_openstream_params, DISKSIM_OPENSTREAM_MAX, (lp_modloader_t)disksim_openstream_loadparams,  0, 0, DISKSIM_OPENSTREAM_loaders, DISKSIM_OPENSTREAM_deps };
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _DISKSIM_OPENSTREAM_PARAM_H
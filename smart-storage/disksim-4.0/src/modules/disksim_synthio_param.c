@@ -66,13 +66,25 @@ if (! (!loadsynthgenerators(0,l))) { // foo
 
 }
 
+static int DISKSIM_SYNTHIO_INDEPENDENT_GENERATOR_STREAMS_depend(char *bv) {
+return -1;
+}
+
+static void DISKSIM_SYNTHIO_INDEPENDENT_GENERATOR_STREAMS_loader(int result, int i) { 
+if (! (RANGE(i,0,1))) { // foo 
+ } 
+ synthio_streams = i;
+
+}
+
 void * DISKSIM_SYNTHIO_loaders[] = {
 (void *)DISKSIM_SYNTHIO_NUMBER_OF_IO_REQUESTS_TO_GENERATE_loader,
 (void *)DISKSIM_SYNTHIO_MAXIMUM_TIME_OF_TRACE_GENERATED_loader,
 (void *)DISKSIM_SYNTHIO_SYSTEM_CALLRETURN_WITH_EACH_REQUEST_loader,
 (void *)DISKSIM_SYNTHIO_THINK_TIME_FROM_CALL_TO_REQUEST_loader,
 (void *)DISKSIM_SYNTHIO_THINK_TIME_FROM_REQUEST_TO_RETURN_loader,
-(void *)DISKSIM_SYNTHIO_GENERATORS_loader
+(void *)DISKSIM_SYNTHIO_GENERATORS_loader,
+(void *)DISKSIM_SYNTHIO_INDEPENDENT_GENERATOR_STREAMS_loader
 };
 
 lp_paramdep_t DISKSIM_SYNTHIO_deps[] = {
@@ -81,6 +93,7 @@ DISKSIM_SYNTHIO_MAXIMUM_TIME_OF_TRACE_GENERATED_depend,
 DISKSIM_SYNTHIO_SYSTEM_CALLRETURN_WITH_EACH_REQUEST_depend,
 DISKSIM_SYNTHIO_THINK_TIME_FROM_CALL_TO_REQUEST_depend,
 DISKSIM_SYNTHIO_THINK_TIME_FROM_REQUEST_TO_RETURN_depend,
-DISKSIM_SYNTHIO_GENERATORS_depend
+DISKSIM_SYNTHIO_GENERATORS_depend,
+DISKSIM_SYNTHIO_INDEPENDENT_GENERATOR_STREAMS_depend
 };
 
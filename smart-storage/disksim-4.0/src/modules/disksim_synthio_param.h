@@ -17,10 +17,11 @@ typedef enum {
    DISKSIM_SYNTHIO_SYSTEM_CALLRETURN_WITH_EACH_REQUEST,
    DISKSIM_SYNTHIO_THINK_TIME_FROM_CALL_TO_REQUEST,
    DISKSIM_SYNTHIO_THINK_TIME_FROM_REQUEST_TO_RETURN,
-   DISKSIM_SYNTHIO_GENERATORS
+   DISKSIM_SYNTHIO_GENERATORS,
+   DISKSIM_SYNTHIO_INDEPENDENT_GENERATOR_STREAMS
 } disksim_synthio_param_t;
 
-#define DISKSIM_SYNTHIO_MAX_PARAM		DISKSIM_SYNTHIO_GENERATORS
+#define DISKSIM_SYNTHIO_MAX_PARAM		DISKSIM_SYNTHIO_INDEPENDENT_GENERATOR_STREAMS
 extern void * DISKSIM_SYNTHIO_loaders[];
 extern lp_paramdep_t DISKSIM_SYNTHIO_deps[];
 
@@ -32,9 +33,10 @@ static struct lp_varspec disksim_synthio_params [] = {
    {"Think time from call to request", D, 1 },
    {"Think time from request to return", D, 1 },
    {"Generators", LIST, 1 },
+   {"Independent generator streams", I, 0 },
    {0,0,0}
 };
-#define DISKSIM_SYNTHIO_MAX 6
+#define DISKSIM_SYNTHIO_MAX 7
 static struct lp_mod disksim_synthio_mod = { "disksim_synthio", disksim_synthio_params, DISKSIM_SYNTHIO_MAX, (lp_modloader_t)disksim_synthio_loadparams,  0, 0, DISKSIM_SYNTHIO_loaders, DISKSIM_SYNTHIO_deps };
 
 
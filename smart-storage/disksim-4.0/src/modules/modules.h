@@ -19,6 +19,8 @@
 #include "disksim_ioqueue_param.h"
 #include "disksim_iosim_param.h"
 #include "disksim_logorg_param.h"
+#include "disksim_openloop_param.h"
+#include "disksim_openstream_param.h"
 #include "disksim_pf_param.h"
 #include "disksim_pf_stats_param.h"
 #include "disksim_simpledisk_param.h"
@@ -45,6 +47,8 @@ static struct lp_mod *disksim_mods[] = {
  &disksim_ioqueue_mod ,
  &disksim_iosim_mod ,
  &disksim_logorg_mod ,
+ &disksim_openloop_mod ,
+ &disksim_openstream_mod ,
  &disksim_pf_mod ,
  &disksim_pf_stats_mod ,
  &disksim_simpledisk_mod ,
@@ -71,6 +75,8 @@ typedef enum {
   DISKSIM_MOD_IOQUEUE,
   DISKSIM_MOD_IOSIM,
   DISKSIM_MOD_LOGORG,
+  DISKSIM_MOD_OPENLOOP,
+  DISKSIM_MOD_OPENSTREAM,
   DISKSIM_MOD_PF,
   DISKSIM_MOD_PF_STATS,
   DISKSIM_MOD_SIMPLEDISK,
@@ -80,5 +86,5 @@ typedef enum {
   DISKSIM_MOD_SYNTHIO
 } disksim_mod_t;
 
-#define DISKSIM_MAX_MODULE 22
+#define DISKSIM_MAX_MODULE 24
 #endif // _DISKSIM_MODULES_H
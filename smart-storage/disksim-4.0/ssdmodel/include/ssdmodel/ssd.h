@@ -418,6 +418,7 @@ void    ssd_resetstats (void);
 void    ssd_printstats (void);
 void    ssd_printsetstats (int *set, int setsize, char *sourcestr);
 void    ssd_cleanstats (void);
+void    ssd_telemetry (FILE *outfile, int header);
 int     ssd_set_depth (int devno, int inbusno, int depth, int slotno);
 int     ssd_get_depth (int devno);
 int     ssd_get_inbus (int devno);
@@ -1057,6 +1057,39 @@ void ssd_cleanstats (void)
    }
 }
 
+/*
+ * telemetry columns per ssd: queue length, free blocks across all
+ * elements, and the cleaning (GC) invocations and page moves so far.
+ */
+void ssd_telemetry (FILE *outfile, int header)
+{
+   int i, j;
+
+   if (disksim->ssdinfo == NULL) {
+      return;
+   }
+   for (i=0; i<MAXDEVICES; i++) {
+      ssd_t *currdisk = getssd (i);
+      unsigned int freeblks = 0;
+      int cleans = 0;
+      int moved = 0;
+
+      if (!currdisk) {
+         continue;
+      }
+      if (header) {
+         fprintf(outfile, ",ssd%d_queue,ssd%d_freeblks,ssd%d_cleans,ssd%d_pgsmoved", i, i, i, i);
+         continue;
+      }
+      for (j=0; j<currdisk->params.nelements; j++) {
+         freeblks += currdisk->elements[j].metadata.tot_free_blocks;
+         cleans += currdisk->elements[j].stat.num_clean;
+         moved += currdisk->elements[j].stat.pages_moved;
+      }
+      fprintf(outfile, ",%d,%u,%d,%d", ioqueue_get_number_in_queue(currdisk->queue), freeblks, cleans, moved);
+   }
+}
+
 void ssd_setcallbacks ()
 {
    ioqueue_setcallbacks();